@@ -3,17 +3,45 @@
 
 #include "esp32_c3_objects/callback.h"
 #include "packets/packet.h"
+#include "ble_adv_layout.h"
+#include "ble_channel.h"
+#include "ble_compress.h"
 #include "ble_config.h"
+#include "ble_diag.h"
+#include "ble_gatt_client.h"
+#include "ble_observer.h"
+#include "ble_persistence.h"
+#include "ble_power.h"
+#include "ble_preset_registry.h"
+#include "ble_ring.h"
+#include "ble_rx_dispatch.h"
+#include "ble_scanner.h"
+#include "ble_send_schedule.h"
+#include "ble_serial_bridge.h"
+#include "ble_shutdown.h"
+#include "ble_startup.h"
+#include "ble_statistics.h"
+#include "ble_trace.h"
+#include "ble_value_cache.h"
+#include "ble_tx_scheduler.h"
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "esp_bt.h"
 #include "esp_bt_defs.h"
 #include "esp_gatts_api.h"
 #include "esp_gap_ble_api.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
 
 namespace net
 {
@@ -31,6 +59,12 @@ namespace net
         /// @brief Тег для логирования
         static constexpr auto TAG = "BLE";
 
+        /// @brief Таймаут ожидания запуска в quickStart, мс
+        static constexpr uint32_t STARTUP_TIMEOUT_MS = 5000;
+
+        /// @brief Максимальное ожидание кредита контроллера при отправке уведомления, мс
+        static constexpr uint32_t TX_CREDIT_TIMEOUT_MS = 50;
+
         /**
          * @brief Конструктор BLE-контроллера
          * @param preset Пресет конфигурации (по умолчанию BLE4_DEFAULT)
@@ -41,6 +75,12 @@ namespace net
          * - Параметры рекламы и соединений
          */
         explicit BLE(BleConfig::Preset preset = BleConfig::Preset::BLE4_DEFAULT);
+
+        /**
+         * @brief Конструктор BLE-контроллера с готовой конфигурацией
+         * @param config Конфигурация (например, константа net::presets или BleConfig::compose())
+         */
+        explicit BLE(const BleConfig& config);
         ~BLE();
 
         // Запрет копирования и присваивания
@@ -66,17 +106,56 @@ namespace net
          * @param deviceName Имя BLE устройства
          * @param dataCallback Callback для обработки входящих данных
          * @return esp_err_t Код ошибки ESP-IDF
+         * @note Блокирующая обертка над start() и waitForStartup() с таймаутом STARTUP_TIMEOUT_MS
          */
         esp_err_t quickStart(const std::string& deviceName,
                              std::unique_ptr<esp32_c3::objects::Callback> dataCallback);
 
+        /**
+         * @brief Неблокирующий запуск BLE стека
+         * @param deviceName Имя BLE устройства
+         * @param dataCallback Callback для обработки входящих данных
+         * @param onComplete Callback завершения запуска (может быть пустым)
+         * @return esp_err_t Ошибка синхронной части запуска (контроллер, Bluedroid)
+         * @details Создание сервиса, характеристики и запуск рекламы продолжаются
+         *          по событиям GATTS/GAP. Параметры GAP и данные рекламы настраиваются
+         *          параллельно с созданием GATT базы.
+         */
+        esp_err_t start(const std::string& deviceName,
+                        std::unique_ptr<esp32_c3::objects::Callback> dataCallback,
+                        BleStartupCallback onComplete = nullptr);
+
+        /**
+         * @brief Ожидание завершения запуска
+         * @param timeout Таймаут ожидания в тиках FreeRTOS
+         * @return esp_err_t Результат запуска или ESP_ERR_TIMEOUT
+         * @warning Нельзя вызывать из задачи BTC (из callback'ов BLE)
+         */
+        esp_err_t waitForStartup(TickType_t timeout) const;
+
+        /**
+         * @brief Отчет о последнем запуске (статус и длительности фаз)
+         * @return BleStartupReport Копия отчета
+         */
+        BleStartupReport getStartupReport() const;
+
         /**
          * @brief Конвертация строкового UUID в esp_bt_uuid_t
          * @param uuidStr Строка UUID в формате "00001234-0000-1000-8000-00805F9B34FB"
          * @param invertBytes Флаг инверсии байт (актуально для 128-бит UUID)
-         * @return esp_bt_uuid_t Преобразованный UUID
+         * @return esp_bt_uuid_t Преобразованный UUID (len = 0 при ошибке)
+         * @note Для UUID, известных на этапе сборки, используйте BleUuid::fromString в constexpr-контексте
+         */
+        static esp_bt_uuid_t uuidFromString(std::string_view uuidStr, bool invertBytes);
+
+        /**
+         * @brief Конвертация строкового UUID в esp_bt_uuid_t с кодом ошибки
+         * @param uuidStr Строка UUID
+         * @param invertBytes Флаг инверсии байт (актуально для 128-бит UUID)
+         * @param[out] uuid Преобразованный UUID
+         * @return esp_err_t ESP_OK или ESP_ERR_INVALID_ARG при ошибке разбора
          */
-        static esp_bt_uuid_t uuidFromString(const std::string& uuidStr, bool invertBytes);
+        static esp_err_t uuidFromString(std::string_view uuidStr, bool invertBytes, esp_bt_uuid_t& uuid);
 
         /**
          * @brief Создание BLE сервиса по UUID
@@ -130,9 +209,32 @@ namespace net
         /**
          * @brief Остановка BLE стека и освобождение ресурсов
          * @return esp_err_t Код ошибки ESP-IDF
+         * @note Немедленная: уведомления в очередях отбрасываются, соединения рвутся
+         *       выключением стека без ожидания подтверждения
          */
         esp_err_t stop();
 
+        /**
+         * @brief Мягкая остановка BLE стека
+         * @param options Сроки сброса данных и разрыва соединений
+         * @return esp_err_t Результат выключения стека (как у stop())
+         * @details Новые отправки (sendData, scheduleSend, каналы) отклоняются с
+         *          ESP_ERR_INVALID_STATE, новые соединения разрываются, реклама, сканер и
+         *          мост останавливаются. Очередь планировщика и буферы контроллера
+         *          сбрасываются до options.drainTimeoutMs, затем каждому соединению
+         *          отправляется запрос разрыва и до options.disconnectTimeoutMs ожидаются
+         *          ESP_GATTS_DISCONNECT_EVT. После этого стек выключается как в stop().
+         *          Итог - в getShutdownReport().
+         * @warning Нельзя вызывать из задачи BTC (из callback'ов BLE)
+         */
+        esp_err_t stopGracefully(const BleShutdownOptions& options = {});
+
+        /**
+         * @brief Отчет о последней остановке (объем сброшенных данных и длительности фаз)
+         * @return BleShutdownReport Копия отчета
+         */
+        BleShutdownReport getShutdownReport() const;
+
         /**
          * @brief Получение количества подключенных устройств
          * @return uint8_t Количество активных подключений
@@ -152,11 +254,389 @@ namespace net
         std::shared_ptr<const BleConfig> getConfig() const;
 
         /**
-         * @brief Обновить конфигурацию (только до инициализации)
+         * @brief Раскладка данных рекламы и scan response для текущей конфигурации и имени
+         * @return BleAdvLayout::Plan Пакеты и решения раскладки (сокращение имени, форма UUID)
+         * @note Раскладка вычисляется один раз после смены конфигурации или имени
+         */
+        BleAdvLayout::Plan getAdvertisingLayout() const;
+
+        /**
+         * @brief Подключить постоянное хранилище (только до инициализации)
+         * @param store Бэкенд хранилища (NvsKeyValueStore на устройстве, FileKeyValueStore на хосте)
+         * @return esp_err_t ESP_OK, ESP_ERR_INVALID_STATE если уже инициализирован
+         * @details Хранит хэш и раскладку GATT базы и список bonded-устройств:
+         *          если база не изменилась, bonded-клиенты используют кэш обнаружения,
+         *          иначе им отправляется Service Changed при подключении.
+         */
+        esp_err_t setPersistentStore(std::unique_ptr<BleKeyValueStore> store);
+
+        /**
+         * @brief Получить снимок статистики
+         * @return BleStatistics Копия статистики
+         */
+        BleStatistics getStatistics() const;
+
+        /**
+         * @brief Результат обновления конфигурации
+         */
+        struct ConfigUpdateResult
+        {
+            uint16_t changed = 0;      ///< Отличающиеся группы параметров (BleConfig::Field)
+            uint16_t appliedLive = 0;  ///< Группы, примененные без перезапуска стека
+            uint16_t needsRestart = 0; ///< Группы, вступающие в силу после stop()/start()
+        };
+
+        /**
+         * @brief Обновить конфигурацию
          * @param newConfig Новая конфигурация
-         * @return esp_err_t ESP_OK если успешно, ESP_ERR_INVALID_STATE если уже инициализирован
+         * @param[out] result Отчет о примененных изменениях (может быть nullptr)
+         * @return esp_err_t ESP_OK если успешно, ESP_ERR_INVALID_ARG если конфигурация не прошла
+         *         BleConfig::validateAll() (нарушения выводятся в лог), иначе ошибка первого
+         *         неудачного вызова GAP
+         * @details До инициализации конфигурация просто копируется. После инициализации
+         *          применяются только изменившиеся группы параметров, соединения сохраняются:
+         *          - параметры и данные рекламы (реклама перезапускается, если была активна)
+         *          - мощность передачи (esp_ble_tx_power_set)
+         *          - предпочитаемые PHY (для новых и текущих соединений)
+         *          - параметры соединения (esp_ble_gap_update_conn_params для каждого соединения)
+         *          - параметры безопасности (для новых сопряжений)
+         *          Параметры контроллера и GATT (и выбор BLE 4/BLE 5) сохраняются отдельно и
+         *          вступают в силу при следующем start(); до этого getConfig() возвращает
+         *          конфигурацию работающего стека.
+         */
+        esp_err_t updateConfig(const BleConfig& newConfig, ConfigUpdateResult* result = nullptr);
+
+        /**
+         * @brief Применить пресет из реестра по имени
+         * @param name Имя встроенного или зарегистрированного пресета
+         * @param[out] result Отчет о примененных изменениях (может быть nullptr)
+         * @return esp_err_t ESP_ERR_NOT_FOUND, если пресет не найден, иначе результат updateConfig()
+         */
+        esp_err_t applyPreset(std::string_view name, ConfigUpdateResult* result = nullptr);
+
+        /**
+         * @brief Реестр именованных пресетов
+         */
+        BlePresetRegistry& getPresets() noexcept;
+
+        /**
+         * @brief Счетчики точки диагностики горячего пути
+         * @param event Точка диагностики
+         * @return BleDiag::Counters Всего событий, выведено, подавлено лимитом, потеряно
+         */
+        [[nodiscard]] BleDiag::Counters getDiagCounters(BleDiagEvent event) const noexcept;
+
+        /**
+         * @brief Оценка энергопотребления соединения (время работы радио, простой)
+         * @param connId Идентификатор соединения
+         * @param[out] energy Снимок оценки
+         * @return esp_err_t ESP_ERR_NOT_FOUND, если соединение не найдено
+         * @note Учитываются соединения GATT сервера (роль peripheral)
+         */
+        esp_err_t getLinkEnergy(uint16_t connId, BleLinkEnergy& energy) const;
+
+        /**
+         * @brief Счетчики сжатия данных (gatt.compressionEnabled)
+         * @return BleCompression::Statistics Исходные и переданные байты по направлениям
+         */
+        [[nodiscard]] BleCompression::Statistics getCompressionStatistics() const;
+
+        /**
+         * @brief Счетчики доставки принятых данных задачей ble_rx (rx.deferred)
+         * @return BleRxDispatcher::Statistics Доставленные и непринятые записи, задержка доставки
+         */
+        [[nodiscard]] BleRxDispatcher::Statistics getRxStatistics() const;
+
+        /**
+         * @brief Отправка данных в событии соединения (schedule.enabled)
+         * @param connId Идентификатор соединения
+         * @param data Данные (копируются в очередь)
+         * @param len Длина данных (не больше MTU - 3)
+         * @param dueUs Время esp_timer_get_time(), не раньше которого данные уходят в эфир
+         *              (0 - ближайшее событие соединения)
+         * @return esp_err_t ESP_ERR_INVALID_STATE - планировщик не запущен,
+         *         ESP_ERR_NOT_FOUND - соединение не найдено, ESP_ERR_NO_MEM - очередь заполнена
+         * @details Данные передаются стеку за schedule.leadUs до расчетного события соединения,
+         *          а не в момент вызова: задержка до эфира постоянна. Результат отправки
+         *          учитывается в getScheduleStatistics().
+         */
+        esp_err_t scheduleSend(uint16_t connId, const uint8_t* data, size_t len, int64_t dueUs = 0);
+
+        /**
+         * @brief Время следующего события соединения (schedule.enabled)
+         * @param connId Идентификатор соединения
+         * @param[out] timeUs Время esp_timer_get_time() расчетного события
+         * @return esp_err_t ESP_ERR_INVALID_STATE - фаза еще не определена (нужна одна отправка)
+         */
+        esp_err_t getNextConnectionEvent(uint16_t connId, int64_t& timeUs) const;
+
+        /**
+         * @brief Счетчики отправки по событиям соединения
+         * @return BleSendScheduler::Statistics Отправленные уведомления, отклонение от
+         *         расчетного события и задержка до подтверждения
+         */
+        [[nodiscard]] BleSendScheduler::Statistics getScheduleStatistics() const;
+
+        /**
+         * @brief Запрос параметров соединения из конфигурации
+         * @param connId Идентификатор соединения (0 - все соединения)
+         * @return esp_err_t Код ошибки ESP-IDF
+         */
+        esp_err_t requestConnectionParams(uint16_t connId = 0) const;
+
+        /**
+         * @brief Запуск сканирования рекламы (роль observer/central)
+         * @param config Параметры сканирования и фильтры
+         * @param callback Callback отчетов (вызывается из задачи сканера, не из стека)
+         * @return esp_err_t ESP_ERR_NOT_SUPPORTED для пресетов без BLE 5.0
+         * @details Работает параллельно с рекламой и GATT сервером.
+         */
+        esp_err_t startScan(const BleScanConfig& config, BleScanner::ResultCallback callback);
+
+        /**
+         * @brief Остановка сканирования
+         * @return esp_err_t Код ошибки ESP-IDF
+         */
+        esp_err_t stopScan();
+
+        /**
+         * @brief Получить счетчики сканера (received/filtered/duplicates/dropped/processed)
+         * @return BleScanner::Statistics Снимок счетчиков (нули, если сканер не запускался)
+         */
+        BleScanner::Statistics getScanStatistics() const;
+
+        /**
+         * @brief Включение роли GATT клиента
+         * @return esp_err_t Код ошибки ESP-IDF
+         * @details Регистрирует обработчик GATTC и приложение с идентификатором
+         *          gatt.appId + 1. Клиент использует общий с сервером планировщик
+         *          передачи, счетчики передачи попадают в getStatistics().
+         */
+        esp_err_t enableGattClient();
+
+        /**
+         * @brief Доступ к GATT клиенту
+         * @return BleGattClient* Клиент или nullptr, если роль не включена
+         */
+        BleGattClient* getGattClient() const noexcept;
+
+        /**
+         * @brief Установка наблюдателя соединений
+         * @param observer Наблюдатель (nullptr - отключить); BLE не владеет объектом
+         * @note При stop() открытые соединения получают onDisconnect с причиной
+         *       ESP_GATT_CONN_TERMINATE_LOCAL_HOST, чтобы приложение освободило контексты
+         */
+        void setConnectionObserver(BleConnectionObserver* observer);
+
+        /**
+         * @brief Callback данных соединения
+         * @param connId Идентификатор соединения
+         * @param data Данные записи в характеристику данных (после распаковки, без копирования)
+         * @param context Контекст соединения, переданный в setConnectionHandler
+         * @warning Вызывается из задачи BTC (ble_rx при rx.deferred) без мьютекса BLE;
+         *          data действительны только на время вызова
          */
-        esp_err_t updateConfig(const BleConfig& newConfig);
+        using ConnectionDataHandler = std::function<void(uint16_t connId, std::span<const uint8_t> data,
+                                                         void* context)>;
+
+        /**
+         * @brief Привязка callback'а данных и контекста к соединению
+         * @param connId Идентификатор соединения
+         * @param handler Callback (пустой - данные идут в общий callback из start())
+         * @param context Контекст приложения (например, состояние клиента), BLE не владеет им
+         * @return esp_err_t ESP_ERR_NOT_FOUND, если соединение не найдено
+         * @details Привязка действует до отключения; контекст возвращается в onDisconnect
+         *          наблюдателя для освобождения. Обычно вызывается из onConnect.
+         */
+        esp_err_t setConnectionHandler(uint16_t connId, ConnectionDataHandler handler, void* context = nullptr);
+
+        /**
+         * @brief Контекст соединения
+         * @return void* Контекст из setConnectionHandler (nullptr, если не задан или соединения нет)
+         */
+        void* getConnectionContext(uint16_t connId) const;
+
+        /**
+         * @brief Callback поступления потоковых данных
+         * @param connId Идентификатор соединения
+         * @param available Непрочитанных байт в потоке соединения
+         * @warning Вызывается из задачи BTC под мьютексом BLE: только уведомить потребителя
+         */
+        using BulkDataHandler = std::function<void(uint16_t connId, size_t available)>;
+
+        /**
+         * @brief Установка callback'а поступления потоковых данных (gatt.bulkEnabled)
+         */
+        void setBulkDataHandler(BulkDataHandler handler);
+
+        /**
+         * @brief Непрерывный участок принятых потоковых данных без копирования
+         * @param connId Идентификатор соединения
+         * @return std::span<const uint8_t> Данные (пустой, если данных или потока нет)
+         * @note Поток соединения читает одна задача - первая вызвавшая peekBulk() после
+         *       подключения; для других задач возвращается пустой участок. Участок остается
+         *       действительным до consumeBulk() той же задачей, в том числе после разрыва
+         *       соединения: до этого буфер не отдается новому соединению.
+         */
+        std::span<const uint8_t> peekBulk(uint16_t connId) const;
+
+        /**
+         * @brief Освобождение обработанных потоковых данных
+         * @param connId Идентификатор соединения
+         * @param len Количество байт
+         * @note Вызывается задачей-читателем; после разрыва соединения только освобождает участок
+         */
+        void consumeBulk(uint16_t connId, size_t len) const;
+
+        /**
+         * @brief Транспорт каналов с кредитным управлением потоком (gatt.channelsEnabled)
+         * @return BleChannelTransport& Транспорт для регистрации PSM и отправки SDU
+         * @details Фреймы каналов передаются через отдельную характеристику:
+         *          клиент пишет в нее без ответа, устройство отвечает уведомлениями.
+         */
+        BleChannelTransport& getChannels() noexcept;
+
+        /**
+         * @brief Трассировка событий GAP/GATT, отправок и callback'ов приложения
+         * @return BleTrace& Буфер для dump() в консоль или snapshot() для своего транспорта
+         * @details Запись включена всегда (BleTrace::setEnabled), буфер переживает
+         *          перезапуск стека. Преобразование в Chrome trace: tools/ble_trace_to_chrome.py.
+         */
+        BleTrace& getTrace() noexcept;
+
+        /**
+         * @brief Запуск прозрачного моста между последовательным портом и характеристикой данных
+         * @param port Порт (UartSerialPort, FdSerialPort или своя реализация), должен жить до остановки
+         * @param config Параметры моста
+         * @return esp_err_t ESP_ERR_INVALID_STATE, если BLE не инициализирован или мост уже запущен
+         * @details Данные порта уходят уведомлениями характеристики gatt.charUuid (NUS TX),
+         *          записи клиента в нее - в порт, callback данных для них не вызывается.
+         *          Мост обслуживает первое подключившееся соединение.
+         */
+        esp_err_t startSerialBridge(BleSerialPort& port, const BleSerialBridgeConfig& config = {});
+
+        /**
+         * @brief Остановка моста (порт закрывается)
+         */
+        void stopSerialBridge();
+
+        /**
+         * @brief Счетчики моста
+         */
+        [[nodiscard]] BleSerialBridge::Statistics getSerialBridgeStatistics() const noexcept;
+
+        /**
+         * @brief Значение характеристики данных, возвращаемое клиенту при чтении
+         * @return BleValueCache& Кэш для публикации значения (update) из любой задачи
+         * @details Запросы чтения, включая длинные (Read Blob), обслуживаются из кэша в
+         *          задаче BTC без мьютекса BLE и без callback'ов приложения. Значение
+         *          переживает перезапуск стека; до первой публикации читается пустым.
+         */
+        BleValueCache& getValueCache() noexcept;
+
+        /**
+         * @brief Состояние безопасности соединения
+         */
+        struct LinkSecurity
+        {
+            bool encrypted = false;         ///< Канал зашифрован
+            bool authenticated = false;     ///< Ключ получен с защитой от MITM
+            bool secureConnections = false; ///< Сопряжение LE Secure Connections
+            bool bonded = false;            ///< Ключи сохранены (bonding)
+            bool resumed = false;           ///< Шифрование возобновлено по сохраненному ключу
+            uint32_t timeToEncryptUs = 0;   ///< Время от подключения до шифрования, мкс (0 - не зашифровано)
+        };
+
+        /**
+         * @brief Запрос, требующий участия пользователя при сопряжении
+         */
+        enum class PairingRequest : uint8_t
+        {
+            PASSKEY_DISPLAY,   ///< Показать passkey (ответ не требуется)
+            PASSKEY_ENTRY,     ///< Ввести passkey, показанный удаленным устройством (replyPasskey)
+            NUMERIC_COMPARISON ///< Сравнить числа на обоих устройствах (confirmPairing)
+        };
+
+        /**
+         * @brief Callback запросов сопряжения
+         * @param address Адрес удаленного устройства
+         * @param request Тип запроса
+         * @param passkey Passkey для отображения или сравнения
+         * @warning Вызывается из задачи BTC под мьютексом BLE: ответ можно дать позже из другой задачи
+         */
+        using PairingHandler = std::function<void(const uint8_t* address, PairingRequest request, uint32_t passkey)>;
+
+        /**
+         * @brief Установка callback'а запросов сопряжения
+         * @note Без callback'а ввод passkey и сравнение чисел отклоняются
+         */
+        void setPairingHandler(PairingHandler handler);
+
+        /**
+         * @brief Ответ на PairingRequest::PASSKEY_ENTRY
+         */
+        esp_err_t replyPasskey(const esp_bd_addr_t address, bool accept, uint32_t passkey);
+
+        /**
+         * @brief Ответ на PairingRequest::NUMERIC_COMPARISON
+         */
+        esp_err_t confirmPairing(const esp_bd_addr_t address, bool accept);
+
+        /**
+         * @brief Состояние безопасности соединения
+         * @param connId Идентификатор соединения
+         * @param[out] security Снимок состояния
+         * @return esp_err_t ESP_ERR_NOT_FOUND, если соединение не найдено
+         */
+        esp_err_t getLinkSecurity(uint16_t connId, LinkSecurity& security) const;
+
+        /**
+         * @brief Устройство в accept list
+         */
+        struct AcceptListPeer
+        {
+            esp_bd_addr_t address;       ///< Адрес (identity-адрес для устройств с RPA)
+            esp_ble_wl_addr_type_t type; ///< Тип адреса
+        };
+
+        /**
+         * @brief Добавление устройств в accept list
+         * @param peers Устройства (уже добавленные пропускаются)
+         * @return esp_err_t Код ошибки ESP-IDF
+         * @details Пакет применяется за одну остановку рекламы: контроллер не меняет
+         *          accept list, пока реклама его использует. Устройства сверх емкости
+         *          контроллера хранятся на хосте; пока такие есть, подключения
+         *          фильтрует хост (разрывает соединения с устройствами вне списка).
+         */
+        esp_err_t addToAcceptList(std::span<const AcceptListPeer> peers);
+
+        /**
+         * @brief Удаление устройств из accept list
+         */
+        esp_err_t removeFromAcceptList(std::span<const AcceptListPeer> peers);
+
+        /**
+         * @brief Очистка accept list
+         */
+        esp_err_t clearAcceptList();
+
+        /**
+         * @brief Добавление всех bonded-устройств в accept list
+         */
+        esp_err_t loadBondedToAcceptList();
+
+        /**
+         * @brief Смена политики фильтрации рекламы на лету
+         * @param policy Политика (ADV_FILTER_ALLOW_SCAN_ANY_CON_WLST - подключения только из accept list)
+         * @return esp_err_t Код ошибки ESP-IDF
+         * @note Меняет extAdvParams.filter_policy и legacyAdvParams.adv_filter_policy конфигурации
+         */
+        esp_err_t setAdvertisingFilterPolicy(esp_ble_adv_filter_t policy);
+
+        /**
+         * @brief Количество устройств в accept list
+         */
+        size_t getAcceptListSize() const;
 
     private:
         /**
@@ -166,16 +646,150 @@ namespace net
                                       esp_gatt_if_t gattsIf,
                                       esp_ble_gatts_cb_param_t* param);
 
+        /**
+         * @brief Обработчик событий GATT клиента
+         */
+        static void gattcEventHandler(esp_gattc_cb_event_t event,
+                                      esp_gatt_if_t gattcIf,
+                                      esp_ble_gattc_cb_param_t* param);
+
         /**
          * @brief Обработчик событий GAP
          */
         static void gapEventHandler(esp_gap_ble_cb_event_t event,
                                     esp_ble_gap_cb_param_t* param);
 
+        /**
+         * @brief Запись событий стека в трассировку (соединение и аргумент по типу события)
+         */
+        void traceGattsEvent(esp_gatts_cb_event_t event, const esp_ble_gatts_cb_param_t* param) noexcept;
+        void traceGattcEvent(esp_gattc_cb_event_t event, const esp_ble_gattc_cb_param_t* param) noexcept;
+        void traceGapEvent(esp_gap_ble_cb_event_t event, const esp_ble_gap_cb_param_t* param) noexcept;
+
+        /**
+         * @brief Вызов callback'а сопряжения с записью в трассировку
+         */
+        void invokePairingHandler(const uint8_t* address, PairingRequest request, uint32_t passkey);
+
+        /**
+         * @brief Вызов метода наблюдателя соединений с записью в трассировку
+         * @note Вызывается без мьютекса BLE: под ним копируется только указатель наблюдателя
+         */
+        template <typename Method, typename... Args>
+        void notifyObserver(uint16_t connId, Method method, Args... args);
+
         /**
          * @brief Обработка события записи в характеристику
          */
-        void handleWriteEvent(uint16_t connId, const esp_ble_gatts_cb_param_t* param) const;
+        void handleWriteEvent(uint16_t connId, const esp_ble_gatts_cb_param_t* param);
+
+        /**
+         * @brief Передача записи характеристики данных задаче ble_rx или сразу callback'у
+         * @param lock Мьютекс BLE, захваченный вызывающим (освобождается перед callback'ом)
+         * @return esp_gatt_status_t Статус для ответа на запись
+         */
+        esp_gatt_status_t dispatchData(std::unique_lock<std::recursive_mutex>& lock, uint16_t connId,
+                                       std::span<const uint8_t> data);
+
+        /**
+         * @brief Передача записи характеристики данных callback'у соединения или общему
+         * @param generation Номер подключения на момент приема (запись закрытого соединения отбрасывается)
+         * @return esp_gatt_status_t Статус для ответа на запись
+         * @note Callback'и вызываются без мьютекса BLE
+         */
+        esp_gatt_status_t deliverData(uint16_t connId, uint32_t generation, std::span<const uint8_t> data);
+
+        /**
+         * @brief Фрагмент Prepare Write характеристики данных: накопление до Execute Write
+         */
+        void handlePrepareWrite(uint16_t connId, const esp_ble_gatts_cb_param_t* param);
+
+        /**
+         * @brief Execute Write: доставка накопленной записи или ее отмена (задача BTC)
+         */
+        void handleExecWrite(const esp_ble_gatts_cb_param_t* param);
+
+        /**
+         * @brief Ответ на запись в характеристику данных (Prepare Write - с эхом значения)
+         */
+        void sendWriteResponse(uint16_t connId, const esp_ble_gatts_cb_param_t* param, esp_gatt_status_t status);
+
+        /**
+         * @brief Обработка запроса чтения (задача BTC, без мьютекса)
+         */
+        void handleReadEvent(const esp_ble_gatts_cb_param_t* param);
+
+        /**
+         * @brief Поток приема соединения
+         */
+        struct BulkStream
+        {
+            bool bound = false;                    ///< Поток закреплен за соединением
+            mutable bool leased = false;           ///< Выдан участок peekBulk(), не освобожденный consumeBulk()
+            uint16_t connId = 0;                   ///< Идентификатор соединения
+            mutable TaskHandle_t reader = nullptr; ///< Задача-читатель (первая вызвавшая peekBulk())
+            std::unique_ptr<SpscByteRing> ring;    ///< Буфер потока
+        };
+
+        /**
+         * @brief Добавление характеристики потокового приема (запуск, после основной)
+         */
+        esp_err_t addBulkCharacteristic();
+
+        /**
+         * @brief Прием записи в характеристику потокового приема
+         */
+        void handleBulkWrite(uint16_t connId, const esp_ble_gatts_cb_param_t* param);
+
+        /**
+         * @brief Закрепление и освобождение потока за соединением
+         */
+        void bindBulkStream(uint16_t connId);
+        void releaseBulkStream(uint16_t connId) noexcept;
+
+        /**
+         * @brief Поиск потока соединения
+         */
+        const BulkStream* findBulkStream(uint16_t connId) const noexcept;
+
+        /**
+         * @brief Добавление характеристики транспорта каналов и ее CCCD (запуск)
+         */
+        esp_err_t addChannelCharacteristic();
+        esp_err_t addChannelCccd();
+
+        /**
+         * @brief Добавление характеристики возможностей сжатия (запуск)
+         */
+        esp_err_t addCompressionCharacteristic();
+
+        /**
+         * @brief Число хэндлов, резервируемых под сервис при текущей конфигурации
+         * @note Должно совпадать с атрибутами, которые добавляет цепочка ADD_CHAR/ADD_CHAR_DESCR
+         */
+        [[nodiscard]] uint16_t serviceHandleCount() const noexcept;
+
+        /**
+         * @brief Длина уведомления моста с учетом заголовка кадра сжатия
+         */
+        [[nodiscard]] uint16_t bridgeMtu() const noexcept;
+
+        /**
+         * @brief Отправка фрейма канала уведомлением
+         * @param blocking Ждать кредит контроллера (false - отправка из задачи BTC)
+         * @note Не захватывает мьютекс BLE: вызывается из задач, удерживающих мьютекс транспорта
+         */
+        esp_err_t sendChannelFrame(uint16_t connId, const uint8_t* data, size_t len, bool blocking) const;
+
+        /**
+         * @brief Раскладка рекламы (вычисляется при первом обращении после смены конфигурации)
+         */
+        const BleAdvLayout::Plan& advLayout() const;
+
+        /**
+         * @brief Настройка данных legacy рекламы (BLE 4.x)
+         */
+        esp_err_t configureLegacyAdvertising();
 
         /**
          * @brief Запуск legacy рекламы (BLE 4.x)
@@ -183,32 +797,322 @@ namespace net
         esp_err_t startLegacyAdvertising();
 
         /**
-         * @brief Настройка параметров расширенной рекламы BLE 5.0
+         * @brief Настройка параметров и данных расширенной рекламы BLE 5.0
          */
         esp_err_t configureExtendedAdvertising();
 
+        /**
+         * @brief Запуск ранее настроенной расширенной рекламы BLE 5.0
+         */
+        esp_err_t startExtendedAdvertising();
+
+        /// @brief Шаги запуска, которые должны завершиться до старта рекламы
+        enum StartupStep : uint8_t
+        {
+            STEP_GATT_DB = 1 << 0,    ///< Сервис создан и запущен
+            STEP_ADV_PARAMS = 1 << 1, ///< Параметры расширенной рекламы установлены
+            STEP_ADV_DATA = 1 << 2,   ///< Данные рекламы установлены
+            STEP_SCAN_RSP = 1 << 3,   ///< Данные scan response установлены
+            STEP_PRIVACY = 1 << 4     ///< Локальная приватность (RPA) включена
+        };
+
+        /// @brief Биты группы событий запуска
+        static constexpr EventBits_t STARTUP_DONE_BIT = 1 << 0;
+
+        /**
+         * @brief Начало фазы запуска (фиксирует время)
+         */
+        void beginStartupPhase(BleStartupPhase phase) noexcept;
+
+        /**
+         * @brief Завершение фазы запуска (фиксирует длительность)
+         */
+        void endStartupPhase(BleStartupPhase phase) noexcept;
+
+        /**
+         * @brief Отметка выполненного шага; запускает рекламу после всех шагов
+         */
+        void completeStartupStep(StartupStep step);
+
+        /**
+         * @brief Переход автомата запуска по событию GATTS
+         */
+        void advanceStartup(esp_gatts_cb_event_t event, esp_gatt_status_t status);
+
+        /**
+         * @brief Завершение запуска с указанным статусом
+         */
+        void finishStartup(esp_err_t status, BleStartupPhase phase);
+
+        /**
+         * @brief Вызов callback завершения запуска (вне мьютекса, в конце обработчика событий)
+         */
+        void notifyStartup();
+
+        /**
+         * @brief Проверка, что идет автоматический запуск
+         */
+        bool isStartupActive() const noexcept;
+
+        /**
+         * @brief Обработка подключения известного bonded-устройства
+         */
+        void handleBondedReconnect(const esp_bd_addr_t address);
+
+        /**
+         * @brief Установка параметров безопасности SMP из конфигурации
+         */
+        void applySecurityParams();
+
+        /**
+         * @brief Обработка событий SMP (запросы безопасности, passkey, завершение)
+         */
+        void handleSecurityEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param);
+
+        /**
+         * @brief Завершение сопряжения или возобновления шифрования
+         */
+        void handleAuthComplete(const esp_ble_auth_cmpl_t& auth);
+
+        /**
+         * @brief Запрос шифрования при подключении (bonded-устройство или gatt.requireEncryption)
+         */
+        void requestEncryption(const esp_bd_addr_t address, bool bonded);
+
+        /**
+         * @brief Проверка наличия ключей устройства (хранилище или список bond'ов стека)
+         */
+        bool isPeerBonded(const esp_bd_addr_t address) const;
+
+        /**
+         * @brief Список bond'ов стека
+         */
+        static std::vector<esp_ble_bond_dev_t> getBondedDevices();
+
+        /**
+         * @brief Добавление в список разрешения контроллера bond'ов, которых в нем еще нет
+         * @note Разрешение RPA выполняет контроллер, список нужно обновлять после новых bond'ов.
+         *       Размер списка учитывается по ESP_GAP_BLE_ADD_DEV_TO_RESOLVING_LIST_COMPLETE_EVT.
+         */
+        void loadResolvingList();
+
+        /**
+         * @brief Удаление устройства из зеркала списка разрешения
+         * @note Запись контроллера удаляет сам стек в esp_ble_remove_bond_device()
+         */
+        void forgetResolvingEntry(const esp_bd_addr_t identity);
+
+        /**
+         * @brief Синхронизация списков контроллера с bond'ами (resolving list, accept list)
+         */
+        void syncBondLists();
+
+        /**
+         * @brief Применение адреса приватности и фильтра accept list к параметрам рекламы
+         */
+        void applyAddressPolicy(esp_ble_addr_type_t& ownAddrType, esp_ble_adv_filter_t& filterPolicy) const noexcept;
+
+        /**
+         * @brief Устройство accept list (зеркало списка контроллера)
+         */
+        struct AcceptEntry
+        {
+            AcceptListPeer peer;       ///< Устройство
+            bool inController = false; ///< Запись загружена в контроллер
+        };
+
+        /**
+         * @brief Устройство списка разрешения контроллера
+         */
+        struct ResolvingEntry
+        {
+            esp_bd_addr_t identity; ///< Identity-адрес устройства
+            bool confirmed = false; ///< Контроллер подтвердил добавление
+        };
+
+        /**
+         * @brief Изменение accept list пакетом с одной остановкой рекламы
+         */
+        esp_err_t updateAcceptList(std::span<const AcceptListPeer> peers, bool add);
+
+        /**
+         * @brief Подключения фильтрует хост (accept list не поместился в контроллер)
+         */
+        bool isHostFilterActive() const noexcept;
+
+        /**
+         * @brief Проверка нового соединения по accept list
+         * @return true - соединение принято
+         */
+        bool admitConnection(uint16_t connId, const esp_bd_addr_t address);
+
+        /**
+         * @brief Применение конфигурации, отложенной updateConfig() до запуска (под мьютексом)
+         */
+        void applyPendingConfig();
+
+        /**
+         * @brief Остановка рекламы без перезапуска
+         * @return bool Реклама была активна
+         */
+        bool haltAdvertising();
+
+        /**
+         * @brief Ожидание подтверждения пакетов, переданных контроллеру (фаза DRAIN)
+         * @param deadlineUs Срок ожидания, время esp_timer_get_time()
+         * @param[in,out] report Отчет (controllerFlushed, controllerPending)
+         */
+        void drainController(int64_t deadlineUs, BleShutdownReport& report) const;
+
+        /**
+         * @brief Выключение стека (фаза TEARDOWN) и сохранение отчета
+         * @param report Отчет предыдущих фаз
+         * @param beginUs Время начала остановки
+         */
+        esp_err_t teardown(BleShutdownReport& report, int64_t beginUs);
+
+        /**
+         * @brief Перезапуск рекламы с текущими параметрами и данными
+         */
+        esp_err_t restartAdvertising();
+
+        /**
+         * @brief Настройка и запуск рекламы независимо от ее текущего состояния
+         */
+        esp_err_t resumeAdvertising();
+
+        /**
+         * @brief Параметры расширенной рекламы с учетом окна переподключения
+         */
+        esp_ble_gap_ext_adv_params_t activeExtAdvParams() const noexcept;
+
+        /**
+         * @brief Параметры legacy рекламы с учетом окна переподключения
+         */
+        esp_ble_adv_params_t activeLegacyAdvParams() const noexcept;
+
+        /**
+         * @brief Политика переподключения: обработка разрыва соединения
+         */
+        void handleReconnectOnDisconnect();
+
+        /**
+         * @brief Политика переподключения: обработка нового соединения
+         */
+        void handleReconnectOnConnect();
+
+        /**
+         * @brief Завершение окна быстрого переподключения (таймер)
+         */
+        static void reconnectBurstTimerCallback(void* arg);
+
         /**
          * @brief Внутренний метод отправки данных конкретному устройству
+         * @note Вызывается без мьютекса: кредит контроллера ожидается без блокировки,
+         *       мьютекс берется только на сжатие и передачу стеку
+         */
+        esp_err_t sendToDevice(uint16_t connId, const uint8_t* data, size_t size) const noexcept;
+
+        /**
+         * @brief Сжатие (если включено) и передача уведомления стеку (под мьютексом)
+         * @param[out] length Длина переданного кадра
          */
-        esp_err_t sendToDevice(uint16_t connId, std::array<uint8_t, MAX_MTU>& buffer, size_t size) const noexcept;
+        esp_err_t notifyLocked(uint16_t connId, const uint8_t* data, size_t size, size_t& length) const noexcept;
+
+        /**
+         * @brief Проверка активного соединения (под мьютексом)
+         */
+        [[nodiscard]] bool hasConnection(uint16_t connId) const noexcept;
+
+        /**
+         * @brief Отправка уведомления из задачи библиотеки - моста или планировщика
+         *        (с ожиданием кредитов без мьютекса)
+         */
+        esp_err_t sendFromTask(uint16_t connId, const uint8_t* data, size_t len) const;
+
+        /**
+         * @brief Идентификатор соединения GATT сервера по адресу (-1, если не найдено)
+         */
+        int findConnId(const esp_bd_addr_t address) const;
 
         struct DeviceConnection
         {
-            uint16_t connId;
-            esp_bd_addr_t address;
+            uint16_t connId;               ///< Идентификатор соединения
+            esp_bd_addr_t address;         ///< Адрес устройства
+            int64_t connectedUs = 0;       ///< Время подключения, мкс
+            uint16_t txCredits = 0;        ///< Кредитов контроллера при подключении (все свободны)
+            bool bondedAtConnect = false;  ///< Ключи устройства были сохранены до подключения
+            LinkSecurity security = {};    ///< Состояние безопасности
+            ConnectionDataHandler handler; ///< Callback данных соединения (пустой - общий)
+            void* context = nullptr;       ///< Контекст приложения
+            std::vector<uint8_t> prepared; ///< Фрагменты Prepare Write до Execute Write
+            uint32_t generation = 0;       ///< Номер подключения (connId переиспользуется стеком)
         };
 
         mutable std::recursive_mutex mMutex;              ///< Мьютекс для потокобезопасности
         BleConfig mConfig;                                ///< Текущая конфигурация BLE
+        std::unique_ptr<BleConfig> mPendingConfig;        ///< Конфигурация до следующего запуска (FIELDS_RESTART)
         std::vector<DeviceConnection> mActiveConnections; ///< Список активных подключений
+        uint32_t mConnGeneration = 0;                     ///< Счетчик подключений (DeviceConnection::generation)
 
         std::string mDeviceName;                                    ///< Имя BLE-устройства для рекламы и подключения
+        mutable BleAdvLayout::Plan mAdvLayout = {};                 ///< Раскладка рекламы (кэш)
+        mutable bool mAdvLayoutValid = false;                       ///< Раскладка соответствует конфигурации
         std::unique_ptr<esp32_c3::objects::Callback> mDataCallback; ///< Callback для данных
         esp_gatt_if_t mGattsIf = ESP_GATT_IF_NONE;                  ///< Интерфейс GATT
         uint16_t mServiceHandle = 0;                                ///< Хэндл сервиса
         uint16_t mCharHandle = 0;                                   ///< Хэндл характеристики
+        uint16_t mBulkHandle = 0;                                   ///< Хэндл характеристики потокового приема
+        uint16_t mChannelHandle = 0;                                ///< Хэндл характеристики транспорта каналов
+        uint16_t mChannelCccdHandle = 0;                            ///< Хэндл CCCD транспорта каналов
+        uint16_t mCompressionHandle = 0;                            ///< Хэндл характеристики возможностей сжатия
+        mutable std::array<uint8_t, MAX_MTU> mFrameBuffer = {};     ///< Кадр сжатия для отправки (под мьютексом)
         uint16_t mMtu = 23;                                         ///< Текущий размер MTU
         bool mIsInitialized = false;                                ///< Флаг инициализации
+        bool mIsAdvertising = false;                                ///< Реклама активна
+        std::atomic<bool> mStopping = false;                        ///< Идет мягкая остановка: отправки закрыты
+
+        bool mReconnectBurst = false;                 ///< Идет окно быстрого переподключения
+        bool mHasDirectedPeer = false;                ///< Реклама направлена на mDirectedPeer
+        BlePersistence::BondEntry mDirectedPeer = {}; ///< Последнее bonded-устройство
+        esp_timer_handle_t mReconnectTimer = nullptr; ///< Таймер окна переподключения
+        int64_t mLastDisconnectUs = 0;                ///< Время последнего разрыва, мкс (0 - нет)
+
+        std::unique_ptr<BlePersistence> mPersistence; ///< Постоянное хранилище GATT раскладки и bond'ов
+        BleStatistics mStats;                         ///< Статистика
+        std::unique_ptr<BleScanner> mScanner;         ///< Сканер (создается при первом startScan)
+        mutable BleTxScheduler mTxScheduler;          ///< Планировщик передачи, общий для ролей
+        std::unique_ptr<BleGattClient> mGattClient;   ///< GATT клиент (создается enableGattClient)
+        std::vector<BulkStream> mBulkStreams;         ///< Потоки приема (выделяются при запуске)
+        BulkDataHandler mBulkHandler;                 ///< Callback поступления потоковых данных
+        BleChannelTransport mChannels;                ///< Транспорт каналов
+        BlePresetRegistry mPresets;                   ///< Реестр именованных пресетов
+        mutable BlePowerManager mPower;               ///< Блокировки питания и учет активности радио
+        mutable BleDiag mDiag;                        ///< Диагностика горячего пути
+        mutable BleTrace mTrace;                      ///< Трассировка событий
+        BleSerialBridge mBridge;                      ///< Мост последовательный порт - BLE
+        BleValueCache mValueCache;                    ///< Значение характеристики данных для чтения
+        mutable BleCompression mCompression;          ///< Сжатие данных по соединениям
+        BleRxDispatcher mRxDispatcher;                ///< Доставка принятых данных задачей ble_rx
+        BleSendScheduler mSendScheduler;              ///< Отправка по событиям соединения
+        esp_gatt_rsp_t mAttrResponse = {};            ///< Буфер ответа на чтение и Prepare Write (задача BTC)
+        PairingHandler mPairingHandler;               ///< Callback запросов сопряжения
+        BleConnectionObserver* mObserver = nullptr;   ///< Наблюдатель соединений (не владеет)
+        std::vector<AcceptEntry> mAcceptList;         ///< Accept list (зеркало контроллера и переполнение)
+        std::vector<ResolvingEntry> mResolvingList;   ///< Список разрешения (зеркало контроллера)
+        uint16_t mAcceptListCapacity = 0;             ///< Емкость accept list контроллера
+        std::vector<uint16_t> mRejectedConnIds;       ///< Соединения, разорванные фильтром хоста
+
+        bool mAutoStart = false;                                               ///< Запуск ведется автоматом по событиям
+        uint8_t mStartupPending = 0;                                           ///< Невыполненные шаги StartupStep
+        BleStartupReport mStartupReport;                                       ///< Отчет о запуске
+        std::array<int64_t, BleStartupReport::PHASE_COUNT> mPhaseStartUs = {}; ///< Время начала фаз, мкс
+        int64_t mStartupBeginUs = 0;                                           ///< Время начала запуска, мкс
+        BleStartupPhase mLastStartupPhase = BleStartupPhase::CONTROLLER;       ///< Последняя начатая фаза
+        BleStartupCallback mStartupCallback;                                   ///< Callback завершения запуска
+        bool mStartupNotifyPending = false;                                    ///< Callback ждет вызова notifyStartup()
+        EventGroupHandle_t mStartupEvents = nullptr;                           ///< События завершения запуска
+        BleShutdownReport mShutdownReport;                                     ///< Отчет об остановке
     };
 } // namespace net
 
@@ -0,0 +1,125 @@
+#ifndef NET_BLE_ADV_LAYOUT_H
+#define NET_BLE_ADV_LAYOUT_H
+
+#include "ble_uuid.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace net
+{
+    /**
+     * @brief Раскладка AD структур по рекламному пакету и scan response
+     * @details Флаги всегда идут в рекламный пакет (в scan response они запрещены). UUID
+     *          сервиса кладется в рекламный пакет, если помещается (по нему фильтруют
+     *          пассивные и фоновые сканеры), иначе в scan response; UUID на базе Bluetooth
+     *          Base UUID передается в 16- или 32-бит форме. Полное имя кладется туда, где
+     *          осталось место; если оно ушло в scan response, а в рекламном пакете есть
+     *          место - туда добавляется сокращенное имя. Имя, не помещающееся нигде целиком,
+     *          сокращается по границе символа UTF-8.
+     */
+    class BleAdvLayout
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_ADV";
+
+        /// @brief Данные legacy рекламы и scan response, байт
+        static constexpr uint8_t LEGACY_DATA_MAX = 31;
+
+        /// @brief Данные расширенной рекламы в одном AUX_ADV_IND, байт
+        /// @details 255 байт PDU за вычетом расширенного заголовка с AdvA, TargetA, ADI и TxPower
+        static constexpr uint8_t EXT_DATA_MAX = 238;
+
+        /// @brief Сокращенное имя короче этого в рекламный пакет не добавляется
+        static constexpr uint8_t MIN_SHORT_NAME = 4;
+
+        /// @brief Типы AD структур (Core Specification Supplement, часть A)
+        static constexpr uint8_t AD_FLAGS = 0x01;
+        static constexpr uint8_t AD_UUID16_COMPLETE = 0x03;
+        static constexpr uint8_t AD_UUID32_COMPLETE = 0x05;
+        static constexpr uint8_t AD_UUID128_COMPLETE = 0x07;
+        static constexpr uint8_t AD_NAME_SHORT = 0x08;
+        static constexpr uint8_t AD_NAME_COMPLETE = 0x09;
+
+        /**
+         * @brief Пакет, в который попала AD структура
+         */
+        enum class Placement : uint8_t
+        {
+            NONE,    ///< Не попала (пустое значение или нет места)
+            ADV,     ///< Рекламный пакет
+            SCAN_RSP ///< Scan response
+        };
+
+        /**
+         * @brief Данные одного пакета
+         */
+        struct Payload
+        {
+            std::array<uint8_t, EXT_DATA_MAX> data; ///< AD структуры
+            uint8_t size;                           ///< Занято байт
+
+            /**
+             * @brief Занятая часть
+             */
+            [[nodiscard]] std::span<const uint8_t> view() const noexcept { return {data.data(), size}; }
+        };
+
+        /**
+         * @brief Исходные данные раскладки
+         */
+        struct Input
+        {
+            uint8_t flags;           ///< Флаги рекламы (0 - без AD структуры флагов)
+            std::string_view name;   ///< Имя устройства
+            BleUuid serviceUuid;     ///< UUID сервиса (невалидный - без UUID)
+            bool invertBytes;        ///< Инверсия байт 128-бит UUID (как в GATT)
+            uint8_t advCapacity;     ///< Емкость рекламного пакета
+            uint8_t scanRspCapacity; ///< Емкость scan response (0 - не сканируемая реклама)
+        };
+
+        /**
+         * @brief Результат раскладки
+         */
+        struct Plan
+        {
+            Payload adv;             ///< Рекламный пакет
+            Payload scanRsp;         ///< Scan response
+            Placement uuid;          ///< Пакет UUID сервиса
+            uint8_t uuidLength;      ///< Переданная форма UUID, байт (2, 4 или 16)
+            Placement name;          ///< Пакет полного имени
+            Placement shortName;     ///< Пакет сокращенного имени
+            uint8_t shortNameLength; ///< Длина сокращенного имени, байт
+        };
+
+        /**
+         * @brief Раскладка AD структур
+         * @param input Исходные данные
+         * @return Plan Пакеты не превышают заданных емкостей (и EXT_DATA_MAX)
+         */
+        [[nodiscard]] static Plan plan(const Input& input) noexcept;
+
+        /**
+         * @brief Самая короткая форма UUID в порядке передачи (little-endian)
+         * @param uuid UUID
+         * @param invertBytes Инверсия байт 128-бит UUID
+         * @param[out] out Байты UUID
+         * @return uint8_t Длина формы (0 для невалидного UUID)
+         */
+        static uint8_t compactUuid(const BleUuid& uuid, bool invertBytes,
+                                   std::array<uint8_t, ESP_UUID_LEN_128>& out) noexcept;
+
+        /**
+         * @brief Длина префикса строки, не разрезающего символ UTF-8
+         * @param str Строка
+         * @param maxBytes Максимальная длина префикса
+         */
+        [[nodiscard]] static size_t utf8Prefix(std::string_view str, size_t maxBytes) noexcept;
+    };
+} // namespace net
+
+#endif // NET_BLE_ADV_LAYOUT_H
@@ -0,0 +1,321 @@
+#ifndef NET_BLE_CHANNEL_H
+#define NET_BLE_CHANNEL_H
+
+#include "esp32_c3_objects/callback.h"
+#include "packets/packet.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "esp_err.h"
+
+#include "freertos/FreeRTOS.h"
+
+namespace net
+{
+    /**
+     * @brief Транспорт каналов с кредитным управлением потоком (по модели L2CAP LE CoC)
+     * @details Канал определяется парой (соединение, PSM). Устройство регистрирует PSM
+     *          и принимает каналы, открываемые клиентом. SDU автоматически делятся на
+     *          K-фреймы (первый несет длину SDU), каждый фрейм расходует один кредит
+     *          получателя; получатель возвращает кредиты по мере обработки.
+     *
+     *          Формат фрейма: [тип:1][PSM:2 LE][данные]
+     *          - CONNECT_REQ: [MTU SDU:2][начальные кредиты:2]
+     *          - CONNECT_RSP: [результат:1][MTU SDU:2][начальные кредиты:2]
+     *          - DATA:        [длина SDU:2 - только в первом фрейме][сегмент]
+     *          - CREDIT:      [кредиты:2]
+     *          - DISCONNECT:  -
+     *
+     *          Транспорт не зависит от канального уровня: фреймы уходят через FrameSender
+     *          и поступают через handleFrame(). BLE передает их через отдельную
+     *          GATT характеристику, т.к. Bluedroid не предоставляет API LE CoC;
+     *          на хосте два транспорта можно соединить напрямую (tools/ble_channel_bench.cpp).
+     *
+     *          FrameSender, callback SDU и ChannelEventHandler вызываются без мьютекса
+     *          транспорта: из них можно отправлять SDU и закрывать каналы.
+     */
+    class BleChannelTransport
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_CHAN";
+
+        /// @brief Максимальное количество зарегистрированных PSM
+        static constexpr size_t MAX_PSMS = 4;
+
+        /// @brief Максимальное количество открытых каналов
+        static constexpr size_t MAX_CHANNELS = 4;
+
+        /// @brief Минимальный MTU SDU (как в L2CAP LE)
+        static constexpr uint16_t MIN_SDU_MTU = 23;
+
+        /// @brief Размер заголовка фрейма (тип + PSM)
+        static constexpr size_t FRAME_HEADER = 3;
+
+        /// @brief Размер заголовка ATT в уведомлении/записи
+        static constexpr size_t ATT_HEADER = 3;
+
+        /**
+         * @brief Типы фреймов
+         */
+        enum FrameType : uint8_t
+        {
+            FRAME_CONNECT_REQ = 1, ///< Запрос открытия канала
+            FRAME_CONNECT_RSP = 2, ///< Ответ на запрос открытия
+            FRAME_DATA = 3,        ///< Сегмент SDU (K-фрейм)
+            FRAME_CREDIT = 4,      ///< Возврат кредитов
+            FRAME_DISCONNECT = 5   ///< Закрытие канала
+        };
+
+        /**
+         * @brief Результат открытия канала (коды L2CAP LE Credit Based Connection)
+         */
+        enum class ConnectResult : uint8_t
+        {
+            SUCCESS = 0x00,            ///< Канал открыт
+            PSM_NOT_SUPPORTED = 0x02,  ///< PSM не зарегистрирован
+            NO_RESOURCES = 0x04,       ///< Нет свободных каналов
+            UNACCEPTABLE_PARAMS = 0x0B ///< Недопустимые параметры
+        };
+
+        /**
+         * @brief Отправка фрейма на канальный уровень
+         * @param connId Идентификатор соединения
+         * @param data Фрейм
+         * @param len Размер фрейма
+         * @param blocking Можно ждать кредитов контроллера (false для вызовов из стека)
+         */
+        using FrameSender = std::function<esp_err_t(uint16_t connId, const uint8_t* data, size_t len, bool blocking)>;
+
+        /**
+         * @brief Callback открытия/закрытия канала (без мьютекса транспорта)
+         */
+        using ChannelEventHandler = std::function<void(uint16_t connId, uint16_t psm, bool connected)>;
+
+        /**
+         * @brief Параметры PSM
+         */
+        struct PsmConfig
+        {
+            uint16_t sduMtu = MAX_MTU;   ///< Максимальный размер принимаемого SDU (не больше MAX_MTU)
+            uint16_t initialCredits = 8; ///< Кредиты, выдаваемые отправителю при открытии
+        };
+
+        /**
+         * @brief Статистика канала
+         */
+        struct ChannelStatistics
+        {
+            uint32_t txSdus;        ///< Отправлено SDU
+            uint32_t txFrames;      ///< Отправлено K-фреймов
+            uint64_t txBytes;       ///< Отправлено байт SDU
+            uint32_t rxSdus;        ///< Принято SDU
+            uint32_t rxFrames;      ///< Принято K-фреймов
+            uint64_t rxBytes;       ///< Принято байт SDU
+            uint32_t creditStalls;  ///< Ожиданий кредитов получателя
+            uint16_t localCredits;  ///< Кредиты на отправку (выданы удаленной стороной)
+            uint16_t remoteCredits; ///< Кредиты, выданные удаленной стороне
+        };
+
+        /**
+         * @param sender Отправка фреймов на канальный уровень
+         */
+        explicit BleChannelTransport(FrameSender sender);
+
+        // Запрет копирования и присваивания
+        BleChannelTransport(const BleChannelTransport&) = delete;
+        BleChannelTransport& operator=(const BleChannelTransport&) = delete;
+
+        /**
+         * @brief Регистрация PSM
+         * @param psm Номер PSM (0x0080-0x00FF - динамический диапазон)
+         * @param config Параметры приема
+         * @param dataCallback Callback принятых SDU (Packet, id = connId)
+         * @return esp_err_t ESP_ERR_NO_MEM, если таблица PSM заполнена
+         */
+        esp_err_t registerPsm(uint16_t psm, const PsmConfig& config,
+                              std::unique_ptr<esp32_c3::objects::Callback> dataCallback);
+
+        /**
+         * @brief Снятие регистрации PSM и закрытие его каналов
+         */
+        esp_err_t unregisterPsm(uint16_t psm);
+
+        /**
+         * @brief Установка callback'а открытия/закрытия каналов
+         */
+        void setChannelEventHandler(ChannelEventHandler handler);
+
+        /**
+         * @brief Открытие канала со стороны инициатора (CONNECT_REQ)
+         * @param connId Идентификатор соединения
+         * @param psm Зарегистрированный PSM (его параметры и callback используются для приема)
+         * @return esp_err_t Код ошибки ESP-IDF; об открытии сообщает ChannelEventHandler
+         * @details Устройство обычно принимает каналы клиента; открытие нужно, когда
+         *          инициатор - устройство или второй транспорт на хосте.
+         */
+        esp_err_t connectChannel(uint16_t connId, uint16_t psm);
+
+        /**
+         * @brief Отправка SDU
+         * @param connId Идентификатор соединения
+         * @param psm PSM канала
+         * @param data Данные SDU
+         * @param len Размер SDU (не больше MTU SDU удаленной стороны)
+         * @param creditTimeout Таймаут ожидания кредита на каждый фрейм
+         * @return esp_err_t ESP_ERR_TIMEOUT, если получатель не вернул кредиты
+         * @details Без кредитов задача спит до фрейма CREDIT или закрытия канала.
+         * @warning Блокирующий вызов, нельзя вызывать из callback'ов BLE
+         */
+        esp_err_t sendSdu(uint16_t connId, uint16_t psm, const uint8_t* data, size_t len,
+                          TickType_t creditTimeout);
+
+        /**
+         * @brief Закрытие канала
+         */
+        esp_err_t closeChannel(uint16_t connId, uint16_t psm);
+
+        /**
+         * @brief Обработка входящего фрейма
+         */
+        void handleFrame(uint16_t connId, const uint8_t* data, size_t len);
+
+        /**
+         * @brief Закрытие всех каналов соединения при его разрыве
+         */
+        void handleDisconnect(uint16_t connId);
+
+        /**
+         * @brief Установка MTU канального уровня
+         */
+        void setLinkMtu(uint16_t mtu) noexcept;
+
+        /**
+         * @brief Статистика канала
+         * @param[out] stats Снимок статистики
+         * @return esp_err_t ESP_ERR_NOT_FOUND, если канал не открыт
+         */
+        esp_err_t getStatistics(uint16_t connId, uint16_t psm, ChannelStatistics& stats) const;
+
+    private:
+        /**
+         * @brief Зарегистрированный PSM
+         */
+        struct PsmEntry
+        {
+            uint16_t psm = 0;                                          ///< Номер PSM (0 - свободно)
+            PsmConfig config;                                          ///< Параметры приема
+            std::shared_ptr<esp32_c3::objects::Callback> dataCallback; ///< Callback принятых SDU
+        };
+
+        /**
+         * @brief Открытый канал
+         */
+        struct Channel
+        {
+            bool open = false;                                         ///< Канал открыт
+            bool pending = false;                                      ///< Отправлен CONNECT_REQ, ждем ответа
+            uint16_t connId = 0;                                       ///< Идентификатор соединения
+            uint16_t psm = 0;                                          ///< PSM
+            uint16_t remoteMtu = 0;                                    ///< MTU SDU удаленной стороны
+            uint16_t localMtu = 0;                                     ///< MTU SDU приема
+            uint16_t creditBatch = 1;                                  ///< Порог возврата кредитов
+            uint16_t pendingReturn = 0;                                ///< Обработанные, но не возвращенные кредиты
+            uint16_t sduLength = 0;                                    ///< Длина собираемого SDU (0 - нет)
+            uint16_t sduReceived = 0;                                  ///< Принято байт собираемого SDU
+            std::array<uint8_t, MAX_MTU> sdu = {};                     ///< Буфер сборки SDU
+            std::shared_ptr<esp32_c3::objects::Callback> dataCallback; ///< Callback принятых SDU
+            ChannelStatistics stats = {};                              ///< Статистика
+        };
+
+        /**
+         * @brief Действия, отложенные до освобождения мьютекса
+         * @details Управляющие фреймы, события каналов и собранный SDU копируются под
+         *          мьютексом и выполняются в flush() после его освобождения.
+         */
+        struct Deferred
+        {
+            /// @brief Емкость очередей: закрытие всех каналов PSM и ответ на запрос
+            static constexpr size_t MAX_ITEMS = MAX_CHANNELS + 1;
+
+            /**
+             * @brief Управляющий фрейм
+             */
+            struct Frame
+            {
+                uint16_t connId;    ///< Идентификатор соединения
+                FrameType type;     ///< Тип фрейма
+                uint16_t psm;       ///< PSM
+                uint8_t len;        ///< Длина полезной нагрузки
+                uint8_t payload[5]; ///< Полезная нагрузка
+                uint16_t credits;   ///< Возвращаемые кредиты (откат, если фрейм не отправлен)
+            };
+
+            /**
+             * @brief Событие открытия/закрытия канала
+             */
+            struct Event
+            {
+                uint16_t connId; ///< Идентификатор соединения
+                uint16_t psm;    ///< PSM
+                bool connected;  ///< Канал открыт
+            };
+
+            std::array<Frame, MAX_ITEMS> frames = {};                 ///< Управляющие фреймы
+            size_t frameCount = 0;                                    ///< Количество фреймов
+            std::array<Event, MAX_ITEMS> events = {};                 ///< События каналов
+            size_t eventCount = 0;                                    ///< Количество событий
+            std::shared_ptr<esp32_c3::objects::Callback> sduCallback; ///< Callback собранного SDU (пустой - нет SDU)
+            Packet sdu;                                               ///< Собранный SDU
+        };
+
+        PsmEntry* findPsm(uint16_t psm) noexcept;
+        Channel* findChannel(uint16_t connId, uint16_t psm) noexcept;
+        const Channel* findChannel(uint16_t connId, uint16_t psm) const noexcept;
+
+        void handleConnectRequest(uint16_t connId, uint16_t psm, const uint8_t* payload, size_t len,
+                                  Deferred& deferred);
+        void handleConnectResponse(uint16_t connId, uint16_t psm, const uint8_t* payload, size_t len,
+                                   Deferred& deferred);
+        void handleData(Channel& channel, const uint8_t* payload, size_t len, Deferred& deferred);
+
+        /**
+         * @brief Постановка управляющего фрейма в отложенные действия
+         */
+        static void queueControl(Deferred& deferred, uint16_t connId, FrameType type, uint16_t psm,
+                                 const uint8_t* payload = nullptr, size_t len = 0, uint16_t credits = 0) noexcept;
+
+        /**
+         * @brief Выполнение отложенных действий (без мьютекса)
+         * @return esp_err_t Первая ошибка отправки фрейма
+         */
+        esp_err_t flush(Deferred& deferred);
+
+        /**
+         * @brief Отправка управляющего фрейма (без ожидания кредитов)
+         */
+        esp_err_t sendControl(const Deferred::Frame& frame) const;
+
+        /**
+         * @brief Закрытие канала: событие приложению, пробуждение ждущего кредиты отправителя
+         */
+        void closeLocal(Channel& channel, Deferred& deferred);
+
+        FrameSender mSender;                         ///< Отправка фреймов
+        ChannelEventHandler mEventHandler;           ///< Callback открытия/закрытия каналов
+        mutable std::recursive_mutex mMutex;         ///< Мьютекс таблиц PSM и каналов
+        std::condition_variable_any mCreditCv;       ///< Возврат кредитов или закрытие канала
+        std::mutex mTxMutex;                         ///< Сериализация отправки SDU
+        std::array<PsmEntry, MAX_PSMS> mPsms;        ///< Зарегистрированные PSM
+        std::array<Channel, MAX_CHANNELS> mChannels; ///< Открытые каналы
+        uint16_t mLinkMtu = 23;                      ///< MTU канального уровня
+    };
+} // namespace net
+
+#endif // NET_BLE_CHANNEL_H
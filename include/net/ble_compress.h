@@ -0,0 +1,176 @@
+#ifndef NET_BLE_COMPRESS_H
+#define NET_BLE_COMPRESS_H
+
+#include "packets/packet.h"
+#include "ble_lz.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "esp_err.h"
+
+namespace net
+{
+    /**
+     * @brief Сжатие данных характеристики данных по соединениям
+     * @details Сжатие согласуется с каждым клиентом отдельно. Клиент читает характеристику
+     *          возможностей ([версия, возможности, размер окна в битах]) и записывает в нее
+     *          байт своих возможностей. Если общий бит CAP_LZ есть, каждое уведомление и каждая
+     *          запись характеристики данных этого соединения - кадр [заголовок, данные]:
+     *          FRAME_RAW - данные как есть, FRAME_LZ - поток BleLz. Окно общее для всех
+     *          кадров соединения в своем направлении, поэтому повторы между уведомлениями
+     *          тоже сжимаются. Клиенты, не записавшие возможности, получают данные без кадров.
+     * @warning Методы вызываются под мьютексом BLE.
+     */
+    class BleCompression
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_LZ";
+
+        /// @brief Версия протокола в значении характеристики возможностей
+        static constexpr uint8_t VERSION = 1;
+
+        /// @brief Возможность: кадры BleLz с общим окном
+        static constexpr uint8_t CAP_LZ = 0x01;
+
+        /// @brief Размер заголовка кадра
+        static constexpr size_t HEADER_SIZE = 1;
+
+        /// @brief Размер значения характеристики возможностей
+        static constexpr size_t CAPABILITIES_SIZE = 3;
+
+        /**
+         * @brief Тип кадра (заголовок)
+         */
+        enum FrameType : uint8_t
+        {
+            FRAME_RAW = 0x00, ///< Данные без сжатия (добавляются в окно)
+            FRAME_LZ = 0x01   ///< Данные BleLz
+        };
+
+        /**
+         * @brief Счетчики сжатия
+         */
+        struct Statistics
+        {
+            uint64_t txPlainBytes; ///< Исходных байт отправлено
+            uint64_t txWireBytes;  ///< Байт кадров отправлено (с заголовками)
+            uint64_t rxPlainBytes; ///< Исходных байт принято
+            uint64_t rxWireBytes;  ///< Байт кадров принято
+            uint32_t txRawFrames;  ///< Кадров, отправленных без сжатия
+            uint32_t rxErrors;     ///< Поврежденных кадров
+            uint32_t links;        ///< Соединений со сжатием сейчас
+        };
+
+        BleCompression() = default;
+
+        // Запрет копирования и присваивания
+        BleCompression(const BleCompression&) = delete;
+        BleCompression& operator=(const BleCompression&) = delete;
+
+        /**
+         * @brief Размер окна для новых соединений
+         * @param windowBits Размер окна, бит (BleLz::MIN_WINDOW_BITS..BleLz::MAX_WINDOW_BITS)
+         */
+        void setWindowBits(uint8_t windowBits) noexcept { mWindowBits = windowBits; }
+
+        /**
+         * @brief Значение характеристики возможностей
+         * @param[out] out Буфер не меньше CAPABILITIES_SIZE
+         * @return size_t Длина значения
+         */
+        size_t capabilities(uint8_t* out) const noexcept;
+
+        /**
+         * @brief Запись клиентом байта возможностей
+         * @param connId Идентификатор соединения
+         * @param peerCaps Возможности клиента (0 - отключить сжатие)
+         * @return esp_err_t ESP_ERR_NO_MEM - не удалось выделить окна
+         * @details Повторная запись сбрасывает окна обоих направлений.
+         */
+        esp_err_t negotiate(uint16_t connId, uint8_t peerCaps);
+
+        /**
+         * @brief Освобождение окон соединения
+         */
+        void release(uint16_t connId) noexcept;
+
+        /**
+         * @brief Освобождение окон всех соединений
+         */
+        void releaseAll() noexcept;
+
+        /**
+         * @brief Сжатие согласовано с соединением
+         */
+        [[nodiscard]] bool isActive(uint16_t connId) const noexcept;
+
+        /**
+         * @brief Кадр для отправки
+         * @param connId Идентификатор соединения (isActive)
+         * @param data Исходные данные
+         * @param len Длина
+         * @param out Буфер кадра
+         * @param capacity Максимальная длина кадра (MTU - 3)
+         * @return size_t Длина кадра (0 - данные не помещаются даже без сжатия)
+         * @note После успешной отправки вызывается commit(), иначе окно не меняется.
+         */
+        size_t encode(uint16_t connId, const uint8_t* data, size_t len, uint8_t* out, size_t capacity) noexcept;
+
+        /**
+         * @brief Подтверждение отправки последнего кадра соединения
+         */
+        void commit(uint16_t connId) noexcept;
+
+        /**
+         * @brief Разбор принятого кадра
+         * @param connId Идентификатор соединения (isActive)
+         * @param frame Кадр
+         * @param len Длина кадра
+         * @param[out] out Исходные данные (действительны до следующего decode этого соединения)
+         * @return esp_err_t ESP_ERR_INVALID_RESPONSE - поврежденный кадр
+         */
+        esp_err_t decode(uint16_t connId, const uint8_t* frame, size_t len, std::span<const uint8_t>& out) noexcept;
+
+        /**
+         * @brief Снимок счетчиков
+         */
+        [[nodiscard]] Statistics getStatistics() const noexcept;
+
+    private:
+        /**
+         * @brief Окна соединения
+         */
+        struct Link
+        {
+            uint16_t connId;         ///< Идентификатор соединения
+            BleLzEncoder encoder;    ///< Окно отправки
+            BleLzDecoder decoder;    ///< Окно приема
+            size_t pendingPlain = 0; ///< Исходных байт в неподтвержденном кадре
+            size_t pendingWire = 0;  ///< Длина неподтвержденного кадра
+            bool pendingRaw = false; ///< Неподтвержденный кадр без сжатия
+        };
+
+        /**
+         * @brief Окна соединения (nullptr, если сжатие не согласовано)
+         */
+        Link* find(uint16_t connId) const noexcept;
+
+        std::vector<std::unique_ptr<Link>> mLinks; ///< Соединения со сжатием
+        uint8_t mWindowBits = 10;                  ///< Размер окна новых соединений, бит
+
+        std::atomic<uint64_t> mTxPlainBytes = 0; ///< Счетчик исходных байт отправки
+        std::atomic<uint64_t> mTxWireBytes = 0;  ///< Счетчик байт кадров отправки
+        std::atomic<uint64_t> mRxPlainBytes = 0; ///< Счетчик исходных байт приема
+        std::atomic<uint64_t> mRxWireBytes = 0;  ///< Счетчик байт кадров приема
+        std::atomic<uint32_t> mTxRawFrames = 0;  ///< Счетчик кадров без сжатия
+        std::atomic<uint32_t> mRxErrors = 0;     ///< Счетчик поврежденных кадров
+    };
+} // namespace net
+
+#endif // NET_BLE_COMPRESS_H
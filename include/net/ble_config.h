@@ -1,10 +1,15 @@
 #ifndef NET_BLE_CONFIG_H
 #define NET_BLE_CONFIG_H
 
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
 #include "esp_bt.h"
 #include "esp_gap_ble_api.h"
 #include "esp_gatts_api.h"
-#include <string>
+#include "ble_task.h"
+#include "ble_uuid.h"
 
 namespace net
 {
@@ -17,6 +22,21 @@ namespace net
     class BleConfig
     {
     public:
+        /// @brief UUID сервиса Nordic UART Service (NUS)
+        static constexpr BleUuid NUS_SERVICE_UUID = BleUuid::fromString("6E400001-B5A3-F393-E0A9-E50E24DCCA9E");
+
+        /// @brief UUID характеристики NUS RX (запись от клиента)
+        static constexpr BleUuid NUS_RX_CHAR_UUID = BleUuid::fromString("6E400002-B5A3-F393-E0A9-E50E24DCCA9E");
+
+        /// @brief UUID характеристики потокового приема (запись без ответа)
+        static constexpr BleUuid BULK_CHAR_UUID = BleUuid::fromString("6E400010-B5A3-F393-E0A9-E50E24DCCA9E");
+
+        /// @brief UUID характеристики транспорта каналов (фреймы BleChannelTransport)
+        static constexpr BleUuid CHANNEL_CHAR_UUID = BleUuid::fromString("6E400020-B5A3-F393-E0A9-E50E24DCCA9E");
+
+        /// @brief UUID характеристики возможностей сжатия (согласование BleCompression)
+        static constexpr BleUuid COMPRESSION_CHAR_UUID = BleUuid::fromString("6E400030-B5A3-F393-E0A9-E50E24DCCA9E");
+
         /**
       * @brief Предустановленные режимы конфигурации
       */
@@ -31,22 +51,160 @@ namespace net
         };
 
         /**
-             * @brief Конструктор с инициализацией пресета
-             * @param preset Пресет конфигурации (по умолчанию BLE4_DEFAULT)
-             */
-        explicit BleConfig(Preset preset = Preset::BLE4_DEFAULT);
+         * @brief Ошибки проверки конфигурации
+         * @details Результат validate(). Для конфигураций времени компиляции проверка
+         *          выполняется через static_assert, см. compose().
+         */
+        enum class ValidationError : uint8_t
+        {
+            NONE,                ///< Конфигурация корректна
+            MAX_ACTIVITIES,      ///< controller.ble_max_act вне 1..MAX_ACTIVITIES
+            EXT_ADV_DISABLED,    ///< Пресет BLE 5 без controller.ble_50_feat_supp
+            ADV_INTERVAL,        ///< Интервалы рекламы вне 0x20..0x4000 (ext: 0x20..0xFFFFFF) или min > max
+            ADV_PHY,             ///< Основная PHY рекламы не 1M/Coded или недопустимая вторичная PHY
+            RECONNECT_INTERVAL,  ///< Интервалы быстрого переподключения вне 0x20..0x4000 или min > max
+            PHY_MASK,            ///< Пустая маска PHY соединения или лишние биты
+            CONN_INTERVAL,       ///< Интервалы соединения вне 0x06..0x0C80 или min > max
+            CONN_LATENCY,        ///< Latency больше 499
+            SUPERVISION_TIMEOUT, ///< Таймаут вне 0x0A..0x0C80 или не больше (1 + latency) * maxInterval * 2
+            KEY_SIZE,            ///< Размер ключа вне 7..16
+            RPA_TIMEOUT,         ///< Период смены RPA вне 1..3600 с
+            DATA_LENGTH,         ///< power.txOctets вне 27..251
+            COMPRESSION_WINDOW,  ///< gatt.compressionWindowBits вне 8..12
+            RX_BUFFER,           ///< rx.bufferSize меньше MIN_RX_BUFFER
+            SCHEDULE             ///< schedule.queueLength вне 1..MAX_SCHEDULE_QUEUE или schedule.leadUs вне 200..7500
+        };
+
+        /**
+         * @brief Единицы измерения поля (для перевода в читаемый вид)
+         */
+        enum class Unit : uint8_t
+        {
+            NONE,        ///< Безразмерное значение
+            SLOTS_625,   ///< 0.625 мс (интервалы рекламы)
+            SLOTS_1250,  ///< 1.25 мс (интервалы соединения)
+            SLOTS_10MS,  ///< 10 мс (таймаут супервизии)
+            SECONDS,     ///< Секунды
+            BYTES,       ///< Байты
+            MICROSECONDS ///< Микросекунды
+        };
+
+        /**
+         * @brief Найденное нарушение
+         * @details Ограничения, зависящие от других полей (min <= max, таймаут супервизии),
+         *          приводятся к диапазону [min, max] для конкретного поля.
+         */
+        struct ValidationIssue
+        {
+            ValidationError error; ///< Код ошибки
+            const char* field;     ///< Имя поля ("connection.maxInterval")
+            uint32_t value;        ///< Текущее значение (в единицах поля)
+            uint32_t min;          ///< Минимально допустимое значение
+            uint32_t max;          ///< Максимально допустимое значение
+            Unit unit;             ///< Единицы измерения
+            const char* rule;      ///< Описание ограничения, не сводимого к диапазону (иначе nullptr)
+        };
+
+        /// @brief Максимальное значение controller.ble_max_act (CONFIG_BT_CTRL_BLE_MAX_ACT)
+        static constexpr uint8_t MAX_ACTIVITIES = 10;
+
+        /// @brief Минимальное значение rx.bufferSize (запись максимальной длины с заголовком и запас)
+        static constexpr uint16_t MIN_RX_BUFFER = 1024;
+
+        /// @brief Максимальное значение schedule.queueLength
+        static constexpr uint8_t MAX_SCHEDULE_QUEUE = 32;
+
+        /**
+         * @brief Конструктор с инициализацией пресета
+         * @param preset Пресет конфигурации (по умолчанию BLE4_DEFAULT)
+         * @note constexpr: конфигурация, известная при сборке, размещается как константа
+         *       без кода инициализации
+         */
+        constexpr explicit BleConfig(const Preset preset = Preset::BLE4_DEFAULT) noexcept
+        {
+            applyPreset(preset);
+        }
+
+        /**
+         * @brief Построение пользовательского пресета на этапе компиляции
+         * @param base Базовый пресет
+         * @param modify Функция, изменяющая копию базового пресета
+         * @return BleConfig Итоговая конфигурация
+         * @details Пример:
+         * @code
+         * constexpr auto SENSOR = net::BleConfig::compose(net::BleConfig::Preset::BLE5_LOW_POWER,
+         *     [](net::BleConfig& config) { config.connection.latency = 8; });
+         * static_assert(SENSOR.isValid());
+         * @endcode
+         */
+        template <typename Modifier>
+        [[nodiscard]] static constexpr BleConfig compose(const Preset base, Modifier&& modify) noexcept
+        {
+            BleConfig config(base);
+            modify(config);
+            return config;
+        }
 
         /**
          * @brief Получить текущий активный пресет конфигурации
-         * @return Preset Текущий примененный пресет
-         * @note Определяет пресет по текущим параметрам конфигурации
+         * @return Preset Базовый пресет (для compose() - пресет, с которого начато построение)
          */
-        [[nodiscard]] Preset currentPreset() const noexcept;
+        [[nodiscard]] constexpr Preset currentPreset() const noexcept
+        {
+            return mCurrentPreset;
+        }
 
         /**
          * @brief Проверка поддержки расширенной рекламы (BLE 5.0+)
          */
-        [[nodiscard]] bool supportsExtendedAdvertising() const noexcept;
+        [[nodiscard]] constexpr bool supportsExtendedAdvertising() const noexcept
+        {
+            return mCurrentPreset == Preset::BLE5_DEFAULT ||
+                mCurrentPreset == Preset::BLE5_LOW_POWER ||
+                mCurrentPreset == Preset::BLE5_ULTRA_PERF;
+        }
+
+        /**
+         * @brief Права доступа характеристик с учетом gatt.requireEncryption
+         * @return esp_gatt_perm_t Права из gatt.charPermissions, при requireEncryption
+         *         повышенные до шифрованных (с MITM, если он требуется security.authReq)
+         */
+        [[nodiscard]] constexpr esp_gatt_perm_t characteristicPermissions() const noexcept;
+
+        /**
+         * @brief Проверка параметров на соответствие спецификации Bluetooth и контроллеру
+         * @return ValidationError Первая найденная ошибка или NONE
+         */
+        [[nodiscard]] constexpr ValidationError validate() const noexcept
+        {
+            ValidationIssue issue = {};
+            return validateAll({&issue, 1}) != 0 ? issue.error : ValidationError::NONE;
+        }
+
+        /**
+         * @brief Полная проверка параметров
+         * @param[out] issues Буфер для найденных нарушений (заполняется по порядку)
+         * @return size_t Общее количество нарушений (может превышать размер буфера)
+         */
+        [[nodiscard]] constexpr size_t validateAll(std::span<ValidationIssue> issues) const noexcept;
+
+        /**
+         * @brief Форматирование нарушения с переводом в физические единицы
+         * @details Пример: "connection.maxInterval = 3300 (4125.00 ms), allowed 6..3200 (7.50..4000.00 ms)"
+         * @param issue Нарушение
+         * @param buffer Буфер строки
+         * @param size Размер буфера
+         * @return size_t Длина строки без завершающего нуля
+         */
+        static size_t formatIssue(const ValidationIssue& issue, char* buffer, size_t size) noexcept;
+
+        /**
+         * @brief Конфигурация корректна (validate() == NONE)
+         */
+        [[nodiscard]] constexpr bool isValid() const noexcept
+        {
+            return validate() == ValidationError::NONE;
+        }
 
         /**
          * @brief Применяет предустановленную конфигурацию
@@ -57,13 +215,69 @@ namespace net
          * - Интервалы рекламы
          * - Количество соединений
          */
-        void applyPreset(Preset preset) noexcept;
+        constexpr void applyPreset(Preset preset) noexcept;
+
+        /**
+         * @brief Группы параметров конфигурации (битовая маска)
+         * @details Используется для сравнения конфигураций и отчета о применении
+         *          изменений без перезапуска стека.
+         */
+        enum Field : uint16_t
+        {
+            FIELD_ADV_PARAMS = 1 << 0,  ///< Параметры рекламы (интервалы, PHY, мощность рекламы) - на лету
+            FIELD_ADV_DATA = 1 << 1,    ///< Флаги рекламных данных - на лету
+            FIELD_TX_POWER = 1 << 2,    ///< Мощность передачи по умолчанию - на лету
+            FIELD_DEFAULT_PHY = 1 << 3, ///< Предпочитаемые PHY - на лету
+            FIELD_CONN_PARAMS = 1 << 4, ///< Параметры соединения - на лету
+            FIELD_SECURITY = 1 << 5,    ///< Параметры безопасности - на лету (для новых сопряжений)
+            FIELD_CONTROLLER = 1 << 6,  ///< Прочие параметры контроллера - требуется перезапуск
+            FIELD_GATT = 1 << 7,        ///< Параметры GATT сервера - требуется перезапуск
+
+            /// @brief Поля, применяемые без перезапуска стека
+            FIELDS_LIVE = FIELD_ADV_PARAMS | FIELD_ADV_DATA | FIELD_TX_POWER |
+                FIELD_DEFAULT_PHY | FIELD_CONN_PARAMS | FIELD_SECURITY,
+
+            /// @brief Поля, требующие перезапуска стека
+            FIELDS_RESTART = FIELD_CONTROLLER | FIELD_GATT
+        };
+
+        /**
+         * @brief Сравнение с другой конфигурацией
+         * @param other Конфигурация для сравнения
+         * @return uint16_t Битовая маска Field отличающихся групп параметров
+         */
+        [[nodiscard]] uint16_t diff(const BleConfig& other) const noexcept;
 
         /**
          * @brief Копирует значения из другой конфигурации
          * @param[in] source Источник данных для копирования
          */
-        void copyFrom(const BleConfig& source) noexcept;
+        constexpr void copyFrom(const BleConfig& source) noexcept
+        {
+            *this = source;
+        }
+
+        /**
+         * @brief Копирует из источника только параметры, применяемые на лету
+         * @param[in] source Новая конфигурация
+         * @details Группы FIELDS_RESTART (параметры контроллера, кроме мощности по умолчанию,
+         *          семейство рекламы BLE 4/BLE 5, приватность, питание, задачи библиотеки и
+         *          GATT) остаются прежними: с ними создан работающий стек.
+         */
+        constexpr void copyLiveFrom(const BleConfig& source) noexcept
+        {
+            const BleConfig running = *this;
+            *this = source;
+            controller = running.controller;
+            controller.txpwr_dft = source.controller.txpwr_dft;
+            privacy = running.privacy;
+            power = running.power;
+            diag = running.diag;
+            rx = running.rx;
+            schedule = running.schedule;
+            gatt = running.gatt;
+            mCurrentPreset = running.mCurrentPreset;
+        }
 
         /**
          * @brief Конфигурация BLE контроллера
@@ -83,8 +297,8 @@ namespace net
          */
         esp_ble_gap_ext_adv_params_t extAdvParams = {
             .type = ESP_BLE_GAP_SET_EXT_ADV_PROP_CONNECTABLE,   ///< Устройство разрешает подключения
-            .interval_min = 0x20,                               ///< Минимальный интервал = 160 мс
-            .interval_max = 0x40,                               ///< Максимальный интервал = 320 мс
+            .interval_min = 0x20,                               ///< Минимальный интервал = 20 мс (0x20 * 0.625 мс)
+            .interval_max = 0x40,                               ///< Максимальный интервал = 40 мс (0x40 * 0.625 мс)
             .channel_map = ADV_CHNL_ALL,                        ///< Использовать все BLE-каналы (37, 38, 39)
             .own_addr_type = BLE_ADDR_TYPE_PUBLIC,              ///< Публичный статический адрес
             .peer_addr_type = BLE_ADDR_TYPE_PUBLIC,             ///< Тип адреса peer-устройства
@@ -102,8 +316,8 @@ namespace net
          * @brief Параметры legacy рекламы (BLE 4.x)
          */
         esp_ble_adv_params_t legacyAdvParams = {
-            .adv_int_min = 0x20,                                    ///< 20ms (минимальный интервал)
-            .adv_int_max = 0x40,                                    ///< 40ms (максимальный интервал)
+            .adv_int_min = 0x20,                                    ///< 20 мс (минимальный интервал)
+            .adv_int_max = 0x40,                                    ///< 40 мс (максимальный интервал)
             .adv_type = ADV_TYPE_IND,                               ///< Connectable undirected advertising
             .own_addr_type = BLE_ADDR_TYPE_PUBLIC,                  ///< Публичный адрес
             .peer_addr = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00},      ///< Не используется
@@ -157,6 +371,23 @@ namespace net
              * @details Аналогично initKey
              */
             uint8_t rspKey = ESP_BLE_ENC_KEY_MASK;
+
+            /**
+             * @brief LE Secure Connections (ECDH P-256)
+             * @details Добавляет флаг SC к authReq; с устройствами без поддержки SC
+             *          сопряжение идет по legacy-схеме, если не задан secureConnectionsOnly.
+             */
+            bool secureConnections = true;
+
+            /**
+             * @brief Отклонять сопряжение без Secure Connections
+             */
+            bool secureConnectionsOnly = false;
+
+            /**
+             * @brief Статический passkey (0 - генерируется стеком для каждого сопряжения)
+             */
+            uint32_t staticPasskey = 0;
         } security;
 
         /**
@@ -167,16 +398,36 @@ namespace net
             /**
              * @brief Предпочитаемые PHY для передачи
              * @details Битовая маска из esp_ble_gap_phy_mask_t:
-             * - ESP_BLE_GAP_PHY_1M
-             * - ESP_BLE_GAP_PHY_2M
-             * - ESP_BLE_GAP_PHY_CODED
+             * - ESP_BLE_GAP_PHY_1M_PREF_MASK
+             * - ESP_BLE_GAP_PHY_2M_PREF_MASK
+             * - ESP_BLE_GAP_PHY_CODED_PREF_MASK
              */
-            esp_ble_gap_phy_mask_t txPhy = ESP_BLE_GAP_PHY_2M | ESP_BLE_GAP_PHY_1M;
+            esp_ble_gap_phy_mask_t txPhy = ESP_BLE_GAP_PHY_2M_PREF_MASK | ESP_BLE_GAP_PHY_1M_PREF_MASK;
 
             /**
              * @brief Предпочитаемые PHY для приема
              */
-            esp_ble_gap_phy_mask_t rxPhy = ESP_BLE_GAP_PHY_2M | ESP_BLE_GAP_PHY_1M;
+            esp_ble_gap_phy_mask_t rxPhy = ESP_BLE_GAP_PHY_2M_PREF_MASK | ESP_BLE_GAP_PHY_1M_PREF_MASK;
+
+            /**
+             * @brief Минимальный интервал соединения (единицы 1.25 мс, 0x0006-0x0C80)
+             */
+            uint16_t minInterval = 0x18; // 30 мс
+
+            /**
+             * @brief Максимальный интервал соединения (единицы 1.25 мс, 0x0006-0x0C80)
+             */
+            uint16_t maxInterval = 0x28; // 50 мс
+
+            /**
+             * @brief Допустимое число пропускаемых событий соединения (slave latency, 0-499)
+             */
+            uint16_t latency = 0;
+
+            /**
+             * @brief Таймаут супервизии (единицы 10 мс, 0x000A-0x0C80)
+             */
+            uint16_t supervisionTimeout = 400; // 4 с
         } connection;
 
         /**
@@ -190,6 +441,238 @@ namespace net
             uint8_t flags = ESP_BLE_ADV_FLAG_GEN_DISC | ESP_BLE_ADV_FLAG_BREDR_NOT_SPT;
         } advertising;
 
+        /**
+         * @brief Политика рекламы после разрыва соединения
+         * @details После разрыва реклама запускается с быстрым интервалом на время
+         *          burstDurationMs, затем возвращается к интервалам пресета.
+         */
+        struct
+        {
+            /**
+             * @brief Автоматически перезапускать рекламу, пока есть свободные слоты соединений
+             */
+            bool autoRestart = true;
+
+            /**
+             * @brief Минимальный интервал рекламы в окне быстрого переподключения (единицы 0.625 мс)
+             */
+            uint16_t fastIntervalMin = 0x30; // 30 мс
+
+            /**
+             * @brief Максимальный интервал рекламы в окне быстрого переподключения (единицы 0.625 мс)
+             */
+            uint16_t fastIntervalMax = 0x50; // 50 мс
+
+            /**
+             * @brief Длительность окна быстрого переподключения, мс (0 - без ускорения)
+             */
+            uint32_t burstDurationMs = 30000;
+
+            /**
+             * @brief Направленная реклама последнему bonded-устройству в окне переподключения
+             * @note Требует постоянного хранилища (BLE::setPersistentStore)
+             */
+            bool directedToLastPeer = false;
+        } reconnect;
+
+        /**
+         * @brief Приватность (Resolvable Private Address)
+         * @details Устройство рекламируется с RPA, которые периодически меняются; адреса
+         *          bonded-устройств разрешает контроллер по списку разрешения (resolving list),
+         *          CPU в разрешении не участвует. Локальный IRK раздается при сопряжении.
+         */
+        struct
+        {
+            /**
+             * @brief Включить RPA (изменение требует перезапуска стека)
+             */
+            bool enabled = false;
+
+            /**
+             * @brief Период смены RPA, с (1-3600)
+             */
+            uint16_t rpaTimeoutS = 900;
+
+            /**
+             * @brief Принимать подключения только от bonded-устройств
+             * @details Реклама использует фильтр по accept list, заполненному
+             *          identity-адресами bonded-устройств. Пока bond'ов нет, фильтр
+             *          не включается, чтобы первое сопряжение было возможно.
+             */
+            bool bondedOnly = false;
+        } privacy;
+
+        /**
+         * @brief Accept list (фильтр подключений)
+         * @details Политика фильтрации задается filter_policy параметров рекламы,
+         *          список - через BLE::addToAcceptList() и связанные методы.
+         */
+        struct
+        {
+            /**
+             * @brief Заносить bonded-устройства в accept list при запуске и после сопряжения
+             */
+            bool autoFromBonds = false;
+        } acceptList;
+
+        /**
+         * @brief Управление питанием (см. BlePowerManager)
+         * @details Учет активности радио ведется всегда; блокировки ESP-IDF PM
+         *          берутся только при enabled и CONFIG_PM_ENABLE.
+         */
+        struct
+        {
+            /**
+             * @brief Удерживать блокировки PM только на время передачи и быстрого профиля
+             */
+            bool enabled = false;
+
+            /**
+             * @brief Порог быстрого профиля: соединения с интервалом не больше (единицы 1.25 мс)
+             *        удерживают блокировки все время
+             */
+            uint16_t fastIntervalMax = 0x0C; // 15 мс
+
+            /**
+             * @brief Удержание блокировок после последней отправки, мс (выгрузка очереди контроллера)
+             */
+            uint32_t txHoldMs = 20;
+
+            /**
+             * @brief Дополнительно удерживать максимальную частоту CPU (ESP_PM_CPU_FREQ_MAX)
+             */
+            bool lockCpuFrequency = true;
+
+            /**
+             * @brief Длина PDU данных для оценки времени работы радио (27 без DLE, до 251)
+             */
+            uint8_t txOctets = 251;
+        } power;
+
+        /**
+         * @brief Диагностика горячего пути (см. BleDiag)
+         * @details Ошибки отправки и приема пишутся бинарными записями и форматируются
+         *          задачей низкого приоритета, вывод каждой точки ограничен.
+         */
+        struct
+        {
+            /**
+             * @brief Форматировать записи в отдельной задаче (false - сразу, в контексте вызова)
+             */
+            bool deferred = true;
+
+            /**
+             * @brief Записей одной точки за окно (0 - только счетчики)
+             */
+            uint8_t burst = 5;
+
+            /**
+             * @brief Окно лимита и период сводок подавленных записей, мс
+             */
+            uint16_t windowMs = 1000;
+
+            /**
+             * @brief Приоритет задачи форматирования
+             */
+            uint8_t taskPriority = 1;
+
+            /**
+             * @brief Размер стека задачи форматирования
+             */
+            uint16_t taskStack = 3072;
+
+            /**
+             * @brief Ядро задачи форматирования (см. BleTask)
+             */
+            int8_t taskCore = BleTask::CORE_AUTO;
+        } diag;
+
+        /**
+         * @brief Доставка принятых данных (см. BleRxDispatcher)
+         * @details По умолчанию callback'и данных вызываются в задаче BTC: пока приложение
+         *          обрабатывает запись, стек не обрабатывает следующие события. С deferred
+         *          записи копируются в буфер и передаются callback'ам задачей ble_rx на ядре,
+         *          свободном от стека.
+         */
+        struct
+        {
+            /**
+             * @brief Вызывать callback'и данных из задачи ble_rx (false - из задачи BTC)
+             */
+            bool deferred = false;
+
+            /**
+             * @brief Буфер принятых записей, байт (при переполнении клиент получает ошибку записи)
+             */
+            uint16_t bufferSize = 4096;
+
+            /**
+             * @brief Приоритет задачи доставки
+             */
+            uint8_t taskPriority = 5;
+
+            /**
+             * @brief Размер стека задачи доставки
+             */
+            uint16_t taskStack = 4096;
+
+            /**
+             * @brief Ядро задачи доставки (см. BleTask)
+             */
+            int8_t taskCore = BleTask::CORE_AUTO;
+        } rx;
+
+        /**
+         * @brief Отправка по событиям соединения (см. BleSendScheduler, BLE::scheduleSend)
+         * @details Уведомления, поставленные scheduleSend, передаются стеку за leadUs до
+         *          расчетного события соединения: задержка до эфира не зависит от того,
+         *          в какой момент интервала вызвана отправка.
+         */
+        struct
+        {
+            /**
+             * @brief Запустить задачу ble_sched (без нее scheduleSend возвращает ESP_ERR_INVALID_STATE)
+             */
+            bool enabled = false;
+
+            /**
+             * @brief Уведомлений в очереди (память выделяется при запуске)
+             */
+            uint8_t queueLength = 8;
+
+            /**
+             * @brief Упреждение передачи стеку перед событием, мкс
+             * @details Должно покрывать путь уведомления через задачу BTC до контроллера
+             */
+            uint16_t leadUs = 2000;
+
+            /**
+             * @brief Все уведомления, попадающие в одно событие, отправлять вместе
+             *        (false - одно уведомление соединения на событие)
+             */
+            bool batch = false;
+
+            /**
+             * @brief Уточнять фазу по каждому N-му событию с отправкой (1 - по каждому)
+             */
+            uint8_t observeEvery = 4;
+
+            /**
+             * @brief Приоритет задачи выпуска
+             */
+            uint8_t taskPriority = 10;
+
+            /**
+             * @brief Размер стека задачи выпуска
+             */
+            uint16_t taskStack = 3072;
+
+            /**
+             * @brief Ядро задачи выпуска (см. BleTask)
+             */
+            int8_t taskCore = BleTask::CORE_AUTO;
+        } schedule;
+
         /**
          * @brief Параметры GATT сервера и характеристик
          */
@@ -203,14 +686,14 @@ namespace net
 
             /**
              * @brief UUID сервиса по умолчанию
-             * @note В формате "6E400001-B5A3-F393-E0A9-E50E24DCCA9E"
+             * @note Задается через BleUuid::fromString("...") или литерал "..."_uuid
              */
-            std::string serviceUuid = "6E400001-B5A3-F393-E0A9-E50E24DCCA9E";
+            BleUuid serviceUuid = NUS_SERVICE_UUID;
 
             /**
              * @brief UUID характеристики по умолчанию
              */
-            std::string charUuid = "6E400002-B5A3-F393-E0A9-E50E24DCCA9E";
+            BleUuid charUuid = NUS_RX_CHAR_UUID;
 
             /**
              * @brief Флаг инверсии байт (актуально для 128-бит UUID)
@@ -227,6 +710,7 @@ namespace net
             esp_gatt_char_prop_t charProperties =
                 ESP_GATT_CHAR_PROP_BIT_READ |
                 ESP_GATT_CHAR_PROP_BIT_WRITE |
+                ESP_GATT_CHAR_PROP_BIT_WRITE_NR |
                 ESP_GATT_CHAR_PROP_BIT_NOTIFY;
 
             /**
@@ -239,14 +723,362 @@ namespace net
             esp_gatt_perm_t charPermissions =
                 ESP_GATT_PERM_READ |
                 ESP_GATT_PERM_WRITE;
+
+            /**
+             * @brief Характеристика потокового приема
+             * @details Запись без ответа складывается в байтовый поток соединения,
+             *          который читается без копирования через BLE::peekBulk()/consumeBulk().
+             *          Запись с ответом также принимается (для клиентов без Write Command).
+             */
+            bool bulkEnabled = false;
+
+            /**
+             * @brief UUID характеристики потокового приема
+             */
+            BleUuid bulkCharUuid = BULK_CHAR_UUID;
+
+            /**
+             * @brief Размер потока на соединение, байт (округляется до степени двойки)
+             */
+            uint32_t bulkBufferSize = 8192;
+
+            /**
+             * @brief Количество потоков (одновременных соединений с потоковым приемом)
+             */
+            uint8_t bulkStreams = 2;
+
+            /**
+             * @brief Транспорт каналов с кредитным управлением потоком
+             * @details Фреймы BleChannelTransport принимаются записью в отдельную
+             *          характеристику и отправляются уведомлениями (см. BLE::getChannels()).
+             */
+            bool channelsEnabled = false;
+
+            /**
+             * @brief UUID характеристики транспорта каналов
+             */
+            BleUuid channelCharUuid = CHANNEL_CHAR_UUID;
+
+            /**
+             * @brief Сжатие данных характеристики данных (см. BleCompression)
+             * @details Добавляет характеристику возможностей; сжатие включается для
+             *          соединения, только если клиент записал в нее свои возможности.
+             */
+            bool compressionEnabled = false;
+
+            /**
+             * @brief UUID характеристики возможностей сжатия
+             */
+            BleUuid compressionCharUuid = COMPRESSION_CHAR_UUID;
+
+            /**
+             * @brief Окно сжатия, бит (8..12: 256 байт..4 КБ на направление соединения)
+             */
+            uint8_t compressionWindowBits = 10;
+
+            /**
+             * @brief Доступ к характеристикам только по зашифрованному каналу
+             * @details Чтение и запись без шифрования отклоняются стеком с Insufficient
+             *          Encryption; устройство само запрашивает шифрование при подключении.
+             */
+            bool requireEncryption = false;
         } gatt;
 
     private:
-        void applyBle5Preset(Preset preset) noexcept;
-        void applyBle4Preset(Preset preset) noexcept;
+        constexpr void applyBle5Preset(Preset preset) noexcept;
+        constexpr void applyBle4Preset(Preset preset) noexcept;
 
         Preset mCurrentPreset = Preset::BLE4_DEFAULT; ///< Текущий активный пресет
     };
+
+    constexpr esp_gatt_perm_t BleConfig::characteristicPermissions() const noexcept
+    {
+        esp_gatt_perm_t permissions = gatt.charPermissions;
+        if (!gatt.requireEncryption)
+        {
+            return permissions;
+        }
+
+        const bool mitm = (security.authReq & ESP_LE_AUTH_REQ_MITM) != 0;
+        if (permissions & (ESP_GATT_PERM_READ | ESP_GATT_PERM_READ_ENCRYPTED))
+        {
+            permissions &= ~(ESP_GATT_PERM_READ | ESP_GATT_PERM_READ_ENCRYPTED);
+            permissions |= mitm ? ESP_GATT_PERM_READ_ENC_MITM : ESP_GATT_PERM_READ_ENCRYPTED;
+        }
+        if (permissions & (ESP_GATT_PERM_WRITE | ESP_GATT_PERM_WRITE_ENCRYPTED))
+        {
+            permissions &= ~(ESP_GATT_PERM_WRITE | ESP_GATT_PERM_WRITE_ENCRYPTED);
+            permissions |= mitm ? ESP_GATT_PERM_WRITE_ENC_MITM : ESP_GATT_PERM_WRITE_ENCRYPTED;
+        }
+        return permissions;
+    }
+
+    constexpr size_t BleConfig::validateAll(const std::span<ValidationIssue> issues) const noexcept
+    {
+        size_t count = 0;
+        const auto report = [&](const ValidationError error, const char* field, const uint32_t value,
+                                const uint32_t min, const uint32_t max, const Unit unit, const char* rule)
+        {
+            if (count < issues.size())
+            {
+                issues[count] = {error, field, value, min, max, unit, rule};
+            }
+            ++count;
+        };
+        const auto check = [&](const ValidationError error, const char* field, const uint32_t value,
+                               const uint32_t min, const uint32_t max, const Unit unit,
+                               const char* rule = nullptr)
+        {
+            if (value < min || value > max)
+            {
+                report(error, field, value, min, max, unit, rule);
+            }
+        };
+
+        check(ValidationError::MAX_ACTIVITIES, "controller.ble_max_act", controller.ble_max_act,
+              1, MAX_ACTIVITIES, Unit::NONE);
+
+        if (supportsExtendedAdvertising())
+        {
+            check(ValidationError::EXT_ADV_DISABLED, "controller.ble_50_feat_supp", controller.ble_50_feat_supp,
+                  1, 1, Unit::NONE, "must be enabled for BLE 5 presets");
+            check(ValidationError::ADV_INTERVAL, "extAdvParams.interval_max", extAdvParams.interval_max,
+                  0x20, 0xFFFFFF, Unit::SLOTS_625);
+            check(ValidationError::ADV_INTERVAL, "extAdvParams.interval_min", extAdvParams.interval_min,
+                  0x20, extAdvParams.interval_max, Unit::SLOTS_625);
+            // Основной канал рекламы - только 1M или Coded (Core Spec, Vol 6, Part B, 2.3.4)
+            if (extAdvParams.primary_phy != ESP_BLE_GAP_PHY_1M && extAdvParams.primary_phy != ESP_BLE_GAP_PHY_CODED)
+            {
+                report(ValidationError::ADV_PHY, "extAdvParams.primary_phy", extAdvParams.primary_phy,
+                       ESP_BLE_GAP_PHY_1M, ESP_BLE_GAP_PHY_CODED, Unit::NONE, "1M or Coded");
+            }
+            check(ValidationError::ADV_PHY, "extAdvParams.secondary_phy", extAdvParams.secondary_phy,
+                  ESP_BLE_GAP_PHY_1M, ESP_BLE_GAP_PHY_CODED, Unit::NONE, "1M, 2M or Coded");
+        }
+        else
+        {
+            check(ValidationError::ADV_INTERVAL, "legacyAdvParams.adv_int_max", legacyAdvParams.adv_int_max,
+                  0x20, 0x4000, Unit::SLOTS_625);
+            check(ValidationError::ADV_INTERVAL, "legacyAdvParams.adv_int_min", legacyAdvParams.adv_int_min,
+                  0x20, legacyAdvParams.adv_int_max, Unit::SLOTS_625);
+        }
+
+        if (reconnect.burstDurationMs != 0)
+        {
+            check(ValidationError::RECONNECT_INTERVAL, "reconnect.fastIntervalMax", reconnect.fastIntervalMax,
+                  0x20, 0x4000, Unit::SLOTS_625);
+            check(ValidationError::RECONNECT_INTERVAL, "reconnect.fastIntervalMin", reconnect.fastIntervalMin,
+                  0x20, reconnect.fastIntervalMax, Unit::SLOTS_625);
+        }
+
+        constexpr uint32_t PHY_MASK_ALL =
+            ESP_BLE_GAP_PHY_1M_PREF_MASK | ESP_BLE_GAP_PHY_2M_PREF_MASK | ESP_BLE_GAP_PHY_CODED_PREF_MASK;
+        check(ValidationError::PHY_MASK, "connection.txPhy", connection.txPhy, 1, PHY_MASK_ALL, Unit::NONE,
+              "non-empty mask of *_PREF_MASK bits");
+        check(ValidationError::PHY_MASK, "connection.rxPhy", connection.rxPhy, 1, PHY_MASK_ALL, Unit::NONE,
+              "non-empty mask of *_PREF_MASK bits");
+
+        check(ValidationError::CONN_INTERVAL, "connection.maxInterval", connection.maxInterval,
+              0x06, 0x0C80, Unit::SLOTS_1250);
+        check(ValidationError::CONN_INTERVAL, "connection.minInterval", connection.minInterval,
+              0x06, connection.maxInterval, Unit::SLOTS_1250);
+        check(ValidationError::CONN_LATENCY, "connection.latency", connection.latency, 0, 499, Unit::NONE);
+
+        // timeout * 10 мс > (1 + latency) * maxInterval * 1.25 мс * 2
+        const uint32_t minTimeout = (1u + connection.latency) * connection.maxInterval / 4 + 1;
+        check(ValidationError::SUPERVISION_TIMEOUT, "connection.supervisionTimeout", connection.supervisionTimeout,
+              minTimeout > 0x0A ? minTimeout : 0x0A, 0x0C80, Unit::SLOTS_10MS);
+
+        check(ValidationError::KEY_SIZE, "security.keySize", security.keySize, 7, 16, Unit::BYTES);
+
+        if (privacy.enabled)
+        {
+            check(ValidationError::RPA_TIMEOUT, "privacy.rpaTimeoutS", privacy.rpaTimeoutS, 1, 3600, Unit::SECONDS);
+        }
+
+        check(ValidationError::DATA_LENGTH, "power.txOctets", power.txOctets, 27, 251, Unit::BYTES);
+
+        if (gatt.compressionEnabled)
+        {
+            check(ValidationError::COMPRESSION_WINDOW, "gatt.compressionWindowBits", gatt.compressionWindowBits,
+                  8, 12, Unit::NONE);
+        }
+
+        if (rx.deferred)
+        {
+            check(ValidationError::RX_BUFFER, "rx.bufferSize", rx.bufferSize, MIN_RX_BUFFER, 0xFFFF, Unit::BYTES);
+        }
+
+        if (schedule.enabled)
+        {
+            check(ValidationError::SCHEDULE, "schedule.queueLength", schedule.queueLength, 1, MAX_SCHEDULE_QUEUE,
+                  Unit::NONE);
+            check(ValidationError::SCHEDULE, "schedule.leadUs", schedule.leadUs, 200, 7500,
+                  Unit::MICROSECONDS);
+        }
+
+        return count;
+    }
+
+    constexpr void BleConfig::applyPreset(const Preset preset) noexcept
+    {
+        mCurrentPreset = preset;
+
+        switch (preset)
+        {
+        case Preset::BLE5_DEFAULT:
+        case Preset::BLE5_LOW_POWER:
+        case Preset::BLE5_ULTRA_PERF:
+            applyBle5Preset(preset);
+            break;
+
+        case Preset::BLE4_DEFAULT:
+        case Preset::BLE4_LOW_POWER:
+        case Preset::BLE4_HIGH_PERF:
+            applyBle4Preset(preset);
+            break;
+
+        default:
+            applyBle5Preset(Preset::BLE5_DEFAULT);
+        }
+    }
+
+    constexpr void BleConfig::applyBle5Preset(const Preset preset) noexcept
+    {
+        // Базовые настройки для BLE 5.x
+        controller = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
+        controller.bluetooth_mode = ESP_BT_MODE_BLE;
+        controller.ble_max_act = 6;
+        extAdvParams.primary_phy = ESP_BLE_GAP_PHY_1M; // 2M на основном канале запрещен спецификацией
+        extAdvParams.secondary_phy = ESP_BLE_GAP_PHY_2M;
+        controller.ble_50_feat_supp = true; // Включаем BLE 5.0 фичи
+        gatt.invertBytes = false;
+        power.txOctets = 251; // DLE
+
+        // Настройки для разных пресетов BLE 5
+        // (интервалы рекламы - единицы 0.625 мс, соединения - 1.25 мс, таймаут - 10 мс)
+        switch (preset)
+        {
+        case Preset::BLE5_ULTRA_PERF:
+            controller.txpwr_dft = ESP_PWR_LVL_P9;
+            controller.sleep_mode = ESP_BT_SLEEP_MODE_NONE;
+            extAdvParams.tx_power = ESP_PWR_LVL_P9;
+            extAdvParams.interval_min = 0x40; // 40 мс
+            extAdvParams.interval_max = 0x60; // 60 мс
+            connection.txPhy = ESP_BLE_GAP_PHY_2M_PREF_MASK;
+            connection.rxPhy = ESP_BLE_GAP_PHY_2M_PREF_MASK;
+            connection.minInterval = 0x06; // 7.5 мс
+            connection.maxInterval = 0x0C; // 15 мс
+            connection.latency = 0;
+            connection.supervisionTimeout = 200; // 2 с
+            break;
+
+        case Preset::BLE5_DEFAULT:
+            controller.txpwr_dft = ESP_PWR_LVL_P6;
+            controller.sleep_mode = ESP_BT_SLEEP_MODE_1;
+            extAdvParams.tx_power = ESP_PWR_LVL_P6;
+            extAdvParams.interval_min = 0x80;  // 80 мс
+            extAdvParams.interval_max = 0x100; // 160 мс
+            connection.txPhy = ESP_BLE_GAP_PHY_2M_PREF_MASK | ESP_BLE_GAP_PHY_1M_PREF_MASK;
+            connection.rxPhy = ESP_BLE_GAP_PHY_2M_PREF_MASK | ESP_BLE_GAP_PHY_1M_PREF_MASK;
+            connection.minInterval = 0x18; // 30 мс
+            connection.maxInterval = 0x28; // 50 мс
+            connection.latency = 0;
+            connection.supervisionTimeout = 400; // 4 с
+            break;
+
+        case Preset::BLE5_LOW_POWER:
+            controller.txpwr_dft = ESP_PWR_LVL_N12;
+            controller.sleep_mode = ESP_BT_SLEEP_MODE_1;
+            extAdvParams.tx_power = ESP_PWR_LVL_N6;
+            extAdvParams.interval_min = 0x200; // 320 мс
+            extAdvParams.interval_max = 0x400; // 640 мс
+            connection.txPhy = ESP_BLE_GAP_PHY_1M_PREF_MASK;
+            connection.rxPhy = ESP_BLE_GAP_PHY_1M_PREF_MASK;
+            connection.minInterval = 0x50; // 100 мс
+            connection.maxInterval = 0xA0; // 200 мс
+            connection.latency = 4;
+            connection.supervisionTimeout = 600; // 6 с
+            break;
+
+        default: ;
+        }
+    }
+
+    constexpr void BleConfig::applyBle4Preset(const Preset preset) noexcept
+    {
+        // Базовые настройки для BLE 4.2
+        controller = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
+        controller.bluetooth_mode = ESP_BT_MODE_BLE;
+        controller.ble_max_act = 3; // Меньше соединений для BLE 4.2
+        controller.ble_50_feat_supp = false; // Отключаем BLE 5.0 фичи
+        power.txOctets = 27;                 // Без DLE: устройства BLE 4.0/4.1 его не поддерживают
+
+        // Настройки legacy рекламы
+        legacyAdvParams.adv_type = ADV_TYPE_IND;
+        legacyAdvParams.channel_map = ADV_CHNL_ALL;
+
+        gatt.invertBytes = true;
+
+        // Настройки для разных пресетов BLE 4
+        // (интервалы рекламы - единицы 0.625 мс, соединения - 1.25 мс, таймаут - 10 мс)
+        switch (preset)
+        {
+        case Preset::BLE4_HIGH_PERF:
+            controller.txpwr_dft = ESP_PWR_LVL_P9;
+            legacyAdvParams.adv_int_min = 0x20; // 20 мс
+            legacyAdvParams.adv_int_max = 0x30; // 30 мс
+            connection.minInterval = 0x06;      // 7.5 мс
+            connection.maxInterval = 0x0C;      // 15 мс
+            connection.latency = 0;
+            connection.supervisionTimeout = 200; // 2 с
+            break;
+
+        case Preset::BLE4_DEFAULT:
+            controller.txpwr_dft = ESP_PWR_LVL_P6;
+            legacyAdvParams.adv_int_min = 0x40; // 40 мс
+            legacyAdvParams.adv_int_max = 0x60; // 60 мс
+            connection.minInterval = 0x18;      // 30 мс
+            connection.maxInterval = 0x28;      // 50 мс
+            connection.latency = 0;
+            connection.supervisionTimeout = 400; // 4 с
+            break;
+
+        case Preset::BLE4_LOW_POWER:
+            controller.txpwr_dft = ESP_PWR_LVL_N12;
+            legacyAdvParams.adv_int_min = 0x80; // 80 мс
+            legacyAdvParams.adv_int_max = 0xC0; // 120 мс
+            connection.minInterval = 0x50;      // 100 мс
+            connection.maxInterval = 0xA0;      // 200 мс
+            connection.latency = 4;
+            connection.supervisionTimeout = 600; // 6 с
+            break;
+
+        default: ;
+        }
+    }
+
+    /**
+     * @brief Встроенные пресеты как константы времени компиляции
+     * @details Прошивка с фиксированным пресетом передает константу в BLE(const BleConfig&),
+     *          и конфигурация не строится во время выполнения.
+     */
+    namespace presets
+    {
+        inline constexpr BleConfig BLE5_DEFAULT{BleConfig::Preset::BLE5_DEFAULT};
+        inline constexpr BleConfig BLE5_LOW_POWER{BleConfig::Preset::BLE5_LOW_POWER};
+        inline constexpr BleConfig BLE5_ULTRA_PERF{BleConfig::Preset::BLE5_ULTRA_PERF};
+        inline constexpr BleConfig BLE4_DEFAULT{BleConfig::Preset::BLE4_DEFAULT};
+        inline constexpr BleConfig BLE4_LOW_POWER{BleConfig::Preset::BLE4_LOW_POWER};
+        inline constexpr BleConfig BLE4_HIGH_PERF{BleConfig::Preset::BLE4_HIGH_PERF};
+
+        static_assert(BLE5_DEFAULT.isValid(), "BLE5_DEFAULT preset is invalid");
+        static_assert(BLE5_LOW_POWER.isValid(), "BLE5_LOW_POWER preset is invalid");
+        static_assert(BLE5_ULTRA_PERF.isValid(), "BLE5_ULTRA_PERF preset is invalid");
+        static_assert(BLE4_DEFAULT.isValid(), "BLE4_DEFAULT preset is invalid");
+        static_assert(BLE4_LOW_POWER.isValid(), "BLE4_LOW_POWER preset is invalid");
+        static_assert(BLE4_HIGH_PERF.isValid(), "BLE4_HIGH_PERF preset is invalid");
+    } // namespace presets
 } // namespace net::ble
 
 #endif //NET_BLE_CONFIG_H
@@ -0,0 +1,187 @@
+#ifndef NET_BLE_DIAG_H
+#define NET_BLE_DIAG_H
+
+#include "ble_config.h"
+#include "ble_ring.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace net
+{
+    /**
+     * @brief Точки диагностики горячего пути (у каждой свой лимит и счетчики)
+     */
+    enum class BleDiagEvent : uint8_t
+    {
+        SEND_INVALID_ARGS,   ///< sendData: неверные параметры (arg0 - длина, arg1 - MTU)
+        SEND_NO_CONNECTIONS, ///< sendData: broadcast без соединений
+        SEND_CONN_NOT_FOUND, ///< sendToDevice: соединение не найдено
+        SEND_NO_CREDITS,     ///< sendToDevice: нет кредитов контроллера (error - код)
+        SEND_FAILED,         ///< sendToDevice: ошибка esp_ble_gatts_send_indicate (error - код)
+        RX_NULL_PARAM,       ///< handleWriteEvent: пустые параметры события
+        RX_NO_CALLBACK,      ///< handleWriteEvent: callback данных не назначен
+        RX_INVALID_HANDLE,   ///< handleWriteEvent: чужой хэндл (arg0 - хэндл, arg1 - ожидаемый)
+        RX_INVALID_SIZE,     ///< handleWriteEvent: недопустимая длина (arg0 - длина, arg1 - максимум)
+        RX_PAYLOAD_FAILED,   ///< handleWriteEvent: ошибка заполнения пакета (arg0 - длина)
+        RX_RESPONSE_FAILED,  ///< handleWrite/ReadEvent: ошибка отправки ответа (error - код)
+        SEND_TOO_LARGE,      ///< sendToDevice: кадр сжатия не помещается в MTU (arg0 - длина, arg1 - предел)
+        RX_DECODE_FAILED,    ///< handleWriteEvent: поврежденный кадр сжатия (arg0 - длина)
+        RX_QUEUE_FULL,       ///< handleWriteEvent: буфер задачи доставки заполнен (arg0 - длина)
+        RX_STALE_CONNECTION, ///< deliverData: соединение закрыто до доставки записи (arg0 - длина)
+        COUNT                ///< Количество точек
+    };
+
+    /**
+     * @brief Бинарная запись диагностики (форматируется задачей диагностики)
+     */
+    struct BleDiagRecord
+    {
+        int64_t timeUs;     ///< Время события, мкс
+        esp_err_t error;    ///< Код ошибки ESP-IDF (ESP_OK - нет)
+        uint32_t arg0;      ///< Аргумент события (см. BleDiagEvent)
+        uint32_t arg1;      ///< Аргумент события (см. BleDiagEvent)
+        uint16_t connId;    ///< Идентификатор соединения
+        BleDiagEvent event; ///< Точка диагностики
+    };
+
+    /**
+     * @brief Диагностика горячего пути с отложенным форматированием
+     * @details record() не форматирует строки и не пишет в UART: запись из нескольких
+     *          чисел копируется в lock-free кольцевой буфер, текст формирует задача
+     *          низкого приоритета. У каждой точки свой лимит - не больше
+     *          BleConfig::diag.burst записей за diag.windowMs; сверх лимита растет только
+     *          счетчик подавленных, и раз в окно задача выводит сводку
+     *          ("Send failed: 37 suppressed"). При переполнении буфера запись
+     *          отбрасывается и учитывается отдельно.
+     *          Без задачи (до begin() или при diag.deferred = false) записи в пределах
+     *          лимита выводятся сразу.
+     * @warning record() - сторона производителя SpscRing: вызовы должны быть
+     *          сериализованы (в BLE - мьютексом BLE)
+     */
+    class BleDiag
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_DIAG";
+
+        /// @brief Емкость кольцевого буфера записей
+        static constexpr size_t RING_SIZE = 64;
+
+        /// @brief Количество точек диагностики
+        static constexpr size_t EVENT_COUNT = static_cast<size_t>(BleDiagEvent::COUNT);
+
+        /**
+         * @brief Счетчики точки диагностики
+         */
+        struct Counters
+        {
+            uint32_t total;      ///< Всего событий
+            uint32_t logged;     ///< Выведено в лог
+            uint32_t suppressed; ///< Подавлено лимитом
+            uint32_t dropped;    ///< Потеряно из-за переполнения буфера
+        };
+
+        BleDiag() = default;
+        ~BleDiag();
+
+        // Запрет копирования и присваивания
+        BleDiag(const BleDiag&) = delete;
+        BleDiag& operator=(const BleDiag&) = delete;
+
+        /**
+         * @brief Запуск задачи форматирования
+         * @param config Конфигурация (используется группа diag)
+         * @return esp_err_t ESP_ERR_NO_MEM, если задачу создать не удалось
+         */
+        esp_err_t begin(const BleConfig& config);
+
+        /**
+         * @brief Остановка задачи (накопленные записи выводятся до выхода)
+         */
+        void end();
+
+        /**
+         * @brief Регистрация события горячего пути
+         * @param event Точка диагностики
+         * @param connId Идентификатор соединения
+         * @param error Код ошибки ESP-IDF
+         * @param arg0 Аргумент события
+         * @param arg1 Аргумент события
+         */
+        void record(BleDiagEvent event, uint16_t connId, esp_err_t error = ESP_OK,
+                    uint32_t arg0 = 0, uint32_t arg1 = 0) noexcept;
+
+        /**
+         * @brief Снимок счетчиков точки
+         */
+        [[nodiscard]] Counters getCounters(BleDiagEvent event) const noexcept;
+
+        /**
+         * @brief Сумма счетчиков по всем точкам
+         */
+        [[nodiscard]] Counters getTotals() const noexcept;
+
+        /**
+         * @brief Сброс счетчиков (записи в буфере сохраняются)
+         */
+        void resetCounters() noexcept;
+
+        /**
+         * @brief Имя точки для сводок
+         */
+        static const char* eventName(BleDiagEvent event) noexcept;
+
+    private:
+        /**
+         * @brief Состояние точки диагностики
+         */
+        struct Site
+        {
+            int64_t windowStartUs = 0;            ///< Начало окна лимита (только производитель)
+            uint32_t windowCount = 0;             ///< Записей в текущем окне (только производитель)
+            std::atomic<uint32_t> total = 0;      ///< Всего событий
+            std::atomic<uint32_t> logged = 0;     ///< Выведено в лог
+            std::atomic<uint32_t> suppressed = 0; ///< Подавлено лимитом
+            std::atomic<uint32_t> dropped = 0;    ///< Потеряно при переполнении
+            uint32_t reportedSuppressed = 0;      ///< Подавлено на момент последней сводки
+            uint32_t reportedDropped = 0;         ///< Потеряно на момент последней сводки
+        };
+
+        /**
+         * @brief Форматирование и вывод записи
+         */
+        void emit(const BleDiagRecord& record) noexcept;
+
+        /**
+         * @brief Вывод сводки подавленных и потерянных записей с прошлой сводки
+         */
+        void reportSuppressed() noexcept;
+
+        /**
+         * @brief Вывод сводки одной точки
+         */
+        void reportSite(size_t index) noexcept;
+
+        /**
+         * @brief Тело задачи форматирования
+         */
+        static void formatterTask(void* arg);
+
+        std::array<Site, EVENT_COUNT> mSites;      ///< Точки диагностики
+        SpscRing<BleDiagRecord, RING_SIZE> mRing;  ///< Буфер записей
+        std::atomic<TaskHandle_t> mTask = nullptr; ///< Задача форматирования
+        std::atomic<bool> mRunning = false;        ///< Задача форматирования работает
+        uint32_t mBurst = 5;                       ///< Записей на точку за окно
+        int64_t mWindowUs = 1000000;               ///< Окно лимита, мкс
+    };
+} // namespace net
+
+#endif // NET_BLE_DIAG_H
@@ -0,0 +1,296 @@
+#ifndef NET_BLE_GATT_CLIENT_H
+#define NET_BLE_GATT_CLIENT_H
+
+#include "ble_tx_scheduler.h"
+#include "ble_uuid.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "esp_bt_defs.h"
+#include "esp_gattc_api.h"
+
+#include "freertos/FreeRTOS.h"
+
+namespace net
+{
+    /**
+     * @brief GATT клиент для обмена данными с удаленными периферийными устройствами
+     * @details Поддерживает несколько одновременных соединений. Для каждого соединения:
+     *          - обнаружение одного сервиса и таблица хэндлов его характеристик
+     *            (кэшируется по адресу устройства, повторное подключение обходится
+     *            без обнаружения до индикации Service Changed);
+     *          - асинхронные чтение и запись с ответом (completion вызывается в порядке ATT);
+     *          - подписка на уведомления/индикации;
+     *          - пакетная запись без ответа, ограниченная кредитами контроллера
+     *            через общий с сервером BleTxScheduler.
+     */
+    class BleGattClient
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_GATTC";
+
+        /// @brief Максимальное количество одновременных клиентских соединений
+        static constexpr size_t MAX_CONNECTIONS = 4;
+
+        /// @brief Количество устройств в кэше таблиц хэндлов
+        static constexpr size_t MAX_CACHED_PEERS = 4;
+
+        /**
+         * @brief Callback готовности соединения (обнаружение завершено)
+         * @note Вызывается повторно после переобнаружения по Service Changed
+         */
+        using ReadyCallback = std::function<void(uint16_t connId, esp_err_t status)>;
+
+        /**
+         * @brief Callback завершения операции чтения/записи
+         * @note data/len заполнены только для чтения
+         */
+        using Completion = std::function<void(esp_err_t status, const uint8_t* data, size_t len)>;
+
+        /**
+         * @brief Callback входящих уведомлений и индикаций
+         */
+        using NotifyCallback = std::function<void(uint16_t connId, uint16_t handle,
+                                                  const uint8_t* data, size_t len)>;
+
+        /**
+         * @brief Характеристика в таблице хэндлов
+         */
+        struct Characteristic
+        {
+            BleUuid uuid;                    ///< UUID характеристики
+            uint16_t handle;                 ///< Хэндл значения
+            esp_gatt_char_prop_t properties; ///< Свойства
+        };
+
+        /**
+         * @brief Счетчики клиента
+         */
+        struct Statistics
+        {
+            uint32_t connects;      ///< Успешных подключений
+            uint32_t discoveries;   ///< Полных обнаружений сервиса
+            uint32_t cacheHits;     ///< Подключений с таблицей хэндлов из кэша
+            uint32_t reads;         ///< Завершенных чтений
+            uint32_t writes;        ///< Завершенных записей с ответом
+            uint32_t notifications; ///< Принятых уведомлений и индикаций
+            uint64_t rxBytes;       ///< Принято байт в уведомлениях
+        };
+
+        /**
+         * @param scheduler Планировщик передачи, общий с сервером
+         * @param appId Идентификатор приложения GATTC
+         */
+        BleGattClient(BleTxScheduler& scheduler, uint16_t appId);
+
+        // Запрет копирования и присваивания
+        BleGattClient(const BleGattClient&) = delete;
+        BleGattClient& operator=(const BleGattClient&) = delete;
+
+        /**
+         * @brief Регистрация приложения GATTC
+         * @return esp_err_t Код ошибки ESP-IDF
+         * @note Обработчик событий GATTC должен быть зарегистрирован заранее
+         */
+        esp_err_t registerApp();
+
+        /**
+         * @brief Снятие регистрации и закрытие всех соединений
+         */
+        void shutdown();
+
+        /**
+         * @brief Подключение к устройству и обнаружение сервиса
+         * @param address Адрес устройства
+         * @param addrType Тип адреса
+         * @param service UUID сервиса, характеристики которого попадут в таблицу хэндлов
+         * @param onReady Callback готовности
+         * @param extended Подключение через расширенную рекламу (BLE 5.0)
+         * @return esp_err_t ESP_ERR_NO_MEM, если все слоты соединений заняты
+         * @note До завершения регистрации приложения подключение откладывается
+         */
+        esp_err_t connect(const esp_bd_addr_t address, esp_ble_addr_type_t addrType,
+                          const BleUuid& service, ReadyCallback onReady, bool extended = false);
+
+        /**
+         * @brief Отключение от устройства
+         * @param connId Идентификатор соединения
+         * @return esp_err_t Код ошибки ESP-IDF
+         */
+        esp_err_t disconnect(uint16_t connId);
+
+        /**
+         * @brief Поиск хэндла характеристики в таблице соединения
+         * @param connId Идентификатор соединения
+         * @param uuid UUID характеристики
+         * @param[out] handle Хэндл значения
+         * @return esp_err_t ESP_ERR_NOT_FOUND, если соединение или характеристика не найдены
+         */
+        esp_err_t findCharacteristic(uint16_t connId, const BleUuid& uuid, uint16_t& handle) const;
+
+        /**
+         * @brief Подписка на уведомления или индикации
+         * @param connId Идентификатор соединения
+         * @param handle Хэндл значения характеристики
+         * @param indicate true - индикации, false - уведомления
+         * @param completion Callback завершения записи CCCD
+         * @return esp_err_t ESP_ERR_INVALID_STATE, если предыдущая подписка не завершена
+         */
+        esp_err_t subscribe(uint16_t connId, uint16_t handle, bool indicate, Completion completion);
+
+        /**
+         * @brief Асинхронное чтение характеристики
+         */
+        esp_err_t read(uint16_t connId, uint16_t handle, Completion completion);
+
+        /**
+         * @brief Асинхронная запись с ответом
+         */
+        esp_err_t write(uint16_t connId, uint16_t handle, const uint8_t* data, size_t len,
+                        Completion completion);
+
+        /**
+         * @brief Пакетная запись без ответа
+         * @param connId Идентификатор соединения
+         * @param handle Хэндл значения характеристики
+         * @param data Данные (делятся на фрагменты MTU - 3)
+         * @param len Размер данных
+         * @param creditTimeout Таймаут ожидания кредита контроллера на каждый фрагмент
+         * @return esp_err_t ESP_ERR_TIMEOUT, если кредиты не освободились
+         * @details Фрагменты отправляются подряд, пока у контроллера есть свободные
+         *          буферы; при их исчерпании вызывающая задача ждет возврата кредитов.
+         * @warning Блокирующий вызов, нельзя вызывать из callback'ов BLE
+         */
+        esp_err_t writeBurst(uint16_t connId, uint16_t handle, const uint8_t* data, size_t len,
+                             TickType_t creditTimeout);
+
+        /**
+         * @brief Установка callback'а уведомлений
+         */
+        void setNotifyCallback(NotifyCallback callback);
+
+        /**
+         * @brief Обработка событий GATTC
+         */
+        void handleEvent(esp_gattc_cb_event_t event, esp_gatt_if_t gattcIf, esp_ble_gattc_cb_param_t* param);
+
+        /**
+         * @brief MTU соединения (23, если соединение не найдено)
+         */
+        [[nodiscard]] uint16_t getMtu(uint16_t connId) const;
+
+        /**
+         * @brief Количество установленных клиентских соединений
+         */
+        [[nodiscard]] size_t getConnectionCount() const;
+
+        /**
+         * @brief Получить снимок счетчиков
+         */
+        [[nodiscard]] Statistics getStatistics() const;
+
+    private:
+        /**
+         * @brief Состояние клиентского соединения
+         */
+        enum class State : uint8_t
+        {
+            FREE,        ///< Слот свободен
+            OPENING,     ///< Ожидание OPEN_EVT
+            DISCOVERING, ///< Обнаружение сервиса
+            READY        ///< Таблица хэндлов готова
+        };
+
+        /**
+         * @brief Клиентское соединение
+         */
+        struct Connection
+        {
+            State state = State::FREE;                           ///< Состояние
+            bool openPending = false;                            ///< Открытие отложено до регистрации
+            bool extended = false;                               ///< Подключение через расширенную рекламу
+            uint16_t connId = 0;                                 ///< Идентификатор соединения
+            esp_bd_addr_t address = {};                          ///< Адрес устройства
+            esp_ble_addr_type_t addrType = BLE_ADDR_TYPE_PUBLIC; ///< Тип адреса
+            uint16_t mtu = 23;                                   ///< MTU соединения
+            BleUuid service;                                     ///< UUID обнаруживаемого сервиса
+            uint16_t startHandle = 0;                            ///< Начальный хэндл сервиса
+            uint16_t endHandle = 0;                              ///< Конечный хэндл сервиса
+            std::vector<Characteristic> chars;                   ///< Таблица хэндлов
+            std::deque<Completion> pending;                      ///< Ожидающие ответа операции (порядок ATT)
+            uint16_t subscribeHandle = 0;                        ///< Хэндл незавершенной подписки
+            uint16_t subscribeValue = 0;                         ///< Значение CCCD для подписки
+            Completion subscribeCompletion;                      ///< Completion подписки
+            ReadyCallback onReady;                               ///< Callback готовности
+        };
+
+        /**
+         * @brief Кэш таблицы хэндлов устройства
+         */
+        struct CacheEntry
+        {
+            bool valid = false;                ///< Запись заполнена
+            esp_bd_addr_t address = {};        ///< Адрес устройства
+            BleUuid service;                   ///< UUID сервиса
+            std::vector<Characteristic> chars; ///< Таблица хэндлов
+        };
+
+        Connection* findByConnId(uint16_t connId) noexcept;
+        const Connection* findByConnId(uint16_t connId) const noexcept;
+        Connection* findByAddress(const esp_bd_addr_t address) noexcept;
+
+        /**
+         * @brief Отправка запроса на открытие соединения
+         */
+        esp_err_t openConnection(Connection& conn) const;
+
+        /**
+         * @brief Запуск обнаружения сервиса
+         */
+        void startDiscovery(Connection& conn);
+
+        /**
+         * @brief Заполнение таблицы хэндлов после SEARCH_CMPL_EVT
+         */
+        void completeDiscovery(Connection& conn);
+
+        /**
+         * @brief Запись CCCD после регистрации уведомлений в стеке
+         */
+        void writeCccd(Connection& conn);
+
+        /**
+         * @brief Завершение первой ожидающей операции соединения
+         */
+        static void completePending(Connection& conn, esp_gatt_status_t status,
+                                    const uint8_t* data, size_t len);
+
+        /**
+         * @brief Освобождение слота с отменой ожидающих операций
+         */
+        static void releaseConnection(Connection& conn);
+
+        CacheEntry* findCache(const esp_bd_addr_t address, const BleUuid& service) noexcept;
+        void storeCache(const Connection& conn);
+        void dropCache(const esp_bd_addr_t address) noexcept;
+
+        BleTxScheduler& mScheduler;                           ///< Общий планировщик передачи
+        const uint16_t mAppId;                                ///< Идентификатор приложения GATTC
+        esp_gatt_if_t mGattcIf = ESP_GATT_IF_NONE;            ///< Интерфейс GATTC
+        mutable std::recursive_mutex mMutex;                  ///< Мьютекс для потокобезопасности
+        std::array<Connection, MAX_CONNECTIONS> mConnections; ///< Слоты соединений
+        std::array<CacheEntry, MAX_CACHED_PEERS> mCache;      ///< Кэш таблиц хэндлов
+        size_t mCacheNext = 0;                                ///< Индекс вытесняемой записи кэша
+        NotifyCallback mNotifyCallback;                       ///< Callback уведомлений
+        Statistics mStats = {};                               ///< Счетчики
+    };
+} // namespace net
+
+#endif // NET_BLE_GATT_CLIENT_H
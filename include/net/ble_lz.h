@@ -0,0 +1,144 @@
+#ifndef NET_BLE_LZ_H
+#define NET_BLE_LZ_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace net
+{
+    /**
+     * @brief Параметры потокового кодека LZSS (класс heatshrink)
+     * @details Формат: группы из байта флагов и до 8 элементов (бит 0 - первый элемент).
+     *          Флаг 0 - литерал (1 байт), флаг 1 - ссылка (2 байта):
+     *          [(dist - 1) >> 8 : 4 | (len - 3) : 4] [(dist - 1) & 0xFF], при (len - 3) == 15
+     *          следует байт добавки к длине. Ссылка может указывать в окно прошлых кадров
+     *          соединения и в уже декодированную часть текущего; допускается перекрытие.
+     *          Кодер и декодер ведут одинаковое окно: после каждого кадра сохраняются
+     *          последние 2^windowBits байт исходных данных.
+     */
+    struct BleLz
+    {
+        /// @brief Минимальный размер окна, бит
+        static constexpr uint8_t MIN_WINDOW_BITS = 8;
+
+        /// @brief Максимальный размер окна, бит (дистанция ссылки - 12 бит)
+        static constexpr uint8_t MAX_WINDOW_BITS = 12;
+
+        /// @brief Минимальная длина ссылки
+        static constexpr size_t MIN_MATCH = 3;
+
+        /// @brief Максимальная длина ссылки
+        static constexpr size_t MAX_MATCH = MIN_MATCH + 15 + 255;
+
+        /// @brief Максимальная дистанция ссылки
+        static constexpr size_t MAX_DISTANCE = 1u << 12;
+
+        /**
+         * @brief Размер сжатых данных в худшем случае (только литералы)
+         */
+        static constexpr size_t maxCompressedSize(const size_t len) noexcept { return len + (len + 7) / 8; }
+    };
+
+    /**
+     * @brief Кодер потока кадров с общим окном
+     * @details Память: окно + максимальный кадр и таблица хэшей на 256 позиций (1 КБ).
+     *          Поиск - одна позиция-кандидат на хэш трех байт (как в LZ4), без цепочек:
+     *          на повторяющейся телеметрии этого достаточно, а время на байт постоянно.
+     */
+    class BleLzEncoder
+    {
+    public:
+        /**
+         * @param windowBits Размер окна, бит (MIN_WINDOW_BITS..MAX_WINDOW_BITS)
+         * @param maxInput Максимальный размер кадра
+         */
+        BleLzEncoder(uint8_t windowBits, size_t maxInput);
+
+        /**
+         * @brief Сжатие кадра
+         * @param in Исходные данные (не больше maxInput)
+         * @param len Длина
+         * @param out Буфер результата
+         * @param capacity Размер буфера результата
+         * @return size_t Длина сжатых данных (0 - не поместились в capacity)
+         * @details Кадр становится частью окна только после commit(): если он не был
+         *          отправлен, следующий вызов compress() его заменяет.
+         */
+        size_t compress(const uint8_t* in, size_t len, uint8_t* out, size_t capacity) noexcept;
+
+        /**
+         * @brief Добавление последнего кадра в окно (кадр доставлен, сжатым или как есть)
+         */
+        void commit() noexcept;
+
+        /**
+         * @brief Сброс окна
+         */
+        void reset() noexcept;
+
+    private:
+        static constexpr size_t HASH_BITS = 8;
+
+        /**
+         * @brief Хэш трех байт
+         */
+        static size_t hash(const uint8_t* data) noexcept;
+
+        std::vector<uint8_t> mBuffer;                 ///< Окно и текущий кадр
+        size_t mWindow;                               ///< Размер окна, байт
+        size_t mHistory = 0;                          ///< Байт окна в буфере
+        size_t mPending = 0;                          ///< Длина несохраненного кадра
+        uint32_t mBase = 0;                           ///< Позиция потока начала буфера
+        std::array<uint32_t, 1u << HASH_BITS> mHash;  ///< Позиция потока + 1 (0 - пусто)
+    };
+
+    /**
+     * @brief Декодер потока кадров с общим окном
+     */
+    class BleLzDecoder
+    {
+    public:
+        /**
+         * @param windowBits Размер окна, бит (как у кодера отправителя)
+         * @param maxOutput Максимальный размер исходного кадра
+         */
+        BleLzDecoder(uint8_t windowBits, size_t maxOutput);
+
+        /**
+         * @brief Распаковка кадра
+         * @param in Сжатые данные
+         * @param len Длина
+         * @param[out] out Исходные данные во внутреннем буфере (действительны до следующего вызова)
+         * @return bool false - поврежденные данные (окно не меняется)
+         */
+        bool decompress(const uint8_t* in, size_t len, std::span<const uint8_t>& out) noexcept;
+
+        /**
+         * @brief Кадр, переданный без сжатия (добавляется в окно)
+         * @return bool false - кадр длиннее maxOutput
+         */
+        bool store(const uint8_t* in, size_t len, std::span<const uint8_t>& out) noexcept;
+
+        /**
+         * @brief Сброс окна
+         */
+        void reset() noexcept;
+
+    private:
+        /**
+         * @brief Перенос прошлого кадра в окно
+         */
+        void commit() noexcept;
+
+        std::vector<uint8_t> mBuffer; ///< Окно и текущий кадр
+        size_t mWindow;               ///< Размер окна, байт
+        size_t mMaxOutput;            ///< Максимальный размер кадра
+        size_t mHistory = 0;          ///< Байт окна в буфере
+        size_t mPending = 0;          ///< Длина последнего кадра
+    };
+} // namespace net
+
+#endif // NET_BLE_LZ_H
@@ -0,0 +1,60 @@
+#ifndef NET_BLE_OBSERVER_H
+#define NET_BLE_OBSERVER_H
+
+#include <cstdint>
+
+#include "esp_bt_defs.h"
+
+namespace net
+{
+    /**
+     * @brief Наблюдатель жизненного цикла соединений (роль peripheral)
+     * @details Все методы необязательны: реализация по умолчанию ничего не делает.
+     *          В onConnect удобно создать состояние клиента и привязать его к соединению
+     *          через BLE::setConnectionHandler: данные этого клиента придут вместе с указателем
+     *          на состояние, без поиска по таблице на каждом пакете.
+     * @warning Вызывается из задачи BTC без мьютекса BLE: методы должны возвращаться быстро,
+     *          вызовы API BLE из них допустимы.
+     */
+    class BleConnectionObserver
+    {
+    public:
+        virtual ~BleConnectionObserver() = default;
+
+        /**
+         * @brief Клиент подключен (после проверки accept list)
+         * @param connId Идентификатор соединения
+         * @param address Адрес клиента
+         * @param interval Интервал соединения (единицы 1.25 мс)
+         */
+        virtual void onConnect(uint16_t connId, const esp_bd_addr_t address, uint16_t interval) {}
+
+        /**
+         * @brief Клиент отключен (состояние соединения уже освобождено)
+         * @param connId Идентификатор соединения
+         * @param reason Причина разрыва (esp_gatt_conn_reason_t)
+         * @param context Контекст соединения, переданный в setConnectionHandler
+         */
+        virtual void onDisconnect(uint16_t connId, int reason, void* context) {}
+
+        /**
+         * @brief Согласован MTU
+         */
+        virtual void onMtu(uint16_t connId, uint16_t mtu) {}
+
+        /**
+         * @brief Изменен PHY (ESP_BLE_GAP_PHY_*)
+         */
+        virtual void onPhy(uint16_t connId, uint8_t txPhy, uint8_t rxPhy) {}
+
+        /**
+         * @brief Изменены параметры соединения
+         * @param interval Интервал (единицы 1.25 мс)
+         * @param latency Slave latency
+         * @param timeout Supervision timeout (единицы 10 мс)
+         */
+        virtual void onConnParams(uint16_t connId, uint16_t interval, uint16_t latency, uint16_t timeout) {}
+    };
+} // namespace net
+
+#endif // NET_BLE_OBSERVER_H
@@ -0,0 +1,179 @@
+#ifndef NET_BLE_PERSISTENCE_H
+#define NET_BLE_PERSISTENCE_H
+
+#include "ble_config.h"
+#include "ble_storage.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "esp_bt_defs.h"
+
+namespace net
+{
+    /**
+     * @brief Постоянное хранение GATT раскладки и списка bonded-устройств
+     * @details Сохраняет хэш описания GATT базы и полученные хэндлы. Если после
+     *          перезагрузки база не изменилась, Service Changed не отправляется и
+     *          bonded-клиенты продолжают использовать кэш обнаружения сервисов.
+     *          При изменении базы индикация Service Changed отправляется каждому
+     *          bonded-устройству при его следующем подключении.
+     * @note Bluedroid хранит GATT базу в RAM, поэтому сама база создается заново
+     *       при каждом запуске; сохраняется только ее описание.
+     */
+    class BlePersistence
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_PERSIST";
+
+        /// @brief Максимальное количество хранимых bonded-устройств
+        static constexpr size_t MAX_BONDS = 8;
+
+        /// @brief Максимальное количество хранимых хэндлов
+        static constexpr size_t MAX_HANDLES = 8;
+
+        /**
+         * @brief Флаги bonded-устройства
+         */
+        enum BondFlags : uint8_t
+        {
+            BOND_SERVICE_CHANGED = 1 << 0 ///< Требуется индикация Service Changed
+        };
+
+        /**
+         * @brief Запись о bonded-устройстве
+         */
+        struct BondEntry
+        {
+            esp_bd_addr_t address; ///< Адрес устройства
+            uint8_t addrType;      ///< Тип адреса (esp_ble_addr_type_t)
+            uint8_t flags;         ///< Флаги BondFlags
+        };
+
+        /**
+         * @brief Сохраняемая раскладка GATT базы
+         */
+        struct GattLayout
+        {
+            uint16_t version;                          ///< Версия формата записи
+            uint16_t count;                            ///< Количество хэндлов
+            uint32_t dbHash;                           ///< Хэш описания базы
+            std::array<uint16_t, MAX_HANDLES> handles; ///< Хэндлы атрибутов
+        };
+
+        /**
+         * @param store Бэкенд хранилища (NvsKeyValueStore, FileKeyValueStore и т.д.)
+         */
+        explicit BlePersistence(std::unique_ptr<BleKeyValueStore> store);
+
+        /**
+         * @brief Загрузка сохраненных данных
+         * @return esp_err_t ESP_OK (отсутствие данных - не ошибка)
+         */
+        esp_err_t load();
+
+        /**
+         * @brief Хэш описания GATT базы (UUID, свойства, права доступа)
+         * @param config Конфигурация BLE
+         * @return uint32_t FNV-1a хэш
+         */
+        static uint32_t computeDatabaseHash(const BleConfig& config) noexcept;
+
+        /**
+         * @brief Начало загрузки с указанным хэшем базы
+         * @param dbHash Хэш текущего описания базы
+         * @return bool true - "теплая" загрузка (база совпадает с сохраненной)
+         */
+        bool beginBoot(uint32_t dbHash) noexcept;
+
+        /**
+         * @brief Фиксация фактических хэндлов после создания базы
+         * @param handles Массив хэндлов
+         * @param count Количество хэндлов (не больше MAX_HANDLES)
+         * @return bool true, если база изменилась относительно сохраненной
+         */
+        bool commitLayout(const uint16_t* handles, size_t count);
+
+        /**
+         * @brief Добавление (обновление) bonded-устройства
+         */
+        esp_err_t recordBond(const esp_bd_addr_t address, uint8_t addrType);
+
+        /**
+         * @brief Удаление bonded-устройства
+         */
+        esp_err_t removeBond(const esp_bd_addr_t address);
+
+        /**
+         * @brief Проверка наличия устройства в списке bonded
+         */
+        [[nodiscard]] bool isBonded(const esp_bd_addr_t address) const noexcept;
+
+        /**
+         * @brief Проверка и сброс флага Service Changed для устройства
+         * @return bool true, если устройству нужно отправить индикацию
+         */
+        bool takeServiceChanged(const esp_bd_addr_t address);
+
+        /**
+         * @brief Запомнить последнее подключенное bonded-устройство
+         */
+        esp_err_t setLastPeer(const esp_bd_addr_t address);
+
+        /**
+         * @brief Последнее подключенное bonded-устройство
+         * @param[out] entry Запись об устройстве
+         * @return bool false, если устройство неизвестно
+         */
+        bool lastPeer(BondEntry& entry) const noexcept;
+
+        /**
+         * @brief Количество bonded-устройств и доступ к записям
+         */
+        [[nodiscard]] size_t bondCount() const noexcept { return mBonds.count; }
+        [[nodiscard]] const BondEntry& bond(const size_t index) const noexcept { return mBonds.entries[index]; }
+
+        /**
+         * @brief Признак "теплой" загрузки
+         */
+        [[nodiscard]] bool isWarmBoot() const noexcept { return mWarmBoot; }
+
+    private:
+        /// @brief Версия формата записей
+        static constexpr uint16_t FORMAT_VERSION = 1;
+
+        /// @brief Индекс отсутствующего устройства
+        static constexpr uint8_t NO_INDEX = 0xFF;
+
+        /**
+         * @brief Таблица bonded-устройств в формате хранения
+         */
+        struct BondTable
+        {
+            uint16_t version;                          ///< Версия формата записи
+            uint8_t count;                             ///< Количество записей
+            uint8_t lastIndex;                         ///< Индекс последнего подключенного
+            std::array<BondEntry, MAX_BONDS> entries;  ///< Записи
+        };
+
+        /**
+         * @brief Поиск записи по адресу
+         * @return int Индекс или -1
+         */
+        [[nodiscard]] int findBond(const esp_bd_addr_t address) const noexcept;
+
+        esp_err_t saveLayout();
+        esp_err_t saveBonds();
+
+        std::unique_ptr<BleKeyValueStore> mStore; ///< Бэкенд хранилища
+        GattLayout mLayout = {};                  ///< Сохраненная раскладка
+        BondTable mBonds = {};                    ///< Таблица bonded-устройств
+        uint32_t mBootHash = 0;                   ///< Хэш базы текущей загрузки
+        bool mWarmBoot = false;                   ///< Признак "теплой" загрузки
+    };
+} // namespace net
+
+#endif // NET_BLE_PERSISTENCE_H
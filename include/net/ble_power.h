@@ -0,0 +1,229 @@
+#ifndef NET_BLE_POWER_H
+#define NET_BLE_POWER_H
+
+#include "ble_config.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "esp_err.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+
+namespace net
+{
+    /**
+     * @brief Оценка энергопотребления соединения
+     * @details Время работы радио оценивается по модели: каждое событие соединения
+     *          (с учетом slave latency) - пробуждение и обмен пустыми пакетами,
+     *          каждый пакет данных - время передачи на текущем PHY, T_IFS и подтверждение.
+     *          Значения предназначены для сравнения пресетов, а не для абсолютного расчета.
+     */
+    struct BleLinkEnergy
+    {
+        uint32_t connectedMs;      ///< Время с момента подключения, мс
+        uint16_t interval;         ///< Текущий интервал соединения (единицы 1.25 мс)
+        uint16_t latency;          ///< Текущий slave latency
+        uint8_t txPhy;             ///< Текущий PHY передачи (ESP_BLE_GAP_PHY_*)
+        bool fastProfile;          ///< Соединение в быстром профиле (удерживает PM блокировку)
+        uint32_t connectionEvents; ///< Оценка количества событий соединения
+        uint32_t txPackets;        ///< Отправлено пакетов данных (с учетом фрагментации)
+        uint64_t txBytes;          ///< Отправлено байт приложения
+        uint32_t rxPackets;        ///< Принято пакетов данных (с учетом фрагментации)
+        uint64_t rxBytes;          ///< Принято байт приложения
+        uint64_t radioOnUs;        ///< Оценка времени работы радио, мкс
+        uint64_t idleUs;           ///< Время без обмена данными, мкс
+        uint16_t dutyPermille;     ///< Доля работы радио, ‰
+    };
+
+    /**
+     * @brief Управление блокировками питания и учет активности радио
+     * @details Блокировки ESP-IDF PM (ESP_PM_NO_LIGHT_SLEEP и, по настройке,
+     *          ESP_PM_CPU_FREQ_MAX) удерживаются, только пока идет отправка
+     *          (плюс BleConfig::power.txHoldMs после последнего пакета, чтобы контроллер
+     *          успел выгрузить очередь) или хотя бы одно соединение работает в быстром
+     *          профиле (интервал не больше power.fastIntervalMax). В простое блокировки
+     *          отпускаются, и система может уйти в light sleep с modem sleep контроллера.
+     *          Без CONFIG_PM_ENABLE блокировки не создаются, учет энергии работает.
+     */
+    class BlePowerManager
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_PM";
+
+        /**
+         * @brief Счетчики блокировок питания
+         */
+        struct Statistics
+        {
+            bool lockHeld;             ///< Блокировка удерживается сейчас
+            uint32_t lockAcquisitions; ///< Количество захватов блокировки
+            uint64_t lockHeldUs;       ///< Суммарное время удержания, мкс
+        };
+
+        BlePowerManager() = default;
+        ~BlePowerManager();
+
+        // Запрет копирования и присваивания
+        BlePowerManager(const BlePowerManager&) = delete;
+        BlePowerManager& operator=(const BlePowerManager&) = delete;
+
+        /**
+         * @brief Запуск (создание блокировок и таймера удержания)
+         * @param config Конфигурация (используется группа power)
+         * @return esp_err_t Код ошибки ESP-IDF; отсутствие CONFIG_PM_ENABLE ошибкой не считается
+         */
+        esp_err_t begin(const BleConfig& config);
+
+        /**
+         * @brief Остановка: отпускание и удаление блокировок, сброс соединений
+         */
+        void end();
+
+        /**
+         * @brief Новое соединение
+         * @param connId Идентификатор соединения
+         * @param interval Интервал соединения (единицы 1.25 мс)
+         * @param latency Slave latency
+         */
+        void onConnect(uint16_t connId, uint16_t interval, uint16_t latency);
+
+        /**
+         * @brief Разрыв соединения
+         */
+        void onDisconnect(uint16_t connId);
+
+        /**
+         * @brief Изменение параметров соединения
+         */
+        void onConnectionParams(uint16_t connId, uint16_t interval, uint16_t latency);
+
+        /**
+         * @brief Изменение PHY соединения
+         * @param txPhy PHY передачи (ESP_BLE_GAP_PHY_1M/2M/CODED)
+         */
+        void onPhyUpdate(uint16_t connId, uint8_t txPhy);
+
+        /**
+         * @brief Начало отправки (блокировка захватывается до txEnd() + txHoldMs)
+         */
+        void txBegin();
+
+        /**
+         * @brief Завершение отправки
+         * @param connId Идентификатор соединения
+         * @param bytes Отправлено байт приложения (0 - отправка не удалась)
+         */
+        void txEnd(uint16_t connId, size_t bytes);
+
+        /**
+         * @brief Прием данных от клиента
+         */
+        void onRx(uint16_t connId, size_t bytes);
+
+        /**
+         * @brief Оценка энергопотребления соединения
+         * @param[out] energy Снимок оценки
+         * @return esp_err_t ESP_ERR_NOT_FOUND, если соединение не найдено
+         */
+        esp_err_t getLinkEnergy(uint16_t connId, BleLinkEnergy& energy) const;
+
+        /**
+         * @brief Снимок счетчиков блокировок
+         */
+        [[nodiscard]] Statistics getStatistics() const;
+
+        /**
+         * @brief Время передачи пакета канального уровня
+         * @param phy PHY (ESP_BLE_GAP_PHY_1M/2M/CODED, Coded считается как S8)
+         * @param payload Длина полезной нагрузки PDU, байт
+         * @return uint32_t Время в эфире, мкс
+         */
+        static constexpr uint32_t packetAirtimeUs(const uint8_t phy, const uint32_t payload) noexcept
+        {
+            switch (phy)
+            {
+            case ESP_BLE_GAP_PHY_2M: return (11 + payload) * 4;
+            case ESP_BLE_GAP_PHY_CODED: return 400 + (5 + payload) * 64;
+            default: return (10 + payload) * 8;
+            }
+        }
+
+    private:
+        /// @brief Межкадровый интервал T_IFS, мкс
+        static constexpr uint32_t T_IFS_US = 150;
+
+        /// @brief Пробуждение и подготовка радио к событию соединения, мкс
+        static constexpr uint32_t WAKEUP_US = 400;
+
+        /// @brief Заголовки L2CAP (4) и ATT (3)
+        static constexpr uint32_t L2CAP_ATT_OVERHEAD = 7;
+
+        /**
+         * @brief Учет соединения
+         */
+        struct Link
+        {
+            uint16_t connId = 0;                ///< Идентификатор соединения
+            uint16_t interval = 0x18;           ///< Интервал соединения (единицы 1.25 мс)
+            uint16_t latency = 0;               ///< Slave latency
+            uint8_t txPhy = ESP_BLE_GAP_PHY_1M; ///< PHY передачи
+            int64_t connectedUs = 0;            ///< Время подключения
+            int64_t integratedUs = 0;           ///< Момент последнего учета событий
+            int64_t lastActivityUs = 0;         ///< Момент последнего обмена данными
+            double events = 0.0;                ///< Оценка событий соединения
+            uint64_t radioOnUs = 0;             ///< Оценка времени работы радио
+            uint64_t activeUs = 0;              ///< Время с обменом данными
+            uint32_t txPackets = 0;             ///< Пакетов данных отправлено
+            uint64_t txBytes = 0;               ///< Байт отправлено
+            uint32_t rxPackets = 0;             ///< Пакетов данных принято
+            uint64_t rxBytes = 0;               ///< Байт принято
+        };
+
+        Link* findLink(uint16_t connId) noexcept;
+        const Link* findLink(uint16_t connId) const noexcept;
+
+        /**
+         * @brief Учет событий соединения до момента now
+         */
+        void integrate(Link& link, int64_t now) const noexcept;
+
+        /**
+         * @brief Учет пакета данных (фрагментация по power.txOctets)
+         * @return uint32_t Количество пакетов канального уровня
+         */
+        uint32_t accountData(Link& link, size_t bytes, int64_t now) const noexcept;
+
+        [[nodiscard]] bool isFast(const Link& link) const noexcept;
+        [[nodiscard]] size_t fastLinkCount() const noexcept;
+
+        /**
+         * @brief Захват или отпускание блокировок по текущему состоянию
+         */
+        void updateLock();
+
+        static void holdTimerCallback(void* arg);
+
+        mutable std::recursive_mutex mMutex;         ///< Мьютекс для потокобезопасности
+        bool mStarted = false;                       ///< Менеджер запущен
+        bool mManageLocks = false;                   ///< Управлять блокировками (power.enabled)
+        uint16_t mFastIntervalMax = 0x0C;            ///< Порог быстрого профиля
+        uint32_t mTxHoldUs = 20000;                  ///< Удержание после отправки, мкс
+        uint8_t mTxOctets = 251;                     ///< Длина PDU данных для оценки
+        esp_pm_lock_handle_t mNoSleepLock = nullptr; ///< Блокировка light sleep
+        esp_pm_lock_handle_t mCpuLock = nullptr;     ///< Блокировка частоты CPU
+        esp_timer_handle_t mHoldTimer = nullptr;     ///< Таймер удержания после отправки
+        uint32_t mTxInFlight = 0;                    ///< Незавершенных отправок
+        bool mTxHold = false;                        ///< Идет удержание после отправки
+        bool mLockHeld = false;                      ///< Блокировки захвачены
+        int64_t mLockSinceUs = 0;                    ///< Момент захвата
+        uint32_t mLockAcquisitions = 0;              ///< Количество захватов
+        uint64_t mLockHeldUs = 0;                    ///< Суммарное время удержания
+        std::vector<Link> mLinks;                    ///< Соединения
+    };
+} // namespace net
+
+#endif // NET_BLE_POWER_H
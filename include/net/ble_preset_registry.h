@@ -0,0 +1,130 @@
+#ifndef NET_BLE_PRESET_REGISTRY_H
+#define NET_BLE_PRESET_REGISTRY_H
+
+#include "ble_config.h"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string_view>
+
+#include "esp_err.h"
+
+namespace net
+{
+    /**
+     * @brief Реестр именованных пресетов конфигурации
+     * @details Содержит шесть встроенных пресетов (имена совпадают с BleConfig::Preset:
+     *          "BLE5_DEFAULT", "BLE4_LOW_POWER" и т.д.) и до MAX_CUSTOM пользовательских.
+     *          Встроенные пресеты ссылаются на константы net::presets и не занимают RAM.
+     *          Пользовательский пресет перед регистрацией проходит BleConfig::validateAll(),
+     *          нарушения выводятся в лог в физических единицах.
+     */
+    class BlePresetRegistry
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_PRESETS";
+
+        /// @brief Максимальное количество пользовательских пресетов
+        static constexpr size_t MAX_CUSTOM = 4;
+
+        /// @brief Максимальная длина имени пресета
+        static constexpr size_t MAX_NAME_LENGTH = 23;
+
+        /// @brief Максимальное количество нарушений, выводимых в лог при регистрации
+        static constexpr size_t MAX_REPORTED_ISSUES = 8;
+
+        /**
+         * @brief Callback перечисления пресетов
+         * @param name Имя пресета
+         * @param config Конфигурация
+         * @param builtIn true - встроенный пресет
+         */
+        using Visitor = std::function<void(std::string_view name, const BleConfig& config, bool builtIn)>;
+
+        BlePresetRegistry() = default;
+
+        // Запрет копирования и присваивания
+        BlePresetRegistry(const BlePresetRegistry&) = delete;
+        BlePresetRegistry& operator=(const BlePresetRegistry&) = delete;
+
+        /**
+         * @brief Регистрация пользовательского пресета
+         * @param name Имя (1..MAX_NAME_LENGTH символов, не совпадает со встроенными)
+         * @param config Конфигурация
+         * @return esp_err_t ESP_ERR_INVALID_ARG - недопустимое имя или конфигурация не прошла проверку,
+         *         ESP_ERR_INVALID_STATE - имя занято встроенным пресетом, ESP_ERR_NO_MEM - реестр заполнен
+         * @note Пресет с уже зарегистрированным пользовательским именем заменяется
+         */
+        esp_err_t add(std::string_view name, const BleConfig& config);
+
+        /**
+         * @brief Удаление пользовательского пресета
+         * @return esp_err_t ESP_ERR_NOT_FOUND, если пресет не найден; ESP_ERR_INVALID_STATE для встроенного
+         */
+        esp_err_t remove(std::string_view name);
+
+        /**
+         * @brief Поиск пресета по имени
+         * @param name Имя пресета
+         * @param[out] config Копия конфигурации
+         * @return esp_err_t ESP_ERR_NOT_FOUND, если пресет не найден
+         */
+        esp_err_t find(std::string_view name, BleConfig& config) const;
+
+        /**
+         * @brief Перечисление всех пресетов (сначала встроенные)
+         * @warning Visitor вызывается под мьютексом реестра
+         */
+        void forEach(const Visitor& visitor) const;
+
+        /**
+         * @brief Количество пресетов (встроенные + пользовательские)
+         */
+        [[nodiscard]] size_t size() const;
+
+        /**
+         * @brief Проверка конфигурации с выводом всех нарушений в лог
+         * @param name Имя для сообщений
+         * @param config Конфигурация
+         * @return bool true, если нарушений нет
+         */
+        static bool validate(std::string_view name, const BleConfig& config);
+
+    private:
+        /**
+         * @brief Встроенный пресет
+         */
+        struct BuiltIn
+        {
+            std::string_view name;   ///< Имя (совпадает с BleConfig::Preset)
+            const BleConfig* config; ///< Константа из net::presets
+        };
+
+        /**
+         * @brief Пользовательский пресет
+         */
+        struct Custom
+        {
+            bool used = false;                           ///< Слот занят
+            std::array<char, MAX_NAME_LENGTH> name = {}; ///< Имя (без завершающего нуля)
+            size_t nameLength = 0;                       ///< Длина имени
+            BleConfig config;                            ///< Конфигурация
+
+            [[nodiscard]] std::string_view view() const noexcept { return {name.data(), nameLength}; }
+        };
+
+        static const BuiltIn* findBuiltIn(std::string_view name) noexcept;
+        Custom* findCustom(std::string_view name) noexcept;
+        const Custom* findCustom(std::string_view name) const noexcept;
+
+        static const std::array<BuiltIn, 6> BUILT_IN; ///< Встроенные пресеты
+
+        mutable std::recursive_mutex mMutex;    ///< Мьютекс для потокобезопасности
+        std::array<Custom, MAX_CUSTOM> mCustom; ///< Пользовательские пресеты
+    };
+} // namespace net
+
+#endif // NET_BLE_PRESET_REGISTRY_H
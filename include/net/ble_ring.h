@@ -0,0 +1,229 @@
+#ifndef NET_BLE_RING_H
+#define NET_BLE_RING_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+
+namespace net
+{
+    /**
+     * @brief Lock-free кольцевой буфер для одного производителя и одного потребителя
+     * @tparam T Тип элемента (копируемый)
+     * @tparam N Емкость буфера (степень двойки)
+     * @details Производитель (например, обработчик событий GAP) и потребитель (рабочая
+     *          задача) могут работать одновременно без мьютексов. Переполнение не
+     *          блокирует производителя: push() возвращает false.
+     */
+    template <typename T, size_t N>
+    class SpscRing
+    {
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "Ring capacity must be a power of two");
+
+    public:
+        /**
+         * @brief Добавление элемента (только производитель)
+         * @return bool false, если буфер заполнен
+         */
+        bool push(const T& item) noexcept
+        {
+            const size_t head = mHead.load(std::memory_order_relaxed);
+            if (head - mTail.load(std::memory_order_acquire) == N)
+            {
+                return false;
+            }
+
+            mItems[head & (N - 1)] = item;
+            mHead.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Получение ссылки на слот для записи без копирования (только производитель)
+         * @return T* Слот или nullptr, если буфер заполнен
+         * @note После заполнения слота необходимо вызвать commit()
+         */
+        T* reserve() noexcept
+        {
+            const size_t head = mHead.load(std::memory_order_relaxed);
+            if (head - mTail.load(std::memory_order_acquire) == N)
+            {
+                return nullptr;
+            }
+            return &mItems[head & (N - 1)];
+        }
+
+        /**
+         * @brief Публикация слота, полученного через reserve() (только производитель)
+         */
+        void commit() noexcept
+        {
+            mHead.store(mHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Извлечение элемента (только потребитель)
+         * @return bool false, если буфер пуст
+         */
+        bool pop(T& item) noexcept
+        {
+            const size_t tail = mTail.load(std::memory_order_relaxed);
+            if (mHead.load(std::memory_order_acquire) == tail)
+            {
+                return false;
+            }
+
+            item = mItems[tail & (N - 1)];
+            mTail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Доступ к первому элементу без копирования (только потребитель)
+         * @return const T* Элемент или nullptr, если буфер пуст
+         * @note После обработки необходимо вызвать release()
+         */
+        const T* front() const noexcept
+        {
+            const size_t tail = mTail.load(std::memory_order_relaxed);
+            if (mHead.load(std::memory_order_acquire) == tail)
+            {
+                return nullptr;
+            }
+            return &mItems[tail & (N - 1)];
+        }
+
+        /**
+         * @brief Освобождение элемента, полученного через front() (только потребитель)
+         */
+        void release() noexcept
+        {
+            mTail.store(mTail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Текущее количество элементов (приблизительно при конкурентном доступе)
+         */
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Проверка на пустоту
+         */
+        [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+        /**
+         * @brief Емкость буфера
+         */
+        static constexpr size_t capacity() noexcept { return N; }
+
+    private:
+        std::array<T, N> mItems = {};  ///< Элементы
+        std::atomic<size_t> mHead = 0; ///< Индекс записи (производитель)
+        std::atomic<size_t> mTail = 0; ///< Индекс чтения (потребитель)
+    };
+
+    /**
+     * @brief Lock-free байтовый поток для одного производителя и одного потребителя
+     * @details Производитель дописывает данные произвольной длины, потребитель читает
+     *          их на месте: peek() возвращает непрерывный участок буфера, consume()
+     *          освобождает прочитанное. Емкость задается при создании (степень двойки).
+     */
+    class SpscByteRing
+    {
+    public:
+        /**
+         * @param capacity Емкость буфера, байт (округляется вверх до степени двойки)
+         */
+        explicit SpscByteRing(size_t capacity) :
+            mCapacity(std::bit_ceil(std::max<size_t>(capacity, 2))),
+            mData(std::make_unique<uint8_t[]>(mCapacity))
+        {
+        }
+
+        // Запрет копирования и присваивания
+        SpscByteRing(const SpscByteRing&) = delete;
+        SpscByteRing& operator=(const SpscByteRing&) = delete;
+
+        /**
+         * @brief Запись данных (только производитель)
+         * @return size_t Записано байт (меньше len, если буфер заполнен)
+         */
+        size_t write(const uint8_t* data, const size_t len) noexcept
+        {
+            const size_t head = mHead.load(std::memory_order_relaxed);
+            const size_t free = mCapacity - (head - mTail.load(std::memory_order_acquire));
+            const size_t count = std::min(len, free);
+
+            const size_t offset = head & (mCapacity - 1);
+            const size_t first = std::min(count, mCapacity - offset);
+            std::memcpy(mData.get() + offset, data, first);
+            std::memcpy(mData.get(), data + first, count - first);
+
+            mHead.store(head + count, std::memory_order_release);
+            return count;
+        }
+
+        /**
+         * @brief Непрерывный участок непрочитанных данных (только потребитель)
+         * @return std::span<const uint8_t> Данные до конца буфера или до head
+         * @note Если данные переходят через конец буфера, остаток доступен
+         *       следующим вызовом peek() после consume()
+         */
+        [[nodiscard]] std::span<const uint8_t> peek() const noexcept
+        {
+            const size_t tail = mTail.load(std::memory_order_relaxed);
+            const size_t available = mHead.load(std::memory_order_acquire) - tail;
+            const size_t offset = tail & (mCapacity - 1);
+            return {mData.get() + offset, std::min(available, mCapacity - offset)};
+        }
+
+        /**
+         * @brief Освобождение прочитанных данных (только потребитель)
+         * @param len Количество байт (не больше доступного)
+         */
+        void consume(const size_t len) noexcept
+        {
+            const size_t tail = mTail.load(std::memory_order_relaxed);
+            const size_t available = mHead.load(std::memory_order_acquire) - tail;
+            mTail.store(tail + std::min(len, available), std::memory_order_release);
+        }
+
+        /**
+         * @brief Сброс буфера (при отсутствии конкурентного доступа)
+         */
+        void reset() noexcept
+        {
+            mTail.store(mHead.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        /**
+         * @brief Количество непрочитанных байт
+         */
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Емкость буфера, байт
+         */
+        [[nodiscard]] size_t capacity() const noexcept { return mCapacity; }
+
+    private:
+        const size_t mCapacity;           ///< Емкость (степень двойки)
+        std::unique_ptr<uint8_t[]> mData; ///< Данные
+        std::atomic<size_t> mHead = 0;    ///< Позиция записи (производитель)
+        std::atomic<size_t> mTail = 0;    ///< Позиция чтения (потребитель)
+    };
+} // namespace net
+
+#endif // NET_BLE_RING_H
@@ -0,0 +1,146 @@
+#ifndef NET_BLE_RX_DISPATCH_H
+#define NET_BLE_RX_DISPATCH_H
+
+#include "packets/packet.h"
+#include "ble_config.h"
+#include "ble_ring.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+
+#include "esp_err.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace net
+{
+    /**
+     * @brief Доставка принятых записей приложению из отдельной задачи
+     * @details Задача BTC только копирует запись ([заголовок, данные]) в lock-free буфер и
+     *          будит задачу ble_rx; callback'и приложения вызываются из нее, на ядре,
+     *          заданном BleConfig::rx.taskCore. Порядок записей сохраняется. Если записи
+     *          нет места, post() возвращает false: запись с ответом получает ошибку (клиент
+     *          повторяет), запись без ответа теряется и учитывается в Statistics::rejected.
+     * @warning post() - сторона производителя SpscByteRing: вызовы должны быть
+     *          сериализованы (в BLE - задача BTC под мьютексом BLE)
+     */
+    class BleRxDispatcher
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_RX";
+
+        /**
+         * @brief Получатель записи
+         * @param connId Идентификатор соединения
+         * @param generation Номер подключения, переданный в post()
+         * @param data Данные (действительны только на время вызова)
+         */
+        using Sink = std::function<void(uint16_t connId, uint32_t generation, std::span<const uint8_t> data)>;
+
+        /**
+         * @brief Счетчики доставки
+         */
+        struct Statistics
+        {
+            uint32_t delivered;      ///< Доставлено записей
+            uint32_t rejected;       ///< Не принято записей (буфер заполнен)
+            uint32_t maxQueuedBytes; ///< Максимальное заполнение буфера, байт
+            uint32_t maxLatencyUs;   ///< Максимальная задержка от приема до вызова, мкс
+            uint64_t totalLatencyUs; ///< Суммарная задержка, мкс (среднее - / delivered)
+        };
+
+        BleRxDispatcher() = default;
+        ~BleRxDispatcher();
+
+        // Запрет копирования и присваивания
+        BleRxDispatcher(const BleRxDispatcher&) = delete;
+        BleRxDispatcher& operator=(const BleRxDispatcher&) = delete;
+
+        /**
+         * @brief Запуск задачи доставки
+         * @param config Конфигурация (используется группа rx)
+         * @param sink Получатель записей
+         * @return esp_err_t ESP_ERR_NO_MEM, если задачу или буфер создать не удалось
+         * @note При rx.deferred = false задача не создается и isRunning() возвращает false
+         */
+        esp_err_t begin(const BleConfig& config, Sink sink);
+
+        /**
+         * @brief Остановка задачи (принятые записи доставляются до выхода)
+         * @warning Нельзя вызывать под мьютексом, который захватывает получатель
+         */
+        void end();
+
+        /**
+         * @brief Задача доставки работает
+         */
+        [[nodiscard]] bool isRunning() const noexcept { return mRunning; }
+
+        /**
+         * @brief Постановка записи в очередь (задача BTC)
+         * @param generation Номер подключения: получатель отбрасывает записи закрытого соединения
+         * @return bool false - записи нет места в буфере или она длиннее MAX_MTU
+         */
+        bool post(uint16_t connId, uint32_t generation, const uint8_t* data, size_t len) noexcept;
+
+        /**
+         * @brief Снимок счетчиков
+         */
+        [[nodiscard]] Statistics getStatistics() const noexcept;
+
+        /**
+         * @brief Сброс счетчиков
+         */
+        void resetStatistics() noexcept;
+
+    private:
+        /**
+         * @brief Заголовок записи в буфере
+         */
+        struct Header
+        {
+            uint32_t timeUs;     ///< Время приема (младшие 32 бита esp_timer_get_time)
+            uint32_t generation; ///< Номер подключения
+            uint16_t connId;     ///< Идентификатор соединения
+            uint16_t len;        ///< Длина данных
+        };
+
+        /**
+         * @brief Копирование из буфера с переходом через его конец
+         */
+        void read(uint8_t* out, size_t len) noexcept;
+
+        /**
+         * @brief Доставка всех полностью записанных записей
+         */
+        void drain();
+
+        /**
+         * @brief Тело задачи доставки
+         */
+        static void dispatchTask(void* arg);
+
+        std::unique_ptr<SpscByteRing> mRing;       ///< Буфер записей
+        std::array<uint8_t, MAX_MTU> mRecord = {}; ///< Запись, перешедшая через конец буфера (задача ble_rx)
+        Header mHeader = {};                       ///< Заголовок доставляемой записи (задача ble_rx)
+        bool mHasHeader = false;                   ///< Заголовок прочитан, данные еще пишутся
+        Sink mSink;                                ///< Получатель записей
+        std::atomic<TaskHandle_t> mTask = nullptr; ///< Задача доставки
+        std::atomic<bool> mRunning = false;        ///< Задача доставки работает
+
+        std::atomic<uint32_t> mDelivered = 0;      ///< Счетчик доставленных записей
+        std::atomic<uint32_t> mRejected = 0;       ///< Счетчик непринятых записей
+        std::atomic<uint32_t> mMaxQueued = 0;      ///< Максимальное заполнение буфера
+        std::atomic<uint32_t> mMaxLatencyUs = 0;   ///< Максимальная задержка доставки
+        std::atomic<uint64_t> mTotalLatencyUs = 0; ///< Суммарная задержка доставки
+    };
+} // namespace net
+
+#endif // NET_BLE_RX_DISPATCH_H
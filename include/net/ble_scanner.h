@@ -0,0 +1,212 @@
+#ifndef NET_BLE_SCANNER_H
+#define NET_BLE_SCANNER_H
+
+#include "ble_ring.h"
+#include "ble_task.h"
+#include "ble_uuid.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+#include "esp_bt_defs.h"
+#include "esp_gap_ble_api.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace net
+{
+    /**
+     * @brief Параметры сканирования (роль observer/central)
+     */
+    struct BleScanConfig
+    {
+        /// @brief Максимальная длина префикса имени для фильтра
+        static constexpr size_t MAX_NAME_PREFIX = 16;
+
+        uint16_t interval = 0x50; ///< Интервал сканирования (единицы 0.625 мс) = 50 мс
+        uint16_t window = 0x30;   ///< Окно сканирования (единицы 0.625 мс) = 30 мс
+        bool active = false;      ///< Активное сканирование (scan request)
+        bool coded = false;       ///< Дополнительно сканировать Coded PHY
+        uint32_t durationMs = 0;  ///< Длительность сканирования, мс (0 - непрерывно)
+
+        int8_t minRssi = -127;                          ///< Отбрасывать отчеты слабее порога, дБм
+        BleUuid serviceUuid;                            ///< Фильтр по UUID сервиса (невалидный - без фильтра)
+        std::array<char, MAX_NAME_PREFIX> namePrefix{}; ///< Фильтр по префиксу имени (пустой - без фильтра)
+        uint32_t dedupWindowMs = 1000;                  ///< Окно подавления дубликатов, мс (0 - без подавления)
+
+        UBaseType_t taskPriority = 5;         ///< Приоритет задачи-потребителя
+        uint32_t taskStack = 4096;            ///< Размер стека задачи-потребителя
+        int8_t taskCore = BleTask::CORE_AUTO; ///< Ядро задачи-потребителя (см. BleTask)
+
+        /**
+         * @brief Установка фильтра по префиксу имени
+         * @param prefix Префикс (обрезается до MAX_NAME_PREFIX символов)
+         */
+        void setNamePrefix(std::string_view prefix) noexcept;
+
+        /**
+         * @brief Длина префикса имени
+         */
+        [[nodiscard]] size_t namePrefixLength() const noexcept;
+    };
+
+    /**
+     * @brief Отчет о рекламном пакете
+     */
+    struct BleScanReport
+    {
+        /// @brief Максимальный размер рекламных данных в отчете
+        static constexpr size_t MAX_DATA_LEN = 251;
+
+        int64_t timestampUs;                    ///< Время приема, мкс
+        esp_bd_addr_t address;                  ///< Адрес рекламирующего устройства
+        uint8_t addrType;                       ///< Тип адреса
+        uint8_t eventType;                      ///< Тип события (битовая маска HCI)
+        uint8_t primaryPhy;                     ///< Основная PHY
+        uint8_t secondaryPhy;                   ///< Вторичная PHY
+        int8_t rssi;                            ///< Уровень сигнала, дБм
+        int8_t txPower;                         ///< Мощность передачи (127 - неизвестна)
+        uint8_t dataLen;                        ///< Длина рекламных данных
+        std::array<uint8_t, MAX_DATA_LEN> data; ///< Рекламные данные
+    };
+
+    /**
+     * @brief Сканер рекламы с потоковой обработкой отчетов
+     * @details Обработчик событий GAP выполняет только дешевые операции: ранние фильтры
+     *          (RSSI, UUID сервиса, префикс имени), подавление дубликатов по хэш-таблице
+     *          фиксированного размера и копирование в lock-free кольцевой буфер.
+     *          Callback пользователя вызывается из отдельной задачи-потребителя.
+     */
+    class BleScanner
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_SCAN";
+
+        /// @brief Емкость кольцевого буфера отчетов
+        static constexpr size_t RING_SIZE = 32;
+
+        /// @brief Размер таблицы подавления дубликатов (степень двойки)
+        static constexpr size_t DEDUP_TABLE_SIZE = 256;
+
+        /**
+         * @brief Callback обработки отчета (вызывается из задачи-потребителя)
+         */
+        using ResultCallback = std::function<void(const BleScanReport&)>;
+
+        /**
+         * @brief Счетчики сканера
+         */
+        struct Statistics
+        {
+            uint32_t received;   ///< Отчетов получено от стека
+            uint32_t filtered;   ///< Отброшено ранними фильтрами
+            uint32_t duplicates; ///< Подавлено как дубликаты
+            uint32_t dropped;    ///< Потеряно из-за переполнения буфера
+            uint32_t processed;  ///< Передано в callback
+        };
+
+        BleScanner() = default;
+        ~BleScanner();
+
+        // Запрет копирования и присваивания
+        BleScanner(const BleScanner&) = delete;
+        BleScanner& operator=(const BleScanner&) = delete;
+
+        /**
+         * @brief Запуск сканирования
+         * @param config Параметры сканирования
+         * @param callback Callback обработки отчетов
+         * @return esp_err_t Код ошибки ESP-IDF
+         * @note Сканирование начинается после ESP_GAP_BLE_SET_EXT_SCAN_PARAMS_COMPLETE_EVT.
+         *       Сканирование с durationMs завершается по ESP_GAP_BLE_SCAN_TIMEOUT_EVT.
+         */
+        esp_err_t start(const BleScanConfig& config, ResultCallback callback);
+
+        /**
+         * @brief Остановка сканирования и задачи-потребителя
+         * @return esp_err_t Код ошибки ESP-IDF
+         * @note Допускается вызов из callback: задача-потребитель завершится после
+         *       возврата из него, без ожидания
+         */
+        esp_err_t stop();
+
+        /**
+         * @brief Обработка событий GAP, относящихся к сканированию
+         * @param event Событие GAP
+         * @param param Параметры события
+         * @return bool true, если событие обработано сканером
+         */
+        bool handleGapEvent(esp_gap_ble_cb_event_t event, const esp_ble_gap_cb_param_t* param);
+
+        /**
+         * @brief Прием отчета о рекламе (контекст производителя)
+         * @param report Отчет стека
+         * @note Вызывается из обработчика GAP; может вызываться генератором отчетов
+         *       для измерения пропускной способности.
+         */
+        void submitReport(const esp_ble_gap_ext_adv_reprot_t& report) noexcept;
+
+        /**
+         * @brief Получить снимок счетчиков
+         */
+        [[nodiscard]] Statistics getStatistics() const noexcept;
+
+        /**
+         * @brief Сброс счетчиков и таблицы дубликатов
+         */
+        void resetStatistics() noexcept;
+
+        /**
+         * @brief Проверка активности сканирования
+         */
+        [[nodiscard]] bool isScanning() const noexcept { return mScanning.load(); }
+
+    private:
+        /**
+         * @brief Запись таблицы подавления дубликатов
+         */
+        struct DedupEntry
+        {
+            uint32_t key;      ///< Хэш адреса и данных (0 - пустая запись)
+            uint32_t lastSeen; ///< Время последнего приема, мс
+        };
+
+        /**
+         * @brief Проверка ранних фильтров
+         */
+        [[nodiscard]] bool passesFilters(const esp_ble_gap_ext_adv_reprot_t& report) const noexcept;
+
+        /**
+         * @brief Проверка и регистрация дубликата
+         * @return bool true, если отчет - дубликат в пределах окна
+         */
+        bool isDuplicate(const esp_ble_gap_ext_adv_reprot_t& report, uint32_t nowMs) noexcept;
+
+        /**
+         * @brief Тело задачи-потребителя
+         */
+        static void consumerTask(void* arg);
+
+        BleScanConfig mConfig;                                ///< Параметры сканирования
+        ResultCallback mCallback;                             ///< Callback обработки отчетов
+        SpscRing<BleScanReport, RING_SIZE> mRing;             ///< Буфер отчетов
+        std::array<DedupEntry, DEDUP_TABLE_SIZE> mDedup = {}; ///< Таблица дубликатов (только производитель)
+        std::atomic<TaskHandle_t> mTask = nullptr;            ///< Задача-потребитель
+        std::atomic<bool> mRunning = false;                   ///< Задача-потребитель работает
+        std::atomic<bool> mScanning = false;                  ///< Сканирование активно
+
+        std::atomic<uint32_t> mReceived = 0;   ///< Счетчик полученных отчетов
+        std::atomic<uint32_t> mFiltered = 0;   ///< Счетчик отфильтрованных отчетов
+        std::atomic<uint32_t> mDuplicates = 0; ///< Счетчик дубликатов
+        std::atomic<uint32_t> mDropped = 0;    ///< Счетчик потерянных отчетов
+        std::atomic<uint32_t> mProcessed = 0;  ///< Счетчик обработанных отчетов
+    };
+} // namespace net
+
+#endif // NET_BLE_SCANNER_H
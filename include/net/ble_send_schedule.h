@@ -0,0 +1,340 @@
+#ifndef NET_BLE_SEND_SCHEDULE_H
+#define NET_BLE_SEND_SCHEDULE_H
+
+#include "packets/packet.h"
+#include "ble_config.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace net
+{
+    /**
+     * @brief Отправка уведомлений, выровненная по событиям соединения
+     * @details Уведомление, отданное стеку в произвольный момент, уходит в эфир в ближайшем
+     *          событии соединения: задержка случайна в пределах интервала. Планировщик ведет
+     *          для каждого соединения интервал (из параметров соединения) и фазу событий и
+     *          отдает уведомление стеку за schedule.leadUs до расчетного события - задержка
+     *          до эфира становится постоянной.
+     *
+     *          Bluedroid не сообщает время опорных точек, поэтому фаза определяется по
+     *          возврату кредита контроллера (Number Of Completed Packets): он приходит в
+     *          событии, где пакет подтвержден, с постоянным сдвигом от опорной точки.
+     *          Первое уведомление соединения (и первое после смены параметров) отправляется
+     *          сразу и задает фазу, далее фаза уточняется по каждому schedule.observeEvery
+     *          событию с отправкой, компенсируя уход часов.
+     *
+     *          С schedule.batch все уведомления, попадающие в одно событие, отправляются
+     *          вместе; без него в событие уходит одно уведомление соединения, остальные -
+     *          в следующих событиях.
+     * @note Наблюдение возврата кредита (до интервала соединения) чередует активное ожидание
+     *       и сон отрезками по SPIN_US: задачи ниже ble_sched получают процессор, а выпуск
+     *       для других соединений на это время откладывается
+     */
+    class BleSendScheduler
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_SCHED";
+
+        /// @brief Единица интервала соединения, мкс
+        static constexpr int64_t INTERVAL_UNIT_US = 1250;
+
+        /// @brief Наибольший отрезок активного ожидания (выпуск, наблюдение кредита), мкс
+        static constexpr int64_t SPIN_US = 300;
+
+        /**
+         * @brief Отправка уведомления (под мьютексом BLE, с ожиданием кредитов)
+         */
+        using Sender = std::function<esp_err_t(uint16_t connId, const uint8_t* data, size_t len)>;
+
+        /**
+         * @brief Счетчики планировщика
+         * @details Отклонение - разница между наблюдаемым и расчетным временем события
+         *          соединения (точность выравнивания); задержка - от запрошенного времени
+         *          самого раннего уведомления события до его подтверждения.
+         */
+        struct Statistics
+        {
+            uint32_t queued;         ///< Принято уведомлений
+            uint32_t sent;           ///< Отправлено уведомлений
+            uint32_t rejected;       ///< Отклонено (очередь заполнена)
+            uint32_t failed;         ///< Ошибок отправки
+            uint32_t late;           ///< Отправлено позже чем через интервал после запрошенного времени
+            uint32_t events;         ///< Событий соединения с отправкой
+            uint32_t observed;       ///< Событий с измеренным отклонением
+            uint32_t unobserved;     ///< Событий, где возврат кредита не дождались
+            uint32_t relocks;        ///< Повторных определений фазы (отклонение больше четверти интервала)
+            uint32_t maxJitterUs;    ///< Максимальное отклонение, мкс
+            uint64_t totalJitterUs;  ///< Суммарное отклонение, мкс (среднее - / observed)
+            uint32_t maxLatencyUs;   ///< Максимальная задержка, мкс
+            uint64_t totalLatencyUs; ///< Суммарная задержка, мкс (среднее - / observed)
+        };
+
+        /**
+         * @brief Итог сброса очереди
+         */
+        struct DrainResult
+        {
+            uint32_t flushed; ///< Отправлено уведомлений
+            uint32_t dropped; ///< Осталось в очереди или не отправлено из-за ошибки
+        };
+
+        /**
+         * @param sender Отправка уведомлений характеристики данных
+         */
+        explicit BleSendScheduler(Sender sender);
+        ~BleSendScheduler();
+
+        // Запрет копирования и присваивания
+        BleSendScheduler(const BleSendScheduler&) = delete;
+        BleSendScheduler& operator=(const BleSendScheduler&) = delete;
+
+        /**
+         * @brief Запуск задачи выпуска
+         * @param config Конфигурация (используется группа schedule)
+         * @return esp_err_t ESP_ERR_NO_MEM, если задачу или таймер создать не удалось
+         * @note При schedule.enabled = false задача не создается и isRunning() возвращает false
+         */
+        esp_err_t begin(const BleConfig& config);
+
+        /**
+         * @brief Остановка задачи (поставленные уведомления отбрасываются)
+         * @warning Нельзя вызывать под мьютексом BLE: задача может быть внутри отправки
+         */
+        void end();
+
+        /**
+         * @brief Задача выпуска работает
+         */
+        [[nodiscard]] bool isRunning() const noexcept { return mRunning; }
+
+        /**
+         * @brief Сброс очереди до срока
+         * @details Уведомления выпускаются сразу, без ожидания запрошенного времени и
+         *          расчетных событий. Оставшиеся к сроку уведомления остаются в очереди
+         *          (их отбрасывает end()).
+         * @param deadlineUs Время esp_timer_get_time(), до которого ждать опустошения очереди
+         * @warning Нельзя вызывать под мьютексом BLE: отправка задачи ble_sched берет его
+         */
+        DrainResult drain(int64_t deadlineUs);
+
+        /**
+         * @brief Постановка уведомления
+         * @param connId Идентификатор соединения
+         * @param data Данные (копируются)
+         * @param len Длина данных
+         * @param dueUs Время esp_timer_get_time(), не раньше которого уведомление уходит в эфир
+         *              (0 - ближайшее событие)
+         * @return esp_err_t ESP_ERR_NOT_FOUND - соединение неизвестно,
+         *         ESP_ERR_NO_MEM - очередь заполнена, ESP_ERR_INVALID_SIZE - длиннее MAX_MTU
+         */
+        esp_err_t schedule(uint16_t connId, const uint8_t* data, size_t len, int64_t dueUs);
+
+        /**
+         * @brief Время следующего события соединения
+         * @param connId Идентификатор соединения
+         * @param[out] timeUs Время esp_timer_get_time() расчетного события
+         * @return esp_err_t ESP_ERR_NOT_FOUND - соединение неизвестно,
+         *         ESP_ERR_INVALID_STATE - фаза еще не определена
+         */
+        esp_err_t nextEvent(uint16_t connId, int64_t& timeUs) const;
+
+        /**
+         * @brief Новое соединение (задача BTC)
+         * @param interval Интервал соединения в единицах 1.25 мс
+         */
+        void handleConnect(uint16_t connId, uint16_t interval);
+
+        /**
+         * @brief Смена параметров соединения (задача BTC): фаза определяется заново
+         */
+        void handleConnectionParams(uint16_t connId, uint16_t interval);
+
+        /**
+         * @brief Разрыв соединения (задача BTC): его уведомления отбрасываются
+         */
+        void handleDisconnect(uint16_t connId);
+
+        /**
+         * @brief Снимок счетчиков
+         */
+        [[nodiscard]] Statistics getStatistics() const noexcept;
+
+        /**
+         * @brief Сброс счетчиков
+         */
+        void resetStatistics() noexcept;
+
+    private:
+        /**
+         * @brief Состояние слота очереди
+         */
+        enum class EntryState : uint8_t
+        {
+            FREE,   ///< Свободен
+            QUEUED, ///< Ждет выпуска
+            SENDING ///< Передается стеку (задача ble_sched, без мьютекса)
+        };
+
+        /**
+         * @brief Уведомление в очереди
+         */
+        struct Entry
+        {
+            EntryState state;                  ///< Состояние слота
+            uint16_t connId;                   ///< Идентификатор соединения
+            uint16_t len;                      ///< Длина данных
+            uint32_t sequence;                 ///< Порядок постановки
+            int64_t dueUs;                     ///< Запрошенное время
+            std::array<uint8_t, MAX_MTU> data; ///< Данные
+        };
+
+        /**
+         * @brief Хронометраж соединения
+         */
+        struct Link
+        {
+            uint16_t connId;    ///< Идентификатор соединения
+            int64_t intervalUs; ///< Интервал соединения, мкс
+            int64_t phaseUs;    ///< Время одного из событий (наблюдаемое)
+            int64_t lastSlotUs; ///< Событие последнего выпуска
+            bool locked;        ///< Фаза определена
+            uint8_t skipped;    ///< Событий с отправкой после последнего наблюдения
+            uint8_t misses;     ///< Наблюдений подряд без возврата кредита
+        };
+
+        /**
+         * @brief Ближайший выпуск
+         */
+        struct Plan
+        {
+            uint16_t connId;   ///< Соединение
+            int64_t slotUs;    ///< Расчетное событие
+            int64_t releaseUs; ///< Время передачи стеку
+        };
+
+        /**
+         * @brief Уведомлений в очереди (ждущих и передаваемых)
+         */
+        [[nodiscard]] size_t pending() const;
+
+        /**
+         * @brief Первое событие соединения не раньше timeUs
+         */
+        static int64_t slotAtOrAfter(const Link& link, int64_t timeUs) noexcept;
+
+        /**
+         * @brief Поиск хронометража соединения (под mMutex)
+         */
+        Link* findLink(uint16_t connId) noexcept;
+
+        /**
+         * @brief Расчет ближайшего выпуска (под mMutex)
+         * @return bool false - очередь пуста
+         */
+        bool plan(int64_t nowUs, Plan& result) noexcept;
+
+        /**
+         * @brief Ожидание времени выпуска
+         * @return bool false - задачу разбудили раньше (новое уведомление, остановка)
+         */
+        bool waitUntil(int64_t timeUs);
+
+        /**
+         * @brief Сон на SPIN_US, если текущий отрезок активного ожидания исчерпан
+         * @param[in,out] sliceEndUs Конец отрезка (после сна - конец следующего)
+         * @param nowUs Текущее время
+         * @return bool true - задача спала
+         */
+        bool yieldSlice(int64_t& sliceEndUs, int64_t nowUs);
+
+        /**
+         * @brief Отправка уведомлений события и наблюдение его подтверждения
+         */
+        void release(const Plan& plan);
+
+        /**
+         * @brief Наблюдение подтверждения отправленных уведомлений
+         * @param plan Выпуск
+         * @param credits Кредиты соединения до отправки
+         * @param locked Фаза была определена на момент выпуска
+         * @param intervalUs Интервал соединения
+         * @return int64_t Время возврата кредита (0 - не дождались)
+         */
+        int64_t observeCompletion(const Plan& plan, uint16_t credits, bool locked, int64_t intervalUs);
+
+        /**
+         * @brief Ожидание возврата кредита отрезками по SPIN_US
+         * @param connId Соединение
+         * @param[in,out] lowest Наименьшее число кредитов после отправки
+         * @param untilUs Граница ожидания
+         * @return int64_t Время возврата (0 - не дождались, -1 - вернулся до начала ожидания)
+         */
+        int64_t spinForCredit(uint16_t connId, uint16_t& lowest, int64_t untilUs);
+
+        /**
+         * @brief Учет наблюдения в фазе и счетчиках
+         * @param plan Выпуск
+         * @param completionUs Время возврата кредита (0 - не дождались)
+         * @param requestUs Запрошенное время самого раннего уведомления события
+         */
+        void updatePhase(const Plan& plan, int64_t completionUs, int64_t requestUs);
+
+        /**
+         * @brief Пробуждение задачи для пересчета выпуска
+         */
+        void wake() const noexcept;
+
+        /**
+         * @brief Тело задачи выпуска
+         */
+        static void scheduleTask(void* arg);
+
+        /**
+         * @brief Таймер выпуска: будит задачу
+         */
+        static void timerCallback(void* arg);
+
+        Sender mSender;                            ///< Отправка уведомлений
+        mutable std::mutex mMutex;                 ///< Защита очереди и хронометража
+        std::vector<Entry> mEntries;               ///< Очередь (выделяется при запуске)
+        std::vector<Link> mLinks;                  ///< Хронометраж соединений
+        std::vector<Entry*> mBatch;                ///< Уведомления выпускаемого события (задача ble_sched)
+        uint32_t mSequence = 0;                    ///< Счетчик постановок
+        int64_t mLeadUs = 0;                       ///< Упреждение выпуска
+        bool mBatchMode = false;                   ///< Все уведомления события вместе
+        uint8_t mObserveEvery = 1;                 ///< Период наблюдения подтверждения
+        esp_timer_handle_t mTimer = nullptr;       ///< Таймер выпуска
+        std::atomic<TaskHandle_t> mTask = nullptr; ///< Задача выпуска
+        std::atomic<bool> mRunning = false;        ///< Задача выпуска работает
+        std::atomic<bool> mFlushing = false;       ///< Сброс очереди (drain)
+
+        std::atomic<uint32_t> mQueued = 0;         ///< Счетчик принятых уведомлений
+        std::atomic<uint32_t> mSent = 0;           ///< Счетчик отправленных уведомлений
+        std::atomic<uint32_t> mRejected = 0;       ///< Счетчик отклоненных уведомлений
+        std::atomic<uint32_t> mFailed = 0;         ///< Счетчик ошибок отправки
+        std::atomic<uint32_t> mLate = 0;           ///< Счетчик опоздавших уведомлений
+        std::atomic<uint32_t> mEvents = 0;         ///< Счетчик событий с отправкой
+        std::atomic<uint32_t> mObserved = 0;       ///< Счетчик измеренных событий
+        std::atomic<uint32_t> mUnobserved = 0;     ///< Счетчик неизмеренных событий
+        std::atomic<uint32_t> mRelocks = 0;        ///< Счетчик повторных определений фазы
+        std::atomic<uint32_t> mMaxJitterUs = 0;    ///< Максимальное отклонение
+        std::atomic<uint64_t> mTotalJitterUs = 0;  ///< Суммарное отклонение
+        std::atomic<uint32_t> mMaxLatencyUs = 0;   ///< Максимальная задержка
+        std::atomic<uint64_t> mTotalLatencyUs = 0; ///< Суммарная задержка
+    };
+} // namespace net
+
+#endif // NET_BLE_SEND_SCHEDULE_H
@@ -0,0 +1,171 @@
+#ifndef NET_BLE_SERIAL_BRIDGE_H
+#define NET_BLE_SERIAL_BRIDGE_H
+
+#include "ble_ring.h"
+#include "ble_serial_port.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "esp_err.h"
+
+namespace net
+{
+    /**
+     * @brief Параметры моста последовательный порт - BLE
+     */
+    struct BleSerialBridgeConfig
+    {
+        uint32_t coalesceMs = 5;            ///< Дозаполнение уведомления после первых байт, мс
+        uint32_t idleWaitMs = 100;          ///< Ожидание данных порта в простое, мс
+        uint16_t downlinkBufferSize = 2048; ///< Буфер данных от клиента к порту, байт
+        uint32_t taskPriority = 5;          ///< Приоритет задач моста
+        uint32_t taskStack = 3072;          ///< Размер стека задач моста
+        int8_t taskCore = -1;               ///< Ядро задач моста (BleTask::CORE_AUTO, см. BleTask)
+    };
+
+    /**
+     * @brief Прозрачный мост между последовательным портом и характеристикой данных (NUS)
+     * @details Uplink (порт -> клиент): задача читает порт прямо в буфер уведомления,
+     *          дожидаясь до coalesceMs его заполнения до MTU - 3, и отправляет одним
+     *          уведомлением. Пока контроллер не дает кредитов, задача повторяет отправку
+     *          того же буфера и не читает порт: буфер приема UART заполняется, и аппаратное
+     *          управление потоком останавливает отправителя. Без соединения порт не читается.
+     *          Downlink (клиент -> порт): запись в характеристику копируется из события
+     *          стека в кольцевой буфер, задача пишет в порт прямо из него (peek/consume).
+     *          Запись, не поместившаяся в буфер, не принимается частично: с ответом
+     *          отклоняется, без ответа (Write Command) отбрасывается целиком.
+     *          Мост обслуживает одно соединение - первое из подключившихся.
+     *          Заголовок не зависит от FreeRTOS и пакетов esp32-c3-common: мост собирается
+     *          на хосте с FdSerialPort (test/test_ble_serial_bridge).
+     */
+    class BleSerialBridge
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_BRIDGE";
+
+        /// @brief Максимальная длина уведомления (значение атрибута 512 байт - MAX_MTU - 3)
+        static constexpr size_t MAX_PAYLOAD = 512 - 3;
+
+        /// @brief Соединение не назначено
+        static constexpr int32_t NO_PEER = -1;
+
+        /**
+         * @brief Отправка уведомления клиенту
+         * @return esp_err_t ESP_ERR_TIMEOUT - нет кредитов контроллера (отправка повторяется)
+         */
+        using DataSender = std::function<esp_err_t(uint16_t connId, const uint8_t* data, size_t len)>;
+
+        /**
+         * @brief Счетчики моста
+         */
+        struct Statistics
+        {
+            uint64_t uplinkBytes;           ///< Передано байт порт -> клиент
+            uint32_t uplinkNotifications;   ///< Отправлено уведомлений
+            uint32_t uplinkStalls;          ///< Повторов отправки из-за отсутствия кредитов
+            uint64_t uplinkDropped;         ///< Потеряно байт из-за ошибок отправки
+            uint64_t downlinkBytes;         ///< Передано байт клиент -> порт
+            uint64_t downlinkDropped;       ///< Отброшено байт записей без ответа (буфер заполнен)
+            uint32_t downlinkDroppedWrites; ///< Отброшено записей без ответа (целиком)
+            uint32_t downlinkRejected;      ///< Отклонено записей с ответом (клиент повторит)
+        };
+
+        /**
+         * @param sender Отправка уведомлений характеристики данных
+         */
+        explicit BleSerialBridge(DataSender sender);
+        ~BleSerialBridge();
+
+        // Запрет копирования и присваивания
+        BleSerialBridge(const BleSerialBridge&) = delete;
+        BleSerialBridge& operator=(const BleSerialBridge&) = delete;
+
+        /**
+         * @brief Открытие порта и запуск задач моста
+         * @param port Порт (должен жить до stop())
+         * @param config Параметры моста
+         * @return esp_err_t ESP_ERR_INVALID_STATE, если мост уже запущен
+         */
+        esp_err_t start(BleSerialPort& port, const BleSerialBridgeConfig& config);
+
+        /**
+         * @brief Остановка задач и закрытие порта
+         * @warning Не вызывать под мьютексом BLE: задача uplink может ждать его в отправке
+         */
+        void stop();
+
+        /**
+         * @brief Подключение клиента (назначается, если соединение еще не выбрано)
+         */
+        void handleConnect(uint16_t connId) noexcept;
+
+        /**
+         * @brief Разрыв соединения
+         */
+        void handleDisconnect(uint16_t connId) noexcept;
+
+        /**
+         * @brief Установка MTU (длина уведомления MTU - 3)
+         */
+        void setLinkMtu(uint16_t mtu) noexcept;
+
+        /**
+         * @brief Запись клиента в характеристику данных (задача BTC)
+         * @param connId Идентификатор соединения
+         * @param data Данные
+         * @param len Длина
+         * @param needRsp Запись с ответом (иначе Write Command: при нехватке места отбрасывается)
+         * @return bool false - запись с ответом отклонена (буфер заполнен)
+         */
+        bool handleWrite(uint16_t connId, const uint8_t* data, size_t len, bool needRsp) noexcept;
+
+        /**
+         * @brief Мост запущен
+         */
+        [[nodiscard]] bool isRunning() const noexcept { return mRunning.load(); }
+
+        /**
+         * @brief Снимок счетчиков
+         */
+        [[nodiscard]] Statistics getStatistics() const noexcept;
+
+    private:
+        /**
+         * @brief Задача порт -> клиент
+         */
+        static void uplinkTask(void* arg);
+
+        /**
+         * @brief Задача клиент -> порт
+         */
+        static void downlinkTask(void* arg);
+
+        DataSender mSender;                            ///< Отправка уведомлений
+        BleSerialPort* mPort = nullptr;                ///< Порт
+        BleSerialBridgeConfig mConfig;                 ///< Параметры моста
+        std::unique_ptr<SpscByteRing> mDownlink;       ///< Буфер клиент -> порт
+        std::array<uint8_t, MAX_PAYLOAD> mUplink = {}; ///< Буфер уведомления (только задача uplink)
+        std::atomic<void*> mUplinkTask = nullptr;      ///< Задача порт -> клиент (TaskHandle_t)
+        std::atomic<void*> mDownlinkTask = nullptr;    ///< Задача клиент -> порт (TaskHandle_t)
+        std::atomic<bool> mRunning = false;            ///< Мост запущен
+        std::atomic<int32_t> mPeer = NO_PEER;          ///< Обслуживаемое соединение
+        std::atomic<uint16_t> mPayload = 20;           ///< Длина уведомления (MTU - 3)
+
+        std::atomic<uint64_t> mUplinkBytes = 0;           ///< Счетчик байт порт -> клиент
+        std::atomic<uint32_t> mUplinkNotifications = 0;   ///< Счетчик уведомлений
+        std::atomic<uint32_t> mUplinkStalls = 0;          ///< Счетчик повторов отправки
+        std::atomic<uint64_t> mUplinkDropped = 0;         ///< Счетчик потерянных байт uplink
+        std::atomic<uint64_t> mDownlinkBytes = 0;         ///< Счетчик байт клиент -> порт
+        std::atomic<uint64_t> mDownlinkDropped = 0;       ///< Счетчик отброшенных байт downlink
+        std::atomic<uint32_t> mDownlinkDroppedWrites = 0; ///< Счетчик отброшенных записей downlink
+        std::atomic<uint32_t> mDownlinkRejected = 0;      ///< Счетчик отклоненных записей
+    };
+} // namespace net
+
+#endif // NET_BLE_SERIAL_BRIDGE_H
@@ -0,0 +1,139 @@
+#ifndef NET_BLE_SERIAL_PORT_H
+#define NET_BLE_SERIAL_PORT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+#ifdef ESP_PLATFORM
+#include "driver/uart.h"
+#endif
+
+namespace net
+{
+    /**
+     * @brief Последовательный порт для моста BleSerialBridge
+     * @details Абстракция байтового потока: мосту не важно, UART это, USB CDC или
+     *          файловый дескриптор (pty или pipe на хосте). read() и write() вызываются
+     *          из разных задач моста и должны допускать одновременную работу.
+     */
+    class BleSerialPort
+    {
+    public:
+        virtual ~BleSerialPort() = default;
+
+        /**
+         * @brief Открытие порта
+         * @return esp_err_t Код ошибки ESP-IDF
+         */
+        virtual esp_err_t open() = 0;
+
+        /**
+         * @brief Закрытие порта
+         */
+        virtual void close() = 0;
+
+        /**
+         * @brief Чтение данных
+         * @param data Буфер назначения
+         * @param len Размер буфера
+         * @param timeoutMs Ожидание, мс
+         * @return size_t Прочитано байт: возврат, когда буфер заполнен или истекло ожидание
+         */
+        virtual size_t read(uint8_t* data, size_t len, uint32_t timeoutMs) = 0;
+
+        /**
+         * @brief Запись данных
+         * @param data Данные
+         * @param len Длина
+         * @param timeoutMs Ожидание места в буфере передачи, мс
+         * @return size_t Записано байт (меньше len при таймауте или ошибке)
+         */
+        virtual size_t write(const uint8_t* data, size_t len, uint32_t timeoutMs) = 0;
+    };
+
+#ifdef ESP_PLATFORM
+    /**
+     * @brief UART через драйвер ESP-IDF
+     * @details Прием идет через кольцевой буфер драйвера, который заполняет прерывание UART.
+     *          При аппаратном управлении потоком (rtsPin и ctsPin заданы) контроллер снимает
+     *          RTS, когда FIFO приема заполнен выше rxFlowThreshold: если мост не успевает
+     *          отправлять в BLE, кольцевой буфер драйвера заполняется, FIFO перестает
+     *          опустошаться и отправитель останавливается.
+     *          Передача пишет прямо в FIFO (uart_tx_chars) и ждет его опустошения не дольше
+     *          timeoutMs: при снятом CTS write() возвращает частичный результат, а не
+     *          блокирует задачу моста.
+     */
+    class UartSerialPort final : public BleSerialPort
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_UART";
+
+        /**
+         * @brief Параметры UART
+         */
+        struct Config
+        {
+            uart_port_t port = 1;            ///< Номер UART
+            int baudRate = 115200;           ///< Скорость, бод
+            int txPin = UART_PIN_NO_CHANGE;  ///< Вывод TX
+            int rxPin = UART_PIN_NO_CHANGE;  ///< Вывод RX
+            int rtsPin = UART_PIN_NO_CHANGE; ///< Вывод RTS (не задан - без управления потоком приема)
+            int ctsPin = UART_PIN_NO_CHANGE; ///< Вывод CTS (не задан - без управления потоком передачи)
+            uint8_t rxFlowThreshold = 100;   ///< Порог заполнения FIFO приема для снятия RTS, байт
+            uint16_t rxBufferSize = 4096;    ///< Кольцевой буфер приема драйвера, байт
+        };
+
+        /**
+         * @param config Параметры UART
+         */
+        explicit UartSerialPort(const Config& config) noexcept : mConfig(config) {}
+        ~UartSerialPort() override;
+
+        // Запрет копирования и присваивания
+        UartSerialPort(const UartSerialPort&) = delete;
+        UartSerialPort& operator=(const UartSerialPort&) = delete;
+
+        esp_err_t open() override;
+        void close() override;
+        size_t read(uint8_t* data, size_t len, uint32_t timeoutMs) override;
+        size_t write(const uint8_t* data, size_t len, uint32_t timeoutMs) override;
+
+    private:
+        Config mConfig;     ///< Параметры UART
+        bool mOpen = false; ///< Драйвер установлен
+    };
+#endif // ESP_PLATFORM
+
+    /**
+     * @brief Порт на файловом дескрипторе
+     * @details Работает с любым дескриптором, поддерживающим poll(): pty или pipe на хосте,
+     *          /dev/uart/N или /dev/usbserjtag через VFS ESP-IDF. Дескрипторы не закрываются
+     *          портом; для pipe чтение и запись задаются разными дескрипторами.
+     */
+    class FdSerialPort final : public BleSerialPort
+    {
+    public:
+        /**
+         * @param readFd Дескриптор чтения
+         * @param writeFd Дескриптор записи (-1 - тот же, что readFd)
+         */
+        explicit FdSerialPort(const int readFd, const int writeFd = -1) noexcept :
+            mReadFd(readFd), mWriteFd(writeFd < 0 ? readFd : writeFd)
+        {
+        }
+
+        esp_err_t open() override;
+        void close() override {}
+        size_t read(uint8_t* data, size_t len, uint32_t timeoutMs) override;
+        size_t write(const uint8_t* data, size_t len, uint32_t timeoutMs) override;
+
+    private:
+        const int mReadFd;  ///< Дескриптор чтения
+        const int mWriteFd; ///< Дескриптор записи
+    };
+} // namespace net
+
+#endif // NET_BLE_SERIAL_PORT_H
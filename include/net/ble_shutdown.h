@@ -0,0 +1,91 @@
+#ifndef NET_BLE_SHUTDOWN_H
+#define NET_BLE_SHUTDOWN_H
+
+#include "esp_err.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace net
+{
+    /**
+     * @brief Фазы остановки BLE стека
+     * @details Немедленная остановка (BLE::stop()) выполняет только TEARDOWN,
+     *          мягкая (BLE::stopGracefully()) - все фазы по порядку.
+     */
+    enum class BleShutdownPhase : uint8_t
+    {
+        QUIESCE,    ///< Прием отправок закрыт, реклама, сканер и мост остановлены
+        DRAIN,      ///< Сброс очереди планировщика и буферов контроллера
+        DISCONNECT, ///< Разрыв соединений и ожидание ESP_GATTS_DISCONNECT_EVT
+        TEARDOWN,   ///< Удаление сервиса, выключение Bluedroid и контроллера
+        COUNT       ///< Количество фаз
+    };
+
+    /**
+     * @brief Имя фазы остановки для логирования
+     */
+    constexpr const char* shutdownPhaseToName(const BleShutdownPhase phase) noexcept
+    {
+        switch (phase)
+        {
+        case BleShutdownPhase::QUIESCE: return "QUIESCE";
+        case BleShutdownPhase::DRAIN: return "DRAIN";
+        case BleShutdownPhase::DISCONNECT: return "DISCONNECT";
+        case BleShutdownPhase::TEARDOWN: return "TEARDOWN";
+        default: return "UNKNOWN";
+        }
+    }
+
+    /**
+     * @brief Сроки мягкой остановки
+     * @details Сроки отсчитываются от начала своей фазы; общее время остановки ограничено
+     *          их суммой и длительностью TEARDOWN.
+     */
+    struct BleShutdownOptions
+    {
+        uint32_t drainTimeoutMs = 500;       ///< Сброс данных, мс (0 - данные отбрасываются)
+        uint32_t disconnectTimeoutMs = 1000; ///< Ожидание разрыва соединений, мс
+    };
+
+    /**
+     * @brief Отчет об остановке BLE стека
+     * @details Пакеты контроллера - уведомления, переданные стеку, но еще не подтвержденные
+     *          (занятые кредиты соединения); их учет ведется по кредитам, без разбивки по данным.
+     */
+    struct BleShutdownReport
+    {
+        static constexpr size_t PHASE_COUNT = static_cast<size_t>(BleShutdownPhase::COUNT);
+
+        esp_err_t status = ESP_ERR_INVALID_STATE;       ///< Результат выключения стека
+        bool graceful = false;                          ///< Мягкая остановка (stopGracefully)
+        std::array<uint32_t, PHASE_COUNT> phaseUs = {}; ///< Длительность каждой фазы, мкс
+        uint32_t totalUs = 0;                           ///< Общее время остановки, мкс
+        uint32_t scheduledFlushed = 0;                  ///< Отправлено уведомлений из очереди планировщика
+        uint32_t scheduledDropped = 0;                  ///< Отброшено уведомлений очереди планировщика
+        uint32_t controllerFlushed = 0;                 ///< Подтверждено пакетов контроллера за сброс
+        uint32_t controllerPending = 0;                 ///< Не подтверждено пакетов к сроку сброса
+        uint8_t peers = 0;                              ///< Соединений на начало остановки
+        uint8_t peersDisconnected = 0;                  ///< Разорвано с подтверждением до срока
+
+        /**
+         * @brief Длительность фазы, мкс
+         */
+        [[nodiscard]] uint32_t durationUs(const BleShutdownPhase phase) const noexcept
+        {
+            return phaseUs[static_cast<size_t>(phase)];
+        }
+
+        /**
+         * @brief Все данные доставлены, все соединения разорваны штатно
+         */
+        [[nodiscard]] bool clean() const noexcept
+        {
+            return status == ESP_OK && scheduledDropped == 0 && controllerPending == 0 &&
+                peersDisconnected == peers;
+        }
+    };
+} // namespace net
+
+#endif // NET_BLE_SHUTDOWN_H
@@ -0,0 +1,79 @@
+#ifndef NET_BLE_STARTUP_H
+#define NET_BLE_STARTUP_H
+
+#include "esp_err.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace net
+{
+    /**
+     * @brief Фазы асинхронного запуска BLE стека
+     * @details Фазы GAP_CONFIG и APP_REGISTER..SERVICE_START выполняются параллельно:
+     *          настройка рекламы и параметров GAP не ждет создания GATT базы.
+     */
+    enum class BleStartupPhase : uint8_t
+    {
+        CONTROLLER,     ///< Инициализация и включение контроллера
+        HOST,           ///< Инициализация и включение Bluedroid
+        GAP_CONFIG,     ///< Имя, параметры безопасности, PHY, параметры и данные рекламы
+        APP_REGISTER,   ///< Регистрация GATT приложения (ESP_GATTS_REG_EVT)
+        SERVICE_CREATE, ///< Создание сервиса (ESP_GATTS_CREATE_EVT)
+        CHAR_ADD,       ///< Добавление характеристики (ESP_GATTS_ADD_CHAR_EVT)
+        SERVICE_START,  ///< Запуск сервиса (ESP_GATTS_START_EVT)
+        ADV_START,      ///< Запуск рекламы (ESP_GAP_BLE_*ADV_START_COMPLETE_EVT)
+        COUNT           ///< Количество фаз
+    };
+
+    /**
+     * @brief Имя фазы запуска для логирования
+     */
+    constexpr const char* startupPhaseToName(const BleStartupPhase phase) noexcept
+    {
+        switch (phase)
+        {
+        case BleStartupPhase::CONTROLLER: return "CONTROLLER";
+        case BleStartupPhase::HOST: return "HOST";
+        case BleStartupPhase::GAP_CONFIG: return "GAP_CONFIG";
+        case BleStartupPhase::APP_REGISTER: return "APP_REGISTER";
+        case BleStartupPhase::SERVICE_CREATE: return "SERVICE_CREATE";
+        case BleStartupPhase::CHAR_ADD: return "CHAR_ADD";
+        case BleStartupPhase::SERVICE_START: return "SERVICE_START";
+        case BleStartupPhase::ADV_START: return "ADV_START";
+        default: return "UNKNOWN";
+        }
+    }
+
+    /**
+     * @brief Отчет о запуске BLE стека
+     */
+    struct BleStartupReport
+    {
+        static constexpr size_t PHASE_COUNT = static_cast<size_t>(BleStartupPhase::COUNT);
+
+        esp_err_t status = ESP_ERR_INVALID_STATE;                ///< ESP_OK после запуска рекламы, иначе код ошибки
+        bool completed = false;                                  ///< Запуск завершен (успешно или с ошибкой)
+        BleStartupPhase failedPhase = BleStartupPhase::COUNT;    ///< Фаза, на которой произошла ошибка
+        std::array<uint32_t, PHASE_COUNT> phaseUs = {};          ///< Длительность каждой фазы, мкс
+        uint32_t totalUs = 0;                                    ///< Время до начала рекламы, мкс
+
+        /**
+         * @brief Длительность фазы, мкс
+         */
+        [[nodiscard]] uint32_t durationUs(const BleStartupPhase phase) const noexcept
+        {
+            return phaseUs[static_cast<size_t>(phase)];
+        }
+    };
+
+    /**
+     * @brief Callback завершения запуска
+     * @note Вызывается из задачи BTC (контекст обработчиков событий Bluedroid)
+     */
+    using BleStartupCallback = std::function<void(const BleStartupReport&)>;
+} // namespace net
+
+#endif // NET_BLE_STARTUP_H
@@ -0,0 +1,128 @@
+#ifndef NET_BLE_STATISTICS_H
+#define NET_BLE_STATISTICS_H
+
+#include <cstdint>
+
+namespace net
+{
+    /**
+     * @brief Статистика работы BLE стека
+     * @details Счетчики обновляются в обработчиках событий под мьютексом BLE,
+     *          снимок возвращает BLE::getStatistics().
+     */
+    struct BleStatistics
+    {
+        /// @brief Загрузка с сохраненной GATT базой (хэш и хэндлы совпали)
+        bool warmBoot = false;
+
+        /// @brief Время от начала запуска до подключения bonded-устройства, мкс (0 - еще не было)
+        uint32_t timeToReconnectUs = 0;
+
+        /// @brief Количество переподключений bonded-устройств
+        uint32_t bondedReconnects = 0;
+
+        /// @brief Количество отправленных индикаций Service Changed
+        uint32_t serviceChangedSent = 0;
+
+        /// @brief Количество подключений после разрыва соединения
+        uint32_t reconnects = 0;
+
+        /// @brief Время от последнего разрыва до нового подключения, мкс
+        uint32_t lastReconnectLatencyUs = 0;
+
+        /// @brief Максимальное время переподключения, мкс
+        uint32_t maxReconnectLatencyUs = 0;
+
+        /// @brief Суммарное время переподключений, мкс (для среднего значения)
+        uint64_t totalReconnectLatencyUs = 0;
+
+        /// @brief Количество автоматических перезапусков рекламы
+        uint32_t advertisingRestarts = 0;
+
+        /// @brief Отправлено пакетов (уведомления сервера и запись без ответа клиента)
+        uint32_t txPackets = 0;
+
+        /// @brief Отправлено байт
+        uint64_t txBytes = 0;
+
+        /// @brief Количество ожиданий свободного кредита контроллера
+        uint32_t txCreditWaits = 0;
+
+        /// @brief Количество отказов по таймауту ожидания кредита
+        uint32_t txCreditTimeouts = 0;
+
+        /// @brief Количество ошибок отправки
+        uint32_t txErrors = 0;
+
+        /// @brief Принято записей с ответом (Write Request)
+        uint32_t rxAckedWrites = 0;
+
+        /// @brief Принято байт в записях с ответом
+        uint64_t rxAckedBytes = 0;
+
+        /// @brief Принято записей без ответа (Write Command)
+        uint32_t rxUnackedWrites = 0;
+
+        /// @brief Принято байт в записях без ответа
+        uint64_t rxUnackedBytes = 0;
+
+        /// @brief Отброшено байт потокового приема: Write Command целиком, если не помещается, или поток не назначен
+        uint64_t bulkDroppedBytes = 0;
+
+        /// @brief Успешных сопряжений (новые ключи)
+        uint32_t pairings = 0;
+
+        /// @brief Неудачных сопряжений и возобновлений шифрования
+        uint32_t pairingFailures = 0;
+
+        /// @brief Возобновлений шифрования по сохраненному ключу (без повторного сопряжения)
+        uint32_t encryptionResumes = 0;
+
+        /// @brief Время от подключения до шифрования последнего соединения, мкс
+        uint32_t lastTimeToEncryptUs = 0;
+
+        /// @brief Максимальное время от подключения до шифрования, мкс
+        uint32_t maxTimeToEncryptUs = 0;
+
+        /// @brief Устройств в списке разрешения контроллера (подтвержденных контроллером)
+        uint8_t resolvingListSize = 0;
+
+        /// @brief Устройств в accept list (фильтр подключений)
+        uint8_t acceptListSize = 0;
+
+        /// @brief Соединений, разорванных фильтром хоста (устройство вне accept list)
+        uint32_t connectionsRejected = 0;
+
+        /// @brief Принятых соединений от устройств вне непустого accept list (фильтр выключен)
+        uint32_t unlistedConnections = 0;
+
+        /// @brief Занятых слотов соединений сервера
+        uint8_t connectionSlotsUsed = 0;
+
+        /// @brief Максимум одновременно занятых слотов
+        uint8_t peakConnectionSlots = 0;
+
+        /// @brief Подключений, занявших последний свободный слот (ble_max_act)
+        uint32_t slotExhaustions = 0;
+
+        /// @brief Блокировки питания удерживаются сейчас
+        bool pmLockHeld = false;
+
+        /// @brief Количество захватов блокировок питания
+        uint32_t pmLockAcquisitions = 0;
+
+        /// @brief Суммарное время удержания блокировок питания, мкс
+        uint64_t pmLockHeldUs = 0;
+
+        /// @brief Событий диагностики горячего пути (ошибки отправки и приема)
+        uint32_t diagEvents = 0;
+
+        /// @brief Событий диагностики, не выведенных в лог из-за лимита
+        uint32_t diagSuppressed = 0;
+
+        /// @brief Записей диагностики, потерянных при переполнении буфера
+        uint32_t diagDropped = 0;
+    };
+} // namespace net
+
+#endif // NET_BLE_STATISTICS_H
@@ -0,0 +1,122 @@
+#ifndef NET_BLE_STORAGE_H
+#define NET_BLE_STORAGE_H
+
+#include "esp_err.h"
+
+#include <cstddef>
+#include <string>
+
+#ifdef ESP_PLATFORM
+#include "nvs.h"
+#endif
+
+namespace net
+{
+    /**
+     * @brief Интерфейс хранилища ключ-значение для постоянных данных BLE
+     * @details Позволяет подменять бэкенд: NVS на устройстве, файлы на хосте.
+     */
+    class BleKeyValueStore
+    {
+    public:
+        virtual ~BleKeyValueStore() = default;
+
+        /**
+         * @brief Чтение значения
+         * @param key Ключ (не длиннее 15 символов для совместимости с NVS)
+         * @param[out] data Буфер для значения
+         * @param[in,out] size Размер буфера / фактический размер значения
+         * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND или ошибка бэкенда
+         */
+        virtual esp_err_t read(const char* key, void* data, size_t& size) = 0;
+
+        /**
+         * @brief Запись значения
+         * @param key Ключ
+         * @param data Данные
+         * @param size Размер данных
+         * @return esp_err_t Код ошибки
+         */
+        virtual esp_err_t write(const char* key, const void* data, size_t size) = 0;
+
+        /**
+         * @brief Удаление значения
+         * @param key Ключ
+         * @return esp_err_t Код ошибки (ESP_OK, если ключа не было)
+         */
+        virtual esp_err_t erase(const char* key) = 0;
+
+        /**
+         * @brief Фиксация изменений
+         * @return esp_err_t Код ошибки
+         */
+        virtual esp_err_t commit() = 0;
+    };
+
+#ifdef ESP_PLATFORM
+    /**
+     * @brief Хранилище в NVS (раздел nvs должен быть инициализирован nvs_flash_init)
+     */
+    class NvsKeyValueStore final : public BleKeyValueStore
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_NVS";
+
+        /**
+         * @param nameSpace Пространство имен NVS (не длиннее 15 символов)
+         */
+        explicit NvsKeyValueStore(const char* nameSpace = "ble");
+        ~NvsKeyValueStore() override;
+
+        NvsKeyValueStore(const NvsKeyValueStore&) = delete;
+        NvsKeyValueStore& operator=(const NvsKeyValueStore&) = delete;
+
+        esp_err_t read(const char* key, void* data, size_t& size) override;
+        esp_err_t write(const char* key, const void* data, size_t size) override;
+        esp_err_t erase(const char* key) override;
+        esp_err_t commit() override;
+
+    private:
+        /**
+         * @brief Открытие пространства имен при первом обращении
+         */
+        esp_err_t open();
+
+        const char* mNameSpace;   ///< Пространство имен NVS
+        nvs_handle_t mHandle = 0; ///< Хэндл NVS
+        bool mIsOpen = false;     ///< Флаг открытого хэндла
+    };
+#endif
+
+    /**
+     * @brief Файловое хранилище: каждый ключ - отдельный файл в каталоге
+     * @details Используется на хосте и на устройстве с примонтированной ФС (SPIFFS, LittleFS).
+     */
+    class FileKeyValueStore final : public BleKeyValueStore
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_FILE";
+
+        /**
+         * @param directory Каталог для файлов (должен существовать)
+         */
+        explicit FileKeyValueStore(std::string directory);
+
+        esp_err_t read(const char* key, void* data, size_t& size) override;
+        esp_err_t write(const char* key, const void* data, size_t size) override;
+        esp_err_t erase(const char* key) override;
+        esp_err_t commit() override;
+
+    private:
+        /**
+         * @brief Путь к файлу ключа
+         */
+        std::string pathFor(const char* key) const;
+
+        std::string mDirectory; ///< Каталог хранилища
+    };
+} // namespace net
+
+#endif // NET_BLE_STORAGE_H
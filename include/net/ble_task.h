@@ -0,0 +1,61 @@
+#ifndef NET_BLE_TASK_H
+#define NET_BLE_TASK_H
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace net
+{
+    /**
+     * @brief Размещение задач библиотеки по ядрам
+     * @details На двухъядерных целях (ESP32, ESP32-S3) контроллер и хост Bluedroid (BTC)
+     *          закреплены за одним ядром (CONFIG_BT_CTRL_PINNED_TO_CORE,
+     *          CONFIG_BT_BLUEDROID_PINNED_TO_CORE). Задачи обработки данных по умолчанию
+     *          (CORE_AUTO) закрепляются за другим ядром: обработка не задерживает события
+     *          стека, а стек не вытесняет обработку. На одноядерных целях (ESP32-C3)
+     *          любое значение означает задачу без привязки.
+     */
+    struct BleTask
+    {
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_TASK";
+
+        /// @brief Ядро, свободное от стека Bluetooth (на одноядерных - без привязки)
+        static constexpr int8_t CORE_AUTO = -1;
+
+        /// @brief Без привязки к ядру (tskNO_AFFINITY)
+        static constexpr int8_t CORE_ANY = -2;
+
+        /**
+         * @brief Ядро задачи BTC (хост Bluedroid)
+         */
+        static BaseType_t stackCore() noexcept;
+
+        /**
+         * @brief Ядро для xTaskCreatePinnedToCore
+         * @param core Номер ядра, CORE_AUTO или CORE_ANY
+         * @return BaseType_t Номер ядра или tskNO_AFFINITY (одноядерная цель, ядра нет)
+         */
+        static BaseType_t resolveCore(int8_t core) noexcept;
+
+        /**
+         * @brief Создание задачи с размещением по ядру
+         * @param function Тело задачи
+         * @param name Имя задачи
+         * @param stack Размер стека, байт
+         * @param arg Аргумент задачи
+         * @param priority Приоритет
+         * @param core Номер ядра, CORE_AUTO или CORE_ANY
+         * @param[out] handle Хэндл задачи
+         * @return esp_err_t ESP_ERR_NO_MEM, если задачу создать не удалось
+         */
+        static esp_err_t create(TaskFunction_t function, const char* name, uint32_t stack, void* arg,
+                                UBaseType_t priority, int8_t core, TaskHandle_t& handle) noexcept;
+    };
+} // namespace net
+
+#endif // NET_BLE_TASK_H
@@ -0,0 +1,163 @@
+#ifndef NET_BLE_TRACE_H
+#define NET_BLE_TRACE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace net
+{
+    /**
+     * @brief Тип записи трассировки
+     */
+    enum class BleTraceKind : uint8_t
+    {
+        GAP,            ///< Событие GAP (code - esp_gap_ble_cb_event_t)
+        GATTS,          ///< Событие GATT сервера (code - esp_gatts_cb_event_t)
+        GATTC,          ///< Событие GATT клиента (code - esp_gattc_cb_event_t)
+        SEND_BEGIN,     ///< Начало отправки (code - BleTraceSend, arg - длина)
+        SEND_END,       ///< Завершение отправки (code - BleTraceSend, arg - esp_err_t)
+        CALLBACK_BEGIN, ///< Вызов callback приложения (code - BleTraceCallback)
+        CALLBACK_END    ///< Возврат из callback приложения (code - BleTraceCallback)
+    };
+
+    /**
+     * @brief Вид отправки
+     */
+    enum class BleTraceSend : uint8_t
+    {
+        NOTIFY,       ///< Уведомление характеристики данных
+        CHANNEL_FRAME ///< Фрейм транспорта каналов
+    };
+
+    /**
+     * @brief Callback приложения
+     */
+    enum class BleTraceCallback : uint8_t
+    {
+        DATA,    ///< Callback данных (запись в характеристику)
+        BULK,    ///< Поступление потоковых данных
+        PAIRING, ///< Запрос сопряжения
+        STARTUP, ///< Завершение запуска
+        OBSERVER ///< Наблюдатель соединений
+    };
+
+    /**
+     * @brief Запись трассировки (12 байт)
+     */
+    struct BleTraceEntry
+    {
+        uint32_t timeUs; ///< Младшие 32 бита esp_timer_get_time(), мкс
+        uint16_t connId; ///< Идентификатор соединения (BleTrace::NO_CONN - нет)
+        uint8_t kind;    ///< BleTraceKind
+        uint8_t code;    ///< Событие стека, вид отправки или callback
+        uint32_t arg;    ///< Аргумент (статус, длина, MTU, интервал и т.п.)
+    };
+
+    /**
+     * @brief Постоянно включенная трассировка событий стека
+     * @details Фиксированный кольцевой буфер бинарных записей: новая запись вытесняет
+     *          самую старую. Запись - атомарный инкремент индекса и копирование 12 байт,
+     *          без мьютексов и форматирования, поэтому безопасна из задачи BTC, задач
+     *          приложения и esp_timer одновременно. Согласованность при чтении
+     *          обеспечивает номер последовательности слота (seqlock): записи,
+     *          перезаписанные во время чтения, пропускаются.
+     *          dump() выводит буфер в консоль строками "BLETRACE ...";
+     *          tools/ble_trace_to_chrome.py переводит их в формат Chrome trace / Perfetto.
+     */
+    class BleTrace
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_TRACE";
+
+        /// @brief Емкость буфера, записей (степень двойки)
+        static constexpr size_t CAPACITY = 512;
+
+        /// @brief Соединение не определено
+        static constexpr uint16_t NO_CONN = 0xFFFF;
+
+        /// @brief Версия формата вывода dump()
+        static constexpr uint8_t FORMAT_VERSION = 1;
+
+        BleTrace() = default;
+
+        // Запрет копирования и присваивания
+        BleTrace(const BleTrace&) = delete;
+        BleTrace& operator=(const BleTrace&) = delete;
+
+        /**
+         * @brief Добавление записи
+         * @param kind Тип записи
+         * @param code Событие стека, вид отправки или callback
+         * @param connId Идентификатор соединения
+         * @param arg Аргумент
+         */
+        void record(BleTraceKind kind, uint8_t code, uint16_t connId = NO_CONN, uint32_t arg = 0) noexcept;
+
+        /**
+         * @brief Копия записей от старых к новым
+         * @param[out] out Буфер назначения
+         * @return size_t Количество скопированных записей (последние out.size())
+         */
+        size_t snapshot(std::span<BleTraceEntry> out) const noexcept;
+
+        /**
+         * @brief Вывод буфера в консоль (UART/USB) для tools/ble_trace_to_chrome.py
+         * @details Формат: "BLETRACE BEGIN <версия> <записей> <время, мкс>", затем
+         *          "BLETRACE <seq> <timeUs> <kind> <code> <connId> <arg>" (hex) и "BLETRACE END".
+         *          Строки лога между ними конвертер пропускает.
+         */
+        void dump() const;
+
+        /**
+         * @brief Очистка буфера
+         */
+        void clear() noexcept;
+
+        /**
+         * @brief Включение и выключение записи
+         */
+        void setEnabled(bool enabled) noexcept { mEnabled.store(enabled, std::memory_order_relaxed); }
+
+        /**
+         * @brief Записывать отчеты сканирования (по умолчанию нет - вытесняют остальные события)
+         */
+        void setScanReports(bool enabled) noexcept { mScanReports.store(enabled, std::memory_order_relaxed); }
+
+        [[nodiscard]] bool isEnabled() const noexcept { return mEnabled.load(std::memory_order_relaxed); }
+        [[nodiscard]] bool scanReports() const noexcept { return mScanReports.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Всего записей с момента запуска или очистки (включая вытесненные)
+         */
+        [[nodiscard]] uint32_t recorded() const noexcept { return mHead.load(std::memory_order_relaxed); }
+
+    private:
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Trace capacity must be a power of two");
+
+        /**
+         * @brief Слот буфера
+         */
+        struct Slot
+        {
+            std::atomic<uint32_t> seq = 0; ///< Номер записи + 1 (0 - слот пишется или пуст)
+            BleTraceEntry entry = {};      ///< Запись
+        };
+
+        /**
+         * @brief Чтение записи с номером index
+         * @return bool false, если запись вытеснена или пишется
+         */
+        bool read(uint32_t index, BleTraceEntry& entry) const noexcept;
+
+        std::array<Slot, CAPACITY> mSlots;      ///< Кольцевой буфер
+        std::atomic<uint32_t> mHead = 0;        ///< Номер следующей записи
+        std::atomic<bool> mEnabled = true;      ///< Запись включена
+        std::atomic<bool> mScanReports = false; ///< Записывать отчеты сканирования
+    };
+} // namespace net
+
+#endif // NET_BLE_TRACE_H
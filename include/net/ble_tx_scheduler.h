@@ -0,0 +1,74 @@
+#ifndef NET_BLE_TX_SCHEDULER_H
+#define NET_BLE_TX_SCHEDULER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+#include "freertos/FreeRTOS.h"
+
+namespace net
+{
+    /**
+     * @brief Планировщик передачи по кредитам контроллера
+     * @details Общий для ролей сервера (уведомления) и клиента (запись без ответа).
+     *          Перед отправкой пакета проверяется количество свободных буферов
+     *          контроллера для соединения (esp_ble_get_cur_sendable_packets_num):
+     *          при их отсутствии отправитель ждет, а не переполняет очередь стека.
+     */
+    class BleTxScheduler
+    {
+    public:
+        /// @brief Тег для логирования
+        static constexpr auto TAG = "BLE_TX";
+
+        /**
+         * @brief Счетчики передачи
+         */
+        struct Statistics
+        {
+            uint32_t packets;        ///< Отправлено пакетов
+            uint64_t bytes;          ///< Отправлено байт
+            uint32_t creditWaits;    ///< Ожиданий свободного кредита
+            uint32_t creditTimeouts; ///< Отказов по таймауту ожидания кредита
+            uint32_t errors;         ///< Ошибок отправки
+        };
+
+        /**
+         * @brief Ожидание свободного кредита для соединения
+         * @param connId Идентификатор соединения GATT
+         * @param timeout Таймаут ожидания в тиках FreeRTOS
+         * @return esp_err_t ESP_OK или ESP_ERR_TIMEOUT
+         * @warning Нельзя вызывать из задачи BTC: кредиты возвращаются событиями стека
+         */
+        esp_err_t acquire(uint16_t connId, TickType_t timeout) noexcept;
+
+        /**
+         * @brief Учет результата отправки
+         * @param bytes Размер отправленных данных
+         * @param result Результат вызова API отправки
+         */
+        void complete(size_t bytes, esp_err_t result) noexcept;
+
+        /**
+         * @brief Получить снимок счетчиков
+         */
+        [[nodiscard]] Statistics getStatistics() const noexcept;
+
+        /**
+         * @brief Сброс счетчиков
+         */
+        void resetStatistics() noexcept;
+
+    private:
+        std::atomic<uint32_t> mPackets = 0;        ///< Счетчик пакетов
+        std::atomic<uint64_t> mBytes = 0;          ///< Счетчик байт
+        std::atomic<uint32_t> mCreditWaits = 0;    ///< Счетчик ожиданий
+        std::atomic<uint32_t> mCreditTimeouts = 0; ///< Счетчик таймаутов
+        std::atomic<uint32_t> mErrors = 0;         ///< Счетчик ошибок
+    };
+} // namespace net
+
+#endif // NET_BLE_TX_SCHEDULER_H
@@ -0,0 +1,339 @@
+#ifndef NET_BLE_UUID_H
+#define NET_BLE_UUID_H
+
+#include "esp_bt_defs.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace net
+{
+    /**
+     * @brief Результат разбора строкового UUID
+     */
+    enum class UuidError : uint8_t
+    {
+        NONE,           ///< Разбор выполнен успешно
+        EMPTY,          ///< Пустая строка
+        INVALID_LENGTH, ///< Количество hex-цифр не равно 4, 8 или 32
+        INVALID_CHAR,   ///< Недопустимый символ (не hex и не '-')
+        INVALID_DASH    ///< Дефис не на своем месте (формат 8-4-4-4-12)
+    };
+
+    /**
+     * @brief Получить текстовое описание ошибки разбора UUID
+     * @param error Код ошибки
+     * @return const char* Строка для логирования
+     */
+    constexpr const char* uuidErrorToName(const UuidError error) noexcept
+    {
+        switch (error)
+        {
+        case UuidError::NONE: return "NONE";
+        case UuidError::EMPTY: return "EMPTY";
+        case UuidError::INVALID_LENGTH: return "INVALID_LENGTH";
+        case UuidError::INVALID_CHAR: return "INVALID_CHAR";
+        case UuidError::INVALID_DASH: return "INVALID_DASH";
+        }
+        return "UNKNOWN";
+    }
+
+    namespace detail
+    {
+        /// @brief Таблица декодирования hex-символов (-1 - недопустимый символ)
+        inline constexpr std::array<int8_t, 256> HEX_TABLE = []
+        {
+            std::array<int8_t, 256> table{};
+            for (auto& v : table) v = -1;
+            for (int i = 0; i < 10; i++) table['0' + i] = static_cast<int8_t>(i);
+            for (int i = 0; i < 6; i++)
+            {
+                table['a' + i] = static_cast<int8_t>(10 + i);
+                table['A' + i] = static_cast<int8_t>(10 + i);
+            }
+            return table;
+        }();
+
+        /**
+         * @brief Маркер ошибки разбора UUID во время компиляции
+         * @note Функция намеренно не constexpr: ее вызов в константном выражении
+         *       делает выражение некорректным и останавливает сборку
+         */
+        inline void invalidUuidLiteral(UuidError) noexcept
+        {
+        }
+    } // namespace detail
+
+    /**
+     * @brief UUID BLE-атрибута (16, 32 или 128 бит) в виде literal-типа
+     * @details Хранит UUID в порядке записи строки (big-endian). Разбор не выделяет
+     *          память и может выполняться во время компиляции:
+     * @code
+     * constexpr auto uuid = BleUuid::fromString("6E400001-B5A3-F393-E0A9-E50E24DCCA9E");
+     * @endcode
+     * Некорректная строка в constexpr-контексте приводит к ошибке сборки.
+     */
+    class BleUuid
+    {
+    public:
+        /// @brief Длина строкового представления 128-бит UUID с дефисами
+        static constexpr size_t STRING_LEN_128 = 36;
+
+        constexpr BleUuid() noexcept = default;
+
+        /**
+         * @brief Разбор строкового UUID без выделения памяти
+         * @param str Строка UUID ("1234", "12345678" или "00001234-0000-1000-8000-00805F9B34FB")
+         * @param[out] out Результат разбора (не изменяется при ошибке)
+         * @return UuidError Код ошибки разбора
+         */
+        static constexpr UuidError parse(const std::string_view str, BleUuid& out) noexcept
+        {
+            if (str.empty())
+            {
+                return UuidError::EMPTY;
+            }
+
+            BleUuid result;
+            size_t digits = 0;
+            uint8_t high = 0;
+
+            for (size_t i = 0; i < str.size(); i++)
+            {
+                const char c = str[i];
+                if (c == '-')
+                {
+                    // Дефисы допустимы только в 128-бит формате 8-4-4-4-12
+                    if (str.size() != STRING_LEN_128 || (i != 8 && i != 13 && i != 18 && i != 23))
+                    {
+                        return UuidError::INVALID_DASH;
+                    }
+                    continue;
+                }
+
+                const int8_t nibble = detail::HEX_TABLE[static_cast<uint8_t>(c)];
+                if (nibble < 0)
+                {
+                    return UuidError::INVALID_CHAR;
+                }
+
+                if (digits >= ESP_UUID_LEN_128 * 2)
+                {
+                    return UuidError::INVALID_LENGTH;
+                }
+
+                if ((digits & 1) == 0)
+                {
+                    high = static_cast<uint8_t>(nibble);
+                }
+                else
+                {
+                    result.mBytes[digits / 2] = static_cast<uint8_t>((high << 4) | nibble);
+                }
+                digits++;
+            }
+
+            if (str.size() == STRING_LEN_128 && digits != ESP_UUID_LEN_128 * 2)
+            {
+                return UuidError::INVALID_DASH;
+            }
+
+            switch (digits)
+            {
+            case ESP_UUID_LEN_16 * 2:
+                result.mLen = ESP_UUID_LEN_16;
+                break;
+            case ESP_UUID_LEN_32 * 2:
+                result.mLen = ESP_UUID_LEN_32;
+                break;
+            case ESP_UUID_LEN_128 * 2:
+                result.mLen = ESP_UUID_LEN_128;
+                break;
+            default:
+                return UuidError::INVALID_LENGTH;
+            }
+
+            out = result;
+            return UuidError::NONE;
+        }
+
+        /**
+         * @brief Создание UUID из строки с проверкой во время компиляции
+         * @param str Строка UUID
+         * @return BleUuid UUID (невалидный при ошибке разбора во время выполнения)
+         * @note В constexpr-контексте некорректная строка останавливает сборку
+         */
+        static constexpr BleUuid fromString(const std::string_view str) noexcept
+        {
+            BleUuid uuid;
+            if (const UuidError error = parse(str, uuid); error != UuidError::NONE)
+            {
+                detail::invalidUuidLiteral(error);
+            }
+            return uuid;
+        }
+
+        /**
+         * @brief Создание 16-бит UUID из числа
+         */
+        static constexpr BleUuid from16(const uint16_t value) noexcept
+        {
+            BleUuid uuid;
+            uuid.mLen = ESP_UUID_LEN_16;
+            uuid.mBytes[0] = static_cast<uint8_t>(value >> 8);
+            uuid.mBytes[1] = static_cast<uint8_t>(value);
+            return uuid;
+        }
+
+        /**
+         * @brief Создание UUID из структуры ESP-IDF
+         * @param uuid UUID из API ESP-IDF
+         * @param invertBytes Флаг инверсии байт (актуально для 128-бит UUID)
+         * @return BleUuid UUID (невалидный при неизвестной длине)
+         */
+        static BleUuid fromEsp(const esp_bt_uuid_t& uuid, const bool invertBytes) noexcept
+        {
+            BleUuid result;
+            switch (uuid.len)
+            {
+            case ESP_UUID_LEN_16:
+                result = from16(uuid.uuid.uuid16);
+                break;
+            case ESP_UUID_LEN_32:
+                result.mLen = ESP_UUID_LEN_32;
+                for (size_t i = 0; i < ESP_UUID_LEN_32; i++)
+                {
+                    result.mBytes[i] = static_cast<uint8_t>(uuid.uuid.uuid32 >> (8 * (ESP_UUID_LEN_32 - 1 - i)));
+                }
+                break;
+            case ESP_UUID_LEN_128:
+                result.mLen = ESP_UUID_LEN_128;
+                for (size_t i = 0; i < ESP_UUID_LEN_128; i++)
+                {
+                    result.mBytes[i] = invertBytes ? uuid.uuid.uuid128[ESP_UUID_LEN_128 - 1 - i] : uuid.uuid.uuid128[i];
+                }
+                break;
+            default:
+                break;
+            }
+            return result;
+        }
+
+        /**
+         * @brief Длина UUID в байтах (0 для невалидного UUID)
+         */
+        [[nodiscard]] constexpr uint8_t length() const noexcept { return mLen; }
+
+        /**
+         * @brief Проверка валидности UUID
+         */
+        [[nodiscard]] constexpr bool isValid() const noexcept { return mLen != 0; }
+
+        /**
+         * @brief Байты UUID в порядке записи строки
+         */
+        [[nodiscard]] constexpr const std::array<uint8_t, ESP_UUID_LEN_128>& bytes() const noexcept { return mBytes; }
+
+        /**
+         * @brief Значение 16-бит UUID
+         */
+        [[nodiscard]] constexpr uint16_t value16() const noexcept
+        {
+            return static_cast<uint16_t>(mBytes[0] << 8 | mBytes[1]);
+        }
+
+        /**
+         * @brief Значение 32-бит UUID
+         */
+        [[nodiscard]] constexpr uint32_t value32() const noexcept
+        {
+            return static_cast<uint32_t>(mBytes[0]) << 24 | static_cast<uint32_t>(mBytes[1]) << 16 |
+                static_cast<uint32_t>(mBytes[2]) << 8 | mBytes[3];
+        }
+
+        /**
+         * @brief Преобразование в структуру ESP-IDF
+         * @param invertBytes Флаг инверсии байт (актуально для 128-бит UUID)
+         * @return esp_bt_uuid_t UUID для API ESP-IDF (len = 0 для невалидного UUID)
+         */
+        [[nodiscard]] esp_bt_uuid_t toEsp(const bool invertBytes) const noexcept
+        {
+            esp_bt_uuid_t uuid = {
+                .len = mLen,
+                .uuid = {.uuid16 = 0}
+            };
+
+            switch (mLen)
+            {
+            case ESP_UUID_LEN_16:
+                uuid.uuid.uuid16 = value16();
+                break;
+            case ESP_UUID_LEN_32:
+                uuid.uuid.uuid32 = value32();
+                break;
+            case ESP_UUID_LEN_128:
+                for (size_t i = 0; i < ESP_UUID_LEN_128; i++)
+                {
+                    uuid.uuid.uuid128[i] = invertBytes ? mBytes[ESP_UUID_LEN_128 - 1 - i] : mBytes[i];
+                }
+                break;
+            default:
+                break;
+            }
+            return uuid;
+        }
+
+        /**
+         * @brief Строковое представление UUID для логирования
+         * @return std::array<char, 37> Строка с завершающим нулем
+         */
+        [[nodiscard]] constexpr std::array<char, STRING_LEN_128 + 1> toString() const noexcept
+        {
+            constexpr char digits[] = "0123456789ABCDEF";
+            std::array<char, STRING_LEN_128 + 1> str{};
+            size_t pos = 0;
+            for (size_t i = 0; i < mLen; i++)
+            {
+                if (mLen == ESP_UUID_LEN_128 && (i == 4 || i == 6 || i == 8 || i == 10))
+                {
+                    str[pos++] = '-';
+                }
+                str[pos++] = digits[mBytes[i] >> 4];
+                str[pos++] = digits[mBytes[i] & 0x0F];
+            }
+            str[pos] = '\0';
+            return str;
+        }
+
+        constexpr bool operator==(const BleUuid& other) const noexcept
+        {
+            if (mLen != other.mLen) return false;
+            for (size_t i = 0; i < mLen; i++)
+            {
+                if (mBytes[i] != other.mBytes[i]) return false;
+            }
+            return true;
+        }
+
+        constexpr bool operator!=(const BleUuid& other) const noexcept { return !(*this == other); }
+
+    private:
+        uint8_t mLen = 0;                                  ///< Длина UUID в байтах
+        std::array<uint8_t, ESP_UUID_LEN_128> mBytes = {}; ///< Байты UUID (big-endian)
+    };
+
+    namespace uuid_literals
+    {
+        /**
+         * @brief Литерал UUID: "6E400001-B5A3-F393-E0A9-E50E24DCCA9E"_uuid
+         */
+        constexpr BleUuid operator""_uuid(const char* str, const size_t len) noexcept
+        {
+            return BleUuid::fromString(std::string_view(str, len));
+        }
+    } // namespace uuid_literals
+} // namespace net
+
+#endif // NET_BLE_UUID_H
@@ -0,0 +1,136 @@
+#ifndef NET_BLE_VALUE_CACHE_H
+#define NET_BLE_VALUE_CACHE_H
+
+#include "packets/packet.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "esp_err.h"
+#include "esp_gatt_defs.h"
+
+namespace net
+{
+    /**
+     * @brief Версионированный кэш значения атрибута для чтения клиентом
+     * @details Значение хранится в двух слотах (двойная буферизация): производитель пишет
+     *          новое значение в неактивный слот и публикует его атомарной сменой версии,
+     *          не захватывая мьютексов и не дожидаясь читателей. Читатель копирует
+     *          опубликованный слот и проверяет номер версии слота (seqlock): если за время
+     *          копирования производитель дважды сменил значение, копирование повторяется.
+     *          Запросы чтения обслуживаются в задаче BTC прямо из кэша, без callback'ов
+     *          приложения. Длинное чтение (Read Request + Read Blob с offset) видит один
+     *          снимок: при первом запросе значение длиннее MTU - 1 копируется в слот
+     *          читателя соединения, и все фрагменты отдаются из него.
+     */
+    class BleValueCache
+    {
+    public:
+        /// @brief Максимальная длина значения
+        static constexpr size_t MAX_VALUE = MAX_MTU;
+
+        /// @brief Одновременных длинных чтений (по одному на соединение)
+        static constexpr size_t MAX_READERS = 4;
+
+        /// @brief Повторов копирования, после которых чтение отклоняется (ESP_GATT_BUSY)
+        static constexpr size_t MAX_READ_RETRIES = 4;
+
+        BleValueCache() = default;
+
+        // Запрет копирования и присваивания
+        BleValueCache(const BleValueCache&) = delete;
+        BleValueCache& operator=(const BleValueCache&) = delete;
+
+        /**
+         * @brief Публикация нового значения (любая задача, без блокировок)
+         * @param data Значение
+         * @param len Длина (не больше MAX_VALUE)
+         * @return esp_err_t ESP_ERR_INVALID_SIZE - значение слишком длинное,
+         *         ESP_ERR_INVALID_STATE - значение в этот момент публикует другая задача
+         * @note Производители одного значения не ждут друг друга: при одновременной
+         *       публикации одна из них получает ESP_ERR_INVALID_STATE и может повторить.
+         */
+        esp_err_t update(const uint8_t* data, size_t len) noexcept;
+
+        /**
+         * @brief Согласованная копия текущего значения
+         * @param[out] out Буфер назначения
+         * @param[out] len Длина значения
+         * @param[out] version Версия скопированного значения (0 - значение не задавалось)
+         * @return esp_err_t ESP_ERR_INVALID_SIZE - буфер меньше значения,
+         *         ESP_ERR_TIMEOUT - значение менялось быстрее, чем копировалось
+         */
+        esp_err_t read(std::span<uint8_t> out, size_t& len, uint32_t& version) const noexcept;
+
+        /**
+         * @brief Текущая версия значения (растет с каждой публикацией)
+         */
+        [[nodiscard]] uint32_t version() const noexcept { return mVersion.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Ответ на запрос чтения (только задача BTC)
+         * @param connId Идентификатор соединения
+         * @param offset Смещение (Read Blob)
+         * @param isLong Продолжение длинного чтения
+         * @param mtu MTU соединения
+         * @param[out] rsp Ответ: значение с offset длиной до MTU - 1
+         * @return esp_gatt_status_t Статус ответа клиенту
+         */
+        esp_gatt_status_t serveRead(uint16_t connId, uint16_t offset, bool isLong, uint16_t mtu,
+                                    esp_gatt_rsp_t& rsp) noexcept;
+
+        /**
+         * @brief Освобождение слота читателя при разрыве соединения (только задача BTC)
+         */
+        void releaseReader(uint16_t connId) noexcept;
+
+        /**
+         * @brief Освобождение всех слотов читателей (остановка стека)
+         */
+        void releaseReaders() noexcept;
+
+    private:
+        static_assert(MAX_VALUE <= ESP_GATT_MAX_ATTR_LEN, "Cached value must fit GATT response");
+
+        /// @brief Слот читателя свободен
+        static constexpr uint16_t NO_CONN = 0xFFFF;
+
+        /// @brief Версия слота на время записи
+        static constexpr uint32_t WRITING = UINT32_MAX;
+
+        /**
+         * @brief Слот значения
+         */
+        struct Slot
+        {
+            std::atomic<uint32_t> version = 0;   ///< Версия значения (WRITING на время записи)
+            uint16_t len = 0;                    ///< Длина значения
+            std::array<uint8_t, MAX_VALUE> data; ///< Значение
+        };
+
+        /**
+         * @brief Снимок длинного чтения
+         */
+        struct Reader
+        {
+            uint16_t connId = NO_CONN;           ///< Соединение (NO_CONN - слот свободен)
+            uint16_t len = 0;                    ///< Длина снимка
+            std::array<uint8_t, MAX_VALUE> data; ///< Снимок значения
+        };
+
+        /**
+         * @brief Слот читателя соединения (nullptr, если нет)
+         */
+        Reader* findReader(uint16_t connId) noexcept;
+
+        std::array<Slot, 2> mSlots;                   ///< Двойной буфер значения
+        std::atomic<uint32_t> mVersion = 0;           ///< Опубликованная версия (слот - version & 1)
+        std::atomic_flag mWriting = ATOMIC_FLAG_INIT; ///< Идет публикация
+        std::array<Reader, MAX_READERS> mReaders;     ///< Снимки длинных чтений (только задача BTC)
+    };
+} // namespace net
+
+#endif // NET_BLE_VALUE_CACHE_H
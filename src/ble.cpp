@@ -5,23 +5,47 @@
 #include "esp_bt_main.h"
 #include "esp_gap_ble_api.h"
 #include "esp_gatts_api.h"
+#include "esp_gattc_api.h"
 
 #include "esp_log.h"
 #include "esp_err.h"
 
-#include <cstring>
+#include "esp_timer.h"
+
+#include <algorithm>
 #include <cinttypes>
+#include <cstring>
 
 #define ESP_BLE_GAP_ALL_PHYS_PREF 0x03
 #define ESP_BLE_GAP_PHY_OPTION_NO_PREF 0
 
+// Код HCI "PIN or Key Missing": удаленное устройство не нашло ключ для возобновления шифрования
+#define HCI_KEY_MISSING 0x06
+
 // ReSharper disable once CppDFATimeOver
 static net::BLE* sBLEInstance = nullptr;
 
 namespace net
 {
     BLE::BLE(const BleConfig::Preset preset) :
-        mConfig(preset)
+        BLE(BleConfig(preset))
+    {
+    }
+
+    BLE::BLE(const BleConfig& config) :
+        mConfig(config),
+        mChannels([this](const uint16_t connId, const uint8_t* data, const size_t len, const bool blocking)
+        {
+            return sendChannelFrame(connId, data, len, blocking);
+        }),
+        mBridge([this](const uint16_t connId, const uint8_t* data, const size_t len)
+        {
+            return sendFromTask(connId, data, len);
+        }),
+        mSendScheduler([this](const uint16_t connId, const uint8_t* data, const size_t len)
+        {
+            return sendFromTask(connId, data, len);
+        })
     {
         sBLEInstance = this;
         ESP_LOGD(TAG, "Instance created");
@@ -34,6 +58,17 @@ namespace net
             sBLEInstance = nullptr;
         }
         stop();
+
+        if (mStartupEvents != nullptr)
+        {
+            vEventGroupDelete(mStartupEvents);
+        }
+
+        if (mReconnectTimer != nullptr)
+        {
+            esp_timer_stop(mReconnectTimer);
+            esp_timer_delete(mReconnectTimer);
+        }
     }
 
     esp_err_t BLE::initialize(const std::string& deviceName,
@@ -52,14 +87,17 @@ namespace net
             ESP_LOGE(TAG, "Invalid parameters: empty name or null callback");
             return ESP_ERR_INVALID_ARG;
         }
+        applyPendingConfig();
 
         mDeviceName = deviceName;
+        mAdvLayoutValid = false;
         mDataCallback = std::move(dataCallback);
 
         // Release classic BT memory
         ESP_ERROR_CHECK(esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT));
 
         // Initialize BLE 5.0 controller
+        beginStartupPhase(BleStartupPhase::CONTROLLER);
         esp_err_t ret = esp_bt_controller_init(&mConfig.controller);
         if (ret != ESP_OK)
         {
@@ -73,7 +111,9 @@ namespace net
             ESP_LOGE(TAG, "Controller enable failed: %s", esp_err_to_name(ret));
             return ret;
         }
+        endStartupPhase(BleStartupPhase::CONTROLLER);
 
+        beginStartupPhase(BleStartupPhase::HOST);
         ret = esp_bluedroid_init();
         if (ret != ESP_OK)
         {
@@ -87,6 +127,7 @@ namespace net
             ESP_LOGE(TAG, "Bluedroid enable failed: %s", esp_err_to_name(ret));
             return ret;
         }
+        endStartupPhase(BleStartupPhase::HOST);
 
         // Регистрируем оба обработчика событий
         ret = esp_ble_gatts_register_callback(gattsEventHandler);
@@ -103,6 +144,17 @@ namespace net
             return ret;
         }
 
+        // Регистрация GATT приложения - дальнейшее создание базы идет по событиям,
+        // поэтому запускаем ее как можно раньше, а настройку GAP выполняем параллельно
+        beginStartupPhase(BleStartupPhase::APP_REGISTER);
+        ret = esp_ble_gatts_app_register(mConfig.gatt.appId);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "GATTS app register failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+
+        beginStartupPhase(BleStartupPhase::GAP_CONFIG);
         ret = esp_ble_gap_set_device_name(deviceName.c_str());
         if (ret != ESP_OK)
         {
@@ -110,21 +162,62 @@ namespace net
             return ret;
         }
 
-        esp_ble_gap_set_security_param(ESP_BLE_SM_AUTHEN_REQ_MODE, &mConfig.security.authReq, sizeof(uint8_t));
-        esp_ble_gap_set_security_param(ESP_BLE_SM_IOCAP_MODE, &mConfig.security.ioCap, sizeof(uint8_t));
-        esp_ble_gap_set_security_param(ESP_BLE_SM_MAX_KEY_SIZE, &mConfig.security.keySize, sizeof(uint8_t));
-        esp_ble_gap_set_security_param(ESP_BLE_SM_SET_INIT_KEY, &mConfig.security.initKey, sizeof(uint8_t));
-        esp_ble_gap_set_security_param(ESP_BLE_SM_SET_RSP_KEY, &mConfig.security.rspKey, sizeof(uint8_t));
+        applySecurityParams();
 
-        ret = esp_ble_gatts_app_register(mConfig.gatt.appId);
-        if (ret != ESP_OK)
+        // RPA генерирует стек по локальному IRK; реклама стартует после SET_LOCAL_PRIVACY_COMPLETE
+        if (mConfig.privacy.enabled)
         {
-            ESP_LOGE(TAG, "GATTS app register failed: %s", esp_err_to_name(ret));
-            return ret;
+            ret = esp_ble_gap_config_local_privacy(true);
+            if (ret != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Config local privacy failed: %s", esp_err_to_name(ret));
+                return ret;
+            }
         }
 
         mIsInitialized = true;
 
+        if (const esp_err_t pmRet = mPower.begin(mConfig); pmRet != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Power manager unavailable: %s", esp_err_to_name(pmRet));
+        }
+
+        mCompression.setWindowBits(mConfig.gatt.compressionWindowBits);
+
+        // Без задачи диагностика пишет в лог сразу, с тем же лимитом
+        if (const esp_err_t diagRet = mDiag.begin(mConfig); diagRet != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Deferred diagnostics unavailable: %s", esp_err_to_name(diagRet));
+        }
+
+        // Без задачи доставки callback'и данных вызываются из задачи BTC
+        if (const esp_err_t rxRet = mRxDispatcher.begin(
+                mConfig, [this](const uint16_t connId, const uint32_t generation, const std::span<const uint8_t> data)
+                {
+                    deliverData(connId, generation, data);
+                });
+            rxRet != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Deferred data delivery unavailable: %s", esp_err_to_name(rxRet));
+        }
+
+        // Без задачи выпуска scheduleSend недоступен, sendData работает как прежде
+        if (const esp_err_t scheduleRet = mSendScheduler.begin(mConfig); scheduleRet != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Scheduled sends unavailable: %s", esp_err_to_name(scheduleRet));
+        }
+
+        if (esp_ble_gap_get_whitelist_size(&mAcceptListCapacity) != ESP_OK)
+        {
+            mAcceptListCapacity = 0;
+        }
+
+        // С приватностью списки загружаются после включения RPA
+        if (!mConfig.privacy.enabled && mConfig.acceptList.autoFromBonds)
+        {
+            loadBondedToAcceptList();
+        }
+
         // Устанавливаем предпочтительные параметры PHY по умолчанию
         ret = setPreferredPhy(mConfig.connection.txPhy, mConfig.connection.rxPhy);
         if (ret != ESP_OK)
@@ -134,6 +227,22 @@ namespace net
             return ret;
         }
 
+        // Данные рекламы не зависят от GATT базы - готовим их, пока создается сервис
+        if (mAutoStart)
+        {
+            ret = mConfig.supportsExtendedAdvertising()
+                      ? configureExtendedAdvertising()
+                      : configureLegacyAdvertising();
+            if (ret != ESP_OK)
+            {
+                return ret;
+            }
+        }
+        else
+        {
+            endStartupPhase(BleStartupPhase::GAP_CONFIG);
+        }
+
         ESP_LOGI(TAG, "BLE 5.0 initialized successfully. Device name: %s", deviceName.c_str());
         return ESP_OK;
     }
@@ -141,128 +250,327 @@ namespace net
     esp_err_t BLE::quickStart(const std::string& deviceName,
                               std::unique_ptr<esp32_c3::objects::Callback> dataCallback)
     {
-        // 1. Инициализация BLE стека
-        esp_err_t ret = initialize(deviceName, std::move(dataCallback));
-        if (ret != ESP_OK)
         {
-            ESP_LOGE(TAG, "BLE initialization failed: %s", esp_err_to_name(ret));
-            return ret;
-        }
-
-        // 2. Создание сервиса
-        const esp_bt_uuid_t serviceUuid = uuidFromString(mConfig.gatt.serviceUuid, mConfig.gatt.invertBytes);
-        ret = createService(serviceUuid);
-        if (ret != ESP_OK)
-        {
-            ESP_LOGE(TAG, "Service creation failed: %s", esp_err_to_name(ret));
-            stop();
-            return ret;
+            // Повторный быстрый старт работающего стека не перезапускает его
+            std::lock_guard lock(mMutex);
+            if (mIsInitialized)
+            {
+                ESP_LOGW(TAG, "Already initialized");
+                return ESP_OK;
+            }
         }
 
-        // 3. Создание характеристики
-        const esp_bt_uuid_t charUuid = uuidFromString(mConfig.gatt.charUuid, mConfig.gatt.invertBytes);
-        ret = createCharacteristic(charUuid, mConfig.gatt.charProperties);
-        if (ret != ESP_OK)
+        esp_err_t ret = start(deviceName, std::move(dataCallback));
+        if (ret == ESP_OK)
         {
-            ESP_LOGE(TAG, "Characteristic creation failed: %s", esp_err_to_name(ret));
-            stop();
-            return ret;
+            ret = waitForStartup(pdMS_TO_TICKS(STARTUP_TIMEOUT_MS));
         }
 
-        // 4. Запуск рекламы (автовыбор типа)
-        ret = startAdvertising();
         if (ret != ESP_OK)
         {
-            ESP_LOGE(TAG, "Advertising start failed: %s", esp_err_to_name(ret));
+            ESP_LOGE(TAG, "Quick start failed: %s", esp_err_to_name(ret));
             stop();
             return ret;
         }
 
         ESP_LOGI(TAG, "Quick start completed. Service: %s, Char: %s",
-                 mConfig.gatt.serviceUuid.c_str(), mConfig.gatt.charUuid.c_str());
+                 mConfig.gatt.serviceUuid.toString().data(), mConfig.gatt.charUuid.toString().data());
         return ESP_OK;
     }
 
-    esp_bt_uuid_t BLE::uuidFromString(const std::string& uuidStr, const bool invertBytes)
+    esp_err_t BLE::start(const std::string& deviceName,
+                         std::unique_ptr<esp32_c3::objects::Callback> dataCallback,
+                         BleStartupCallback onComplete)
     {
-        if (uuidStr.empty())
+        std::unique_lock lock(mMutex);
+
+        if (mIsInitialized)
         {
-            ESP_LOGE(TAG, "Empty UUID string");
-            return esp_bt_uuid_t{
-                .len = 0,
-                .uuid = {.uuid16 = 0}
-            };
+            ESP_LOGW(TAG, "Already initialized");
+            return ESP_OK;
         }
+        applyPendingConfig();
 
-        esp_bt_uuid_t uuid = {
-            .len = 0,
-            .uuid = {.uuid16 = 0}
-        };
-
-        // Удаляем все дефисы и приводим к нижнему регистру
-        std::string normalized;
-        for (const char c : uuidStr)
+        if (mStartupEvents == nullptr)
         {
-            if (c != '-')
+            mStartupEvents = xEventGroupCreate();
+            if (mStartupEvents == nullptr)
             {
-                normalized += tolower(c);
+                ESP_LOGE(TAG, "Failed to create startup event group");
+                return ESP_ERR_NO_MEM;
             }
         }
+        xEventGroupClearBits(mStartupEvents, STARTUP_DONE_BIT);
+
+        mStartupReport = {};
+        mPhaseStartUs = {};
+        mStartupBeginUs = esp_timer_get_time();
+        mStartupCallback = std::move(onComplete);
+        mStartupPending = STEP_GATT_DB | STEP_ADV_DATA | STEP_SCAN_RSP |
+                          (mConfig.supportsExtendedAdvertising() ? STEP_ADV_PARAMS : 0);
+        if (mConfig.privacy.enabled)
+        {
+            mStartupPending |= STEP_PRIVACY;
+        }
+        mAutoStart = true;
+        mStats = {};
+
+        if (mPersistence)
+        {
+            mPersistence->load();
+            mStats.warmBoot = mPersistence->beginBoot(BlePersistence::computeDatabaseHash(mConfig));
+        }
+
+        if (const esp_err_t ret = initialize(deviceName, std::move(dataCallback)); ret != ESP_OK)
+        {
+            finishStartup(ret, mLastStartupPhase);
+            lock.unlock();
+            notifyStartup();
+            return ret;
+        }
+        return ESP_OK;
+    }
+
+    esp_err_t BLE::waitForStartup(const TickType_t timeout) const
+    {
+        if (mStartupEvents == nullptr)
+        {
+            ESP_LOGE(TAG, "Startup not requested");
+            return ESP_ERR_INVALID_STATE;
+        }
 
-        // Проверяем длину и формат UUID
-        if (normalized.length() == 4)
+        const EventBits_t bits = xEventGroupWaitBits(mStartupEvents, STARTUP_DONE_BIT, pdFALSE, pdTRUE, timeout);
+        if ((bits & STARTUP_DONE_BIT) == 0)
         {
-            // 16-bit UUID (0000)
-            uuid.len = ESP_UUID_LEN_16;
-            uuid.uuid.uuid16 = static_cast<uint16_t>(strtoul(normalized.c_str(), nullptr, 16));
-            ESP_LOGD(TAG, "Converted 16-bit UUID: 0x%04" PRIx16, uuid.uuid.uuid16);
+            ESP_LOGE(TAG, "Startup timeout");
+            return ESP_ERR_TIMEOUT;
         }
-        else if (normalized.length() == 8)
+
+        std::lock_guard lock(mMutex);
+        return mStartupReport.status;
+    }
+
+    BleStartupReport BLE::getStartupReport() const
+    {
+        std::lock_guard lock(mMutex);
+        return mStartupReport;
+    }
+
+    void BLE::beginStartupPhase(const BleStartupPhase phase) noexcept
+    {
+        mPhaseStartUs[static_cast<size_t>(phase)] = esp_timer_get_time();
+        mLastStartupPhase = phase;
+    }
+
+    void BLE::endStartupPhase(const BleStartupPhase phase) noexcept
+    {
+        const auto index = static_cast<size_t>(phase);
+        if (mPhaseStartUs[index] != 0)
         {
-            // 32-bit UUID (00000000)
-            uuid.len = ESP_UUID_LEN_32;
-            uuid.uuid.uuid32 = static_cast<uint32_t>(strtoul(normalized.c_str(), nullptr, 16));
-            ESP_LOGD(TAG, "Converted 32-bit UUID: 0x%08" PRIx32, uuid.uuid.uuid32);
+            mStartupReport.phaseUs[index] = static_cast<uint32_t>(esp_timer_get_time() - mPhaseStartUs[index]);
         }
-        else if (normalized.length() == 32)
+    }
+
+    bool BLE::isStartupActive() const noexcept
+    {
+        return mAutoStart && !mStartupReport.completed;
+    }
+
+    void BLE::advanceStartup(const esp_gatts_cb_event_t event, const esp_gatt_status_t status)
+    {
+        std::lock_guard lock(mMutex);
+        if (!isStartupActive()) return;
+
+        esp_err_t ret = ESP_OK;
+        switch (event)
         {
-            // 128-bit UUID (00000000000000000000000000000000)
-            uuid.len = ESP_UUID_LEN_128;
+        case ESP_GATTS_REG_EVT:
+            endStartupPhase(BleStartupPhase::APP_REGISTER);
+            if (status != ESP_GATT_OK) break;
+            beginStartupPhase(BleStartupPhase::SERVICE_CREATE);
+            ret = createService(mConfig.gatt.serviceUuid.toEsp(mConfig.gatt.invertBytes));
+            break;
 
-            // Проверяем что все символы hex
-            if (normalized.find_first_not_of("0123456789abcdef") != std::string::npos)
+        case ESP_GATTS_CREATE_EVT:
+            endStartupPhase(BleStartupPhase::SERVICE_CREATE);
+            if (status != ESP_GATT_OK) break;
+            beginStartupPhase(BleStartupPhase::CHAR_ADD);
+            ret = createCharacteristic(mConfig.gatt.charUuid.toEsp(mConfig.gatt.invertBytes),
+                                       mConfig.gatt.charProperties);
+            break;
+
+        case ESP_GATTS_ADD_CHAR_EVT:
+        case ESP_GATTS_ADD_CHAR_DESCR_EVT:
+            // Фаза CHAR_ADD продолжается, пока не добавлены дополнительные атрибуты
+            if (status == ESP_GATT_OK && mConfig.gatt.bulkEnabled && mBulkHandle == 0)
             {
-                ESP_LOGE(TAG, "Invalid characters in 128-bit UUID");
-                uuid.len = 0;
-                return uuid;
+                ret = addBulkCharacteristic();
+                break;
             }
-
-            // Конвертируем каждые 2 символа в байт
-            for (size_t i = 0; i < ESP_UUID_LEN_128; i++)
+            if (status == ESP_GATT_OK && mConfig.gatt.channelsEnabled && mChannelHandle == 0)
+            {
+                ret = addChannelCharacteristic();
+                break;
+            }
+            if (status == ESP_GATT_OK && mConfig.gatt.channelsEnabled && mChannelCccdHandle == 0)
+            {
+                ret = addChannelCccd();
+                break;
+            }
+            if (status == ESP_GATT_OK && mConfig.gatt.compressionEnabled && mCompressionHandle == 0)
             {
-                // Если `invertBytes` == true, читаем байты в обратном порядке
-                const size_t bytePos = invertBytes
-                                           ? (ESP_UUID_LEN_128 - 1 - i) * 2 // Инвертируем порядок
-                                           : i * 2;                         // Оставляем как есть
+                ret = addCompressionCharacteristic();
+                break;
+            }
+            endStartupPhase(BleStartupPhase::CHAR_ADD);
+            if (status != ESP_GATT_OK) break;
+            // Хэндлы выделяются подряд от хэндла сервиса: занятые хэндлы (включая объявление
+            // сервиса) вместе с резервом должны совпасть с бюджетом serviceHandleCount()
+            if (const auto used = static_cast<uint16_t>(
+                    std::max({mCharHandle, mBulkHandle, mChannelCccdHandle, mCompressionHandle}) - mServiceHandle + 2);
+                used != serviceHandleCount())
+            {
+                ESP_LOGE(TAG, "Service handle budget %u does not match %u attribute handles",
+                         serviceHandleCount(), used);
+                ret = ESP_ERR_INVALID_SIZE;
+                break;
+            }
+            beginStartupPhase(BleStartupPhase::SERVICE_START);
+            ret = esp_ble_gatts_start_service(mServiceHandle);
+            break;
 
-                std::string byteStr = normalized.substr(bytePos, 2);
-                uuid.uuid.uuid128[i] = static_cast<uint8_t>(strtoul(byteStr.c_str(), nullptr, 16));
+        case ESP_GATTS_START_EVT:
+            endStartupPhase(BleStartupPhase::SERVICE_START);
+            if (status != ESP_GATT_OK) break;
+            if (mPersistence)
+            {
+                const uint16_t handles[] = {mServiceHandle, mCharHandle, mBulkHandle, mChannelHandle, mChannelCccdHandle,
+                                            mCompressionHandle};
+                mPersistence->commitLayout(handles, std::size(handles));
             }
+            completeStartupStep(STEP_GATT_DB);
+            return;
+
+        default:
+            return;
+        }
+
+        if (status != ESP_GATT_OK)
+        {
+            ESP_LOGE(TAG, "Startup GATTS event %d failed, status: 0x%02X", event, status);
+            finishStartup(ESP_FAIL, mLastStartupPhase);
+        }
+        else if (ret != ESP_OK)
+        {
+            finishStartup(ret, mLastStartupPhase);
+        }
+    }
+
+    void BLE::completeStartupStep(const StartupStep step)
+    {
+        std::lock_guard lock(mMutex);
+        if (!isStartupActive() || (mStartupPending & step) == 0) return;
+
+        mStartupPending &= ~step;
+
+        // Все шаги настройки рекламы выполнены
+        if ((mStartupPending & ~STEP_GATT_DB) == 0 && step != STEP_GATT_DB)
+        {
+            endStartupPhase(BleStartupPhase::GAP_CONFIG);
+        }
+
+        if (mStartupPending != 0) return;
+
+        beginStartupPhase(BleStartupPhase::ADV_START);
+        const esp_err_t ret = mConfig.supportsExtendedAdvertising()
+                                  ? startExtendedAdvertising()
+                                  : startLegacyAdvertising();
+        if (ret != ESP_OK)
+        {
+            finishStartup(ret, BleStartupPhase::ADV_START);
+        }
+    }
+
+    void BLE::finishStartup(const esp_err_t status, const BleStartupPhase phase)
+    {
+        std::lock_guard lock(mMutex);
+        if (!isStartupActive()) return;
 
-            // Логируем первые 4 байта для проверки
-            ESP_LOGD(TAG, "Converted 128-bit UUID (first bytes): %02X%02X%02X%02X...",
-                     uuid.uuid.uuid128[0], uuid.uuid.uuid128[1],
-                     uuid.uuid.uuid128[2], uuid.uuid.uuid128[3]);
+        // Запуск рекламы вне автомата (перезапуски) не меняет отчет
+        if (phase == BleStartupPhase::ADV_START)
+        {
+            endStartupPhase(phase);
+        }
+        mStartupReport.status = status;
+        mStartupReport.completed = true;
+        mStartupReport.totalUs = static_cast<uint32_t>(esp_timer_get_time() - mStartupBeginUs);
+        if (status != ESP_OK)
+        {
+            mStartupReport.failedPhase = phase;
+            ESP_LOGE(TAG, "Startup failed at %s: %s", startupPhaseToName(phase), esp_err_to_name(status));
         }
         else
         {
-            ESP_LOGE(TAG, "Invalid UUID format/length: %s", uuidStr.c_str());
-            uuid.len = 0;
+            ESP_LOGI(TAG, "Startup completed in %" PRIu32 " us", mStartupReport.totalUs);
+        }
+
+        for (size_t i = 0; i < BleStartupReport::PHASE_COUNT; i++)
+        {
+            ESP_LOGD(TAG, "  %-14s %" PRIu32 " us",
+                     startupPhaseToName(static_cast<BleStartupPhase>(i)), mStartupReport.phaseUs[i]);
+        }
+
+        xEventGroupSetBits(mStartupEvents, STARTUP_DONE_BIT);
+
+        // Callback вызывается notifyStartup() после освобождения мьютекса
+        mStartupNotifyPending = static_cast<bool>(mStartupCallback);
+    }
+
+    void BLE::notifyStartup()
+    {
+        BleStartupCallback callback;
+        BleStartupReport report;
+        {
+            std::lock_guard lock(mMutex);
+            if (!mStartupNotifyPending) return;
+
+            mStartupNotifyPending = false;
+            callback = std::move(mStartupCallback);
+            mStartupCallback = nullptr;
+            report = mStartupReport;
         }
 
+        mTrace.record(BleTraceKind::CALLBACK_BEGIN, static_cast<uint8_t>(BleTraceCallback::STARTUP));
+        callback(report);
+        mTrace.record(BleTraceKind::CALLBACK_END, static_cast<uint8_t>(BleTraceCallback::STARTUP));
+    }
+
+    esp_bt_uuid_t BLE::uuidFromString(const std::string_view uuidStr, const bool invertBytes)
+    {
+        esp_bt_uuid_t uuid = {
+            .len = 0,
+            .uuid = {.uuid16 = 0}
+        };
+        uuidFromString(uuidStr, invertBytes, uuid);
         return uuid;
     }
 
+    esp_err_t BLE::uuidFromString(const std::string_view uuidStr, const bool invertBytes, esp_bt_uuid_t& uuid)
+    {
+        BleUuid parsed;
+        if (const UuidError error = BleUuid::parse(uuidStr, parsed); error != UuidError::NONE)
+        {
+            ESP_LOGE(TAG, "Invalid UUID '%.*s': %s",
+                     static_cast<int>(uuidStr.size()), uuidStr.data(), uuidErrorToName(error));
+            uuid.len = 0;
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        uuid = parsed.toEsp(invertBytes);
+        ESP_LOGD(TAG, "Converted %u-bit UUID: %s", parsed.length() * 8, parsed.toString().data());
+        return ESP_OK;
+    }
+
     esp_err_t BLE::createService(const esp_bt_uuid_t& serviceUuid,
                                  const bool isPrimary) const
     {
@@ -289,7 +597,8 @@ namespace net
             .is_primary = isPrimary
         };
 
-        if (const esp_err_t ret = esp_ble_gatts_create_service(mGattsIf, &serviceId, 4); ret != ESP_OK)
+        if (const esp_err_t ret = esp_ble_gatts_create_service(mGattsIf, &serviceId, serviceHandleCount());
+            ret != ESP_OK)
         {
             ESP_LOGE(TAG, "Create service failed: %s", esp_err_to_name(ret));
             return ret;
@@ -300,6 +609,18 @@ namespace net
         return ESP_OK;
     }
 
+    uint16_t BLE::serviceHandleCount() const noexcept
+    {
+        // Объявление сервиса, характеристика (объявление + значение), резерв,
+        // по два хэндла под характеристики потокового приема и возможностей сжатия
+        // и три под транспорт каналов (характеристика + CCCD)
+        uint16_t numHandles = 4;
+        if (mConfig.gatt.bulkEnabled) numHandles += 2;
+        if (mConfig.gatt.channelsEnabled) numHandles += 3;
+        if (mConfig.gatt.compressionEnabled) numHandles += 2;
+        return numHandles;
+    }
+
     esp_err_t BLE::createCharacteristic(const esp_bt_uuid_t& charUuid,
                                         const esp_gatt_char_prop_t properties) const
     {
@@ -317,9 +638,9 @@ namespace net
             return ESP_OK;
         }
 
-        // Подготовка структуры управления атрибутом
+        // Ответы формирует приложение: чтение обслуживается из mValueCache
         esp_attr_control_t control = {
-            .auto_rsp = ESP_GATT_AUTO_RSP
+            .auto_rsp = ESP_GATT_RSP_BY_APP
         };
 
         // Подготовка значения характеристики
@@ -334,12 +655,12 @@ namespace net
 
         // 4. Вызов API с корректными параметрами
         const esp_err_t ret = esp_ble_gatts_add_char(
-            mServiceHandle,               // Хэндл сервиса
-            &charUuidCopy,                // Копия UUID характеристики
-            mConfig.gatt.charPermissions, // Права доступа
-            properties,                   // Свойства характеристики
-            &charValue,                   // Значение характеристики
-            &control                      // Управление атрибутом
+            mServiceHandle,                      // Хэндл сервиса
+            &charUuidCopy,                       // Копия UUID характеристики
+            mConfig.characteristicPermissions(), // Права доступа
+            properties,                          // Свойства характеристики
+            &charValue,                          // Значение характеристики
+            &control                             // Управление атрибутом
         );
 
         if (ret != ESP_OK)
@@ -365,12 +686,14 @@ namespace net
         if (mConfig.supportsExtendedAdvertising())
         {
             ESP_LOGI(TAG, "Starting extended advertising (BLE 5.0)");
-            return configureExtendedAdvertising();
+            const esp_err_t ret = configureExtendedAdvertising();
+            return ret == ESP_OK ? startExtendedAdvertising() : ret;
         }
         else
         {
             ESP_LOGI(TAG, "Starting legacy advertising (BLE 4.2)");
-            return startLegacyAdvertising();
+            const esp_err_t ret = configureLegacyAdvertising();
+            return ret == ESP_OK ? startLegacyAdvertising() : ret;
         }
     }
 
@@ -386,20 +709,20 @@ namespace net
         }
 
         // Устанавливаем предпочтительные PHY для всех соединений
-        for (const auto& [connId, address] : mActiveConnections)
+        for (const auto& conn : mActiveConnections)
         {
             const esp_err_t ret = esp_ble_gap_set_preferred_phy(
-                const_cast<uint8_t*>(address), // [in] MAC-адрес устройства
-                ESP_BLE_GAP_ALL_PHYS_PREF,     // [in] Все PHY доступны
-                txPhy,                         // [in] Предпочтения TX PHY
-                rxPhy,                         // [in] Предпочтения RX PHY
-                ESP_BLE_GAP_PHY_OPTION_NO_PREF // [in] Без специальных опций
+                const_cast<uint8_t*>(conn.address), // [in] MAC-адрес устройства
+                ESP_BLE_GAP_ALL_PHYS_PREF,          // [in] Все PHY доступны
+                txPhy,                              // [in] Предпочтения TX PHY
+                rxPhy,                              // [in] Предпочтения RX PHY
+                ESP_BLE_GAP_PHY_OPTION_NO_PREF      // [in] Без специальных опций
             );
 
             if (ret != ESP_OK)
             {
                 ESP_LOGE(TAG, "Failed to set PHY for conn %d: %s",
-                         connId, esp_err_to_name(ret));
+                         conn.connId, esp_err_to_name(ret));
                 return ret;
             }
         }
@@ -410,73 +733,308 @@ namespace net
 
     esp_err_t BLE::sendData(const uint16_t connId, std::array<uint8_t, MAX_MTU>& buffer, const size_t size) const
     {
-        std::lock_guard lock(mMutex);
-
-        // Валидация параметров
-        if (!mIsInitialized || size == 0 || size > MAX_MTU || size > mMtu)
+        std::vector<uint16_t> peers;
         {
-            ESP_LOGE(TAG, "Invalid send params: init=%d, len=%zu, max_mtu=%u, current_mtu=%u",
-                     mIsInitialized, size, MAX_MTU, mMtu);
-            return ESP_ERR_INVALID_ARG;
-        }
+            std::lock_guard lock(mMutex);
 
-        // Обработка broadcast
-        if (connId == 0)
-        {
-            if (mActiveConnections.empty())
+            // Идет мягкая остановка: данные приложения не принимаются
+            if (mStopping) return ESP_ERR_INVALID_STATE;
+
+            // Валидация параметров
+            if (!mIsInitialized || size == 0 || size > MAX_MTU || size > mMtu)
             {
-                ESP_LOGW(TAG, "No connections for broadcast");
-                return ESP_ERR_NOT_FOUND;
+                mDiag.record(BleDiagEvent::SEND_INVALID_ARGS, connId, ESP_ERR_INVALID_ARG,
+                             static_cast<uint32_t>(size), mIsInitialized ? mMtu : 0);
+                return ESP_ERR_INVALID_ARG;
             }
 
-            esp_err_t finalRet = ESP_OK;
-            for (const auto& [connId, address] : mActiveConnections)
+            // Обработка broadcast: снимок соединений, отправка идет без мьютекса
+            if (connId == 0)
             {
-                if (const esp_err_t ret = sendToDevice(connId, buffer, size); ret != ESP_OK)
+                if (mActiveConnections.empty())
+                {
+                    mDiag.record(BleDiagEvent::SEND_NO_CONNECTIONS, connId);
+                    return ESP_ERR_NOT_FOUND;
+                }
+
+                peers.reserve(mActiveConnections.size());
+                for (const auto& conn : mActiveConnections)
                 {
-                    finalRet = ret;
+                    peers.push_back(conn.connId);
                 }
             }
-            return finalRet;
         }
 
         // Отправка конкретному устройству
-        return sendToDevice(connId, buffer, size);
+        if (connId != 0)
+        {
+            return sendToDevice(connId, buffer.data(), size);
+        }
+
+        esp_err_t finalRet = ESP_OK;
+        for (const uint16_t peer : peers)
+        {
+            if (const esp_err_t ret = sendToDevice(peer, buffer.data(), size); ret != ESP_OK)
+            {
+                finalRet = ret;
+            }
+        }
+        return finalRet;
     }
 
-    esp_err_t BLE::sendToDevice(uint16_t connId, std::array<uint8_t, MAX_MTU>& buffer, const size_t size) const noexcept
+    esp_err_t BLE::sendToDevice(const uint16_t connId, const uint8_t* data, const size_t size) const noexcept
     {
-        // Поиск соединения
-        const auto it = std::ranges::find_if(mActiveConnections,
-                                             [connId](const auto& conn) { return conn.connId == connId; });
+        {
+            std::lock_guard lock(mMutex);
+            if (!hasConnection(connId))
+            {
+                mDiag.record(BleDiagEvent::SEND_CONN_NOT_FOUND, connId, ESP_ERR_NOT_FOUND);
+                return ESP_ERR_NOT_FOUND;
+            }
+        }
 
-        if (it == mActiveConnections.cend())
+        // Пока идет отправка, система не уходит в light sleep
+        mPower.txBegin();
+        mTrace.record(BleTraceKind::SEND_BEGIN, static_cast<uint8_t>(BleTraceSend::NOTIFY), connId,
+                      static_cast<uint32_t>(size));
+
+        // Не переполняем очередь стека: ждем свободный буфер контроллера. Ожидание идет
+        // без мьютекса, иначе одно соединение без кредитов на TX_CREDIT_TIMEOUT_MS
+        // останавливает отправки остальным и обработку событий стека
+        esp_err_t ret = mTxScheduler.acquire(connId, pdMS_TO_TICKS(TX_CREDIT_TIMEOUT_MS));
+        size_t length = 0;
+        if (ret != ESP_OK)
+        {
+            // Мьютекс сериализует производителей записей диагностики
+            std::lock_guard lock(mMutex);
+            mDiag.record(BleDiagEvent::SEND_NO_CREDITS, connId, ret);
+        }
+        else
+        {
+            std::lock_guard lock(mMutex);
+            ret = notifyLocked(connId, data, size, length);
+        }
+
+        mPower.txEnd(connId, ret == ESP_OK ? length : 0);
+        mTrace.record(BleTraceKind::SEND_END, static_cast<uint8_t>(BleTraceSend::NOTIFY), connId,
+                      static_cast<uint32_t>(ret));
+        return ret;
+    }
+
+    esp_err_t BLE::notifyLocked(const uint16_t connId, const uint8_t* data, const size_t size,
+                                size_t& length) const noexcept
+    {
+        // Соединение могло закрыться, пока ждали кредит
+        if (!hasConnection(connId))
         {
-            ESP_LOGE(TAG, "Connection %u not found", connId);
+            mDiag.record(BleDiagEvent::SEND_CONN_NOT_FOUND, connId, ESP_ERR_NOT_FOUND);
             return ESP_ERR_NOT_FOUND;
         }
 
+        // Соединению со сжатием уходит кадр; окно сдвигается только после успешной отправки
+        const bool framed = mCompression.isActive(connId);
+        const uint8_t* payload = data;
+        length = size;
+        if (framed)
+        {
+            const size_t limit = std::min<size_t>(MAX_MTU, mMtu - 3u);
+            length = mCompression.encode(connId, data, size, mFrameBuffer.data(), limit);
+            if (length == 0)
+            {
+                mDiag.record(BleDiagEvent::SEND_TOO_LARGE, connId, ESP_ERR_INVALID_SIZE,
+                             static_cast<uint32_t>(size + BleCompression::HEADER_SIZE), static_cast<uint32_t>(limit));
+                return ESP_ERR_INVALID_SIZE;
+            }
+            payload = mFrameBuffer.data();
+        }
+
         // Оптимизированная отправка через кэшированные параметры
         const esp_err_t ret = esp_ble_gatts_send_indicate(
-            mGattsIf, connId, mCharHandle, size, buffer.data(), false);
+            mGattsIf, connId, mCharHandle, length, const_cast<uint8_t*>(payload), false);
+        mTxScheduler.complete(length, ret);
 
         if (ret != ESP_OK)
         {
-            ESP_LOGE(TAG, "Send failed to %u: %s", connId, esp_err_to_name(ret));
+            mDiag.record(BleDiagEvent::SEND_FAILED, connId, ret);
+        }
+        else if (framed)
+        {
+            mCompression.commit(connId);
         }
 
         return ret;
     }
 
-    esp_err_t BLE::sendPacket(Packet& packet) const
+    bool BLE::hasConnection(const uint16_t connId) const noexcept
     {
-        return sendData(packet.id, packet.buffer, packet.size);
+        return std::ranges::any_of(mActiveConnections,
+                                   [connId](const DeviceConnection& conn) { return conn.connId == connId; });
     }
 
-    esp_err_t BLE::stop()
+    esp_err_t BLE::sendFromTask(const uint16_t connId, const uint8_t* data, const size_t len) const
+    {
+        {
+            std::lock_guard lock(mMutex);
+            if (!mIsInitialized || mCharHandle == 0) return ESP_ERR_INVALID_STATE;
+        }
+        return sendToDevice(connId, data, len);
+    }
+
+    esp_err_t BLE::sendPacket(Packet& packet) const
+    {
+        return sendData(packet.id, packet.buffer, packet.size);
+    }
+
+    esp_err_t BLE::stop()
+    {
+        BleShutdownReport report;
+        return teardown(report, esp_timer_get_time());
+    }
+
+    esp_err_t BLE::stopGracefully(const BleShutdownOptions& options)
+    {
+        const int64_t beginUs = esp_timer_get_time();
+        BleShutdownReport report;
+        report.graceful = true;
+
+        {
+            // Отправки приложения и новые соединения больше не принимаются
+            std::lock_guard lock(mMutex);
+            if (!mIsInitialized) return ESP_OK;
+
+            mStopping = true;
+            report.peers = static_cast<uint8_t>(mActiveConnections.size());
+            haltAdvertising();
+            if (mReconnectBurst)
+            {
+                esp_timer_stop(mReconnectTimer);
+                mReconnectBurst = false;
+                mHasDirectedPeer = false;
+            }
+        }
+        stopScan();
+        mBridge.stop();
+        int64_t phaseUs = esp_timer_get_time();
+        report.phaseUs[static_cast<size_t>(BleShutdownPhase::QUIESCE)] = static_cast<uint32_t>(phaseUs - beginUs);
+
+        // Сброс данных: очередь планировщика, затем подтверждение пакетов контроллером
+        const int64_t drainDeadlineUs = phaseUs + static_cast<int64_t>(options.drainTimeoutMs) * 1000;
+        const BleSendScheduler::DrainResult drained = mSendScheduler.drain(drainDeadlineUs);
+        report.scheduledFlushed = drained.flushed;
+        report.scheduledDropped = drained.dropped;
+        drainController(drainDeadlineUs, report);
+        int64_t nowUs = esp_timer_get_time();
+        report.phaseUs[static_cast<size_t>(BleShutdownPhase::DRAIN)] = static_cast<uint32_t>(nowUs - phaseUs);
+        phaseUs = nowUs;
+
+        {
+            std::lock_guard lock(mMutex);
+            for (const auto& conn : mActiveConnections)
+            {
+                if (const esp_err_t ret = esp_ble_gap_disconnect(const_cast<uint8_t*>(conn.address)); ret != ESP_OK)
+                {
+                    ESP_LOGW(TAG, "Disconnect conn %u failed: %s", conn.connId, esp_err_to_name(ret));
+                }
+            }
+        }
+
+        // Соединения удаляются обработчиком ESP_GATTS_DISCONNECT_EVT в задаче BTC
+        const int64_t disconnectDeadlineUs = phaseUs + static_cast<int64_t>(options.disconnectTimeoutMs) * 1000;
+        uint8_t remaining = getConnectedDevicesCount();
+        while (remaining != 0 && esp_timer_get_time() < disconnectDeadlineUs)
+        {
+            vTaskDelay(1);
+            remaining = getConnectedDevicesCount();
+        }
+        report.peersDisconnected = report.peers > remaining ? static_cast<uint8_t>(report.peers - remaining) : 0;
+        nowUs = esp_timer_get_time();
+        report.phaseUs[static_cast<size_t>(BleShutdownPhase::DISCONNECT)] = static_cast<uint32_t>(nowUs - phaseUs);
+
+        return teardown(report, beginUs);
+    }
+
+    BleShutdownReport BLE::getShutdownReport() const
     {
         std::lock_guard lock(mMutex);
-        if (!mIsInitialized) return ESP_OK;
+        return mShutdownReport;
+    }
+
+    void BLE::drainController(const int64_t deadlineUs, BleShutdownReport& report) const
+    {
+        struct Link
+        {
+            uint16_t connId;
+            uint16_t full;
+            uint16_t initial;
+            uint16_t credits;
+        };
+
+        std::vector<Link> links;
+        {
+            std::lock_guard lock(mMutex);
+            for (const auto& conn : mActiveConnections)
+            {
+                const uint16_t credits = esp_ble_get_cur_sendable_packets_num(conn.connId);
+                links.push_back({
+                    .connId = conn.connId,
+                    .full = std::max(conn.txCredits, credits),
+                    .initial = credits,
+                    .credits = credits
+                });
+            }
+        }
+
+        // Пакет подтвержден, когда контроллер вернул его кредит; разорванное
+        // соединение больше не ждем - его пакеты потеряны
+        while (true)
+        {
+            bool idle = true;
+            {
+                std::lock_guard lock(mMutex);
+                for (Link& link : links)
+                {
+                    const bool connected = std::ranges::any_of(mActiveConnections, [&link](const DeviceConnection& conn)
+                    {
+                        return conn.connId == link.connId;
+                    });
+                    if (!connected || link.credits >= link.full) continue;
+
+                    link.credits = esp_ble_get_cur_sendable_packets_num(link.connId);
+                    link.full = std::max(link.full, link.credits);
+                    idle = idle && link.credits >= link.full;
+                }
+            }
+            if (idle || esp_timer_get_time() >= deadlineUs) break;
+            vTaskDelay(1);
+        }
+
+        for (const Link& link : links)
+        {
+            report.controllerFlushed += link.credits > link.initial ? link.credits - link.initial : 0;
+            report.controllerPending += link.full - link.credits;
+        }
+    }
+
+    esp_err_t BLE::teardown(BleShutdownReport& report, const int64_t beginUs)
+    {
+        // Сканер, мост, доставка данных и планировщик останавливаются до захвата мьютекса:
+        // их задачи могут быть внутри callback или отправки, вызывающих API BLE
+        const int64_t teardownBeginUs = esp_timer_get_time();
+        stopScan();
+        mBridge.stop();
+        mRxDispatcher.end();
+        mSendScheduler.end();
+
+        std::unique_lock lock(mMutex);
+        if (!mIsInitialized)
+        {
+            mStopping = false;
+            return ESP_OK;
+        }
+        if (!report.graceful)
+        {
+            report.peers = static_cast<uint8_t>(mActiveConnections.size());
+        }
 
         esp_err_t finalRet = ESP_OK;
         auto check_error = [&](const esp_err_t ret, const char* msg)
@@ -488,6 +1046,11 @@ namespace net
             }
         };
 
+        if (mGattClient)
+        {
+            mGattClient->shutdown();
+        }
+
         // Останавливаем рекламу (если активна)
         esp_ble_gap_stop_advertising();
         constexpr uint8_t extAdvInst = 0; // Останавливаем нулевую инстанцию
@@ -506,11 +1069,74 @@ namespace net
 
         mGattsIf = ESP_GATT_IF_NONE;
         mCharHandle = 0;
+        mBulkHandle = 0;
+        mChannelHandle = 0;
+        mChannelCccdHandle = 0;
+        mCompressionHandle = 0;
+        std::vector<std::pair<uint16_t, void*>> closed;
+        closed.reserve(mActiveConnections.size());
+        for (const auto& conn : mActiveConnections)
+        {
+            mChannels.handleDisconnect(conn.connId);
+            mBridge.handleDisconnect(conn.connId);
+            closed.emplace_back(conn.connId, conn.context);
+        }
         mActiveConnections.clear();
+        mValueCache.releaseReaders();
+        mCompression.releaseAll();
+        mPower.end();
+        mDiag.end();
+        mAcceptList.clear();
+        mResolvingList.clear();
+        mStats.resolvingListSize = 0;
+        mRejectedConnIds.clear();
+        for (auto& stream : mBulkStreams)
+        {
+            stream.bound = false;
+        }
         mIsInitialized = false;
+        mIsAdvertising = false;
+        mReconnectBurst = false;
+        mHasDirectedPeer = false;
+        mLastDisconnectUs = 0;
+        if (mReconnectTimer != nullptr)
+        {
+            esp_timer_stop(mReconnectTimer);
+        }
         mDataCallback.reset();
+        mAutoStart = false;
+        mStartupCallback = nullptr;
+        mStartupNotifyPending = false;
+        mStopping = false;
+
+        const int64_t endUs = esp_timer_get_time();
+        report.status = finalRet;
+        report.phaseUs[static_cast<size_t>(BleShutdownPhase::TEARDOWN)] = static_cast<uint32_t>(endUs - teardownBeginUs);
+        report.totalUs = static_cast<uint32_t>(endUs - beginUs);
+        mShutdownReport = report;
+
+        if (report.graceful)
+        {
+            for (size_t i = 0; i < BleShutdownReport::PHASE_COUNT; i++)
+            {
+                ESP_LOGI(TAG, "Shutdown phase %s: %u us", shutdownPhaseToName(static_cast<BleShutdownPhase>(i)),
+                         static_cast<unsigned>(report.phaseUs[i]));
+            }
+            ESP_LOGI(TAG, "Shutdown data: scheduled %u sent / %u dropped, controller %u acked / %u pending",
+                     static_cast<unsigned>(report.scheduledFlushed), static_cast<unsigned>(report.scheduledDropped),
+                     static_cast<unsigned>(report.controllerFlushed), static_cast<unsigned>(report.controllerPending));
+            ESP_LOGI(TAG, "Shutdown peers: %u of %u disconnected", report.peersDisconnected, report.peers);
+        }
+        ESP_LOGI(TAG, "BLE stopped with status: %s (%u us)", esp_err_to_name(finalRet),
+                 static_cast<unsigned>(report.totalUs));
 
-        ESP_LOGI(TAG, "BLE stopped with status: %s", esp_err_to_name(finalRet));
+        // Наблюдатель узнает о закрытых соединениях после освобождения мьютекса
+        lock.unlock();
+        for (const auto& [connId, context] : closed)
+        {
+            notifyObserver(connId, &BleConnectionObserver::onDisconnect,
+                           static_cast<int>(ESP_GATT_CONN_TERMINATE_LOCAL_HOST), context);
+        }
         return finalRet;
     }
 
@@ -526,381 +1152,2475 @@ namespace net
         return mMtu;
     }
 
-    std::shared_ptr<const BleConfig> BLE::getConfig() const
-    {
-        std::lock_guard lock(mMutex);
-        return std::make_shared<BleConfig>(mConfig);
-    }
-
-    esp_err_t BLE::updateConfig(const BleConfig& newConfig)
+    esp_err_t BLE::setPersistentStore(std::unique_ptr<BleKeyValueStore> store)
     {
         std::lock_guard lock(mMutex);
 
         if (mIsInitialized)
         {
-            ESP_LOGE(TAG, "Cannot update config after initialization");
+            ESP_LOGE(TAG, "Cannot set persistent store after initialization");
             return ESP_ERR_INVALID_STATE;
         }
 
-        mConfig.copyFrom(newConfig);
-        ESP_LOGD(TAG, "Config updated (preset: %d)",
-                 static_cast<int>(mConfig.currentPreset()));
+        mPersistence = store ? std::make_unique<BlePersistence>(std::move(store)) : nullptr;
         return ESP_OK;
     }
 
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    void BLE::gattsEventHandler(const esp_gatts_cb_event_t event,
-                                const esp_gatt_if_t gattsIf,
-                                esp_ble_gatts_cb_param_t* param)
+    BleStatistics BLE::getStatistics() const
     {
-        if (!sBLEInstance) return;
-
-        switch (event)
-        {
-        case ESP_GATTS_REG_EVT:
-            if (param->reg.status == ESP_OK)
-            {
-                sBLEInstance->mGattsIf = gattsIf;
-                ESP_LOGI(TAG, "GATTS registered, interface: %d", gattsIf);
-            }
-            break;
-
-        case ESP_GATTS_CREATE_EVT:
-            if (param->create.status == ESP_OK)
-            {
-                sBLEInstance->mServiceHandle = param->create.service_handle;
-                ESP_LOGI(TAG, "Service created, handle: %d", sBLEInstance->mServiceHandle);
-            }
-            break;
+        std::lock_guard lock(mMutex);
+        BleStatistics stats = mStats;
+
+        const BleTxScheduler::Statistics tx = mTxScheduler.getStatistics();
+        stats.txPackets = tx.packets;
+        stats.txBytes = tx.bytes;
+        stats.txCreditWaits = tx.creditWaits;
+        stats.txCreditTimeouts = tx.creditTimeouts;
+        stats.txErrors = tx.errors;
+        stats.acceptListSize = static_cast<uint8_t>(mAcceptList.size());
+        stats.connectionSlotsUsed = static_cast<uint8_t>(mActiveConnections.size());
+
+        const BlePowerManager::Statistics power = mPower.getStatistics();
+        stats.pmLockHeld = power.lockHeld;
+        stats.pmLockAcquisitions = power.lockAcquisitions;
+        stats.pmLockHeldUs = power.lockHeldUs;
+
+        const BleDiag::Counters diag = mDiag.getTotals();
+        stats.diagEvents = diag.total;
+        stats.diagSuppressed = diag.suppressed;
+        stats.diagDropped = diag.dropped;
+        return stats;
+    }
 
-        case ESP_GATTS_ADD_CHAR_EVT:
-            if (param->add_char.status == ESP_OK)
-            {
-                sBLEInstance->mCharHandle = param->add_char.attr_handle;
-                ESP_LOGI(TAG, "Characteristic added, handle: %d", sBLEInstance->mCharHandle);
-            }
-            break;
+    void BLE::handleBondedReconnect(const esp_bd_addr_t address)
+    {
+        if (!mPersistence || !mPersistence->isBonded(address)) return;
 
-        case ESP_GATTS_CONNECT_EVT:
-            {
-                std::lock_guard lock(sBLEInstance->mMutex);
-                DeviceConnection conn = {
-                    .connId = param->connect.conn_id,
-                    .address = {}
-                };
-                memcpy(conn.address, param->connect.remote_bda, ESP_BD_ADDR_LEN);
-                sBLEInstance->mActiveConnections.push_back(conn);
-                ESP_LOGI(TAG, "Device connected. Conn_id: %d", param->connect.conn_id);
-                break;
-            }
+        mStats.bondedReconnects++;
+        if (mStats.timeToReconnectUs == 0)
+        {
+            mStats.timeToReconnectUs = static_cast<uint32_t>(esp_timer_get_time() - mStartupBeginUs);
+            ESP_LOGI(TAG, "First bonded reconnect after %" PRIu32 " us", mStats.timeToReconnectUs);
+        }
+        mPersistence->setLastPeer(address);
 
-        case ESP_GATTS_DISCONNECT_EVT:
+        // База изменилась с прошлого подключения - клиент должен сбросить кэш
+        if (mPersistence->takeServiceChanged(address))
+        {
+            if (esp_ble_gatts_send_service_change_indication(mGattsIf, const_cast<uint8_t*>(address)) == ESP_OK)
             {
-                std::lock_guard lock(sBLEInstance->mMutex);
-                const uint16_t conn_id = param->disconnect.conn_id;
-                const size_t before = sBLEInstance->mActiveConnections.size();
-
-                // Удаляем через erase-remove idiom
-                std::erase_if(
-                    sBLEInstance->mActiveConnections,
-                    [conn_id](const DeviceConnection& conn)
-                    {
-                        return conn.connId == conn_id;
-                    });
-
-                if (sBLEInstance->mActiveConnections.size() < before)
-                {
-                    ESP_LOGI(TAG, "Device disconnected. Conn_id: %d", conn_id);
-                }
-                break;
+                mStats.serviceChangedSent++;
             }
+        }
+    }
 
-        case ESP_GATTS_WRITE_EVT:
-            sBLEInstance->handleWriteEvent(param->write.conn_id, param);
-            break;
-
-        case ESP_GATTS_MTU_EVT:
-            sBLEInstance->mMtu = param->mtu.mtu > MAX_MTU ? MAX_MTU : param->mtu.mtu;
-            ESP_LOGI(TAG, "MTU updated: %d", sBLEInstance->mMtu);
-            break;
+    void BLE::applyPendingConfig()
+    {
+        if (!mPendingConfig) return;
 
-        default:
-            ESP_LOGD(TAG, "Unhandled GATTS event: %d", event);
-            break;
-        }
+        mConfig.copyFrom(*mPendingConfig);
+        mPendingConfig.reset();
+        mAdvLayoutValid = false;
+        ESP_LOGI(TAG, "Pending config applied (preset: %d)", static_cast<int>(mConfig.currentPreset()));
     }
 
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    void BLE::gapEventHandler(const esp_gap_ble_cb_event_t event,
-                              esp_ble_gap_cb_param_t* param)
+    std::shared_ptr<const BleConfig> BLE::getConfig() const
     {
-        if (!sBLEInstance) return;
+        std::lock_guard lock(mMutex);
+        return std::make_shared<BleConfig>(mConfig);
+    }
 
-        switch (event)
+    esp_err_t BLE::updateConfig(const BleConfig& newConfig, ConfigUpdateResult* result)
+    {
+        if (!BlePresetRegistry::validate("update", newConfig))
         {
-        case ESP_GAP_BLE_PHY_UPDATE_COMPLETE_EVT:
-            if (param->phy_update.status == ESP_OK)
-            {
-                ESP_LOGI(TAG, "PHY updated: TX=%d, RX=%d",
-                         param->phy_update.tx_phy, param->phy_update.rx_phy);
-            }
-            else
-            {
-                ESP_LOGE(TAG, "PHY update failed: %s",
-                         esp_err_to_name(param->phy_update.status));
-            }
-            break;
+            return ESP_ERR_INVALID_ARG;
+        }
 
-        case ESP_GAP_BLE_EXT_ADV_DATA_SET_COMPLETE_EVT:
-            if (param->ext_adv_data_set.status != ESP_OK)
-            {
-                ESP_LOGE(TAG, "Set extended adv data failed: %s",
-                         esp_err_to_name(param->ext_adv_data_set.status));
-            }
-            break;
+        std::lock_guard lock(mMutex);
 
-        case ESP_GAP_BLE_EXT_ADV_SET_RAND_ADDR_COMPLETE_EVT:
-            if (param->ext_adv_set_rand_addr.status != ESP_OK)
-            {
-                ESP_LOGE(TAG, "Set extended adv random address failed: %s",
-                         esp_err_to_name(param->ext_adv_set_rand_addr.status));
-            }
-            break;
+        ConfigUpdateResult update;
+        update.changed = mConfig.diff(newConfig);
 
-        case ESP_GAP_BLE_EXT_ADV_SET_PARAMS_COMPLETE_EVT:
-            if (param->ext_adv_set_params.status != ESP_OK)
-            {
-                ESP_LOGE(TAG, "Set extended adv params failed: %s",
-                         esp_err_to_name(param->ext_adv_set_params.status));
-            }
-            break;
+        mAdvLayoutValid = false;
+        if (!mIsInitialized)
+        {
+            mConfig.copyFrom(newConfig);
+            mPendingConfig.reset();
+            update.appliedLive = update.changed;
+            if (result) *result = update;
+            ESP_LOGD(TAG, "Config updated (preset: %d)",
+                     static_cast<int>(mConfig.currentPreset()));
+            return ESP_OK;
+        }
 
-        case ESP_GAP_BLE_EXT_ADV_START_COMPLETE_EVT:
-            if (param->ext_adv_start.status != ESP_OK)
+        // Параметры контроллера и GATT сохраняются до следующего запуска: работающий
+        // стек продолжает использовать прежние (семейство API рекламы, GATT база)
+        const uint16_t live = update.changed & BleConfig::FIELDS_LIVE;
+        update.needsRestart = update.changed & BleConfig::FIELDS_RESTART;
+        mConfig.copyLiveFrom(newConfig);
+        mPendingConfig.reset();
+        if (update.needsRestart != 0)
+        {
+            mPendingConfig = std::make_unique<BleConfig>(newConfig);
+        }
+
+        esp_err_t finalRet = ESP_OK;
+        auto apply = [&](const uint16_t field, const esp_err_t ret, const char* msg)
+        {
+            if (ret == ESP_OK)
             {
-                ESP_LOGE(TAG, "Start extended adv failed: %s",
-                         esp_err_to_name(param->ext_adv_start.status));
+                update.appliedLive |= field;
+                return;
             }
-            break;
+            ESP_LOGE(TAG, "%s: %s", msg, esp_err_to_name(ret));
+            update.needsRestart |= field;
+            if (finalRet == ESP_OK) finalRet = ret;
+        };
 
-        default:
-            ESP_LOGD(TAG, "Unhandled GAP event: %d", event);
-            break;
+        if (live & BleConfig::FIELD_TX_POWER)
+        {
+            apply(BleConfig::FIELD_TX_POWER,
+                  esp_ble_tx_power_set(ESP_BLE_PWR_TYPE_DEFAULT,
+                                       static_cast<esp_power_level_t>(mConfig.controller.txpwr_dft)),
+                  "Set TX power failed");
         }
-    }
-
-    esp_err_t BLE::startLegacyAdvertising()
-    {
-        std::lock_guard lock(mMutex);
 
-        if (!mIsInitialized || mServiceHandle == 0)
+        if (live & BleConfig::FIELD_DEFAULT_PHY)
         {
-            ESP_LOGE(TAG, "BLE not initialized");
-            return ESP_ERR_INVALID_STATE;
+            apply(BleConfig::FIELD_DEFAULT_PHY,
+                  setPreferredPhy(mConfig.connection.txPhy, mConfig.connection.rxPhy),
+                  "Set preferred PHY failed");
         }
 
-        // 1. Подготовка advertising data
-        constexpr size_t MAX_ADV_DATA_LEN = ESP_BLE_ADV_DATA_LEN_MAX - 2;
-        const uint8_t nameLen = static_cast<uint8_t>(std::min(mDeviceName.length(), MAX_ADV_DATA_LEN));
+        if (live & BleConfig::FIELD_CONN_PARAMS)
+        {
+            apply(BleConfig::FIELD_CONN_PARAMS, requestConnectionParams(), "Update connection params failed");
+        }
 
-        std::vector<uint8_t> advData = {
-            // Flags
-            0x02, ESP_BLE_AD_TYPE_FLAG, mConfig.advertising.flags,
-            // Device name
-            static_cast<uint8_t>(nameLen + 1), ESP_BLE_AD_TYPE_NAME_CMPL
-        };
-        advData.insert(advData.end(), mDeviceName.begin(), mDeviceName.begin() + nameLen);
+        if (live & BleConfig::FIELD_SECURITY)
+        {
+            applySecurityParams();
+            update.appliedLive |= BleConfig::FIELD_SECURITY;
+        }
 
-        // 2. Добавление UUID сервиса (если 128-bit)
-        if (const auto [len, uuid] = uuidFromString(mConfig.gatt.serviceUuid, mConfig.gatt.invertBytes); len == ESP_UUID_LEN_128)
+        if ((live & BleConfig::FIELD_ADV_PARAMS) && mConfig.acceptList.autoFromBonds)
         {
-            advData.insert(advData.end(), {
-                               static_cast<uint8_t>(1 + ESP_UUID_LEN_128),
-                               ESP_BLE_AD_TYPE_128SRV_CMPL
-                           });
-            advData.insert(advData.end(), uuid.uuid128, uuid.uuid128 + ESP_UUID_LEN_128);
+            loadBondedToAcceptList();
         }
 
-        // 3. Установка advertising data
-        if (const esp_err_t ret = esp_ble_gap_config_adv_data_raw(advData.data(), advData.size());
-            ret != ESP_OK)
+        if (live & (BleConfig::FIELD_ADV_PARAMS | BleConfig::FIELD_ADV_DATA))
         {
-            ESP_LOGE(TAG, "Config adv data failed: %s", esp_err_to_name(ret));
-            return ret;
+            apply(live & (BleConfig::FIELD_ADV_PARAMS | BleConfig::FIELD_ADV_DATA),
+                  restartAdvertising(), "Advertising reconfiguration failed");
         }
 
-        // 4. Запуск рекламы
-        if (const esp_err_t ret = esp_ble_gap_start_advertising(&mConfig.legacyAdvParams);
-            ret != ESP_OK)
+        ESP_LOGI(TAG, "Config updated live: changed=0x%02X applied=0x%02X restart=0x%02X",
+                 update.changed, update.appliedLive, update.needsRestart);
+        if (result) *result = update;
+        return finalRet;
+    }
+
+    esp_err_t BLE::applyPreset(const std::string_view name, ConfigUpdateResult* result)
+    {
+        BleConfig config;
+        if (const esp_err_t ret = mPresets.find(name, config); ret != ESP_OK)
         {
-            ESP_LOGE(TAG, "Start advertising failed: %s", esp_err_to_name(ret));
+            ESP_LOGE(TAG, "Preset '%.*s' not found", static_cast<int>(name.size()), name.data());
             return ret;
         }
+        return updateConfig(config, result);
+    }
 
-        ESP_LOGI(TAG, "Legacy advertising started | Intv: %d-%dms | Flags: 0x%02X",
-                 mConfig.legacyAdvParams.adv_int_min * 5/8,
-                 mConfig.legacyAdvParams.adv_int_max * 5/8,
-                 mConfig.advertising.flags);
-
-        return ESP_OK;
+    esp_err_t BLE::getLinkEnergy(const uint16_t connId, BleLinkEnergy& energy) const
+    {
+        return mPower.getLinkEnergy(connId, energy);
     }
 
-    esp_err_t BLE::configureExtendedAdvertising()
+    BleCompression::Statistics BLE::getCompressionStatistics() const
+    {
+        std::lock_guard lock(mMutex);
+        return mCompression.getStatistics();
+    }
+
+    BleRxDispatcher::Statistics BLE::getRxStatistics() const
+    {
+        return mRxDispatcher.getStatistics();
+    }
+
+    esp_err_t BLE::scheduleSend(const uint16_t connId, const uint8_t* data, const size_t len, const int64_t dueUs)
+    {
+        std::lock_guard lock(mMutex);
+
+        if (!mIsInitialized || mCharHandle == 0 || mStopping) return ESP_ERR_INVALID_STATE;
+        if (data == nullptr || len == 0 || len > static_cast<size_t>(mMtu - 3))
+        {
+            mDiag.record(BleDiagEvent::SEND_INVALID_ARGS, connId, ESP_ERR_INVALID_SIZE,
+                         static_cast<uint32_t>(len), mMtu);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        return mSendScheduler.schedule(connId, data, len, dueUs);
+    }
+
+    esp_err_t BLE::getNextConnectionEvent(const uint16_t connId, int64_t& timeUs) const
+    {
+        if (!mSendScheduler.isRunning()) return ESP_ERR_INVALID_STATE;
+        return mSendScheduler.nextEvent(connId, timeUs);
+    }
+
+    BleSendScheduler::Statistics BLE::getScheduleStatistics() const
+    {
+        return mSendScheduler.getStatistics();
+    }
+
+    int BLE::findConnId(const esp_bd_addr_t address) const
+    {
+        std::lock_guard lock(mMutex);
+
+        const auto it = std::ranges::find_if(mActiveConnections, [address](const DeviceConnection& conn)
+        {
+            return memcmp(conn.address, address, ESP_BD_ADDR_LEN) == 0;
+        });
+        return it != mActiveConnections.cend() ? it->connId : -1;
+    }
+
+    BlePresetRegistry& BLE::getPresets() noexcept
+    {
+        return mPresets;
+    }
+
+    BleDiag::Counters BLE::getDiagCounters(const BleDiagEvent event) const noexcept
+    {
+        return mDiag.getCounters(event);
+    }
+
+    esp_err_t BLE::requestConnectionParams(const uint16_t connId) const
+    {
+        std::lock_guard lock(mMutex);
+
+        esp_err_t finalRet = ESP_OK;
+        for (const auto& conn : mActiveConnections)
+        {
+            if (connId != 0 && conn.connId != connId) continue;
+
+            esp_ble_conn_update_params_t params = {};
+            memcpy(params.bda, conn.address, ESP_BD_ADDR_LEN);
+            params.min_int = mConfig.connection.minInterval;
+            params.max_int = mConfig.connection.maxInterval;
+            params.latency = mConfig.connection.latency;
+            params.timeout = mConfig.connection.supervisionTimeout;
+
+            if (const esp_err_t ret = esp_ble_gap_update_conn_params(&params); ret != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Conn params update for conn %u failed: %s", conn.connId, esp_err_to_name(ret));
+                finalRet = ret;
+            }
+        }
+        return finalRet;
+    }
+
+    esp_err_t BLE::startScan(const BleScanConfig& config, BleScanner::ResultCallback callback)
+    {
+        std::lock_guard lock(mMutex);
+
+        if (!mIsInitialized)
+        {
+            ESP_LOGE(TAG, "BLE not initialized");
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        if (!mConfig.supportsExtendedAdvertising())
+        {
+            ESP_LOGE(TAG, "Scanning requires BLE 5.0 preset");
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+
+        // Сканер не удаляется до разрушения BLE: обработчик GAP обращается к нему без мьютекса
+        if (!mScanner)
+        {
+            mScanner = std::make_unique<BleScanner>();
+        }
+        return mScanner->start(config, std::move(callback));
+    }
+
+    esp_err_t BLE::stopScan()
+    {
+        BleScanner* scanner;
+        {
+            std::lock_guard lock(mMutex);
+            scanner = mScanner.get();
+        }
+        return scanner != nullptr ? scanner->stop() : ESP_OK;
+    }
+
+    BleScanner::Statistics BLE::getScanStatistics() const
+    {
+        std::lock_guard lock(mMutex);
+        return mScanner ? mScanner->getStatistics() : BleScanner::Statistics{};
+    }
+
+    esp_err_t BLE::enableGattClient()
+    {
+        std::lock_guard lock(mMutex);
+
+        if (!mIsInitialized)
+        {
+            ESP_LOGE(TAG, "BLE not initialized");
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        // Клиент не удаляется до разрушения BLE: обработчик GATTC обращается к нему без мьютекса
+        if (!mGattClient)
+        {
+            mGattClient = std::make_unique<BleGattClient>(mTxScheduler, mConfig.gatt.appId + 1);
+        }
+
+        if (const esp_err_t ret = esp_ble_gattc_register_callback(gattcEventHandler); ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "GATTC register callback failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+
+        return mGattClient->registerApp();
+    }
+
+    BleGattClient* BLE::getGattClient() const noexcept
+    {
+        return mGattClient.get();
+    }
+
+    void BLE::applySecurityParams()
+    {
+        esp_ble_auth_req_t authReq = mConfig.security.authReq;
+        if (mConfig.security.secureConnections)
+        {
+            authReq |= ESP_LE_AUTH_REQ_SC_ONLY; // Флаг SC в AuthReq, не режим "только SC"
+        }
+
+        esp_ble_gap_set_security_param(ESP_BLE_SM_AUTHEN_REQ_MODE, &authReq, sizeof(uint8_t));
+        esp_ble_gap_set_security_param(ESP_BLE_SM_IOCAP_MODE, &mConfig.security.ioCap, sizeof(uint8_t));
+        esp_ble_gap_set_security_param(ESP_BLE_SM_MAX_KEY_SIZE, &mConfig.security.keySize, sizeof(uint8_t));
+
+        // С приватностью стороны обмениваются IRK, иначе RPA не разрешить
+        uint8_t initKey = mConfig.security.initKey;
+        uint8_t rspKey = mConfig.security.rspKey;
+        if (mConfig.privacy.enabled)
+        {
+            initKey |= ESP_BLE_ID_KEY_MASK;
+            rspKey |= ESP_BLE_ID_KEY_MASK;
+        }
+        esp_ble_gap_set_security_param(ESP_BLE_SM_SET_INIT_KEY, &initKey, sizeof(uint8_t));
+        esp_ble_gap_set_security_param(ESP_BLE_SM_SET_RSP_KEY, &rspKey, sizeof(uint8_t));
+
+        uint8_t onlySpecified = mConfig.security.secureConnectionsOnly
+                                    ? ESP_BLE_ONLY_ACCEPT_SPECIFIED_AUTH_ENABLE
+                                    : ESP_BLE_ONLY_ACCEPT_SPECIFIED_AUTH_DISABLE;
+        esp_ble_gap_set_security_param(ESP_BLE_SM_ONLY_ACCEPT_SPECIFIED_SEC_AUTH, &onlySpecified, sizeof(uint8_t));
+
+        uint32_t passkey = mConfig.security.staticPasskey;
+        esp_ble_gap_set_security_param(passkey != 0 ? ESP_BLE_SM_SET_STATIC_PASSKEY : ESP_BLE_SM_CLEAR_STATIC_PASSKEY,
+                                       &passkey, sizeof(uint32_t));
+    }
+
+    void BLE::handleSecurityEvent(const esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param)
+    {
+        std::lock_guard lock(mMutex);
+        esp_ble_sec_t& security = param->ble_security;
+
+        switch (event)
+        {
+        case ESP_GAP_BLE_SEC_REQ_EVT:
+            // Параметры SMP уже заданы, запрос принимается всегда
+            esp_ble_gap_security_rsp(security.ble_req.bd_addr, true);
+            break;
+
+        case ESP_GAP_BLE_PASSKEY_NOTIF_EVT:
+            ESP_LOGI(TAG, "Passkey: %06" PRIu32, security.key_notif.passkey);
+            if (mPairingHandler)
+            {
+                invokePairingHandler(security.key_notif.bd_addr, PairingRequest::PASSKEY_DISPLAY,
+                                     security.key_notif.passkey);
+            }
+            break;
+
+        case ESP_GAP_BLE_PASSKEY_REQ_EVT:
+            if (mPairingHandler)
+            {
+                invokePairingHandler(security.ble_req.bd_addr, PairingRequest::PASSKEY_ENTRY, 0);
+            }
+            else
+            {
+                ESP_LOGW(TAG, "Passkey entry requested without pairing handler, rejecting");
+                esp_ble_passkey_reply(security.ble_req.bd_addr, false, 0);
+            }
+            break;
+
+        case ESP_GAP_BLE_NC_REQ_EVT:
+            if (mPairingHandler)
+            {
+                invokePairingHandler(security.key_notif.bd_addr, PairingRequest::NUMERIC_COMPARISON,
+                                     security.key_notif.passkey);
+            }
+            else
+            {
+                ESP_LOGW(TAG, "Numeric comparison requested without pairing handler, rejecting");
+                esp_ble_confirm_reply(security.key_notif.bd_addr, false);
+            }
+            break;
+
+        case ESP_GAP_BLE_KEY_EVT:
+            ESP_LOGD(TAG, "SMP key exchanged, type: %u", security.ble_key.key_type);
+            break;
+
+        case ESP_GAP_BLE_AUTH_CMPL_EVT:
+            handleAuthComplete(security.auth_cmpl);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void BLE::handleAuthComplete(const esp_ble_auth_cmpl_t& auth)
+    {
+        const auto it = std::ranges::find_if(mActiveConnections, [&auth](const DeviceConnection& conn)
+        {
+            return memcmp(conn.address, auth.bd_addr, ESP_BD_ADDR_LEN) == 0;
+        });
+
+        if (!auth.success)
+        {
+            mStats.pairingFailures++;
+            ESP_LOGW(TAG, "Authentication failed, reason: 0x%02x", auth.fail_reason);
+
+            // Устройство потеряло ключи: сохраненный bond больше не действует,
+            // следующее подключение пройдет полное сопряжение
+            if (auth.fail_reason == HCI_KEY_MISSING && it != mActiveConnections.end() && it->bondedAtConnect)
+            {
+                ESP_LOGW(TAG, "Peer lost its keys, removing stale bond");
+                esp_ble_remove_bond_device(const_cast<uint8_t*>(auth.bd_addr));
+                forgetResolvingEntry(auth.bd_addr);
+                if (mPersistence)
+                {
+                    mPersistence->removeBond(auth.bd_addr);
+                }
+            }
+            return;
+        }
+
+        const bool bonded = (auth.auth_mode & ESP_LE_AUTH_BOND) != 0;
+        if (bonded && mPersistence)
+        {
+            mPersistence->recordBond(auth.bd_addr, auth.addr_type);
+        }
+
+        // Новый IRK должен попасть в контроллер до следующего подключения устройства
+        if (bonded && (it == mActiveConnections.end() || !it->bondedAtConnect))
+        {
+            syncBondLists();
+        }
+
+        // Соединения GATT клиента в списке сервера не учитываются
+        if (it == mActiveConnections.end()) return;
+
+        LinkSecurity& link = it->security;
+        const bool firstEncryption = !link.encrypted;
+        link.encrypted = true;
+        link.authenticated = (auth.auth_mode & ESP_LE_AUTH_REQ_MITM) != 0;
+        link.secureConnections = (auth.auth_mode & ESP_LE_AUTH_REQ_SC_ONLY) != 0;
+        link.bonded = bonded || it->bondedAtConnect;
+        link.resumed = it->bondedAtConnect;
+
+        if (link.resumed)
+        {
+            mStats.encryptionResumes++;
+        }
+        else
+        {
+            mStats.pairings++;
+        }
+
+        if (firstEncryption)
+        {
+            link.timeToEncryptUs = static_cast<uint32_t>(esp_timer_get_time() - it->connectedUs);
+            mStats.lastTimeToEncryptUs = link.timeToEncryptUs;
+            mStats.maxTimeToEncryptUs = std::max(mStats.maxTimeToEncryptUs, link.timeToEncryptUs);
+        }
+
+        ESP_LOGI(TAG, "Link %u encrypted (%s, %s%s) in %" PRIu32 " us", it->connId,
+                 link.resumed ? "resumed" : "paired", link.secureConnections ? "SC" : "legacy",
+                 link.authenticated ? ", MITM" : "", link.timeToEncryptUs);
+    }
+
+    void BLE::requestEncryption(const esp_bd_addr_t address, const bool bonded)
+    {
+        if (!bonded && !mConfig.gatt.requireEncryption) return;
+
+        // Для bonded-устройства Security Request приводит к шифрованию сохраненным LTK
+        // без повторного сопряжения; для нового устройства - к сопряжению
+        esp_ble_sec_act_t action = ESP_BLE_SEC_ENCRYPT;
+        if (!bonded)
+        {
+            action = (mConfig.security.authReq & ESP_LE_AUTH_REQ_MITM) != 0
+                         ? ESP_BLE_SEC_ENCRYPT_MITM
+                         : ESP_BLE_SEC_ENCRYPT_NO_MITM;
+        }
+
+        if (const esp_err_t ret = esp_ble_set_encryption(const_cast<uint8_t*>(address), action); ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Set encryption failed: %s", esp_err_to_name(ret));
+        }
+    }
+
+    bool BLE::isPeerBonded(const esp_bd_addr_t address) const
+    {
+        if (mPersistence && mPersistence->isBonded(address)) return true;
+
+        // Без постоянного хранилища ключи есть только в списке стека
+        return std::ranges::any_of(getBondedDevices(), [address](const esp_ble_bond_dev_t& device)
+        {
+            return memcmp(device.bd_addr, address, ESP_BD_ADDR_LEN) == 0;
+        });
+    }
+
+    std::vector<esp_ble_bond_dev_t> BLE::getBondedDevices()
+    {
+        int count = esp_ble_get_bond_device_num();
+        if (count <= 0) return {};
+
+        std::vector<esp_ble_bond_dev_t> devices(count);
+        if (esp_ble_get_bond_device_list(&count, devices.data()) != ESP_OK) return {};
+
+        devices.resize(count);
+        return devices;
+    }
+
+    void BLE::loadResolvingList()
+    {
+        if (!mConfig.privacy.enabled) return;
+
+        uint8_t added = 0;
+        for (auto& device : getBondedDevices())
+        {
+            // Без IRK устройство использует identity-адрес и в списке разрешения не нуждается
+            if ((device.bond_key.key_mask & ESP_BLE_ID_KEY_MASK) == 0) continue;
+
+            esp_ble_pid_keys_t& pid = device.bond_key.pid_key;
+            const bool listed = std::ranges::any_of(mResolvingList, [&pid](const ResolvingEntry& entry)
+            {
+                return memcmp(entry.identity, pid.static_addr, ESP_BD_ADDR_LEN) == 0;
+            });
+            if (listed) continue;
+
+            if (esp_ble_gap_add_device_to_resolving_list(pid.static_addr, pid.addr_type, pid.irk) == ESP_OK)
+            {
+                ResolvingEntry& entry = mResolvingList.emplace_back();
+                memcpy(entry.identity, pid.static_addr, ESP_BD_ADDR_LEN);
+                added++;
+            }
+        }
+
+        if (added != 0)
+        {
+            ESP_LOGI(TAG, "Resolving list: %u devices requested", added);
+        }
+    }
+
+    void BLE::forgetResolvingEntry(const esp_bd_addr_t identity)
+    {
+        std::erase_if(mResolvingList, [identity](const ResolvingEntry& entry)
+        {
+            return memcmp(entry.identity, identity, ESP_BD_ADDR_LEN) == 0;
+        });
+        mStats.resolvingListSize = static_cast<uint8_t>(std::ranges::count_if(
+            mResolvingList, [](const ResolvingEntry& entry) { return entry.confirmed; }));
+    }
+
+    void BLE::syncBondLists()
+    {
+        loadResolvingList();
+        if (mConfig.acceptList.autoFromBonds || (mConfig.privacy.enabled && mConfig.privacy.bondedOnly))
+        {
+            loadBondedToAcceptList();
+        }
+    }
+
+    void BLE::applyAddressPolicy(esp_ble_addr_type_t& ownAddrType, esp_ble_adv_filter_t& filterPolicy) const noexcept
+    {
+        if (mConfig.privacy.enabled)
+        {
+            ownAddrType = BLE_ADDR_TYPE_RPA_PUBLIC;
+            if (mConfig.privacy.bondedOnly && !mAcceptList.empty())
+            {
+                filterPolicy = ADV_FILTER_ALLOW_SCAN_ANY_CON_WLST;
+            }
+        }
+
+        // Часть списка не поместилась в контроллер: подключения проверяет хост
+        if (isHostFilterActive())
+        {
+            filterPolicy = filterPolicy == ADV_FILTER_ALLOW_SCAN_WLST_CON_WLST
+                               ? ADV_FILTER_ALLOW_SCAN_WLST_CON_ANY
+                               : ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY;
+        }
+    }
+
+    esp_err_t BLE::addToAcceptList(const std::span<const AcceptListPeer> peers)
+    {
+        return updateAcceptList(peers, true);
+    }
+
+    esp_err_t BLE::removeFromAcceptList(const std::span<const AcceptListPeer> peers)
+    {
+        return updateAcceptList(peers, false);
+    }
+
+    esp_err_t BLE::clearAcceptList()
+    {
+        std::lock_guard lock(mMutex);
+        if (!mIsInitialized) return ESP_ERR_INVALID_STATE;
+
+        const bool wasAdvertising = haltAdvertising();
+        const esp_err_t ret = esp_ble_gap_clear_whitelist();
+        mAcceptList.clear();
+        ESP_LOGI(TAG, "Accept list cleared");
+
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Clear accept list failed: %s", esp_err_to_name(ret));
+        }
+        return wasAdvertising ? resumeAdvertising() : ret;
+    }
+
+    esp_err_t BLE::loadBondedToAcceptList()
+    {
+        std::vector<AcceptListPeer> peers;
+        for (const auto& device : getBondedDevices())
+        {
+            // Контроллер сравнивает accept list с адресом после разрешения RPA
+            const bool hasIdentity = (device.bond_key.key_mask & ESP_BLE_ID_KEY_MASK) != 0;
+            const esp_ble_pid_keys_t& pid = device.bond_key.pid_key;
+
+            AcceptListPeer peer = {};
+            memcpy(peer.address, hasIdentity ? pid.static_addr : device.bd_addr, ESP_BD_ADDR_LEN);
+            peer.type = hasIdentity && pid.addr_type == BLE_ADDR_TYPE_PUBLIC
+                            ? BLE_WL_ADDR_TYPE_PUBLIC
+                            : BLE_WL_ADDR_TYPE_RANDOM;
+            peers.push_back(peer);
+        }
+
+        if (peers.empty()) return ESP_OK;
+        return updateAcceptList(peers, true);
+    }
+
+    esp_err_t BLE::setAdvertisingFilterPolicy(const esp_ble_adv_filter_t policy)
+    {
+        std::lock_guard lock(mMutex);
+
+        mConfig.extAdvParams.filter_policy = policy;
+        mConfig.legacyAdvParams.adv_filter_policy = policy;
+        if (!mIsInitialized) return ESP_OK;
+
+        if (mAcceptList.empty() && policy != ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY)
+        {
+            ESP_LOGW(TAG, "Accept list is empty: filter policy %d blocks all peers", policy);
+        }
+        return restartAdvertising();
+    }
+
+    size_t BLE::getAcceptListSize() const
+    {
+        std::lock_guard lock(mMutex);
+        return mAcceptList.size();
+    }
+
+    esp_err_t BLE::updateAcceptList(const std::span<const AcceptListPeer> peers, const bool add)
+    {
+        std::lock_guard lock(mMutex);
+        if (!mIsInitialized) return ESP_ERR_INVALID_STATE;
+
+        const bool hostFilterBefore = isHostFilterActive();
+
+        // Контроллер не меняет accept list, пока его использует реклама:
+        // весь пакет применяется за одну остановку
+        const bool wasAdvertising = haltAdvertising();
+        esp_err_t finalRet = ESP_OK;
+        size_t loaded = std::ranges::count_if(mAcceptList, [](const AcceptEntry& entry) { return entry.inController; });
+
+        for (const auto& peer : peers)
+        {
+            const auto it = std::ranges::find_if(mAcceptList, [&peer](const AcceptEntry& entry)
+            {
+                return memcmp(entry.peer.address, peer.address, ESP_BD_ADDR_LEN) == 0;
+            });
+
+            if (add)
+            {
+                if (it != mAcceptList.end()) continue;
+
+                AcceptEntry entry = {.peer = peer, .inController = false};
+                if (loaded < mAcceptListCapacity)
+                {
+                    const esp_err_t ret = esp_ble_gap_update_whitelist(true, entry.peer.address, peer.type);
+                    entry.inController = ret == ESP_OK;
+                    if (ret != ESP_OK) finalRet = ret;
+                    if (entry.inController) loaded++;
+                }
+                mAcceptList.push_back(entry);
+            }
+            else if (it != mAcceptList.end())
+            {
+                if (it->inController)
+                {
+                    const esp_err_t ret = esp_ble_gap_update_whitelist(false, it->peer.address, it->peer.type);
+                    if (ret != ESP_OK) finalRet = ret;
+                    loaded--;
+                }
+                mAcceptList.erase(it);
+            }
+        }
+
+        // Освободившиеся места контроллера занимают записи, хранившиеся на хосте
+        for (auto& entry : mAcceptList)
+        {
+            if (loaded >= mAcceptListCapacity) break;
+            if (entry.inController) continue;
+            if (esp_ble_gap_update_whitelist(true, entry.peer.address, entry.peer.type) == ESP_OK)
+            {
+                entry.inController = true;
+                loaded++;
+            }
+        }
+
+        ESP_LOGI(TAG, "Accept list %s %zu peers: %zu total, %zu in controller", add ? "+" : "-",
+                 peers.size(), mAcceptList.size(), loaded);
+        if (isHostFilterActive() != hostFilterBefore)
+        {
+            ESP_LOGW(TAG, "Host-side connection filtering %s", isHostFilterActive() ? "enabled" : "disabled");
+        }
+
+        if (finalRet != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Accept list update failed: %s", esp_err_to_name(finalRet));
+        }
+
+        // Фильтр рекламы пересчитывается applyAddressPolicy при возобновлении
+        if (wasAdvertising)
+        {
+            const esp_err_t ret = resumeAdvertising();
+            if (finalRet == ESP_OK) finalRet = ret;
+        }
+        return finalRet;
+    }
+
+    bool BLE::isHostFilterActive() const noexcept
+    {
+        const esp_ble_adv_filter_t policy = mConfig.supportsExtendedAdvertising()
+                                                ? mConfig.extAdvParams.filter_policy
+                                                : mConfig.legacyAdvParams.adv_filter_policy;
+        const bool filtersConnections = policy == ADV_FILTER_ALLOW_SCAN_ANY_CON_WLST ||
+            policy == ADV_FILTER_ALLOW_SCAN_WLST_CON_WLST ||
+            (mConfig.privacy.enabled && mConfig.privacy.bondedOnly && !mAcceptList.empty());
+
+        return filtersConnections && std::ranges::any_of(mAcceptList, [](const AcceptEntry& entry)
+        {
+            return !entry.inController;
+        });
+    }
+
+    bool BLE::admitConnection(const uint16_t connId, const esp_bd_addr_t address)
+    {
+        if (mStopping)
+        {
+            ESP_LOGW(TAG, "Rejecting conn %u: stopping", connId);
+            mRejectedConnIds.push_back(connId);
+            esp_ble_gap_disconnect(const_cast<uint8_t*>(address));
+            return false;
+        }
+        if (mAcceptList.empty()) return true;
+
+        const bool listed = std::ranges::any_of(mAcceptList, [address](const AcceptEntry& entry)
+        {
+            return memcmp(entry.peer.address, address, ESP_BD_ADDR_LEN) == 0;
+        });
+        if (listed) return true;
+
+        if (!isHostFilterActive())
+        {
+            mStats.unlistedConnections++;
+            return true;
+        }
+
+        ESP_LOGW(TAG, "Rejecting conn %u: peer not in accept list", connId);
+        mStats.connectionsRejected++;
+        mRejectedConnIds.push_back(connId);
+        esp_ble_gap_disconnect(const_cast<uint8_t*>(address));
+        return false;
+    }
+
+    void BLE::setPairingHandler(PairingHandler handler)
+    {
+        std::lock_guard lock(mMutex);
+        mPairingHandler = std::move(handler);
+    }
+
+    void BLE::invokePairingHandler(const uint8_t* address, const PairingRequest request, const uint32_t passkey)
+    {
+        mTrace.record(BleTraceKind::CALLBACK_BEGIN, static_cast<uint8_t>(BleTraceCallback::PAIRING), BleTrace::NO_CONN,
+                      static_cast<uint32_t>(request));
+        mPairingHandler(address, request, passkey);
+        mTrace.record(BleTraceKind::CALLBACK_END, static_cast<uint8_t>(BleTraceCallback::PAIRING));
+    }
+
+    void BLE::setConnectionObserver(BleConnectionObserver* observer)
+    {
+        std::lock_guard lock(mMutex);
+        mObserver = observer;
+    }
+
+    template <typename Method, typename... Args>
+    void BLE::notifyObserver(const uint16_t connId, const Method method, Args... args)
+    {
+        // Под мьютексом только копия указателя: наблюдатель может вызывать API BLE из другой задачи
+        BleConnectionObserver* observer = nullptr;
+        {
+            std::lock_guard lock(mMutex);
+            observer = mObserver;
+        }
+        if (observer == nullptr) return;
+
+        mTrace.record(BleTraceKind::CALLBACK_BEGIN, static_cast<uint8_t>(BleTraceCallback::OBSERVER), connId);
+        (observer->*method)(connId, args...);
+        mTrace.record(BleTraceKind::CALLBACK_END, static_cast<uint8_t>(BleTraceCallback::OBSERVER), connId);
+    }
+
+    esp_err_t BLE::setConnectionHandler(const uint16_t connId, ConnectionDataHandler handler, void* context)
+    {
+        std::lock_guard lock(mMutex);
+        const auto it = std::ranges::find_if(mActiveConnections,
+                                             [connId](const auto& conn) { return conn.connId == connId; });
+        if (it == mActiveConnections.end())
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+        it->handler = std::move(handler);
+        it->context = context;
+        return ESP_OK;
+    }
+
+    void* BLE::getConnectionContext(const uint16_t connId) const
+    {
+        std::lock_guard lock(mMutex);
+        const auto it = std::ranges::find_if(mActiveConnections,
+                                             [connId](const auto& conn) { return conn.connId == connId; });
+        return it != mActiveConnections.cend() ? it->context : nullptr;
+    }
+
+    esp_err_t BLE::replyPasskey(const esp_bd_addr_t address, const bool accept, const uint32_t passkey)
+    {
+        return esp_ble_passkey_reply(const_cast<uint8_t*>(address), accept, passkey);
+    }
+
+    esp_err_t BLE::confirmPairing(const esp_bd_addr_t address, const bool accept)
+    {
+        return esp_ble_confirm_reply(const_cast<uint8_t*>(address), accept);
+    }
+
+    esp_err_t BLE::getLinkSecurity(const uint16_t connId, LinkSecurity& security) const
+    {
+        std::lock_guard lock(mMutex);
+        const auto it = std::ranges::find_if(mActiveConnections,
+                                             [connId](const auto& conn) { return conn.connId == connId; });
+        if (it == mActiveConnections.cend())
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+        security = it->security;
+        return ESP_OK;
+    }
+
+    esp_err_t BLE::resumeAdvertising()
+    {
+        std::lock_guard lock(mMutex);
+
+        const bool extended = mConfig.supportsExtendedAdvertising();
+        const esp_err_t ret = extended ? configureExtendedAdvertising() : configureLegacyAdvertising();
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        return extended ? startExtendedAdvertising() : startLegacyAdvertising();
+    }
+
+    esp_ble_gap_ext_adv_params_t BLE::activeExtAdvParams() const noexcept
+    {
+        esp_ble_gap_ext_adv_params_t params = mConfig.extAdvParams;
+        applyAddressPolicy(params.own_addr_type, params.filter_policy);
+        if (mReconnectBurst)
+        {
+            params.interval_min = mConfig.reconnect.fastIntervalMin;
+            params.interval_max = mConfig.reconnect.fastIntervalMax;
+            if (mHasDirectedPeer)
+            {
+                params.type = ESP_BLE_GAP_SET_EXT_ADV_PROP_CONNECTABLE | ESP_BLE_GAP_SET_EXT_ADV_PROP_DIRECTED;
+                params.peer_addr_type = static_cast<esp_ble_addr_type_t>(mDirectedPeer.addrType);
+                memcpy(params.peer_addr, mDirectedPeer.address, ESP_BD_ADDR_LEN);
+            }
+        }
+        return params;
+    }
+
+    esp_ble_adv_params_t BLE::activeLegacyAdvParams() const noexcept
+    {
+        esp_ble_adv_params_t params = mConfig.legacyAdvParams;
+        applyAddressPolicy(params.own_addr_type, params.adv_filter_policy);
+        if (mReconnectBurst)
+        {
+            params.adv_int_min = mConfig.reconnect.fastIntervalMin;
+            params.adv_int_max = mConfig.reconnect.fastIntervalMax;
+            if (mHasDirectedPeer)
+            {
+                params.adv_type = ADV_TYPE_DIRECT_IND_LOW;
+                params.peer_addr_type = static_cast<esp_ble_addr_type_t>(mDirectedPeer.addrType);
+                memcpy(params.peer_addr, mDirectedPeer.address, ESP_BD_ADDR_LEN);
+            }
+        }
+        return params;
+    }
+
+    void BLE::handleReconnectOnDisconnect()
+    {
+        mLastDisconnectUs = esp_timer_get_time();
+
+        if (!mIsInitialized || mStopping || !mConfig.reconnect.autoRestart ||
+            mActiveConnections.size() >= mConfig.controller.ble_max_act)
+        {
+            return;
+        }
+
+        if (mConfig.reconnect.burstDurationMs != 0)
+        {
+            if (mReconnectTimer == nullptr)
+            {
+                const esp_timer_create_args_t args = {
+                    .callback = reconnectBurstTimerCallback,
+                    .arg = this,
+                    .dispatch_method = ESP_TIMER_TASK,
+                    .name = "ble_reconnect",
+                    .skip_unhandled_events = true
+                };
+                if (esp_timer_create(&args, &mReconnectTimer) != ESP_OK)
+                {
+                    mReconnectTimer = nullptr;
+                }
+            }
+
+            if (mReconnectTimer != nullptr)
+            {
+                esp_timer_stop(mReconnectTimer);
+                esp_timer_start_once(mReconnectTimer, static_cast<uint64_t>(mConfig.reconnect.burstDurationMs) * 1000);
+                mReconnectBurst = true;
+                mHasDirectedPeer = mConfig.reconnect.directedToLastPeer && mPersistence &&
+                    mPersistence->lastPeer(mDirectedPeer);
+            }
+        }
+
+        const esp_err_t ret = mIsAdvertising ? restartAdvertising() : resumeAdvertising();
+        if (ret == ESP_OK)
+        {
+            mStats.advertisingRestarts++;
+            ESP_LOGI(TAG, "Advertising restarted after disconnect%s%s",
+                     mReconnectBurst ? " (fast)" : "", mHasDirectedPeer ? " (directed)" : "");
+        }
+    }
+
+    void BLE::handleReconnectOnConnect()
+    {
+        if (mLastDisconnectUs != 0)
+        {
+            const auto latency = static_cast<uint32_t>(esp_timer_get_time() - mLastDisconnectUs);
+            mStats.reconnects++;
+            mStats.lastReconnectLatencyUs = latency;
+            mStats.maxReconnectLatencyUs = std::max(mStats.maxReconnectLatencyUs, latency);
+            mStats.totalReconnectLatencyUs += latency;
+            mLastDisconnectUs = 0;
+        }
+
+        if (mReconnectBurst)
+        {
+            esp_timer_stop(mReconnectTimer);
+            mReconnectBurst = false;
+            mHasDirectedPeer = false;
+        }
+
+        // Подключаемая реклама завершилась - продолжаем, пока есть свободные слоты
+        if (mIsInitialized && mConfig.reconnect.autoRestart &&
+            mActiveConnections.size() < mConfig.controller.ble_max_act)
+        {
+            if (resumeAdvertising() == ESP_OK)
+            {
+                mStats.advertisingRestarts++;
+            }
+        }
+    }
+
+    void BLE::reconnectBurstTimerCallback(void* arg)
+    {
+        auto* self = static_cast<BLE*>(arg);
+        std::lock_guard lock(self->mMutex);
+
+        if (!self->mReconnectBurst) return;
+
+        self->mReconnectBurst = false;
+        self->mHasDirectedPeer = false;
+        if (self->mIsAdvertising)
+        {
+            ESP_LOGI(TAG, "Reconnect window elapsed, back to preset advertising interval");
+            self->restartAdvertising();
+        }
+    }
+
+    esp_err_t BLE::restartAdvertising()
+    {
+        std::lock_guard lock(mMutex);
+
+        // Параметры набора рекламы нельзя менять, пока он включен
+        if (!haltAdvertising())
+        {
+            return mConfig.supportsExtendedAdvertising() ? configureExtendedAdvertising() : configureLegacyAdvertising();
+        }
+        return resumeAdvertising();
+    }
+
+    bool BLE::haltAdvertising()
+    {
+        if (!mIsAdvertising) return false;
+
+        if (mConfig.supportsExtendedAdvertising())
+        {
+            constexpr uint8_t extAdvInst = 0;
+            esp_ble_gap_ext_adv_stop(1, &extAdvInst);
+        }
+        else
+        {
+            esp_ble_gap_stop_advertising();
+        }
+        mIsAdvertising = false;
+        return true;
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    void BLE::traceGattsEvent(const esp_gatts_cb_event_t event, const esp_ble_gatts_cb_param_t* param) noexcept
+    {
+        uint16_t connId = BleTrace::NO_CONN;
+        uint32_t arg = 0;
+        switch (event)
+        {
+        case ESP_GATTS_READ_EVT:
+            connId = param->read.conn_id;
+            arg = param->read.handle;
+            break;
+        case ESP_GATTS_WRITE_EVT:
+            connId = param->write.conn_id;
+            arg = param->write.len;
+            break;
+        case ESP_GATTS_EXEC_WRITE_EVT:
+            connId = param->exec_write.conn_id;
+            arg = param->exec_write.exec_write_flag;
+            break;
+        case ESP_GATTS_MTU_EVT:
+            connId = param->mtu.conn_id;
+            arg = param->mtu.mtu;
+            break;
+        case ESP_GATTS_CONF_EVT:
+            connId = param->conf.conn_id;
+            arg = param->conf.status;
+            break;
+        case ESP_GATTS_CONNECT_EVT:
+            connId = param->connect.conn_id;
+            arg = param->connect.conn_params.interval;
+            break;
+        case ESP_GATTS_DISCONNECT_EVT:
+            connId = param->disconnect.conn_id;
+            arg = param->disconnect.reason;
+            break;
+        case ESP_GATTS_CONGEST_EVT:
+            connId = param->congest.conn_id;
+            arg = param->congest.congested;
+            break;
+        case ESP_GATTS_RESPONSE_EVT:
+            arg = param->rsp.status;
+            break;
+        default:
+            break;
+        }
+        mTrace.record(BleTraceKind::GATTS, static_cast<uint8_t>(event), connId, arg);
+    }
+
+    void BLE::traceGattcEvent(const esp_gattc_cb_event_t event, const esp_ble_gattc_cb_param_t* param) noexcept
+    {
+        uint16_t connId = BleTrace::NO_CONN;
+        uint32_t arg = 0;
+        switch (event)
+        {
+        case ESP_GATTC_OPEN_EVT:
+            connId = param->open.conn_id;
+            arg = param->open.status;
+            break;
+        case ESP_GATTC_CLOSE_EVT:
+            connId = param->close.conn_id;
+            arg = param->close.reason;
+            break;
+        case ESP_GATTC_CFG_MTU_EVT:
+            connId = param->cfg_mtu.conn_id;
+            arg = param->cfg_mtu.mtu;
+            break;
+        case ESP_GATTC_READ_CHAR_EVT:
+            connId = param->read.conn_id;
+            arg = param->read.status;
+            break;
+        case ESP_GATTC_WRITE_CHAR_EVT:
+            connId = param->write.conn_id;
+            arg = param->write.status;
+            break;
+        case ESP_GATTC_NOTIFY_EVT:
+            connId = param->notify.conn_id;
+            arg = param->notify.value_len;
+            break;
+        case ESP_GATTC_CONGEST_EVT:
+            connId = param->congest.conn_id;
+            arg = param->congest.congested;
+            break;
+        case ESP_GATTC_DISCONNECT_EVT:
+            connId = param->disconnect.conn_id;
+            arg = param->disconnect.reason;
+            break;
+        default:
+            break;
+        }
+        mTrace.record(BleTraceKind::GATTC, static_cast<uint8_t>(event), connId, arg);
+    }
+
+    void BLE::traceGapEvent(const esp_gap_ble_cb_event_t event, const esp_ble_gap_cb_param_t* param) noexcept
+    {
+        uint32_t arg = 0;
+        switch (event)
+        {
+        case ESP_GAP_BLE_EXT_ADV_REPORT_EVT:
+            // Поток отчетов вытеснил бы из буфера события соединений
+            if (!mTrace.scanReports()) return;
+            break;
+        case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+            arg = param->update_conn_params.conn_int |
+                static_cast<uint32_t>(param->update_conn_params.latency) << 16;
+            break;
+        case ESP_GAP_BLE_PHY_UPDATE_COMPLETE_EVT:
+            arg = param->phy_update.tx_phy | param->phy_update.rx_phy << 8 |
+                static_cast<uint32_t>(param->phy_update.status) << 16;
+            break;
+        case ESP_GAP_BLE_ADV_START_COMPLETE_EVT:
+            arg = param->adv_start_cmpl.status;
+            break;
+        case ESP_GAP_BLE_EXT_ADV_START_COMPLETE_EVT:
+            arg = param->ext_adv_start.status;
+            break;
+        case ESP_GAP_BLE_AUTH_CMPL_EVT:
+            arg = param->ble_security.auth_cmpl.success |
+                static_cast<uint32_t>(param->ble_security.auth_cmpl.fail_reason) << 8;
+            break;
+        default:
+            break;
+        }
+        // Соединение по адресу ищется под мьютексом, поэтому в записи GAP его нет
+        mTrace.record(BleTraceKind::GAP, static_cast<uint8_t>(event), BleTrace::NO_CONN, arg);
+    }
+
+    void BLE::gattsEventHandler(const esp_gatts_cb_event_t event,
+                                const esp_gatt_if_t gattsIf,
+                                esp_ble_gatts_cb_param_t* param)
+    {
+        if (!sBLEInstance) return;
+
+        sBLEInstance->traceGattsEvent(event, param);
+
+        switch (event)
+        {
+        case ESP_GATTS_REG_EVT:
+            if (param->reg.status == ESP_OK)
+            {
+                sBLEInstance->mGattsIf = gattsIf;
+                ESP_LOGI(TAG, "GATTS registered, interface: %d", gattsIf);
+            }
+            sBLEInstance->advanceStartup(event, param->reg.status);
+            break;
+
+        case ESP_GATTS_CREATE_EVT:
+            if (param->create.status == ESP_OK)
+            {
+                sBLEInstance->mServiceHandle = param->create.service_handle;
+                ESP_LOGI(TAG, "Service created, handle: %d", sBLEInstance->mServiceHandle);
+            }
+            sBLEInstance->advanceStartup(event, param->create.status);
+            break;
+
+        case ESP_GATTS_ADD_CHAR_EVT:
+            if (param->add_char.status == ESP_OK)
+            {
+                const BleConfig& config = sBLEInstance->mConfig;
+                if (config.gatt.bulkEnabled && sBLEInstance->mCharHandle != 0 &&
+                    BleUuid::fromEsp(param->add_char.char_uuid, config.gatt.invertBytes) == config.gatt.bulkCharUuid)
+                {
+                    sBLEInstance->mBulkHandle = param->add_char.attr_handle;
+                    ESP_LOGI(TAG, "Bulk characteristic added, handle: %d", sBLEInstance->mBulkHandle);
+                }
+                else if (config.gatt.channelsEnabled && sBLEInstance->mCharHandle != 0 &&
+                         BleUuid::fromEsp(param->add_char.char_uuid, config.gatt.invertBytes) == config.gatt.channelCharUuid)
+                {
+                    sBLEInstance->mChannelHandle = param->add_char.attr_handle;
+                    ESP_LOGI(TAG, "Channel characteristic added, handle: %d", sBLEInstance->mChannelHandle);
+                }
+                else if (config.gatt.compressionEnabled && sBLEInstance->mCharHandle != 0 &&
+                         BleUuid::fromEsp(param->add_char.char_uuid, config.gatt.invertBytes) == config.gatt.compressionCharUuid)
+                {
+                    sBLEInstance->mCompressionHandle = param->add_char.attr_handle;
+                    ESP_LOGI(TAG, "Compression characteristic added, handle: %d", sBLEInstance->mCompressionHandle);
+                }
+                else
+                {
+                    sBLEInstance->mCharHandle = param->add_char.attr_handle;
+                    ESP_LOGI(TAG, "Characteristic added, handle: %d", sBLEInstance->mCharHandle);
+                }
+            }
+            sBLEInstance->advanceStartup(event, param->add_char.status);
+            break;
+
+        case ESP_GATTS_ADD_CHAR_DESCR_EVT:
+            if (param->add_char_descr.status == ESP_OK)
+            {
+                sBLEInstance->mChannelCccdHandle = param->add_char_descr.attr_handle;
+                ESP_LOGI(TAG, "Channel CCCD added, handle: %d", sBLEInstance->mChannelCccdHandle);
+            }
+            sBLEInstance->advanceStartup(event, param->add_char_descr.status);
+            break;
+
+        case ESP_GATTS_START_EVT:
+            if (param->start.status == ESP_OK)
+            {
+                ESP_LOGI(TAG, "Service started, handle: %d", param->start.service_handle);
+            }
+            sBLEInstance->advanceStartup(event, param->start.status);
+            break;
+
+        case ESP_GATTS_CONNECT_EVT:
+            {
+                // Соединения, открытые GATT клиентом (роль central), ведет BleGattClient
+                if (param->connect.link_role == 0) break;
+
+                std::unique_lock lock(sBLEInstance->mMutex);
+                DeviceConnection conn = {
+                    .connId = param->connect.conn_id,
+                    .address = {},
+                    .connectedUs = esp_timer_get_time(),
+                    .txCredits = esp_ble_get_cur_sendable_packets_num(param->connect.conn_id)
+                };
+                memcpy(conn.address, param->connect.remote_bda, ESP_BD_ADDR_LEN);
+                sBLEInstance->mIsAdvertising = false; // Подключаемая реклама завершается при соединении
+                if (!sBLEInstance->admitConnection(conn.connId, conn.address)) break;
+
+                conn.bondedAtConnect = sBLEInstance->isPeerBonded(conn.address);
+                conn.generation = ++sBLEInstance->mConnGeneration;
+                sBLEInstance->mActiveConnections.push_back(conn);
+                sBLEInstance->mPower.onConnect(conn.connId, param->connect.conn_params.interval,
+                                               param->connect.conn_params.latency);
+                sBLEInstance->mSendScheduler.handleConnect(conn.connId, param->connect.conn_params.interval);
+
+                BleStatistics& stats = sBLEInstance->mStats;
+                const auto slots = static_cast<uint8_t>(sBLEInstance->mActiveConnections.size());
+                stats.peakConnectionSlots = std::max(stats.peakConnectionSlots, slots);
+                if (slots >= sBLEInstance->mConfig.controller.ble_max_act)
+                {
+                    stats.slotExhaustions++;
+                }
+                sBLEInstance->bindBulkStream(param->connect.conn_id);
+                sBLEInstance->mBridge.handleConnect(param->connect.conn_id);
+                ESP_LOGI(TAG, "Device connected. Conn_id: %d", param->connect.conn_id);
+                sBLEInstance->handleBondedReconnect(param->connect.remote_bda);
+                sBLEInstance->requestEncryption(conn.address, conn.bondedAtConnect);
+                sBLEInstance->requestConnectionParams(param->connect.conn_id);
+                sBLEInstance->handleReconnectOnConnect();
+
+                lock.unlock();
+                sBLEInstance->notifyObserver(conn.connId, &BleConnectionObserver::onConnect,
+                                             static_cast<const uint8_t*>(conn.address),
+                                             param->connect.conn_params.interval);
+                break;
+            }
+
+        case ESP_GATTS_DISCONNECT_EVT:
+            {
+                std::unique_lock lock(sBLEInstance->mMutex);
+                const uint16_t conn_id = param->disconnect.conn_id;
+                const size_t before = sBLEInstance->mActiveConnections.size();
+                void* context = sBLEInstance->getConnectionContext(conn_id);
+
+                // Удаляем через erase-remove idiom
+                std::erase_if(
+                    sBLEInstance->mActiveConnections,
+                    [conn_id](const DeviceConnection& conn)
+                    {
+                        return conn.connId == conn_id;
+                    });
+
+                if (sBLEInstance->mActiveConnections.size() < before)
+                {
+                    sBLEInstance->mPower.onDisconnect(conn_id);
+                    sBLEInstance->releaseBulkStream(conn_id);
+                    sBLEInstance->mBridge.handleDisconnect(conn_id);
+                    sBLEInstance->mSendScheduler.handleDisconnect(conn_id);
+                    sBLEInstance->mValueCache.releaseReader(conn_id);
+                    sBLEInstance->mCompression.release(conn_id);
+                    sBLEInstance->mChannels.handleDisconnect(conn_id);
+                    ESP_LOGI(TAG, "Device disconnected. Conn_id: %d", conn_id);
+                    sBLEInstance->handleReconnectOnDisconnect();
+
+                    lock.unlock();
+                    sBLEInstance->notifyObserver(conn_id, &BleConnectionObserver::onDisconnect,
+                                                 static_cast<int>(param->disconnect.reason), context);
+                }
+                else if (std::erase(sBLEInstance->mRejectedConnIds, conn_id) != 0 && !sBLEInstance->mStopping)
+                {
+                    // Отклоненное соединение не считается разрывом: реклама просто возобновляется
+                    sBLEInstance->resumeAdvertising();
+                }
+                break;
+            }
+
+        case ESP_GATTS_WRITE_EVT:
+            sBLEInstance->handleWriteEvent(param->write.conn_id, param);
+            break;
+
+        case ESP_GATTS_READ_EVT:
+            sBLEInstance->handleReadEvent(param);
+            break;
+
+        case ESP_GATTS_EXEC_WRITE_EVT:
+            sBLEInstance->handleExecWrite(param);
+            break;
+
+        case ESP_GATTS_MTU_EVT:
+            sBLEInstance->mMtu = param->mtu.mtu > MAX_MTU ? MAX_MTU : param->mtu.mtu;
+            ESP_LOGI(TAG, "MTU updated: %d", sBLEInstance->mMtu);
+            sBLEInstance->mChannels.setLinkMtu(sBLEInstance->mMtu);
+            sBLEInstance->mBridge.setLinkMtu(sBLEInstance->bridgeMtu());
+            sBLEInstance->notifyObserver(param->mtu.conn_id, &BleConnectionObserver::onMtu, sBLEInstance->mMtu);
+            break;
+
+        default:
+            ESP_LOGD(TAG, "Unhandled GATTS event: %d", event);
+            break;
+        }
+
+        sBLEInstance->notifyStartup();
+    }
+
+    void BLE::gattcEventHandler(const esp_gattc_cb_event_t event,
+                                const esp_gatt_if_t gattcIf,
+                                esp_ble_gattc_cb_param_t* param)
+    {
+        if (!sBLEInstance) return;
+
+        sBLEInstance->traceGattcEvent(event, param);
+
+        if (sBLEInstance->mGattClient)
+        {
+            sBLEInstance->mGattClient->handleEvent(event, gattcIf, param);
+        }
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    void BLE::gapEventHandler(const esp_gap_ble_cb_event_t event,
+                              esp_ble_gap_cb_param_t* param)
+    {
+        if (!sBLEInstance) return;
+
+        sBLEInstance->traceGapEvent(event, param);
+
+        // События сканирования обрабатываются без мьютекса BLE: поток отчетов
+        // не должен ждать API-вызовов приложения
+        if (sBLEInstance->mScanner && sBLEInstance->mScanner->handleGapEvent(event, param)) return;
+
+        switch (event)
+        {
+        case ESP_GAP_BLE_PHY_UPDATE_COMPLETE_EVT:
+            if (param->phy_update.status == ESP_OK)
+            {
+                ESP_LOGI(TAG, "PHY updated: TX=%d, RX=%d",
+                         param->phy_update.tx_phy, param->phy_update.rx_phy);
+                if (const int connId = sBLEInstance->findConnId(param->phy_update.bda); connId >= 0)
+                {
+                    sBLEInstance->mPower.onPhyUpdate(static_cast<uint16_t>(connId), param->phy_update.tx_phy);
+                    sBLEInstance->notifyObserver(static_cast<uint16_t>(connId), &BleConnectionObserver::onPhy,
+                                                 param->phy_update.tx_phy, param->phy_update.rx_phy);
+                }
+            }
+            else
+            {
+                ESP_LOGE(TAG, "PHY update failed: %s",
+                         esp_err_to_name(param->phy_update.status));
+            }
+            break;
+
+        case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+            if (param->update_conn_params.status == ESP_BT_STATUS_SUCCESS)
+            {
+                ESP_LOGI(TAG, "Connection params: interval %.2f ms, latency %u, timeout %u ms",
+                         param->update_conn_params.conn_int * 1.25f, param->update_conn_params.latency,
+                         param->update_conn_params.timeout * 10);
+                if (const int connId = sBLEInstance->findConnId(param->update_conn_params.bda); connId >= 0)
+                {
+                    sBLEInstance->mPower.onConnectionParams(static_cast<uint16_t>(connId),
+                                                            param->update_conn_params.conn_int,
+                                                            param->update_conn_params.latency);
+                    sBLEInstance->mSendScheduler.handleConnectionParams(static_cast<uint16_t>(connId),
+                                                                        param->update_conn_params.conn_int);
+                    sBLEInstance->notifyObserver(static_cast<uint16_t>(connId), &BleConnectionObserver::onConnParams,
+                                                 param->update_conn_params.conn_int,
+                                                 param->update_conn_params.latency,
+                                                 param->update_conn_params.timeout);
+                }
+            }
+            break;
+
+        case ESP_GAP_BLE_SEC_REQ_EVT:
+        case ESP_GAP_BLE_PASSKEY_NOTIF_EVT:
+        case ESP_GAP_BLE_PASSKEY_REQ_EVT:
+        case ESP_GAP_BLE_NC_REQ_EVT:
+        case ESP_GAP_BLE_KEY_EVT:
+        case ESP_GAP_BLE_AUTH_CMPL_EVT:
+            sBLEInstance->handleSecurityEvent(event, param);
+            break;
+
+        case ESP_GAP_BLE_EXT_ADV_DATA_SET_COMPLETE_EVT:
+            if (param->ext_adv_data_set.status != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Set extended adv data failed: %s",
+                         esp_err_to_name(param->ext_adv_data_set.status));
+                sBLEInstance->finishStartup(ESP_FAIL, BleStartupPhase::GAP_CONFIG);
+                break;
+            }
+            sBLEInstance->completeStartupStep(STEP_ADV_DATA);
+            break;
+
+        case ESP_GAP_BLE_EXT_SCAN_RSP_DATA_SET_COMPLETE_EVT:
+            if (param->ext_scan_rsp_set.status != ESP_OK)
+            {
+                // Пустой scan response не критичен для запуска рекламы
+                ESP_LOGW(TAG, "Set extended scan rsp data failed: %s",
+                         esp_err_to_name(param->ext_scan_rsp_set.status));
+            }
+            sBLEInstance->completeStartupStep(STEP_SCAN_RSP);
+            break;
+
+        case ESP_GAP_BLE_SCAN_RSP_DATA_RAW_SET_COMPLETE_EVT:
+            if (param->scan_rsp_data_raw_cmpl.status != ESP_OK)
+            {
+                // Без scan response реклама работает, теряются только вынесенные в него данные
+                ESP_LOGW(TAG, "Set scan rsp data failed: %s",
+                         esp_err_to_name(param->scan_rsp_data_raw_cmpl.status));
+            }
+            sBLEInstance->completeStartupStep(STEP_SCAN_RSP);
+            break;
+
+        case ESP_GAP_BLE_ADV_DATA_RAW_SET_COMPLETE_EVT:
+            if (param->adv_data_raw_cmpl.status != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Set adv data failed: %s",
+                         esp_err_to_name(param->adv_data_raw_cmpl.status));
+                sBLEInstance->finishStartup(ESP_FAIL, BleStartupPhase::GAP_CONFIG);
+                break;
+            }
+            sBLEInstance->completeStartupStep(STEP_ADV_DATA);
+            break;
+
+        case ESP_GAP_BLE_ADV_START_COMPLETE_EVT:
+            if (param->adv_start_cmpl.status != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Start adv failed: %s",
+                         esp_err_to_name(param->adv_start_cmpl.status));
+            }
+            sBLEInstance->mIsAdvertising = param->adv_start_cmpl.status == ESP_OK;
+            sBLEInstance->finishStartup(param->adv_start_cmpl.status == ESP_OK ? ESP_OK : ESP_FAIL,
+                                        BleStartupPhase::ADV_START);
+            break;
+
+        case ESP_GAP_BLE_SET_LOCAL_PRIVACY_COMPLETE_EVT:
+            {
+                if (param->local_privacy_cmpl.status != ESP_OK)
+                {
+                    ESP_LOGE(TAG, "Local privacy config failed: %s",
+                             esp_err_to_name(param->local_privacy_cmpl.status));
+                    sBLEInstance->finishStartup(ESP_FAIL, BleStartupPhase::GAP_CONFIG);
+                    break;
+                }
+
+                std::lock_guard lock(sBLEInstance->mMutex);
+                esp_ble_gap_set_resolvable_private_address_timeout(sBLEInstance->mConfig.privacy.rpaTimeoutS);
+                sBLEInstance->syncBondLists();
+                sBLEInstance->completeStartupStep(STEP_PRIVACY);
+                break;
+            }
+
+        case ESP_GAP_BLE_SET_RPA_TIMEOUT_COMPLETE_EVT:
+            if (param->set_rpa_timeout_cmpl.status != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Set RPA timeout failed: %s",
+                         esp_err_to_name(param->set_rpa_timeout_cmpl.status));
+            }
+            break;
+
+        case ESP_GAP_BLE_ADD_DEV_TO_RESOLVING_LIST_COMPLETE_EVT:
+            {
+                // Команды GAP выполняются по порядку: событие относится к первой
+                // неподтвержденной записи
+                std::lock_guard lock(sBLEInstance->mMutex);
+                auto& list = sBLEInstance->mResolvingList;
+                const auto it = std::ranges::find_if(list, [](const ResolvingEntry& entry)
+                {
+                    return !entry.confirmed;
+                });
+                if (param->add_dev_to_resolving_list_cmpl.status != ESP_OK)
+                {
+                    ESP_LOGW(TAG, "Add device to resolving list failed: %s",
+                             esp_err_to_name(param->add_dev_to_resolving_list_cmpl.status));
+                    if (it != list.end()) list.erase(it);
+                    break;
+                }
+                if (it != list.end()) it->confirmed = true;
+                sBLEInstance->mStats.resolvingListSize = static_cast<uint8_t>(std::ranges::count_if(
+                    list, [](const ResolvingEntry& entry) { return entry.confirmed; }));
+                break;
+            }
+
+        case ESP_GAP_BLE_UPDATE_WHITELIST_COMPLETE_EVT:
+            if (param->update_whitelist_cmpl.status != ESP_OK)
+            {
+                ESP_LOGW(TAG, "Accept list update failed: %s",
+                         esp_err_to_name(param->update_whitelist_cmpl.status));
+            }
+            break;
+
+        case ESP_GAP_BLE_EXT_ADV_SET_PARAMS_COMPLETE_EVT:
+            if (param->ext_adv_set_params.status != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Set extended adv params failed: %s",
+                         esp_err_to_name(param->ext_adv_set_params.status));
+                sBLEInstance->finishStartup(ESP_FAIL, BleStartupPhase::GAP_CONFIG);
+                break;
+            }
+            sBLEInstance->completeStartupStep(STEP_ADV_PARAMS);
+            break;
+
+        case ESP_GAP_BLE_EXT_ADV_START_COMPLETE_EVT:
+            if (param->ext_adv_start.status != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Start extended adv failed: %s",
+                         esp_err_to_name(param->ext_adv_start.status));
+            }
+            sBLEInstance->mIsAdvertising = param->ext_adv_start.status == ESP_OK;
+            sBLEInstance->finishStartup(param->ext_adv_start.status == ESP_OK ? ESP_OK : ESP_FAIL,
+                                        BleStartupPhase::ADV_START);
+            break;
+
+        default:
+            ESP_LOGD(TAG, "Unhandled GAP event: %d", event);
+            break;
+        }
+
+        sBLEInstance->notifyStartup();
+    }
+
+    const BleAdvLayout::Plan& BLE::advLayout() const
+    {
+        std::lock_guard lock(mMutex);
+        if (mAdvLayoutValid) return mAdvLayout;
+
+        // Емкость пакетов зависит от типа рекламы: несканируемая не имеет scan response,
+        // расширенная (не legacy PDU) несет данные в AUX_ADV_IND
+        BleAdvLayout::Input input = {
+            .flags = mConfig.advertising.flags,
+            .name = mDeviceName,
+            .serviceUuid = mConfig.gatt.serviceUuid,
+            .invertBytes = mConfig.gatt.invertBytes,
+            .advCapacity = BleAdvLayout::LEGACY_DATA_MAX,
+            .scanRspCapacity = BleAdvLayout::LEGACY_DATA_MAX
+        };
+        if (!mConfig.supportsExtendedAdvertising())
+        {
+            if (mConfig.legacyAdvParams.adv_type == ADV_TYPE_NONCONN_IND)
+            {
+                input.scanRspCapacity = 0;
+            }
+        }
+        else if (const auto type = mConfig.extAdvParams.type; type & ESP_BLE_GAP_SET_EXT_ADV_PROP_LEGACY)
+        {
+            input.scanRspCapacity = (type & ESP_BLE_GAP_SET_EXT_ADV_PROP_SCANNABLE) ? input.scanRspCapacity : 0;
+        }
+        else if (type & ESP_BLE_GAP_SET_EXT_ADV_PROP_SCANNABLE)
+        {
+            // Сканируемая расширенная реклама не несет данных в самом пакете рекламы
+            input.advCapacity = 0;
+            input.scanRspCapacity = BleAdvLayout::EXT_DATA_MAX;
+        }
+        else
+        {
+            input.advCapacity = BleAdvLayout::EXT_DATA_MAX;
+            input.scanRspCapacity = 0;
+        }
+
+        mAdvLayout = BleAdvLayout::plan(input);
+        mAdvLayoutValid = true;
+
+        if (mAdvLayout.name != BleAdvLayout::Placement::ADV)
+        {
+            ESP_LOGI(TAG, "Adv layout: %u + %u bytes, name %s%s, UUID %u bytes in %s",
+                     mAdvLayout.adv.size, mAdvLayout.scanRsp.size,
+                     mAdvLayout.name == BleAdvLayout::Placement::SCAN_RSP ? "in scan rsp" : "shortened",
+                     mAdvLayout.shortName == BleAdvLayout::Placement::ADV ? " (short in adv)" : "",
+                     mAdvLayout.uuidLength,
+                     mAdvLayout.uuid == BleAdvLayout::Placement::ADV ? "adv"
+                         : mAdvLayout.uuid == BleAdvLayout::Placement::SCAN_RSP ? "scan rsp" : "none");
+        }
+        return mAdvLayout;
+    }
+
+    BleAdvLayout::Plan BLE::getAdvertisingLayout() const
+    {
+        std::lock_guard lock(mMutex);
+        return advLayout();
+    }
+
+    esp_err_t BLE::configureLegacyAdvertising()
+    {
+        std::lock_guard lock(mMutex);
+
+        if (!mIsInitialized)
+        {
+            ESP_LOGE(TAG, "BLE not initialized");
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        // 1. Данные рекламы и scan response по раскладке
+        const BleAdvLayout::Plan& layout = advLayout();
+        BleAdvLayout::Payload adv = layout.adv;
+        if (const esp_err_t ret = esp_ble_gap_config_adv_data_raw(adv.data.data(), adv.size);
+            ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Config adv data failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+
+        // 2. Scan response задается и пустым: иначе остаются данные прошлой раскладки
+        BleAdvLayout::Payload scanRsp = layout.scanRsp;
+        if (const esp_err_t ret = esp_ble_gap_config_scan_rsp_data_raw(scanRsp.data.data(), scanRsp.size);
+            ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Config scan rsp data failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+
+        return ESP_OK;
+    }
+
+    esp_err_t BLE::startLegacyAdvertising()
+    {
+        std::lock_guard lock(mMutex);
+
+        if (!mIsInitialized || mServiceHandle == 0)
+        {
+            ESP_LOGE(TAG, "BLE not initialized");
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        esp_ble_adv_params_t advParams = activeLegacyAdvParams();
+        if (const esp_err_t ret = esp_ble_gap_start_advertising(&advParams);
+            ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Start advertising failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+
+        ESP_LOGI(TAG, "Legacy advertising started | Intv: %d-%dms | Flags: 0x%02X",
+                 advParams.adv_int_min * 5/8,
+                 advParams.adv_int_max * 5/8,
+                 mConfig.advertising.flags);
+
+        return ESP_OK;
+    }
+
+    esp_err_t BLE::configureExtendedAdvertising()
+    {
+        std::lock_guard lock(mMutex);
+
+        if (!mIsInitialized)
+        {
+            ESP_LOGE(TAG, "BLE not properly initialized");
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        // 1. Установка параметров рекламы из конфига
+        const esp_ble_gap_ext_adv_params_t advParams = activeExtAdvParams();
+        esp_err_t ret = esp_ble_gap_ext_adv_set_params(0, &advParams);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Set extended adv params failed (0x%X): %s", ret, esp_err_to_name(ret));
+            return ret;
+        }
+
+        // 2. Данные рекламы по раскладке
+        const BleAdvLayout::Plan& layout = advLayout();
+        ret = esp_ble_gap_config_ext_adv_data_raw(0, layout.adv.size, layout.adv.data.data());
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Config adv data failed (0x%X): %s", ret, esp_err_to_name(ret));
+            return ret;
+        }
+
+        // 3. Scan response (пустой для несканируемого набора: шаг запуска ждет его события)
+        ret = esp_ble_gap_config_ext_scan_rsp_data_raw(0, layout.scanRsp.size, layout.scanRsp.data.data());
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Config scan rsp data failed (0x%X): %s", ret, esp_err_to_name(ret));
+            return ret;
+        }
+
+        return ESP_OK;
+    }
+
+    esp_err_t BLE::startExtendedAdvertising()
     {
         std::lock_guard lock(mMutex);
 
         if (!mIsInitialized || mServiceHandle == 0)
         {
-            ESP_LOGE(TAG, "BLE not properly initialized");
-            return ESP_ERR_INVALID_STATE;
+            ESP_LOGE(TAG, "BLE not properly initialized");
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        constexpr esp_ble_gap_ext_adv_t extAdv = {
+            .instance = 0,
+            .duration = 0,  // Бесконечно
+            .max_events = 0 // Без ограничений
+        };
+
+        if (const esp_err_t ret = esp_ble_gap_ext_adv_start(1, &extAdv); ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Start extended adv failed (0x%X): %s", ret, esp_err_to_name(ret));
+            return ret;
+        }
+
+        ESP_LOGI(TAG, "Extended advertising started | PHY: %s/%s | Interval: %.1f-%.1fms | TxPower: %ddBm | UUID: %s",
+                 mConfig.extAdvParams.primary_phy == ESP_BLE_GAP_PHY_CODED ? "Coded" : "1M",
+                 mConfig.extAdvParams.secondary_phy == ESP_BLE_GAP_PHY_2M ? "2M" :
+                 mConfig.extAdvParams.secondary_phy == ESP_BLE_GAP_PHY_CODED ? "Coded" : "1M",
+                 mConfig.extAdvParams.interval_min * 0.625f,
+                 mConfig.extAdvParams.interval_max * 0.625f,
+                 mConfig.extAdvParams.tx_power,
+                 mConfig.gatt.serviceUuid.toString().data());
+
+        return ESP_OK;
+    }
+
+    void BLE::handleWriteEvent(const uint16_t connId, const esp_ble_gatts_cb_param_t* param)
+    {
+        std::unique_lock lock(mMutex);
+
+        if (param == nullptr)
+        {
+            mDiag.record(BleDiagEvent::RX_NULL_PARAM, connId);
+            return;
+        }
+
+        mPower.onRx(connId, param->write.len);
+
+        if (param->write.need_rsp)
+        {
+            mStats.rxAckedWrites++;
+            mStats.rxAckedBytes += param->write.len;
+        }
+        else
+        {
+            mStats.rxUnackedWrites++;
+            mStats.rxUnackedBytes += param->write.len;
+        }
+
+        if (mBulkHandle != 0 && param->write.handle == mBulkHandle)
+        {
+            handleBulkWrite(connId, param);
+            return;
+        }
+
+        if (mChannelHandle != 0 && param->write.handle == mChannelHandle)
+        {
+            // Транспорт каналов вызывает callback'и приложения: без мьютекса BLE
+            lock.unlock();
+            mChannels.handleFrame(connId, param->write.value, param->write.len);
+            if (param->write.need_rsp)
+            {
+                esp_ble_gatts_send_response(mGattsIf, connId, param->write.trans_id, ESP_GATT_OK, nullptr);
+            }
+            return;
+        }
+
+        // Подписка на уведомления каналов: CCCD отвечает стек, фреймы шлются без проверки подписки
+        if (mChannelCccdHandle != 0 && param->write.handle == mChannelCccdHandle)
+        {
+            return;
+        }
+
+        // Возможности сжатия клиента: ответ уходит под мьютексом, до первого кадра
+        if (mCompressionHandle != 0 && param->write.handle == mCompressionHandle)
+        {
+            const esp_err_t ret = param->write.len >= 1 && !param->write.is_prep
+                ? mCompression.negotiate(connId, param->write.value[0])
+                : ESP_ERR_INVALID_SIZE;
+            sendWriteResponse(connId, param, ret == ESP_OK ? ESP_GATT_OK
+                                             : ret == ESP_ERR_NO_MEM ? ESP_GATT_NO_RESOURCES
+                                             : ESP_GATT_INVALID_ATTR_LEN);
+            return;
+        }
+
+        // Кадр соединения со сжатием: дальше обрабатываются исходные данные
+        const uint8_t* value = param->write.value;
+        size_t valueLen = param->write.len;
+        if (param->write.handle == mCharHandle && mCompression.isActive(connId))
+        {
+            // Кадр не делится на фрагменты Prepare Write: клиент ограничивает его MTU - 3
+            if (param->write.is_prep)
+            {
+                sendWriteResponse(connId, param, ESP_GATT_REQ_NOT_SUPPORTED);
+                return;
+            }
+
+            std::span<const uint8_t> plain;
+            if (const esp_err_t ret = mCompression.decode(connId, value, valueLen, plain); ret != ESP_OK)
+            {
+                mDiag.record(BleDiagEvent::RX_DECODE_FAILED, connId, ret, static_cast<uint32_t>(valueLen));
+                sendWriteResponse(connId, param, ESP_GATT_ERROR);
+                return;
+            }
+            value = plain.data();
+            valueLen = plain.size();
+        }
+
+        // Запись в характеристику данных при работающем мосте уходит в порт
+        if (mBridge.isRunning() && param->write.handle == mCharHandle)
+        {
+            const bool accepted = !param->write.is_prep &&
+                mBridge.handleWrite(connId, value, valueLen, param->write.need_rsp);
+            if (param->write.need_rsp)
+            {
+                esp_ble_gatts_send_response(mGattsIf, connId, param->write.trans_id,
+                                            param->write.is_prep ? ESP_GATT_REQ_NOT_SUPPORTED
+                                            : accepted ? ESP_GATT_OK
+                                            : ESP_GATT_NO_RESOURCES, nullptr);
+            }
+            return;
+        }
+
+        // Валидация handle
+        if (param->write.handle != mCharHandle)
+        {
+            mDiag.record(BleDiagEvent::RX_INVALID_HANDLE, connId, ESP_OK, param->write.handle, mCharHandle);
+            sendWriteResponse(connId, param, ESP_GATT_INVALID_HANDLE);
+            return;
+        }
+
+        // Длинная запись доставляется целиком по Execute Write
+        if (param->write.is_prep)
+        {
+            handlePrepareWrite(connId, param);
+            return;
+        }
+
+        // Валидация размера данных
+        const size_t dataLen = valueLen;
+        if (dataLen == 0 || dataLen > MAX_MTU)
+        {
+            mDiag.record(BleDiagEvent::RX_INVALID_SIZE, connId, ESP_OK, static_cast<uint32_t>(dataLen), MAX_MTU);
+            sendWriteResponse(connId, param, dataLen == 0 ? ESP_GATT_OK : ESP_GATT_INVALID_ATTR_LEN);
+            return;
+        }
+
+        sendWriteResponse(connId, param, dispatchData(lock, connId, {value, dataLen}));
+    }
+
+    esp_gatt_status_t BLE::dispatchData(std::unique_lock<std::recursive_mutex>& lock, const uint16_t connId,
+                                        const std::span<const uint8_t> data)
+    {
+        const auto conn = std::ranges::find_if(mActiveConnections,
+                                               [connId](const auto& item) { return item.connId == connId; });
+        if (conn == mActiveConnections.end())
+        {
+            mDiag.record(BleDiagEvent::RX_STALE_CONNECTION, connId, ESP_OK, static_cast<uint32_t>(data.size()));
+            return ESP_GATT_OK;
+        }
+        const uint32_t generation = conn->generation;
+
+        // Задача BTC только копирует запись: callback вызовет задача ble_rx
+        if (mRxDispatcher.isRunning())
+        {
+            if (!mRxDispatcher.post(connId, generation, data.data(), data.size()))
+            {
+                mDiag.record(BleDiagEvent::RX_QUEUE_FULL, connId, ESP_OK, static_cast<uint32_t>(data.size()));
+                return ESP_GATT_NO_RESOURCES;
+            }
+            return ESP_GATT_OK;
+        }
+
+        // Данные остаются действительны: их меняет только задача BTC, а stop() ждет ее в esp_bluedroid_disable()
+        lock.unlock();
+        return deliverData(connId, generation, data);
+    }
+
+    void BLE::handlePrepareWrite(const uint16_t connId, const esp_ble_gatts_cb_param_t* param)
+    {
+        const auto conn = std::ranges::find_if(mActiveConnections,
+                                               [connId](const auto& item) { return item.connId == connId; });
+        if (conn == mActiveConnections.end())
+        {
+            sendWriteResponse(connId, param, ESP_GATT_ERROR);
+            return;
         }
 
-        // 1. Установка параметров рекламы из конфига
-        esp_err_t ret = esp_ble_gap_ext_adv_set_params(0, &mConfig.extAdvParams);
-        if (ret != ESP_OK)
+        // Фрагменты идут подряд: запись собирается с начала значения
+        std::vector<uint8_t>& prepared = conn->prepared;
+        if (param->write.offset != prepared.size())
         {
-            ESP_LOGE(TAG, "Set extended adv params failed (0x%X): %s", ret, esp_err_to_name(ret));
-            return ret;
+            sendWriteResponse(connId, param, ESP_GATT_INVALID_OFFSET);
+            return;
+        }
+        if (prepared.size() + param->write.len > MAX_MTU)
+        {
+            mDiag.record(BleDiagEvent::RX_INVALID_SIZE, connId, ESP_OK,
+                         static_cast<uint32_t>(prepared.size() + param->write.len), MAX_MTU);
+            sendWriteResponse(connId, param, ESP_GATT_PREPARE_Q_FULL);
+            return;
+        }
+
+        prepared.insert(prepared.end(), param->write.value, param->write.value + param->write.len);
+        sendWriteResponse(connId, param, ESP_GATT_OK);
+    }
+
+    void BLE::handleExecWrite(const esp_ble_gatts_cb_param_t* param)
+    {
+        const uint16_t connId = param->exec_write.conn_id;
+        std::vector<uint8_t> prepared;
+        std::unique_lock lock(mMutex);
+        const auto conn = std::ranges::find_if(mActiveConnections,
+                                               [connId](const auto& item) { return item.connId == connId; });
+        if (conn != mActiveConnections.end())
+        {
+            prepared.swap(conn->prepared);
+        }
+
+        // ESP_GATT_PREP_WRITE_CANCEL: накопленные фрагменты отбрасываются
+        esp_gatt_status_t status = ESP_GATT_OK;
+        if (param->exec_write.exec_write_flag == ESP_GATT_PREP_WRITE_EXEC && !prepared.empty())
+        {
+            status = dispatchData(lock, connId, prepared);
+        }
+
+        if (const esp_err_t ret = esp_ble_gatts_send_response(mGattsIf, connId, param->exec_write.trans_id, status,
+                                                             nullptr); ret != ESP_OK)
+        {
+            // dispatchData() мог освободить мьютекс, а record() требует сериализации
+            std::lock_guard diagLock(mMutex);
+            mDiag.record(BleDiagEvent::RX_RESPONSE_FAILED, connId, ret);
+        }
+    }
+
+    esp_gatt_status_t BLE::deliverData(const uint16_t connId, const uint32_t generation,
+                                       const std::span<const uint8_t> data)
+    {
+        // Под мьютексом только поиск получателя: callback может вызывать API BLE из другой задачи
+        ConnectionDataHandler handler;
+        void* context = nullptr;
+        esp32_c3::objects::Callback* callback = nullptr;
+        {
+            std::lock_guard lock(mMutex);
+
+            // Запись, принятая до отключения, не достается новому соединению с тем же connId
+            const auto conn = std::ranges::find_if(mActiveConnections,
+                                                   [connId](const auto& item) { return item.connId == connId; });
+            if (conn == mActiveConnections.end() || conn->generation != generation)
+            {
+                mDiag.record(BleDiagEvent::RX_STALE_CONNECTION, connId, ESP_OK, static_cast<uint32_t>(data.size()));
+                return ESP_GATT_OK;
+            }
+
+            // Копия: callback может сменить свою привязку или разорвать соединение
+            handler = conn->handler;
+            context = conn->context;
+
+            // Общий callback живет до stop(), а тот ждет задачи ble_rx и BTC
+            callback = mDataCallback.get();
+        }
+
+        // Callback соединения имеет приоритет над общим; данные передаются без копирования в пакет
+        if (handler)
+        {
+            mTrace.record(BleTraceKind::CALLBACK_BEGIN, static_cast<uint8_t>(BleTraceCallback::DATA), connId,
+                          static_cast<uint32_t>(data.size()));
+            handler(connId, data, context);
+            mTrace.record(BleTraceKind::CALLBACK_END, static_cast<uint8_t>(BleTraceCallback::DATA), connId);
+            return ESP_GATT_OK;
+        }
+
+        // Проверка callback
+        if (callback == nullptr)
+        {
+            std::lock_guard lock(mMutex);
+            mDiag.record(BleDiagEvent::RX_NO_CALLBACK, connId);
+            return ESP_GATT_OK;
         }
 
-        // 2. Формирование advertising data
-        std::vector<uint8_t> advData;
+        // Создание и заполнение пакета
+        Packet packet;
+        packet.id = connId;
 
-        // 2.1. Флаги из конфига (обязательное поле)
-        advData.insert(advData.end(), {
-                           0x02, // Length
-                           ESP_BLE_AD_TYPE_FLAG,
-                           mConfig.advertising.flags // Флаги из конфига
-                       });
+        if (!packet.setPayload(data.data(), data.size()))
+        {
+            std::lock_guard lock(mMutex);
+            mDiag.record(BleDiagEvent::RX_PAYLOAD_FAILED, connId, ESP_FAIL, static_cast<uint32_t>(data.size()));
+            return ESP_GATT_NO_RESOURCES;
+        }
 
-        // 2.2. Имя устройства (макс. 28 байт для лучшей совместимости)
-        const uint8_t nameLen = static_cast<uint8_t>(std::min(mDeviceName.length(), static_cast<size_t>(28)));
-        advData.insert(advData.end(), {
-                           static_cast<uint8_t>(nameLen + 1), // Length
-                           ESP_BLE_AD_TYPE_NAME_CMPL
-                       });
-        advData.insert(advData.end(), mDeviceName.begin(), mDeviceName.begin() + nameLen);
+        // Вызов callback
+        mTrace.record(BleTraceKind::CALLBACK_BEGIN, static_cast<uint8_t>(BleTraceCallback::DATA), connId,
+                      static_cast<uint32_t>(data.size()));
+        callback->invoke(&packet);
+        mTrace.record(BleTraceKind::CALLBACK_END, static_cast<uint8_t>(BleTraceCallback::DATA), connId);
+        return ESP_GATT_OK;
+    }
 
-        // 2.3. UUID сервиса из конфига (автоматическое определение типа)
-        if (const auto [uuidLen, uuid] = uuidFromString(mConfig.gatt.serviceUuid, mConfig.gatt.invertBytes); uuidLen == ESP_UUID_LEN_16)
+    void BLE::sendWriteResponse(const uint16_t connId, const esp_ble_gatts_cb_param_t* param,
+                                const esp_gatt_status_t status)
+    {
+        // Write Command (запись без ответа) подтверждения не требует
+        if (!param->write.need_rsp)
         {
-            advData.insert(advData.end(), {
-                               0x03, // Length
-                               ESP_BLE_AD_TYPE_16SRV_CMPL,
-                               static_cast<uint8_t>(uuid.uuid16 & 0xFF),
-                               static_cast<uint8_t>((uuid.uuid16 >> 8) & 0xFF)
-                           });
+            return;
         }
-        else if (uuidLen == ESP_UUID_LEN_128)
+
+        // Prepare Write подтверждается эхом принятого фрагмента
+        esp_gatt_rsp_t* rsp = nullptr;
+        if (param->write.is_prep && status == ESP_GATT_OK)
         {
-            advData.insert(advData.end(), {
-                               static_cast<uint8_t>(1 + ESP_UUID_LEN_128),
-                               ESP_BLE_AD_TYPE_128SRV_CMPL
-                           });
-            advData.insert(advData.end(), uuid.uuid128, uuid.uuid128 + ESP_UUID_LEN_128);
+            const uint16_t len = std::min<uint16_t>(param->write.len, ESP_GATT_MAX_ATTR_LEN);
+            mAttrResponse.attr_value.handle = param->write.handle;
+            mAttrResponse.attr_value.offset = param->write.offset;
+            mAttrResponse.attr_value.len = len;
+            mAttrResponse.attr_value.auth_req = ESP_GATT_AUTH_REQ_NONE;
+            std::memcpy(mAttrResponse.attr_value.value, param->write.value, len);
+            rsp = &mAttrResponse;
         }
 
-        // 3. Установка advertising data
-        ret = esp_ble_gap_config_ext_adv_data_raw(0, advData.size(), advData.data());
+        // Отправка подтверждения
+        const esp_err_t ret = esp_ble_gatts_send_response(mGattsIf, connId, param->write.trans_id, status, rsp);
         if (ret != ESP_OK)
         {
-            ESP_LOGE(TAG, "Config adv data failed (0x%X): %s", ret, esp_err_to_name(ret));
-            return ret;
+            // Вызывается и после dispatchData(), освободившего мьютекс
+            std::lock_guard lock(mMutex);
+            mDiag.record(BleDiagEvent::RX_RESPONSE_FAILED, connId, ret);
+        }
+    }
+
+    void BLE::handleReadEvent(const esp_ble_gatts_cb_param_t* param)
+    {
+        if (!param->read.need_rsp) return;
+
+        // Мьютекс не нужен: хэндлы, MTU и буфер ответа меняются только в задаче BTC
+        const uint16_t connId = param->read.conn_id;
+        esp_gatt_status_t status = ESP_GATT_READ_NOT_PERMIT;
+        if (mCharHandle != 0 && param->read.handle == mCharHandle)
+        {
+            status = mValueCache.serveRead(connId, param->read.offset, param->read.is_long, mMtu, mAttrResponse);
+        }
+        else if (mCompressionHandle != 0 && param->read.handle == mCompressionHandle)
+        {
+            const size_t len = mCompression.capabilities(mAttrResponse.attr_value.value);
+            status = param->read.offset <= len ? ESP_GATT_OK : ESP_GATT_INVALID_OFFSET;
+            if (status == ESP_GATT_OK)
+            {
+                std::memmove(mAttrResponse.attr_value.value, mAttrResponse.attr_value.value + param->read.offset,
+                             len - param->read.offset);
+                mAttrResponse.attr_value.offset = param->read.offset;
+                mAttrResponse.attr_value.len = static_cast<uint16_t>(len - param->read.offset);
+            }
         }
 
-        // 4. Scan Response Data (оставляем пустым, но можно добавить в конфиг при необходимости)
-        static constexpr std::array<uint8_t, 0> scanRspData = {};
-        ret = esp_ble_gap_config_ext_scan_rsp_data_raw(0, scanRspData.size(), scanRspData.data());
+        mAttrResponse.attr_value.handle = param->read.handle;
+        mAttrResponse.attr_value.auth_req = ESP_GATT_AUTH_REQ_NONE;
+        const esp_err_t ret = esp_ble_gatts_send_response(
+            mGattsIf, connId, param->read.trans_id, status, status == ESP_GATT_OK ? &mAttrResponse : nullptr);
         if (ret != ESP_OK)
         {
-            ESP_LOGE(TAG, "Config scan rsp data failed (0x%X): %s", ret, esp_err_to_name(ret));
-            return ret;
+            // Записи диагностики сериализуются мьютексом BLE
+            std::lock_guard lock(mMutex);
+            mDiag.record(BleDiagEvent::RX_RESPONSE_FAILED, connId, ret);
         }
+    }
 
-        // 5. Запуск рекламы
-        constexpr esp_ble_gap_ext_adv_t extAdv = {
-            .instance = 0,
-            .duration = 0,  // Бесконечно
-            .max_events = 0 // Без ограничений
+    esp_err_t BLE::addBulkCharacteristic()
+    {
+        // Потоки выделяются один раз; размер меняется только при перезапуске стека
+        if (mBulkStreams.size() != mConfig.gatt.bulkStreams ||
+            (!mBulkStreams.empty() && mBulkStreams.front().ring->capacity() < mConfig.gatt.bulkBufferSize))
+        {
+            mBulkStreams.clear();
+            mBulkStreams.resize(mConfig.gatt.bulkStreams);
+            for (auto& stream : mBulkStreams)
+            {
+                stream.ring = std::make_unique<SpscByteRing>(mConfig.gatt.bulkBufferSize);
+            }
+        }
+
+        // Ответ формирует приложение: для Write Command он не отправляется вовсе
+        esp_attr_control_t control = {
+            .auto_rsp = ESP_GATT_RSP_BY_APP
+        };
+
+        esp_attr_value_t charValue = {
+            .attr_max_len = MAX_MTU,
+            .attr_len = 0,
+            .attr_value = nullptr
         };
 
-        ret = esp_ble_gap_ext_adv_start(1, &extAdv);
+        esp_bt_uuid_t uuid = mConfig.gatt.bulkCharUuid.toEsp(mConfig.gatt.invertBytes);
+        const esp_gatt_perm_t permissions = mConfig.characteristicPermissions() &
+            (ESP_GATT_PERM_WRITE | ESP_GATT_PERM_WRITE_ENCRYPTED | ESP_GATT_PERM_WRITE_ENC_MITM);
+
+        const esp_err_t ret = esp_ble_gatts_add_char(
+            mServiceHandle, &uuid, permissions,
+            ESP_GATT_CHAR_PROP_BIT_WRITE_NR | ESP_GATT_CHAR_PROP_BIT_WRITE,
+            &charValue, &control);
+
         if (ret != ESP_OK)
         {
-            ESP_LOGE(TAG, "Start extended adv failed (0x%X): %s", ret, esp_err_to_name(ret));
-            return ret;
+            ESP_LOGE(TAG, "Add bulk characteristic failed: %s", esp_err_to_name(ret));
         }
+        return ret;
+    }
 
-        ESP_LOGI(TAG, "Extended advertising started | PHY: %s | Interval: %.1f-%.1fms | TxPower: %ddBm | UUID: %s",
-                 mConfig.extAdvParams.primary_phy == ESP_BLE_GAP_PHY_2M ? "2M" : "1M",
-                 mConfig.extAdvParams.interval_min * 0.625f,
-                 mConfig.extAdvParams.interval_max * 0.625f,
-                 mConfig.extAdvParams.tx_power,
-                 mConfig.gatt.serviceUuid.c_str());
+    esp_err_t BLE::addChannelCharacteristic()
+    {
+        // Ответ формирует приложение: для Write Command он не отправляется вовсе
+        esp_attr_control_t control = {
+            .auto_rsp = ESP_GATT_RSP_BY_APP
+        };
 
-        return ESP_OK;
+        esp_attr_value_t charValue = {
+            .attr_max_len = MAX_MTU,
+            .attr_len = 0,
+            .attr_value = nullptr
+        };
+
+        esp_bt_uuid_t uuid = mConfig.gatt.channelCharUuid.toEsp(mConfig.gatt.invertBytes);
+        const esp_gatt_perm_t permissions = mConfig.characteristicPermissions() &
+            (ESP_GATT_PERM_WRITE | ESP_GATT_PERM_WRITE_ENCRYPTED | ESP_GATT_PERM_WRITE_ENC_MITM);
+
+        const esp_err_t ret = esp_ble_gatts_add_char(
+            mServiceHandle, &uuid, permissions,
+            ESP_GATT_CHAR_PROP_BIT_WRITE_NR | ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_NOTIFY,
+            &charValue, &control);
+
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Add channel characteristic failed: %s", esp_err_to_name(ret));
+        }
+        return ret;
     }
 
-    void BLE::handleWriteEvent(const uint16_t connId, const esp_ble_gatts_cb_param_t* param) const
+    esp_err_t BLE::addChannelCccd()
     {
-        if (param == nullptr)
+        esp_attr_control_t control = {
+            .auto_rsp = ESP_GATT_AUTO_RSP
+        };
+
+        uint8_t cccd[2] = {};
+        esp_attr_value_t value = {
+            .attr_max_len = sizeof(cccd),
+            .attr_len = sizeof(cccd),
+            .attr_value = cccd
+        };
+
+        esp_bt_uuid_t uuid = {
+            .len = ESP_UUID_LEN_16,
+            .uuid = {.uuid16 = ESP_GATT_UUID_CHAR_CLIENT_CONFIG}
+        };
+
+        const esp_err_t ret = esp_ble_gatts_add_char_descr(
+            mServiceHandle, &uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, &value, &control);
+
+        if (ret != ESP_OK)
         {
-            ESP_LOGE(TAG, "Null event param for conn: %u", connId);
-            return;
+            ESP_LOGE(TAG, "Add channel CCCD failed: %s", esp_err_to_name(ret));
+        }
+        return ret;
+    }
+
+    esp_err_t BLE::addCompressionCharacteristic()
+    {
+        // Чтение и запись обслуживает приложение: значение зависит от соединения
+        esp_attr_control_t control = {
+            .auto_rsp = ESP_GATT_RSP_BY_APP
+        };
+
+        esp_attr_value_t charValue = {
+            .attr_max_len = BleCompression::CAPABILITIES_SIZE,
+            .attr_len = 0,
+            .attr_value = nullptr
+        };
+
+        esp_bt_uuid_t uuid = mConfig.gatt.compressionCharUuid.toEsp(mConfig.gatt.invertBytes);
+        const esp_gatt_perm_t permissions = mConfig.characteristicPermissions();
+
+        const esp_err_t ret = esp_ble_gatts_add_char(
+            mServiceHandle, &uuid, permissions,
+            ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_WRITE,
+            &charValue, &control);
+
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Add compression characteristic failed: %s", esp_err_to_name(ret));
+        }
+        return ret;
+    }
+
+    uint16_t BLE::bridgeMtu() const noexcept
+    {
+        return mConfig.gatt.compressionEnabled ? mMtu - BleCompression::HEADER_SIZE : mMtu;
+    }
+
+    esp_err_t BLE::sendChannelFrame(const uint16_t connId, const uint8_t* data, const size_t len,
+                                    const bool blocking) const
+    {
+        // Хэндлы неизменны между запуском и остановкой стека
+        if (mChannelHandle == 0 || mGattsIf == ESP_GATT_IF_NONE || mStopping)
+        {
+            return ESP_ERR_INVALID_STATE;
         }
 
+        mPower.txBegin();
+        mTrace.record(BleTraceKind::SEND_BEGIN, static_cast<uint8_t>(BleTraceSend::CHANNEL_FRAME), connId,
+                      static_cast<uint32_t>(len));
+
+        // Из задачи BTC ждать нельзя: управляющие фреймы ставятся в очередь стека
+        if (blocking)
+        {
+            if (const esp_err_t ret = mTxScheduler.acquire(connId, pdMS_TO_TICKS(TX_CREDIT_TIMEOUT_MS)); ret != ESP_OK)
+            {
+                mPower.txEnd(connId, 0);
+                mTrace.record(BleTraceKind::SEND_END, static_cast<uint8_t>(BleTraceSend::CHANNEL_FRAME), connId,
+                              static_cast<uint32_t>(ret));
+                return ret;
+            }
+        }
+
+        const esp_err_t ret = esp_ble_gatts_send_indicate(
+            mGattsIf, connId, mChannelHandle, len, const_cast<uint8_t*>(data), false);
+        mTxScheduler.complete(len, ret);
+        mPower.txEnd(connId, ret == ESP_OK ? len : 0);
+        mTrace.record(BleTraceKind::SEND_END, static_cast<uint8_t>(BleTraceSend::CHANNEL_FRAME), connId,
+                      static_cast<uint32_t>(ret));
+        return ret;
+    }
+
+    BleChannelTransport& BLE::getChannels() noexcept
+    {
+        return mChannels;
+    }
+
+    BleTrace& BLE::getTrace() noexcept
+    {
+        return mTrace;
+    }
+
+    esp_err_t BLE::startSerialBridge(BleSerialPort& port, const BleSerialBridgeConfig& config)
+    {
         std::lock_guard lock(mMutex);
 
-        // Проверка callback
-        if (mDataCallback == nullptr)
+        if (!mIsInitialized)
         {
-            ESP_LOGE(TAG, "Data callback is null. Conn: %u", connId);
-            return;
+            ESP_LOGE(TAG, "BLE not initialized");
+            return ESP_ERR_INVALID_STATE;
         }
 
-        // Валидация handle
-        if (param->write.handle != mCharHandle)
+        mBridge.setLinkMtu(bridgeMtu());
+        if (const esp_err_t ret = mBridge.start(port, config); ret != ESP_OK)
         {
-            ESP_LOGW(TAG, "Invalid handle %u (expected %u). Conn: %u",
-                     param->write.handle, mCharHandle, connId);
-            return;
+            return ret;
+        }
+        if (!mActiveConnections.empty())
+        {
+            mBridge.handleConnect(mActiveConnections.front().connId);
         }
+        return ESP_OK;
+    }
 
-        // Валидация размера данных
-        const size_t dataLen = param->write.len;
-        if (dataLen == 0 || dataLen > MAX_MTU)
+    void BLE::stopSerialBridge()
+    {
+        // Без мьютекса: задача моста может ждать его в отправке
+        mBridge.stop();
+    }
+
+    BleSerialBridge::Statistics BLE::getSerialBridgeStatistics() const noexcept
+    {
+        return mBridge.getStatistics();
+    }
+
+    BleValueCache& BLE::getValueCache() noexcept
+    {
+        return mValueCache;
+    }
+
+    void BLE::handleBulkWrite(const uint16_t connId, const esp_ble_gatts_cb_param_t* param)
+    {
+        esp_gatt_status_t status = ESP_GATT_OK;
+        const auto* stream = findBulkStream(connId);
+
+        if (param->write.is_prep)
+        {
+            // Поток не собирает длинные записи: клиент должен дробить данные по MTU
+            status = ESP_GATT_REQ_NOT_SUPPORTED;
+        }
+        else if (stream == nullptr)
+        {
+            mStats.bulkDroppedBytes += param->write.len;
+            status = ESP_GATT_NO_RESOURCES;
+        }
+        else if (stream->ring->capacity() - stream->ring->size() < param->write.len)
+        {
+            // Запись не принимается частично: запрос с ответом клиент повторит,
+            // Write Command отбрасывается целиком - разрыв внутри записи испортил бы поток
+            status = ESP_GATT_NO_RESOURCES;
+            if (!param->write.need_rsp)
+            {
+                mStats.bulkDroppedBytes += param->write.len;
+            }
+        }
+        else
+        {
+            const size_t written = stream->ring->write(param->write.value, param->write.len);
+            if (mBulkHandler)
+            {
+                mTrace.record(BleTraceKind::CALLBACK_BEGIN, static_cast<uint8_t>(BleTraceCallback::BULK), connId,
+                              static_cast<uint32_t>(written));
+                mBulkHandler(connId, stream->ring->size());
+                mTrace.record(BleTraceKind::CALLBACK_END, static_cast<uint8_t>(BleTraceCallback::BULK), connId);
+            }
+        }
+
+        if (!param->write.need_rsp)
         {
-            ESP_LOGW(TAG, "Invalid data size: %zu (max %u). Conn: %u",
-                     dataLen, MAX_MTU, connId);
             return;
         }
 
-        // Создание и заполнение пакета
-        Packet packet;
-        packet.id = connId;
+        if (const esp_err_t ret = esp_ble_gatts_send_response(mGattsIf, connId, param->write.trans_id, status, nullptr);
+            ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Bulk response failed. Conn: %u, Error: %s", connId, esp_err_to_name(ret));
+        }
+    }
 
-        if (!packet.setPayload(param->write.value, dataLen))
+    void BLE::bindBulkStream(const uint16_t connId)
+    {
+        // Поток с выданным peekBulk() участком не переиспользуется до consumeBulk()
+        const auto it = std::ranges::find_if(mBulkStreams, [](const BulkStream& stream)
         {
-            ESP_LOGE(TAG, "Payload set failed. Conn: %u, Size: %zu", connId, dataLen);
+            return !stream.bound && !stream.leased;
+        });
+        if (it == mBulkStreams.end())
+        {
+            if (!mBulkStreams.empty())
+            {
+                ESP_LOGW(TAG, "No free bulk stream for conn %u", connId);
+            }
             return;
         }
 
-        // Вызов callback
-        mDataCallback->invoke(&packet);
+        // Остаток данных предыдущего соединения отбрасывается
+        it->ring->reset();
+        it->connId = connId;
+        it->reader = nullptr;
+        it->bound = true;
+    }
 
-        // Отправка подтверждения
-        const esp_err_t ret = esp_ble_gatts_send_response(
-            mGattsIf,
-            connId,
-            param->write.trans_id,
-            ESP_GATT_OK,
-            nullptr
-        );
+    void BLE::releaseBulkStream(const uint16_t connId) noexcept
+    {
+        for (auto& stream : mBulkStreams)
+        {
+            if (stream.bound && stream.connId == connId)
+            {
+                stream.bound = false;
+            }
+        }
+    }
 
-        if (ret != ESP_OK)
+    const BLE::BulkStream* BLE::findBulkStream(const uint16_t connId) const noexcept
+    {
+        const auto it = std::ranges::find_if(mBulkStreams, [connId](const BulkStream& stream)
+        {
+            return stream.bound && stream.connId == connId;
+        });
+        return it != mBulkStreams.end() ? &*it : nullptr;
+    }
+
+    void BLE::setBulkDataHandler(BulkDataHandler handler)
+    {
+        std::lock_guard lock(mMutex);
+        mBulkHandler = std::move(handler);
+    }
+
+    std::span<const uint8_t> BLE::peekBulk(const uint16_t connId) const
+    {
+        std::lock_guard lock(mMutex);
+        const BulkStream* stream = findBulkStream(connId);
+        if (stream == nullptr) return {};
+
+        // Читатель потока один: участок буфера отдается без копирования и должен
+        // оставаться неизменным до consumeBulk()
+        const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+        if (stream->reader == nullptr)
+        {
+            stream->reader = task;
+        }
+        else if (stream->reader != task)
+        {
+            ESP_LOGE(TAG, "Bulk stream of conn %u is read by another task", connId);
+            return {};
+        }
+
+        const std::span<const uint8_t> data = stream->ring->peek();
+        stream->leased = !data.empty();
+        return data;
+    }
+
+    void BLE::consumeBulk(const uint16_t connId, const size_t len) const
+    {
+        std::lock_guard lock(mMutex);
+
+        // Участок мог быть выдан до разрыва соединения: поток ищется и среди освобожденных
+        const auto it = std::ranges::find_if(mBulkStreams, [connId](const BulkStream& stream)
+        {
+            return stream.connId == connId && (stream.bound || stream.leased);
+        });
+        if (it == mBulkStreams.end() || it->reader != xTaskGetCurrentTaskHandle()) return;
+
+        it->leased = false;
+        if (it->bound)
         {
-            ESP_LOGE(TAG, "Response failed. Conn: %u, Error: %s",
-                     connId, esp_err_to_name(ret));
+            it->ring->consume(len);
         }
     }
 } // namespace net
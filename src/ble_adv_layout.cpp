@@ -0,0 +1,176 @@
+#include "net/ble_adv_layout.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace net
+{
+    namespace
+    {
+        /// @brief Bluetooth Base UUID 0000xxxx-0000-1000-8000-00805F9B34FB без первых 4 байт
+        constexpr std::array<uint8_t, 12> BASE_UUID_TAIL = {
+            0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB
+        };
+
+        /**
+         * @brief Заполнение пакета с учетом его емкости
+         */
+        class Writer
+        {
+        public:
+            Writer(BleAdvLayout::Payload& payload, const uint8_t capacity) :
+                mPayload(payload),
+                mCapacity(std::min(capacity, BleAdvLayout::EXT_DATA_MAX))
+            {
+            }
+
+            /**
+             * @brief Свободно байт под значение AD структуры (без длины и типа)
+             */
+            [[nodiscard]] size_t room() const noexcept
+            {
+                const size_t free = mCapacity - mPayload.size;
+                return free > 2 ? free - 2 : 0;
+            }
+
+            void append(const uint8_t type, const uint8_t* value, const size_t len) noexcept
+            {
+                mPayload.data[mPayload.size++] = static_cast<uint8_t>(len + 1);
+                mPayload.data[mPayload.size++] = type;
+                std::memcpy(&mPayload.data[mPayload.size], value, len);
+                mPayload.size = static_cast<uint8_t>(mPayload.size + len);
+            }
+
+        private:
+            BleAdvLayout::Payload& mPayload;
+            uint8_t mCapacity;
+        };
+    } // namespace
+
+    BleAdvLayout::Plan BleAdvLayout::plan(const Input& input) noexcept
+    {
+        Plan plan = {};
+        Writer adv(plan.adv, input.advCapacity);
+        Writer scanRsp(plan.scanRsp, input.scanRspCapacity);
+
+        if (input.flags != 0 && adv.room() >= 1)
+        {
+            adv.append(AD_FLAGS, &input.flags, 1);
+        }
+
+        std::array<uint8_t, ESP_UUID_LEN_128> uuid = {};
+        if (const uint8_t len = compactUuid(input.serviceUuid, input.invertBytes, uuid); len != 0)
+        {
+            const uint8_t type = len == ESP_UUID_LEN_16 ? AD_UUID16_COMPLETE
+                                     : len == ESP_UUID_LEN_32 ? AD_UUID32_COMPLETE
+                                     : AD_UUID128_COMPLETE;
+            if (adv.room() >= len)
+            {
+                adv.append(type, uuid.data(), len);
+                plan.uuid = Placement::ADV;
+            }
+            else if (scanRsp.room() >= len)
+            {
+                scanRsp.append(type, uuid.data(), len);
+                plan.uuid = Placement::SCAN_RSP;
+            }
+            plan.uuidLength = plan.uuid != Placement::NONE ? len : 0;
+        }
+
+        const std::string_view name = input.name;
+        const auto* nameData = reinterpret_cast<const uint8_t*>(name.data());
+        if (name.empty()) return plan;
+
+        if (adv.room() >= name.size())
+        {
+            adv.append(AD_NAME_COMPLETE, nameData, name.size());
+            plan.name = Placement::ADV;
+            return plan;
+        }
+
+        if (scanRsp.room() >= name.size())
+        {
+            scanRsp.append(AD_NAME_COMPLETE, nameData, name.size());
+            plan.name = Placement::SCAN_RSP;
+
+            // Пассивный сканер видит только рекламный пакет: начало имени дублируется в нем
+            if (const size_t len = utf8Prefix(name, adv.room()); len >= MIN_SHORT_NAME)
+            {
+                adv.append(AD_NAME_SHORT, nameData, len);
+                plan.shortName = Placement::ADV;
+                plan.shortNameLength = static_cast<uint8_t>(len);
+            }
+            return plan;
+        }
+
+        // Целиком не помещается: сокращенное имя - в пакет, где больше места
+        const bool toScanRsp = scanRsp.room() >= adv.room();
+        Writer& target = toScanRsp ? scanRsp : adv;
+        if (const size_t len = utf8Prefix(name, target.room()); len != 0)
+        {
+            target.append(AD_NAME_SHORT, nameData, len);
+            plan.shortName = toScanRsp ? Placement::SCAN_RSP : Placement::ADV;
+            plan.shortNameLength = static_cast<uint8_t>(len);
+        }
+        return plan;
+    }
+
+    uint8_t BleAdvLayout::compactUuid(const BleUuid& uuid, const bool invertBytes,
+                                      std::array<uint8_t, ESP_UUID_LEN_128>& out) noexcept
+    {
+        const auto& bytes = uuid.bytes();
+        switch (uuid.length())
+        {
+        case ESP_UUID_LEN_16:
+            out[0] = bytes[1];
+            out[1] = bytes[0];
+            return ESP_UUID_LEN_16;
+
+        case ESP_UUID_LEN_32:
+            for (size_t i = 0; i < ESP_UUID_LEN_32; i++)
+            {
+                out[i] = bytes[ESP_UUID_LEN_32 - 1 - i];
+            }
+            return ESP_UUID_LEN_32;
+
+        case ESP_UUID_LEN_128:
+            break;
+
+        default:
+            return 0;
+        }
+
+        // UUID на базе Base UUID однозначно задается 16 или 32 битами
+        if (std::equal(BASE_UUID_TAIL.begin(), BASE_UUID_TAIL.end(), bytes.begin() + ESP_UUID_LEN_32))
+        {
+            if (bytes[0] == 0 && bytes[1] == 0)
+            {
+                out[0] = bytes[3];
+                out[1] = bytes[2];
+                return ESP_UUID_LEN_16;
+            }
+            for (size_t i = 0; i < ESP_UUID_LEN_32; i++)
+            {
+                out[i] = bytes[ESP_UUID_LEN_32 - 1 - i];
+            }
+            return ESP_UUID_LEN_32;
+        }
+
+        // Порядок байт 128-бит UUID - как при регистрации сервиса (BleUuid::toEsp)
+        for (size_t i = 0; i < ESP_UUID_LEN_128; i++)
+        {
+            out[i] = invertBytes ? bytes[ESP_UUID_LEN_128 - 1 - i] : bytes[i];
+        }
+        return ESP_UUID_LEN_128;
+    }
+
+    size_t BleAdvLayout::utf8Prefix(const std::string_view str, const size_t maxBytes) noexcept
+    {
+        size_t len = std::min(str.size(), maxBytes);
+        while (len > 0 && len < str.size() && (static_cast<uint8_t>(str[len]) & 0xC0) == 0x80)
+        {
+            len--;
+        }
+        return len;
+    }
+} // namespace net
@@ -0,0 +1,656 @@
+#include "net/ble_channel.h"
+
+#include "esp_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace net
+{
+    namespace
+    {
+        uint16_t readLe16(const uint8_t* data) noexcept
+        {
+            return static_cast<uint16_t>(data[0] | data[1] << 8);
+        }
+
+        void writeLe16(uint8_t* data, const uint16_t value) noexcept
+        {
+            data[0] = static_cast<uint8_t>(value & 0xFF);
+            data[1] = static_cast<uint8_t>(value >> 8);
+        }
+
+        /// @brief Размер поля длины SDU в первом K-фрейме
+        constexpr size_t SDU_LENGTH_FIELD = 2;
+
+        /// @brief Максимальное значение счетчика кредитов
+        constexpr uint32_t MAX_CREDITS = 0xFFFF;
+    } // namespace
+
+    BleChannelTransport::BleChannelTransport(FrameSender sender) :
+        mSender(std::move(sender))
+    {
+    }
+
+    esp_err_t BleChannelTransport::registerPsm(const uint16_t psm, const PsmConfig& config,
+                                               std::unique_ptr<esp32_c3::objects::Callback> dataCallback)
+    {
+        std::lock_guard lock(mMutex);
+
+        if (psm == 0 || dataCallback == nullptr || config.initialCredits == 0 ||
+            config.sduMtu < MIN_SDU_MTU || config.sduMtu > MAX_MTU)
+        {
+            ESP_LOGE(TAG, "Invalid PSM 0x%04x params: mtu=%u credits=%u", psm, config.sduMtu, config.initialCredits);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (findPsm(psm) != nullptr)
+        {
+            ESP_LOGW(TAG, "PSM 0x%04x already registered", psm);
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        PsmEntry* entry = findPsm(0);
+        if (entry == nullptr)
+        {
+            ESP_LOGE(TAG, "PSM table full (max %zu)", MAX_PSMS);
+            return ESP_ERR_NO_MEM;
+        }
+
+        entry->psm = psm;
+        entry->config = config;
+        entry->dataCallback = std::move(dataCallback);
+        ESP_LOGI(TAG, "PSM 0x%04x registered: mtu=%u credits=%u", psm, config.sduMtu, config.initialCredits);
+        return ESP_OK;
+    }
+
+    esp_err_t BleChannelTransport::unregisterPsm(const uint16_t psm)
+    {
+        Deferred deferred;
+        {
+            std::lock_guard lock(mMutex);
+
+            PsmEntry* entry = findPsm(psm);
+            if (psm == 0 || entry == nullptr)
+            {
+                return ESP_ERR_NOT_FOUND;
+            }
+
+            for (auto& channel : mChannels)
+            {
+                if ((channel.open || channel.pending) && channel.psm == psm)
+                {
+                    if (channel.open)
+                    {
+                        queueControl(deferred, channel.connId, FRAME_DISCONNECT, psm);
+                    }
+                    closeLocal(channel, deferred);
+                }
+            }
+
+            *entry = PsmEntry{};
+        }
+        flush(deferred);
+        return ESP_OK;
+    }
+
+    void BleChannelTransport::setChannelEventHandler(ChannelEventHandler handler)
+    {
+        std::lock_guard lock(mMutex);
+        mEventHandler = std::move(handler);
+    }
+
+    esp_err_t BleChannelTransport::connectChannel(const uint16_t connId, const uint16_t psm)
+    {
+        Deferred deferred;
+        {
+            std::lock_guard lock(mMutex);
+
+            const PsmEntry* entry = psm != 0 ? findPsm(psm) : nullptr;
+            if (entry == nullptr)
+            {
+                ESP_LOGE(TAG, "PSM 0x%04x not registered", psm);
+                return ESP_ERR_NOT_FOUND;
+            }
+
+            const bool busy = std::ranges::any_of(mChannels, [connId, psm](const Channel& channel)
+            {
+                return (channel.open || channel.pending) && channel.connId == connId && channel.psm == psm;
+            });
+            if (busy)
+            {
+                return ESP_ERR_INVALID_STATE;
+            }
+
+            const auto it = std::ranges::find_if(mChannels, [](const Channel& ch) { return !ch.open && !ch.pending; });
+            if (it == mChannels.end())
+            {
+                return ESP_ERR_NO_MEM;
+            }
+
+            *it = Channel{};
+            it->pending = true;
+            it->connId = connId;
+            it->psm = psm;
+            it->localMtu = entry->config.sduMtu;
+            it->creditBatch = std::max<uint16_t>(1, entry->config.initialCredits / 2);
+            it->dataCallback = entry->dataCallback;
+            it->stats.remoteCredits = entry->config.initialCredits;
+
+            uint8_t req[4];
+            writeLe16(req, it->localMtu);
+            writeLe16(req + 2, it->stats.remoteCredits);
+            queueControl(deferred, connId, FRAME_CONNECT_REQ, psm, req, sizeof(req));
+        }
+
+        const esp_err_t ret = flush(deferred);
+        if (ret != ESP_OK)
+        {
+            std::lock_guard lock(mMutex);
+            for (auto& channel : mChannels)
+            {
+                if (channel.pending && channel.connId == connId && channel.psm == psm)
+                {
+                    channel = Channel{};
+                }
+            }
+        }
+        return ret;
+    }
+
+    esp_err_t BleChannelTransport::sendSdu(const uint16_t connId, const uint16_t psm, const uint8_t* data,
+                                           const size_t len, const TickType_t creditTimeout)
+    {
+        if (data == nullptr || len == 0)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        // Фреймы разных SDU не должны перемешиваться
+        std::lock_guard txLock(mTxMutex);
+
+        uint16_t linkMtu;
+        {
+            std::lock_guard lock(mMutex);
+            const Channel* channel = findChannel(connId, psm);
+            if (channel == nullptr)
+            {
+                return ESP_ERR_NOT_FOUND;
+            }
+            if (len > channel->remoteMtu)
+            {
+                ESP_LOGE(TAG, "SDU %zu exceeds remote MTU %u", len, channel->remoteMtu);
+                return ESP_ERR_INVALID_SIZE;
+            }
+            linkMtu = mLinkMtu;
+        }
+
+        std::array<uint8_t, MAX_MTU> frame = {};
+        const size_t maxFrame = std::min<size_t>(linkMtu - ATT_HEADER, frame.size());
+        size_t offset = 0;
+
+        while (offset < len)
+        {
+            // 1. Кредит получателя: ожидание фрейма CREDIT или закрытия канала
+            // (мьютекс освобождается на время ожидания)
+            {
+                std::unique_lock lock(mMutex);
+                const auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(static_cast<uint64_t>(creditTimeout) * portTICK_PERIOD_MS);
+                bool stalled = false;
+                Channel* channel = findChannel(connId, psm);
+                while (channel != nullptr && channel->stats.localCredits == 0)
+                {
+                    if (!stalled)
+                    {
+                        channel->stats.creditStalls++;
+                        stalled = true;
+                    }
+
+                    if (creditTimeout == portMAX_DELAY)
+                    {
+                        mCreditCv.wait(lock);
+                    }
+                    else if (mCreditCv.wait_until(lock, deadline) == std::cv_status::timeout)
+                    {
+                        channel = findChannel(connId, psm);
+                        break;
+                    }
+                    channel = findChannel(connId, psm);
+                }
+
+                if (channel == nullptr)
+                {
+                    return ESP_ERR_INVALID_STATE; // Канал закрыт во время отправки
+                }
+                if (channel->stats.localCredits == 0)
+                {
+                    ESP_LOGW(TAG, "No credits on PSM 0x%04x conn %u, sent %zu/%zu", psm, connId, offset, len);
+                    return ESP_ERR_TIMEOUT;
+                }
+                channel->stats.localCredits--;
+            }
+
+            // 2. K-фрейм: первый несет длину SDU
+            size_t pos = 0;
+            frame[pos++] = FRAME_DATA;
+            writeLe16(&frame[pos], psm);
+            pos += 2;
+            if (offset == 0)
+            {
+                writeLe16(&frame[pos], static_cast<uint16_t>(len));
+                pos += SDU_LENGTH_FIELD;
+            }
+
+            const size_t segment = std::min(len - offset, maxFrame - pos);
+            memcpy(&frame[pos], data + offset, segment);
+
+            if (const esp_err_t ret = mSender(connId, frame.data(), pos + segment, true); ret != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Frame send failed on PSM 0x%04x: %s", psm, esp_err_to_name(ret));
+                return ret;
+            }
+
+            offset += segment;
+            std::lock_guard lock(mMutex);
+            if (Channel* channel = findChannel(connId, psm))
+            {
+                channel->stats.txFrames++;
+            }
+        }
+
+        std::lock_guard lock(mMutex);
+        if (Channel* channel = findChannel(connId, psm))
+        {
+            channel->stats.txSdus++;
+            channel->stats.txBytes += len;
+        }
+        return ESP_OK;
+    }
+
+    esp_err_t BleChannelTransport::closeChannel(const uint16_t connId, const uint16_t psm)
+    {
+        Deferred deferred;
+        {
+            std::lock_guard lock(mMutex);
+
+            Channel* channel = findChannel(connId, psm);
+            if (channel == nullptr)
+            {
+                return ESP_ERR_NOT_FOUND;
+            }
+
+            queueControl(deferred, connId, FRAME_DISCONNECT, psm);
+            closeLocal(*channel, deferred);
+        }
+        return flush(deferred);
+    }
+
+    void BleChannelTransport::handleFrame(const uint16_t connId, const uint8_t* data, const size_t len)
+    {
+        if (data == nullptr || len < FRAME_HEADER)
+        {
+            ESP_LOGW(TAG, "Short frame (%zu bytes) on conn %u", len, connId);
+            return;
+        }
+
+        const auto type = static_cast<FrameType>(data[0]);
+        const uint16_t psm = readLe16(data + 1);
+        const uint8_t* payload = data + FRAME_HEADER;
+        const size_t payloadLen = len - FRAME_HEADER;
+
+        Deferred deferred;
+        {
+            std::lock_guard lock(mMutex);
+
+            if (type == FRAME_CONNECT_REQ)
+            {
+                handleConnectRequest(connId, psm, payload, payloadLen, deferred);
+            }
+            else if (type == FRAME_CONNECT_RSP)
+            {
+                handleConnectResponse(connId, psm, payload, payloadLen, deferred);
+            }
+            else if (Channel* channel = findChannel(connId, psm); channel == nullptr)
+            {
+                ESP_LOGW(TAG, "Frame type %u for closed PSM 0x%04x on conn %u", type, psm, connId);
+                return;
+            }
+            else
+            {
+                switch (type)
+                {
+                case FRAME_DATA:
+                    handleData(*channel, payload, payloadLen, deferred);
+                    break;
+
+                case FRAME_CREDIT:
+                    if (payloadLen >= 2)
+                    {
+                        const uint32_t credits = channel->stats.localCredits + readLe16(payload);
+                        channel->stats.localCredits = static_cast<uint16_t>(std::min(credits, MAX_CREDITS));
+                        mCreditCv.notify_all();
+                    }
+                    break;
+
+                case FRAME_DISCONNECT:
+                    ESP_LOGI(TAG, "PSM 0x%04x closed by peer on conn %u", psm, connId);
+                    closeLocal(*channel, deferred);
+                    break;
+
+                default:
+                    ESP_LOGW(TAG, "Unknown frame type %u on conn %u", type, connId);
+                    break;
+                }
+            }
+        }
+        flush(deferred);
+    }
+
+    void BleChannelTransport::handleDisconnect(const uint16_t connId)
+    {
+        Deferred deferred;
+        {
+            std::lock_guard lock(mMutex);
+            for (auto& channel : mChannels)
+            {
+                if ((channel.open || channel.pending) && channel.connId == connId)
+                {
+                    closeLocal(channel, deferred);
+                }
+            }
+        }
+        flush(deferred);
+    }
+
+    void BleChannelTransport::setLinkMtu(const uint16_t mtu) noexcept
+    {
+        std::lock_guard lock(mMutex);
+        mLinkMtu = std::clamp<uint16_t>(mtu, MIN_SDU_MTU, MAX_MTU);
+    }
+
+    esp_err_t BleChannelTransport::getStatistics(const uint16_t connId, const uint16_t psm,
+                                                 ChannelStatistics& stats) const
+    {
+        std::lock_guard lock(mMutex);
+        const Channel* channel = findChannel(connId, psm);
+        if (channel == nullptr)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+        stats = channel->stats;
+        return ESP_OK;
+    }
+
+    BleChannelTransport::PsmEntry* BleChannelTransport::findPsm(const uint16_t psm) noexcept
+    {
+        const auto it = std::ranges::find_if(mPsms, [psm](const PsmEntry& entry) { return entry.psm == psm; });
+        return it != mPsms.end() ? &*it : nullptr;
+    }
+
+    BleChannelTransport::Channel* BleChannelTransport::findChannel(const uint16_t connId, const uint16_t psm) noexcept
+    {
+        const auto it = std::ranges::find_if(mChannels, [connId, psm](const Channel& channel)
+        {
+            return channel.open && channel.connId == connId && channel.psm == psm;
+        });
+        return it != mChannels.end() ? &*it : nullptr;
+    }
+
+    const BleChannelTransport::Channel* BleChannelTransport::findChannel(const uint16_t connId,
+                                                                        const uint16_t psm) const noexcept
+    {
+        return const_cast<BleChannelTransport*>(this)->findChannel(connId, psm);
+    }
+
+    void BleChannelTransport::handleConnectRequest(const uint16_t connId, const uint16_t psm,
+                                                   const uint8_t* payload, const size_t len, Deferred& deferred)
+    {
+        uint8_t rsp[5] = {};
+        auto reject = [&](const ConnectResult result)
+        {
+            ESP_LOGW(TAG, "Reject PSM 0x%04x on conn %u: result 0x%02x", psm, connId, static_cast<uint8_t>(result));
+            rsp[0] = static_cast<uint8_t>(result);
+            queueControl(deferred, connId, FRAME_CONNECT_RSP, psm, rsp, sizeof(rsp));
+        };
+
+        const PsmEntry* entry = psm != 0 ? findPsm(psm) : nullptr;
+        if (entry == nullptr)
+        {
+            reject(ConnectResult::PSM_NOT_SUPPORTED);
+            return;
+        }
+
+        if (len < 4 || readLe16(payload) < MIN_SDU_MTU)
+        {
+            reject(ConnectResult::UNACCEPTABLE_PARAMS);
+            return;
+        }
+
+        // Повторный запрос на открытом канале переоткрывает его
+        Channel* channel = findChannel(connId, psm);
+        if (channel != nullptr)
+        {
+            closeLocal(*channel, deferred);
+        }
+
+        const auto it = std::ranges::find_if(mChannels, [](const Channel& ch) { return !ch.open && !ch.pending; });
+        if (it == mChannels.end())
+        {
+            reject(ConnectResult::NO_RESOURCES);
+            return;
+        }
+
+        channel = &*it;
+        *channel = Channel{};
+        channel->open = true;
+        channel->connId = connId;
+        channel->psm = psm;
+        channel->remoteMtu = readLe16(payload);
+        channel->localMtu = entry->config.sduMtu;
+        channel->creditBatch = std::max<uint16_t>(1, entry->config.initialCredits / 2);
+        channel->dataCallback = entry->dataCallback;
+        channel->stats.localCredits = readLe16(payload + 2);
+        channel->stats.remoteCredits = entry->config.initialCredits;
+
+        rsp[0] = static_cast<uint8_t>(ConnectResult::SUCCESS);
+        writeLe16(rsp + 1, channel->localMtu);
+        writeLe16(rsp + 3, channel->stats.remoteCredits);
+        queueControl(deferred, connId, FRAME_CONNECT_RSP, psm, rsp, sizeof(rsp));
+
+        ESP_LOGI(TAG, "PSM 0x%04x open on conn %u: tx mtu=%u credits=%u", psm, connId,
+                 channel->remoteMtu, channel->stats.localCredits);
+        deferred.events[deferred.eventCount++] = {connId, psm, true};
+    }
+
+    void BleChannelTransport::handleConnectResponse(const uint16_t connId, const uint16_t psm,
+                                                    const uint8_t* payload, const size_t len, Deferred& deferred)
+    {
+        const auto it = std::ranges::find_if(mChannels, [connId, psm](const Channel& channel)
+        {
+            return channel.pending && channel.connId == connId && channel.psm == psm;
+        });
+        if (it == mChannels.end())
+        {
+            ESP_LOGW(TAG, "Unexpected CONNECT_RSP for PSM 0x%04x on conn %u", psm, connId);
+            return;
+        }
+
+        const auto result = len >= 5 ? static_cast<ConnectResult>(payload[0]) : ConnectResult::UNACCEPTABLE_PARAMS;
+        if (result != ConnectResult::SUCCESS || readLe16(payload + 1) < MIN_SDU_MTU)
+        {
+            ESP_LOGW(TAG, "PSM 0x%04x refused on conn %u: result 0x%02x", psm, connId, static_cast<uint8_t>(result));
+            closeLocal(*it, deferred);
+            return;
+        }
+
+        it->pending = false;
+        it->open = true;
+        it->remoteMtu = readLe16(payload + 1);
+        it->stats.localCredits = readLe16(payload + 3);
+        mCreditCv.notify_all();
+
+        ESP_LOGI(TAG, "PSM 0x%04x open on conn %u: tx mtu=%u credits=%u", psm, connId,
+                 it->remoteMtu, it->stats.localCredits);
+        deferred.events[deferred.eventCount++] = {connId, psm, true};
+    }
+
+    void BleChannelTransport::handleData(Channel& channel, const uint8_t* payload, size_t len, Deferred& deferred)
+    {
+        // Отправитель без кредитов нарушает протокол: канал закрывается
+        if (channel.stats.remoteCredits == 0)
+        {
+            ESP_LOGE(TAG, "Frame without credits on PSM 0x%04x conn %u", channel.psm, channel.connId);
+            queueControl(deferred, channel.connId, FRAME_DISCONNECT, channel.psm);
+            closeLocal(channel, deferred);
+            return;
+        }
+        channel.stats.remoteCredits--;
+        channel.stats.rxFrames++;
+
+        if (channel.sduLength == 0)
+        {
+            const uint16_t sduLength = len >= SDU_LENGTH_FIELD ? readLe16(payload) : 0;
+            if (sduLength == 0 || sduLength > channel.localMtu)
+            {
+                ESP_LOGE(TAG, "Invalid SDU length %u on PSM 0x%04x", sduLength, channel.psm);
+                queueControl(deferred, channel.connId, FRAME_DISCONNECT, channel.psm);
+                closeLocal(channel, deferred);
+                return;
+            }
+            channel.sduLength = sduLength;
+            channel.sduReceived = 0;
+            payload += SDU_LENGTH_FIELD;
+            len -= SDU_LENGTH_FIELD;
+        }
+
+        if (channel.sduReceived + len > channel.sduLength)
+        {
+            ESP_LOGE(TAG, "SDU overflow on PSM 0x%04x", channel.psm);
+            queueControl(deferred, channel.connId, FRAME_DISCONNECT, channel.psm);
+            closeLocal(channel, deferred);
+            return;
+        }
+
+        memcpy(channel.sdu.data() + channel.sduReceived, payload, len);
+        channel.sduReceived += static_cast<uint16_t>(len);
+
+        if (channel.sduReceived == channel.sduLength)
+        {
+            // SDU копируется в пакет: callback вызывается после освобождения мьютекса
+            deferred.sdu.id = channel.connId;
+            if (deferred.sdu.setPayload(channel.sdu.data(), channel.sduLength))
+            {
+                deferred.sduCallback = channel.dataCallback;
+            }
+            else
+            {
+                ESP_LOGE(TAG, "Payload set failed. Conn: %u, Size: %u", channel.connId, channel.sduLength);
+            }
+
+            channel.stats.rxSdus++;
+            channel.stats.rxBytes += channel.sduLength;
+            channel.sduLength = 0;
+            channel.sduReceived = 0;
+        }
+
+        // Кредиты возвращаются пачками, чтобы не тратить фрейм на каждый сегмент;
+        // если фрейм не уйдет, flush() вернет их в pendingReturn
+        if (++channel.pendingReturn >= channel.creditBatch)
+        {
+            uint8_t credits[2];
+            writeLe16(credits, channel.pendingReturn);
+            queueControl(deferred, channel.connId, FRAME_CREDIT, channel.psm, credits, sizeof(credits),
+                         channel.pendingReturn);
+            channel.stats.remoteCredits += channel.pendingReturn;
+            channel.pendingReturn = 0;
+        }
+    }
+
+    void BleChannelTransport::queueControl(Deferred& deferred, const uint16_t connId, const FrameType type,
+                                           const uint16_t psm, const uint8_t* payload, const size_t len,
+                                           const uint16_t credits) noexcept
+    {
+        if (deferred.frameCount == deferred.frames.size()) return;
+
+        Deferred::Frame& frame = deferred.frames[deferred.frameCount++];
+        frame.connId = connId;
+        frame.type = type;
+        frame.psm = psm;
+        frame.len = static_cast<uint8_t>(std::min(len, sizeof(frame.payload)));
+        frame.credits = credits;
+        if (payload != nullptr)
+        {
+            memcpy(frame.payload, payload, frame.len);
+        }
+    }
+
+    esp_err_t BleChannelTransport::flush(Deferred& deferred)
+    {
+        // 1. Управляющие фреймы
+        esp_err_t result = ESP_OK;
+        for (size_t i = 0; i < deferred.frameCount; i++)
+        {
+            const Deferred::Frame& frame = deferred.frames[i];
+            const esp_err_t ret = sendControl(frame);
+            if (ret == ESP_OK) continue;
+
+            result = result == ESP_OK ? ret : result;
+            if (frame.credits != 0)
+            {
+                // Кредиты не вернулись отправителю: повторим со следующим фреймом
+                std::lock_guard lock(mMutex);
+                if (Channel* channel = findChannel(frame.connId, frame.psm))
+                {
+                    channel->stats.remoteCredits -= std::min(channel->stats.remoteCredits, frame.credits);
+                    channel->pendingReturn += frame.credits;
+                }
+            }
+        }
+
+        // 2. Собранный SDU
+        if (deferred.sduCallback)
+        {
+            deferred.sduCallback->invoke(&deferred.sdu);
+        }
+
+        // 3. События каналов
+        if (deferred.eventCount != 0)
+        {
+            ChannelEventHandler handler;
+            {
+                std::lock_guard lock(mMutex);
+                handler = mEventHandler;
+            }
+            for (size_t i = 0; handler && i < deferred.eventCount; i++)
+            {
+                const Deferred::Event& event = deferred.events[i];
+                handler(event.connId, event.psm, event.connected);
+            }
+        }
+        return result;
+    }
+
+    esp_err_t BleChannelTransport::sendControl(const Deferred::Frame& frame) const
+    {
+        uint8_t data[FRAME_HEADER + sizeof(frame.payload)] = {};
+        data[0] = frame.type;
+        writeLe16(data + 1, frame.psm);
+        memcpy(data + FRAME_HEADER, frame.payload, frame.len);
+        return mSender(frame.connId, data, FRAME_HEADER + frame.len, false);
+    }
+
+    void BleChannelTransport::closeLocal(Channel& channel, Deferred& deferred)
+    {
+        // Незавершенное открытие (pending) приложению не объявлялось
+        if (channel.open && deferred.eventCount < deferred.events.size())
+        {
+            deferred.events[deferred.eventCount++] = {channel.connId, channel.psm, false};
+        }
+        channel = Channel{};
+
+        // Отправитель, ждущий кредиты, вернется с ESP_ERR_INVALID_STATE
+        mCreditCv.notify_all();
+    }
+} // namespace net
@@ -0,0 +1,140 @@
+#include "net/ble_compress.h"
+
+#include "esp_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace net
+{
+    size_t BleCompression::capabilities(uint8_t* out) const noexcept
+    {
+        out[0] = VERSION;
+        out[1] = CAP_LZ;
+        out[2] = std::clamp(mWindowBits, BleLz::MIN_WINDOW_BITS, BleLz::MAX_WINDOW_BITS);
+        return CAPABILITIES_SIZE;
+    }
+
+    esp_err_t BleCompression::negotiate(const uint16_t connId, const uint8_t peerCaps)
+    {
+        release(connId);
+        if ((peerCaps & CAP_LZ) == 0)
+        {
+            ESP_LOGI(TAG, "Compression off for conn %u", connId);
+            return ESP_OK;
+        }
+
+        // Окна выделяются только для клиентов, согласивших сжатие
+        const uint8_t windowBits = std::clamp(mWindowBits, BleLz::MIN_WINDOW_BITS, BleLz::MAX_WINDOW_BITS);
+        auto* link = new (std::nothrow) Link{
+            connId, BleLzEncoder(windowBits, MAX_MTU), BleLzDecoder(windowBits, MAX_MTU)
+        };
+        if (link == nullptr)
+        {
+            ESP_LOGE(TAG, "No memory for compression windows, conn %u", connId);
+            return ESP_ERR_NO_MEM;
+        }
+        mLinks.emplace_back(link);
+
+        ESP_LOGI(TAG, "Compression on for conn %u (window %u bytes)", connId, 1u << windowBits);
+        return ESP_OK;
+    }
+
+    void BleCompression::release(const uint16_t connId) noexcept
+    {
+        std::erase_if(mLinks, [connId](const auto& link) { return link->connId == connId; });
+    }
+
+    void BleCompression::releaseAll() noexcept
+    {
+        mLinks.clear();
+    }
+
+    bool BleCompression::isActive(const uint16_t connId) const noexcept
+    {
+        return find(connId) != nullptr;
+    }
+
+    size_t BleCompression::encode(const uint16_t connId, const uint8_t* data, const size_t len, uint8_t* out,
+                                  const size_t capacity) noexcept
+    {
+        Link* link = find(connId);
+        if (link == nullptr || capacity <= HEADER_SIZE || len > MAX_MTU) return 0;
+
+        // Сжатый кадр должен быть короче исходного: иначе данные уходят как есть
+        const size_t limit = std::min(capacity - HEADER_SIZE, len - (len != 0 ? 1 : 0));
+        size_t size = link->encoder.compress(data, len, out + HEADER_SIZE, limit);
+        link->pendingRaw = size == 0;
+        if (size == 0)
+        {
+            if (len > capacity - HEADER_SIZE) return 0;
+            std::memcpy(out + HEADER_SIZE, data, len);
+            size = len;
+        }
+
+        out[0] = link->pendingRaw ? FRAME_RAW : FRAME_LZ;
+        link->pendingPlain = len;
+        link->pendingWire = size + HEADER_SIZE;
+        return link->pendingWire;
+    }
+
+    void BleCompression::commit(const uint16_t connId) noexcept
+    {
+        Link* link = find(connId);
+        if (link == nullptr) return;
+
+        link->encoder.commit();
+        mTxPlainBytes.fetch_add(link->pendingPlain, std::memory_order_relaxed);
+        mTxWireBytes.fetch_add(link->pendingWire, std::memory_order_relaxed);
+        if (link->pendingRaw)
+        {
+            mTxRawFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    esp_err_t BleCompression::decode(const uint16_t connId, const uint8_t* frame, const size_t len,
+                                     std::span<const uint8_t>& out) noexcept
+    {
+        Link* link = find(connId);
+        if (link == nullptr) return ESP_ERR_INVALID_STATE;
+
+        bool ok = false;
+        if (len >= HEADER_SIZE && frame[0] == FRAME_RAW)
+        {
+            ok = link->decoder.store(frame + HEADER_SIZE, len - HEADER_SIZE, out);
+        }
+        else if (len >= HEADER_SIZE && frame[0] == FRAME_LZ)
+        {
+            ok = link->decoder.decompress(frame + HEADER_SIZE, len - HEADER_SIZE, out);
+        }
+
+        if (!ok)
+        {
+            mRxErrors.fetch_add(1, std::memory_order_relaxed);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        mRxWireBytes.fetch_add(len, std::memory_order_relaxed);
+        mRxPlainBytes.fetch_add(out.size(), std::memory_order_relaxed);
+        return ESP_OK;
+    }
+
+    BleCompression::Statistics BleCompression::getStatistics() const noexcept
+    {
+        return {
+            .txPlainBytes = mTxPlainBytes.load(),
+            .txWireBytes = mTxWireBytes.load(),
+            .rxPlainBytes = mRxPlainBytes.load(),
+            .rxWireBytes = mRxWireBytes.load(),
+            .txRawFrames = mTxRawFrames.load(),
+            .rxErrors = mRxErrors.load(),
+            .links = static_cast<uint32_t>(mLinks.size()),
+        };
+    }
+
+    BleCompression::Link* BleCompression::find(const uint16_t connId) const noexcept
+    {
+        const auto it = std::ranges::find_if(mLinks, [connId](const auto& link) { return link->connId == connId; });
+        return it != mLinks.end() ? it->get() : nullptr;
+    }
+} // namespace net
@@ -1,146 +1,149 @@
 #include "net/ble_config.h"
 
+#include <cstdio>
+#include <cstring>
+
 namespace net
 {
-    BleConfig::BleConfig(const Preset preset)
-    {
-        applyPreset(preset);
-    }
-
-    BleConfig::Preset BleConfig::currentPreset() const noexcept
+    uint16_t BleConfig::diff(const BleConfig& other) const noexcept
     {
-        return mCurrentPreset;
-    }
+        uint16_t fields = 0;
+
+        const auto& ea = extAdvParams;
+        const auto& eb = other.extAdvParams;
+        const auto& la = legacyAdvParams;
+        const auto& lb = other.legacyAdvParams;
+        if (ea.type != eb.type || ea.interval_min != eb.interval_min || ea.interval_max != eb.interval_max ||
+            ea.channel_map != eb.channel_map || ea.own_addr_type != eb.own_addr_type ||
+            ea.peer_addr_type != eb.peer_addr_type || memcmp(ea.peer_addr, eb.peer_addr, ESP_BD_ADDR_LEN) != 0 ||
+            ea.filter_policy != eb.filter_policy || ea.tx_power != eb.tx_power ||
+            ea.primary_phy != eb.primary_phy || ea.max_skip != eb.max_skip ||
+            ea.secondary_phy != eb.secondary_phy || ea.sid != eb.sid || ea.scan_req_notif != eb.scan_req_notif ||
+            la.adv_int_min != lb.adv_int_min || la.adv_int_max != lb.adv_int_max || la.adv_type != lb.adv_type ||
+            la.own_addr_type != lb.own_addr_type || memcmp(la.peer_addr, lb.peer_addr, ESP_BD_ADDR_LEN) != 0 ||
+            la.peer_addr_type != lb.peer_addr_type || la.channel_map != lb.channel_map ||
+            la.adv_filter_policy != lb.adv_filter_policy || acceptList.autoFromBonds != other.acceptList.autoFromBonds)
+        {
+            fields |= FIELD_ADV_PARAMS;
+        }
 
-    bool BleConfig::supportsExtendedAdvertising() const noexcept
-    {
-        return mCurrentPreset == Preset::BLE5_DEFAULT ||
-            mCurrentPreset == Preset::BLE5_LOW_POWER ||
-            mCurrentPreset == Preset::BLE5_ULTRA_PERF;
-    }
+        if (advertising.flags != other.advertising.flags)
+        {
+            fields |= FIELD_ADV_DATA;
+        }
 
-    void BleConfig::applyPreset(const Preset preset) noexcept
-    {
-        mCurrentPreset = preset;
+        // Мощность по умолчанию меняется на лету, остальное требует переинициализации контроллера
+        if (controller.txpwr_dft != other.controller.txpwr_dft)
+        {
+            fields |= FIELD_TX_POWER;
+        }
+        esp_bt_controller_config_t controllerCopy = other.controller;
+        controllerCopy.txpwr_dft = controller.txpwr_dft;
+        if (memcmp(&controller, &controllerCopy, sizeof(controller)) != 0 ||
+            supportsExtendedAdvertising() != other.supportsExtendedAdvertising() ||
+            privacy.enabled != other.privacy.enabled || privacy.rpaTimeoutS != other.privacy.rpaTimeoutS ||
+            privacy.bondedOnly != other.privacy.bondedOnly || power.enabled != other.power.enabled ||
+            power.fastIntervalMax != other.power.fastIntervalMax || power.txHoldMs != other.power.txHoldMs ||
+            power.lockCpuFrequency != other.power.lockCpuFrequency || power.txOctets != other.power.txOctets ||
+            diag.deferred != other.diag.deferred || diag.burst != other.diag.burst ||
+            diag.windowMs != other.diag.windowMs || diag.taskPriority != other.diag.taskPriority ||
+            diag.taskStack != other.diag.taskStack || diag.taskCore != other.diag.taskCore ||
+            rx.deferred != other.rx.deferred || rx.bufferSize != other.rx.bufferSize ||
+            rx.taskPriority != other.rx.taskPriority || rx.taskStack != other.rx.taskStack ||
+            rx.taskCore != other.rx.taskCore || schedule.enabled != other.schedule.enabled ||
+            schedule.queueLength != other.schedule.queueLength || schedule.leadUs != other.schedule.leadUs ||
+            schedule.batch != other.schedule.batch || schedule.observeEvery != other.schedule.observeEvery ||
+            schedule.taskPriority != other.schedule.taskPriority || schedule.taskStack != other.schedule.taskStack ||
+            schedule.taskCore != other.schedule.taskCore)
+        {
+            fields |= FIELD_CONTROLLER;
+        }
 
-        switch (preset)
+        if (connection.txPhy != other.connection.txPhy || connection.rxPhy != other.connection.rxPhy)
         {
-        case Preset::BLE5_DEFAULT:
-        case Preset::BLE5_LOW_POWER:
-        case Preset::BLE5_ULTRA_PERF:
-            applyBle5Preset(preset);
-            break;
+            fields |= FIELD_DEFAULT_PHY;
+        }
 
-        case Preset::BLE4_DEFAULT:
-        case Preset::BLE4_LOW_POWER:
-        case Preset::BLE4_HIGH_PERF:
-            applyBle4Preset(preset);
-            break;
+        if (connection.minInterval != other.connection.minInterval ||
+            connection.maxInterval != other.connection.maxInterval ||
+            connection.latency != other.connection.latency ||
+            connection.supervisionTimeout != other.connection.supervisionTimeout)
+        {
+            fields |= FIELD_CONN_PARAMS;
+        }
 
-        default:
-            applyBle5Preset(Preset::BLE5_DEFAULT);
+        if (security.authReq != other.security.authReq || security.ioCap != other.security.ioCap ||
+            security.keySize != other.security.keySize || security.initKey != other.security.initKey ||
+            security.rspKey != other.security.rspKey || security.secureConnections != other.security.secureConnections ||
+            security.secureConnectionsOnly != other.security.secureConnectionsOnly ||
+            security.staticPasskey != other.security.staticPasskey)
+        {
+            fields |= FIELD_SECURITY;
         }
-    }
 
-    void BleConfig::copyFrom(const BleConfig& source) noexcept
-    {
-        // Копируем пресет
-        mCurrentPreset = source.mCurrentPreset;
+        if (gatt.appId != other.gatt.appId || gatt.serviceUuid != other.gatt.serviceUuid ||
+            gatt.charUuid != other.gatt.charUuid || gatt.invertBytes != other.gatt.invertBytes ||
+            gatt.charProperties != other.gatt.charProperties || gatt.charPermissions != other.gatt.charPermissions ||
+            gatt.bulkEnabled != other.gatt.bulkEnabled || gatt.bulkCharUuid != other.gatt.bulkCharUuid ||
+            gatt.bulkBufferSize != other.gatt.bulkBufferSize || gatt.bulkStreams != other.gatt.bulkStreams ||
+            gatt.channelsEnabled != other.gatt.channelsEnabled || gatt.channelCharUuid != other.gatt.channelCharUuid ||
+            gatt.compressionEnabled != other.gatt.compressionEnabled ||
+            gatt.compressionCharUuid != other.gatt.compressionCharUuid ||
+            gatt.compressionWindowBits != other.gatt.compressionWindowBits ||
+            gatt.requireEncryption != other.gatt.requireEncryption ||
+            characteristicPermissions() != other.characteristicPermissions())
+        {
+            fields |= FIELD_GATT;
+        }
 
-        // Копируем простые структуры
-        controller = source.controller;
-        extAdvParams = source.extAdvParams;
-        legacyAdvParams = source.legacyAdvParams;
-        security = source.security;
-        connection = source.connection;
-        advertising = source.advertising;
-        gatt = source.gatt;
+        return fields;
     }
 
-    void BleConfig::applyBle5Preset(const Preset preset) noexcept
+    size_t BleConfig::formatIssue(const ValidationIssue& issue, char* buffer, const size_t size) noexcept
     {
-        // Базовые настройки для BLE 5.x
-        controller = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
-        controller.bluetooth_mode = ESP_BT_MODE_BLE;
-        controller.ble_max_act = 6;
-        extAdvParams.primary_phy = ESP_BLE_GAP_PHY_2M;
-        extAdvParams.secondary_phy = ESP_BLE_GAP_PHY_2M;
-        controller.ble_50_feat_supp = true; // Включаем BLE 5.0 фичи
-        gatt.invertBytes = false;
-
-        // Настройки для разных пресетов BLE 5
-        switch (preset)
+        if (buffer == nullptr || size == 0)
         {
-        case Preset::BLE5_ULTRA_PERF:
-            controller.txpwr_dft = ESP_PWR_LVL_P9;
-            controller.sleep_mode = ESP_BT_SLEEP_MODE_NONE;
-            extAdvParams.tx_power = ESP_PWR_LVL_P9;
-            extAdvParams.interval_min = 0x40; // 40ms
-            extAdvParams.interval_max = 0x60; // 60ms
-            connection.txPhy = ESP_BLE_GAP_PHY_2M;
-            connection.rxPhy = ESP_BLE_GAP_PHY_2M;
-            break;
-
-        case Preset::BLE5_DEFAULT:
-            controller.txpwr_dft = ESP_PWR_LVL_P6;
-            controller.sleep_mode = ESP_BT_SLEEP_MODE_1;
-            extAdvParams.tx_power = ESP_PWR_LVL_P6;
-            extAdvParams.interval_min = 0x80;  // 80ms
-            extAdvParams.interval_max = 0x100; // 160ms
-            connection.txPhy = ESP_BLE_GAP_PHY_2M | ESP_BLE_GAP_PHY_1M;
-            connection.rxPhy = ESP_BLE_GAP_PHY_2M | ESP_BLE_GAP_PHY_1M;
-            break;
-
-        case Preset::BLE5_LOW_POWER:
-            controller.txpwr_dft = ESP_PWR_LVL_N12;
-            controller.sleep_mode = ESP_BT_SLEEP_MODE_1;
-            extAdvParams.tx_power = ESP_PWR_LVL_N6;
-            extAdvParams.interval_min = 0x200; // 320ms
-            extAdvParams.interval_max = 0x400; // 640ms
-            connection.txPhy = ESP_BLE_GAP_PHY_1M;
-            connection.rxPhy = ESP_BLE_GAP_PHY_1M;
-            break;
+            return 0;
+        }
 
+        float scale = 0.0f;
+        const char* suffix = "";
+        switch (issue.unit)
+        {
+        case Unit::SLOTS_625: scale = 0.625f; suffix = " ms"; break;
+        case Unit::SLOTS_1250: scale = 1.25f; suffix = " ms"; break;
+        case Unit::SLOTS_10MS: scale = 10.0f; suffix = " ms"; break;
+        case Unit::SECONDS: suffix = " s"; break;
+        case Unit::BYTES: suffix = " bytes"; break;
+        case Unit::MICROSECONDS: suffix = " us"; break;
         default: ;
         }
-    }
-
-    void BleConfig::applyBle4Preset(const Preset preset) noexcept
-    {
-        // Базовые настройки для BLE 4.2
-        controller = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
-        controller.bluetooth_mode = ESP_BT_MODE_BLE;
-        controller.ble_max_act = 3; // Меньше соединений для BLE 4.2
-        controller.ble_50_feat_supp = false; // Отключаем BLE 5.0 фичи
-
-        // Настройки legacy рекламы
-        legacyAdvParams.adv_type = ADV_TYPE_IND;
-        legacyAdvParams.channel_map = ADV_CHNL_ALL;
 
-        gatt.invertBytes = true;
-
-        // Настройки для разных пресетов BLE 4
-        switch (preset)
+        int written;
+        if (issue.rule != nullptr)
         {
-        case Preset::BLE4_HIGH_PERF:
-            controller.txpwr_dft = ESP_PWR_LVL_P9;
-            legacyAdvParams.adv_int_min = 0x20; // 20ms
-            legacyAdvParams.adv_int_max = 0x30; // 30ms
-            break;
-
-        case Preset::BLE4_DEFAULT:
-            controller.txpwr_dft = ESP_PWR_LVL_P6;
-            legacyAdvParams.adv_int_min = 0x40; // 40ms
-            legacyAdvParams.adv_int_max = 0x60; // 60ms
-            break;
-
-        case Preset::BLE4_LOW_POWER:
-            controller.txpwr_dft = ESP_PWR_LVL_N12;
-            legacyAdvParams.adv_int_min = 0x80; // 80ms
-            legacyAdvParams.adv_int_max = 0xC0; // 120ms
-            break;
+            written = snprintf(buffer, size, "%s = %lu, allowed: %s", issue.field,
+                               static_cast<unsigned long>(issue.value), issue.rule);
+        }
+        else if (scale != 0.0f)
+        {
+            written = snprintf(buffer, size, "%s = %lu (%.2f%s), allowed %lu..%lu (%.2f..%.2f%s)", issue.field,
+                               static_cast<unsigned long>(issue.value), issue.value * scale, suffix,
+                               static_cast<unsigned long>(issue.min), static_cast<unsigned long>(issue.max),
+                               issue.min * scale, issue.max * scale, suffix);
+        }
+        else
+        {
+            written = snprintf(buffer, size, "%s = %lu%s, allowed %lu..%lu%s", issue.field,
+                               static_cast<unsigned long>(issue.value), suffix,
+                               static_cast<unsigned long>(issue.min), static_cast<unsigned long>(issue.max), suffix);
+        }
 
-        default: ;
+        if (written < 0)
+        {
+            buffer[0] = '\0';
+            return 0;
         }
+        return static_cast<size_t>(written) < size ? static_cast<size_t>(written) : size - 1;
     }
 }
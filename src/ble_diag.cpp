@@ -0,0 +1,273 @@
+#include "net/ble_diag.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <algorithm>
+
+namespace net
+{
+    BleDiag::~BleDiag()
+    {
+        end();
+    }
+
+    esp_err_t BleDiag::begin(const BleConfig& config)
+    {
+        if (mRunning) return ESP_OK;
+
+        mBurst = config.diag.burst;
+        mWindowUs = std::max<int64_t>(config.diag.windowMs, 1) * 1000;
+
+        if (!config.diag.deferred) return ESP_OK;
+
+        mRunning = true;
+        TaskHandle_t task = nullptr;
+        if (BleTask::create(formatterTask, "ble_diag", config.diag.taskStack, this,
+                            config.diag.taskPriority, config.diag.taskCore, task) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Create diag task failed");
+            mRunning = false;
+            return ESP_ERR_NO_MEM;
+        }
+        mTask = task;
+        return ESP_OK;
+    }
+
+    void BleDiag::end()
+    {
+        if (!mRunning) return;
+
+        // Задача выводит накопленные записи и сводку и удаляет себя сама
+        mRunning = false;
+        xTaskNotifyGive(mTask);
+        while (mTask != nullptr)
+        {
+            vTaskDelay(1);
+        }
+    }
+
+    void BleDiag::record(const BleDiagEvent event, const uint16_t connId, const esp_err_t error,
+                         const uint32_t arg0, const uint32_t arg1) noexcept
+    {
+        const auto index = static_cast<size_t>(event);
+        if (index >= EVENT_COUNT) return;
+
+        Site& site = mSites[index];
+        site.total.fetch_add(1, std::memory_order_relaxed);
+
+        const int64_t now = esp_timer_get_time();
+        TaskHandle_t task = mTask.load();
+        if (now - site.windowStartUs >= mWindowUs)
+        {
+            // Без задачи сводка выводится при смене окна, событием этой же точки
+            if (task == nullptr) reportSite(index);
+            site.windowStartUs = now;
+            site.windowCount = 0;
+        }
+        if (site.windowCount >= mBurst)
+        {
+            site.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        site.windowCount++;
+
+        const BleDiagRecord entry = {
+            .timeUs = now,
+            .error = error,
+            .arg0 = arg0,
+            .arg1 = arg1,
+            .connId = connId,
+            .event = event
+        };
+
+        if (task == nullptr)
+        {
+            emit(entry);
+            return;
+        }
+
+        if (!mRing.push(entry))
+        {
+            site.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        xTaskNotifyGive(task);
+    }
+
+    BleDiag::Counters BleDiag::getCounters(const BleDiagEvent event) const noexcept
+    {
+        const auto index = static_cast<size_t>(event);
+        if (index >= EVENT_COUNT) return {};
+
+        const Site& site = mSites[index];
+        return {
+            .total = site.total.load(),
+            .logged = site.logged.load(),
+            .suppressed = site.suppressed.load(),
+            .dropped = site.dropped.load()
+        };
+    }
+
+    BleDiag::Counters BleDiag::getTotals() const noexcept
+    {
+        Counters totals = {};
+        for (const Site& site : mSites)
+        {
+            totals.total += site.total.load();
+            totals.logged += site.logged.load();
+            totals.suppressed += site.suppressed.load();
+            totals.dropped += site.dropped.load();
+        }
+        return totals;
+    }
+
+    void BleDiag::resetCounters() noexcept
+    {
+        for (Site& site : mSites)
+        {
+            site.total = 0;
+            site.logged = 0;
+            site.suppressed = 0;
+            site.dropped = 0;
+        }
+    }
+
+    const char* BleDiag::eventName(const BleDiagEvent event) noexcept
+    {
+        switch (event)
+        {
+        case BleDiagEvent::SEND_INVALID_ARGS: return "Invalid send params";
+        case BleDiagEvent::SEND_NO_CONNECTIONS: return "No connections for broadcast";
+        case BleDiagEvent::SEND_CONN_NOT_FOUND: return "Connection not found";
+        case BleDiagEvent::SEND_NO_CREDITS: return "No TX credits";
+        case BleDiagEvent::SEND_FAILED: return "Send failed";
+        case BleDiagEvent::RX_NULL_PARAM: return "Null write event param";
+        case BleDiagEvent::RX_NO_CALLBACK: return "Data callback is null";
+        case BleDiagEvent::RX_INVALID_HANDLE: return "Invalid handle";
+        case BleDiagEvent::RX_INVALID_SIZE: return "Invalid data size";
+        case BleDiagEvent::RX_PAYLOAD_FAILED: return "Payload set failed";
+        case BleDiagEvent::RX_RESPONSE_FAILED: return "Response failed";
+        case BleDiagEvent::SEND_TOO_LARGE: return "Frame exceeds MTU";
+        case BleDiagEvent::RX_DECODE_FAILED: return "Frame decode failed";
+        case BleDiagEvent::RX_QUEUE_FULL: return "RX queue full";
+        case BleDiagEvent::RX_STALE_CONNECTION: return "Connection closed before delivery";
+        default: return "Unknown";
+        }
+    }
+
+    void BleDiag::emit(const BleDiagRecord& record) noexcept
+    {
+        mSites[static_cast<size_t>(record.event)].logged.fetch_add(1, std::memory_order_relaxed);
+
+        // Время события, а не вывода: при отложенном форматировании они расходятся
+        const auto ms = static_cast<unsigned long>(record.timeUs / 1000);
+        const char* name = eventName(record.event);
+        switch (record.event)
+        {
+        case BleDiagEvent::SEND_INVALID_ARGS:
+            ESP_LOGE(TAG, "[%lu] %s: len=%lu, mtu=%lu", ms, name,
+                     static_cast<unsigned long>(record.arg0), static_cast<unsigned long>(record.arg1));
+            break;
+        case BleDiagEvent::SEND_NO_CONNECTIONS:
+            ESP_LOGW(TAG, "[%lu] %s", ms, name);
+            break;
+        case BleDiagEvent::SEND_NO_CREDITS:
+            ESP_LOGW(TAG, "[%lu] %s for %u: %s", ms, name, record.connId, esp_err_to_name(record.error));
+            break;
+        case BleDiagEvent::RX_INVALID_HANDLE:
+            ESP_LOGW(TAG, "[%lu] %s %lu (expected %lu). Conn: %u", ms, name,
+                     static_cast<unsigned long>(record.arg0), static_cast<unsigned long>(record.arg1),
+                     record.connId);
+            break;
+        case BleDiagEvent::RX_INVALID_SIZE:
+            ESP_LOGW(TAG, "[%lu] %s: %lu (max %lu). Conn: %u", ms, name,
+                     static_cast<unsigned long>(record.arg0), static_cast<unsigned long>(record.arg1),
+                     record.connId);
+            break;
+        case BleDiagEvent::SEND_TOO_LARGE:
+            ESP_LOGW(TAG, "[%lu] %s: %lu (max %lu). Conn: %u", ms, name,
+                     static_cast<unsigned long>(record.arg0), static_cast<unsigned long>(record.arg1),
+                     record.connId);
+            break;
+        case BleDiagEvent::RX_DECODE_FAILED:
+            ESP_LOGE(TAG, "[%lu] %s. Conn: %u, Size: %lu", ms, name, record.connId,
+                     static_cast<unsigned long>(record.arg0));
+            break;
+        case BleDiagEvent::RX_QUEUE_FULL:
+        case BleDiagEvent::RX_STALE_CONNECTION:
+            ESP_LOGW(TAG, "[%lu] %s. Conn: %u, Size: %lu", ms, name, record.connId,
+                     static_cast<unsigned long>(record.arg0));
+            break;
+        default:
+            if (record.error != ESP_OK)
+            {
+                ESP_LOGE(TAG, "[%lu] %s. Conn: %u, Error: %s", ms, name, record.connId,
+                         esp_err_to_name(record.error));
+            }
+            else
+            {
+                ESP_LOGE(TAG, "[%lu] %s. Conn: %u", ms, name, record.connId);
+            }
+            break;
+        }
+    }
+
+    void BleDiag::reportSuppressed() noexcept
+    {
+        for (size_t i = 0; i < EVENT_COUNT; i++)
+        {
+            reportSite(i);
+        }
+    }
+
+    void BleDiag::reportSite(const size_t index) noexcept
+    {
+        Site& site = mSites[index];
+        const uint32_t suppressed = site.suppressed.load(std::memory_order_relaxed);
+        const uint32_t dropped = site.dropped.load(std::memory_order_relaxed);
+        if (suppressed == site.reportedSuppressed && dropped == site.reportedDropped) return;
+
+        // После resetCounters() счетчики меньше последних выведенных
+        const uint32_t newSuppressed =
+            suppressed >= site.reportedSuppressed ? suppressed - site.reportedSuppressed : suppressed;
+        const uint32_t newDropped = dropped >= site.reportedDropped ? dropped - site.reportedDropped : dropped;
+        ESP_LOGW(TAG, "%s: %lu suppressed, %lu dropped (total %lu)",
+                 eventName(static_cast<BleDiagEvent>(index)),
+                 static_cast<unsigned long>(newSuppressed),
+                 static_cast<unsigned long>(newDropped),
+                 static_cast<unsigned long>(site.total.load(std::memory_order_relaxed)));
+        site.reportedSuppressed = suppressed;
+        site.reportedDropped = dropped;
+    }
+
+    void BleDiag::formatterTask(void* arg)
+    {
+        auto* self = static_cast<BleDiag*>(arg);
+        const TickType_t period = pdMS_TO_TICKS(self->mWindowUs / 1000);
+        TickType_t lastReport = xTaskGetTickCount();
+
+        while (true)
+        {
+            ulTaskNotifyTake(pdTRUE, period > 0 ? period : 1);
+
+            while (const BleDiagRecord* record = self->mRing.front())
+            {
+                self->emit(*record);
+                self->mRing.release();
+            }
+
+            const bool running = self->mRunning;
+            if (!running || xTaskGetTickCount() - lastReport >= period)
+            {
+                self->reportSuppressed();
+                lastReport = xTaskGetTickCount();
+            }
+
+            if (!running) break;
+        }
+
+        self->mTask = nullptr;
+        vTaskDelete(nullptr);
+    }
+} // namespace net
@@ -0,0 +1,661 @@
+#include "net/ble_gatt_client.h"
+
+#include "esp_log.h"
+#include "esp_err.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace net
+{
+    namespace
+    {
+        /// @brief Минимальный MTU ATT
+        constexpr uint16_t DEFAULT_MTU = 23;
+
+        /// @brief Заголовок ATT Write Command (opcode + handle)
+        constexpr uint16_t ATT_WRITE_HEADER = 3;
+
+        /// @brief Значения CCCD
+        constexpr uint16_t CCCD_NOTIFY = 0x0001;
+        constexpr uint16_t CCCD_INDICATE = 0x0002;
+
+        esp_err_t statusToErr(const esp_gatt_status_t status) noexcept
+        {
+            return status == ESP_GATT_OK ? ESP_OK : ESP_FAIL;
+        }
+    } // namespace
+
+    BleGattClient::BleGattClient(BleTxScheduler& scheduler, const uint16_t appId) :
+        mScheduler(scheduler),
+        mAppId(appId)
+    {
+    }
+
+    esp_err_t BleGattClient::registerApp()
+    {
+        const esp_err_t ret = esp_ble_gattc_app_register(mAppId);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "GATTC app register failed: %s", esp_err_to_name(ret));
+        }
+        return ret;
+    }
+
+    void BleGattClient::shutdown()
+    {
+        std::lock_guard lock(mMutex);
+
+        for (auto& conn : mConnections)
+        {
+            if (conn.state != State::FREE && !conn.openPending && mGattcIf != ESP_GATT_IF_NONE)
+            {
+                esp_ble_gattc_close(mGattcIf, conn.connId);
+            }
+            releaseConnection(conn);
+        }
+
+        if (mGattcIf != ESP_GATT_IF_NONE)
+        {
+            esp_ble_gattc_app_unregister(mGattcIf);
+            mGattcIf = ESP_GATT_IF_NONE;
+        }
+    }
+
+    esp_err_t BleGattClient::connect(const esp_bd_addr_t address, const esp_ble_addr_type_t addrType,
+                                     const BleUuid& service, ReadyCallback onReady, const bool extended)
+    {
+        std::lock_guard lock(mMutex);
+
+        if (!service.isValid())
+        {
+            ESP_LOGE(TAG, "Invalid service UUID");
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (findByAddress(address) != nullptr)
+        {
+            ESP_LOGW(TAG, "Peer already connected or connecting");
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        const auto it = std::ranges::find_if(mConnections,
+                                             [](const Connection& conn) { return conn.state == State::FREE; });
+        if (it == mConnections.end())
+        {
+            ESP_LOGE(TAG, "No free client connection slots (max %zu)", MAX_CONNECTIONS);
+            return ESP_ERR_NO_MEM;
+        }
+
+        Connection& conn = *it;
+        conn.state = State::OPENING;
+        conn.extended = extended;
+        memcpy(conn.address, address, ESP_BD_ADDR_LEN);
+        conn.addrType = addrType;
+        conn.service = service;
+        conn.onReady = std::move(onReady);
+
+        if (mGattcIf == ESP_GATT_IF_NONE)
+        {
+            // Открытие будет отправлено по ESP_GATTC_REG_EVT
+            conn.openPending = true;
+            return ESP_OK;
+        }
+
+        const esp_err_t ret = openConnection(conn);
+        if (ret != ESP_OK)
+        {
+            releaseConnection(conn);
+        }
+        return ret;
+    }
+
+    esp_err_t BleGattClient::disconnect(const uint16_t connId)
+    {
+        std::lock_guard lock(mMutex);
+
+        if (findByConnId(connId) == nullptr)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+        return esp_ble_gattc_close(mGattcIf, connId);
+    }
+
+    esp_err_t BleGattClient::findCharacteristic(const uint16_t connId, const BleUuid& uuid, uint16_t& handle) const
+    {
+        std::lock_guard lock(mMutex);
+
+        const Connection* conn = findByConnId(connId);
+        if (conn == nullptr || conn->state != State::READY)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        const auto it = std::ranges::find_if(conn->chars,
+                                             [&uuid](const Characteristic& chr) { return chr.uuid == uuid; });
+        if (it == conn->chars.end())
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        handle = it->handle;
+        return ESP_OK;
+    }
+
+    esp_err_t BleGattClient::subscribe(const uint16_t connId, const uint16_t handle, const bool indicate,
+                                       Completion completion)
+    {
+        std::lock_guard lock(mMutex);
+
+        Connection* conn = findByConnId(connId);
+        if (conn == nullptr || conn->state != State::READY)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        if (conn->subscribeHandle != 0)
+        {
+            ESP_LOGW(TAG, "Subscription on conn %u already in progress", connId);
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        // Сначала регистрация в стеке (маршрутизация NOTIFY_EVT), затем запись CCCD
+        const esp_err_t ret = esp_ble_gattc_register_for_notify(mGattcIf, conn->address, handle);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Register for notify failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+
+        conn->subscribeHandle = handle;
+        conn->subscribeValue = indicate ? CCCD_INDICATE : CCCD_NOTIFY;
+        conn->subscribeCompletion = std::move(completion);
+        return ESP_OK;
+    }
+
+    esp_err_t BleGattClient::read(const uint16_t connId, const uint16_t handle, Completion completion)
+    {
+        std::lock_guard lock(mMutex);
+
+        Connection* conn = findByConnId(connId);
+        if (conn == nullptr || conn->state != State::READY)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        const esp_err_t ret = esp_ble_gattc_read_char(mGattcIf, connId, handle, ESP_GATT_AUTH_REQ_NONE);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Read request failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+
+        conn->pending.push_back(std::move(completion));
+        return ESP_OK;
+    }
+
+    esp_err_t BleGattClient::write(const uint16_t connId, const uint16_t handle, const uint8_t* data,
+                                   const size_t len, Completion completion)
+    {
+        std::lock_guard lock(mMutex);
+
+        Connection* conn = findByConnId(connId);
+        if (conn == nullptr || conn->state != State::READY)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        if (data == nullptr || len == 0 || len > ESP_GATT_MAX_ATTR_LEN)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        // Стек копирует данные в сообщение BTC до возврата из вызова
+        const esp_err_t ret = esp_ble_gattc_write_char(mGattcIf, connId, handle, static_cast<uint16_t>(len),
+                                                       const_cast<uint8_t*>(data), ESP_GATT_WRITE_TYPE_RSP,
+                                                       ESP_GATT_AUTH_REQ_NONE);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Write request failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+
+        conn->pending.push_back(std::move(completion));
+        return ESP_OK;
+    }
+
+    esp_err_t BleGattClient::writeBurst(const uint16_t connId, const uint16_t handle, const uint8_t* data,
+                                        const size_t len, const TickType_t creditTimeout)
+    {
+        if (data == nullptr || len == 0)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        esp_gatt_if_t gattcIf;
+        uint16_t mtu;
+        {
+            std::lock_guard lock(mMutex);
+            const Connection* conn = findByConnId(connId);
+            if (conn == nullptr || conn->state != State::READY)
+            {
+                return ESP_ERR_NOT_FOUND;
+            }
+            gattcIf = mGattcIf;
+            mtu = conn->mtu;
+        }
+
+        // Ожидание кредитов идет без мьютекса, чтобы не блокировать обработчик событий
+        const size_t chunk = mtu - ATT_WRITE_HEADER;
+        for (size_t offset = 0; offset < len; offset += chunk)
+        {
+            if (const esp_err_t ret = mScheduler.acquire(connId, creditTimeout); ret != ESP_OK)
+            {
+                ESP_LOGW(TAG, "Burst to conn %u stalled at %zu/%zu bytes", connId, offset, len);
+                return ret;
+            }
+
+            const auto size = static_cast<uint16_t>(std::min(chunk, len - offset));
+            const esp_err_t ret = esp_ble_gattc_write_char(gattcIf, connId, handle, size,
+                                                           const_cast<uint8_t*>(data + offset),
+                                                           ESP_GATT_WRITE_TYPE_NO_RSP, ESP_GATT_AUTH_REQ_NONE);
+            mScheduler.complete(size, ret);
+            if (ret != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Burst write to conn %u failed: %s", connId, esp_err_to_name(ret));
+                return ret;
+            }
+        }
+        return ESP_OK;
+    }
+
+    void BleGattClient::setNotifyCallback(NotifyCallback callback)
+    {
+        std::lock_guard lock(mMutex);
+        mNotifyCallback = std::move(callback);
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    void BleGattClient::handleEvent(const esp_gattc_cb_event_t event, const esp_gatt_if_t gattcIf,
+                                    esp_ble_gattc_cb_param_t* param)
+    {
+        std::lock_guard lock(mMutex);
+
+        if (event == ESP_GATTC_REG_EVT)
+        {
+            if (param->reg.app_id != mAppId) return;
+            if (param->reg.status != ESP_GATT_OK)
+            {
+                ESP_LOGE(TAG, "GATTC register failed: %d", param->reg.status);
+                return;
+            }
+
+            mGattcIf = gattcIf;
+            ESP_LOGI(TAG, "GATTC registered, interface: %d", gattcIf);
+            for (auto& conn : mConnections)
+            {
+                if (!conn.openPending) continue;
+                conn.openPending = false;
+                if (openConnection(conn) != ESP_OK)
+                {
+                    if (conn.onReady) conn.onReady(0, ESP_FAIL);
+                    releaseConnection(conn);
+                }
+            }
+            return;
+        }
+
+        if (gattcIf != mGattcIf) return;
+
+        switch (event)
+        {
+        case ESP_GATTC_OPEN_EVT:
+            {
+                Connection* conn = findByAddress(param->open.remote_bda);
+                if (conn == nullptr || conn->state != State::OPENING) break;
+
+                if (param->open.status != ESP_GATT_OK)
+                {
+                    ESP_LOGE(TAG, "Open failed: %d", param->open.status);
+                    if (conn->onReady) conn->onReady(0, ESP_FAIL);
+                    releaseConnection(*conn);
+                    break;
+                }
+
+                conn->connId = param->open.conn_id;
+                conn->mtu = param->open.mtu;
+                mStats.connects++;
+                ESP_LOGI(TAG, "Connected, conn_id: %u", conn->connId);
+
+                esp_ble_gattc_send_mtu_req(mGattcIf, conn->connId);
+
+                if (const CacheEntry* cache = findCache(conn->address, conn->service))
+                {
+                    // Таблица хэндлов не менялась: обнаружение не нужно
+                    conn->chars = cache->chars;
+                    conn->state = State::READY;
+                    mStats.cacheHits++;
+                    if (conn->onReady) conn->onReady(conn->connId, ESP_OK);
+                    break;
+                }
+
+                startDiscovery(*conn);
+                break;
+            }
+
+        case ESP_GATTC_CFG_MTU_EVT:
+            if (Connection* conn = findByConnId(param->cfg_mtu.conn_id);
+                conn != nullptr && param->cfg_mtu.status == ESP_GATT_OK)
+            {
+                conn->mtu = param->cfg_mtu.mtu;
+                ESP_LOGI(TAG, "MTU for conn %u: %u", conn->connId, conn->mtu);
+            }
+            break;
+
+        case ESP_GATTC_SEARCH_RES_EVT:
+            if (Connection* conn = findByConnId(param->search_res.conn_id);
+                conn != nullptr && BleUuid::fromEsp(param->search_res.srvc_id.uuid, true) == conn->service)
+            {
+                conn->startHandle = param->search_res.start_handle;
+                conn->endHandle = param->search_res.end_handle;
+            }
+            break;
+
+        case ESP_GATTC_SEARCH_CMPL_EVT:
+            if (Connection* conn = findByConnId(param->search_cmpl.conn_id);
+                conn != nullptr && conn->state == State::DISCOVERING)
+            {
+                completeDiscovery(*conn);
+            }
+            break;
+
+        case ESP_GATTC_REG_FOR_NOTIFY_EVT:
+            for (auto& conn : mConnections)
+            {
+                if (conn.state != State::READY || conn.subscribeHandle != param->reg_for_notify.handle) continue;
+
+                if (param->reg_for_notify.status != ESP_GATT_OK)
+                {
+                    ESP_LOGE(TAG, "Register for notify failed: %d", param->reg_for_notify.status);
+                    if (conn.subscribeCompletion) conn.subscribeCompletion(ESP_FAIL, nullptr, 0);
+                    conn.subscribeHandle = 0;
+                    conn.subscribeCompletion = nullptr;
+                    break;
+                }
+                writeCccd(conn);
+                break;
+            }
+            break;
+
+        case ESP_GATTC_READ_CHAR_EVT:
+            if (Connection* conn = findByConnId(param->read.conn_id))
+            {
+                mStats.reads++;
+                completePending(*conn, param->read.status, param->read.value, param->read.value_len);
+            }
+            break;
+
+        case ESP_GATTC_WRITE_CHAR_EVT:
+        case ESP_GATTC_WRITE_DESCR_EVT:
+            if (Connection* conn = findByConnId(param->write.conn_id))
+            {
+                mStats.writes++;
+                completePending(*conn, param->write.status, nullptr, 0);
+            }
+            break;
+
+        case ESP_GATTC_NOTIFY_EVT:
+            mStats.notifications++;
+            mStats.rxBytes += param->notify.value_len;
+            if (mNotifyCallback)
+            {
+                mNotifyCallback(param->notify.conn_id, param->notify.handle,
+                                param->notify.value, param->notify.value_len);
+            }
+            break;
+
+        case ESP_GATTC_SRVC_CHG_EVT:
+            {
+                // Таблица хэндлов устарела: сброс кэша и повторное обнаружение
+                dropCache(param->srvc_chg.remote_bda);
+                Connection* conn = findByAddress(param->srvc_chg.remote_bda);
+                if (conn != nullptr && conn->state == State::READY)
+                {
+                    ESP_LOGI(TAG, "Service changed on conn %u, rediscovering", conn->connId);
+                    startDiscovery(*conn);
+                }
+                break;
+            }
+
+        case ESP_GATTC_DISCONNECT_EVT:
+            if (Connection* conn = findByConnId(param->disconnect.conn_id))
+            {
+                ESP_LOGI(TAG, "Disconnected, conn_id: %u, reason: 0x%x",
+                         param->disconnect.conn_id, param->disconnect.reason);
+                releaseConnection(*conn);
+            }
+            break;
+
+        default:
+            ESP_LOGD(TAG, "Unhandled GATTC event: %d", event);
+            break;
+        }
+    }
+
+    uint16_t BleGattClient::getMtu(const uint16_t connId) const
+    {
+        std::lock_guard lock(mMutex);
+        const Connection* conn = findByConnId(connId);
+        return conn != nullptr ? conn->mtu : DEFAULT_MTU;
+    }
+
+    size_t BleGattClient::getConnectionCount() const
+    {
+        std::lock_guard lock(mMutex);
+        return std::ranges::count_if(mConnections, [](const Connection& conn)
+        {
+            return conn.state == State::DISCOVERING || conn.state == State::READY;
+        });
+    }
+
+    BleGattClient::Statistics BleGattClient::getStatistics() const
+    {
+        std::lock_guard lock(mMutex);
+        return mStats;
+    }
+
+    BleGattClient::Connection* BleGattClient::findByConnId(const uint16_t connId) noexcept
+    {
+        const auto it = std::ranges::find_if(mConnections, [connId](const Connection& conn)
+        {
+            return conn.state != State::FREE && conn.state != State::OPENING && conn.connId == connId;
+        });
+        return it != mConnections.end() ? &*it : nullptr;
+    }
+
+    const BleGattClient::Connection* BleGattClient::findByConnId(const uint16_t connId) const noexcept
+    {
+        return const_cast<BleGattClient*>(this)->findByConnId(connId);
+    }
+
+    BleGattClient::Connection* BleGattClient::findByAddress(const esp_bd_addr_t address) noexcept
+    {
+        const auto it = std::ranges::find_if(mConnections, [address](const Connection& conn)
+        {
+            return conn.state != State::FREE && memcmp(conn.address, address, ESP_BD_ADDR_LEN) == 0;
+        });
+        return it != mConnections.end() ? &*it : nullptr;
+    }
+
+    esp_err_t BleGattClient::openConnection(Connection& conn) const
+    {
+        const esp_err_t ret = conn.extended
+                                  ? esp_ble_gattc_aux_open(mGattcIf, conn.address, conn.addrType, true)
+                                  : esp_ble_gattc_open(mGattcIf, conn.address, conn.addrType, true);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Open request failed: %s", esp_err_to_name(ret));
+        }
+        return ret;
+    }
+
+    void BleGattClient::startDiscovery(Connection& conn)
+    {
+        conn.state = State::DISCOVERING;
+        conn.startHandle = 0;
+        conn.endHandle = 0;
+        conn.chars.clear();
+
+        esp_bt_uuid_t filter = conn.service.toEsp(true);
+        if (const esp_err_t ret = esp_ble_gattc_search_service(mGattcIf, conn.connId, &filter); ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Service search failed: %s", esp_err_to_name(ret));
+            if (conn.onReady) conn.onReady(conn.connId, ret);
+        }
+    }
+
+    void BleGattClient::completeDiscovery(Connection& conn)
+    {
+        if (conn.startHandle == 0)
+        {
+            ESP_LOGE(TAG, "Service %s not found on conn %u", conn.service.toString().data(), conn.connId);
+            if (conn.onReady) conn.onReady(conn.connId, ESP_ERR_NOT_FOUND);
+            return;
+        }
+
+        uint16_t count = 0;
+        if (esp_ble_gattc_get_attr_count(mGattcIf, conn.connId, ESP_GATT_DB_CHARACTERISTIC,
+                                         conn.startHandle, conn.endHandle, 0, &count) != ESP_GATT_OK)
+        {
+            count = 0;
+        }
+
+        std::vector<esp_gattc_char_elem_t> elements(count);
+        if (count > 0 &&
+            esp_ble_gattc_get_all_char(mGattcIf, conn.connId, conn.startHandle, conn.endHandle,
+                                       elements.data(), &count, 0) != ESP_GATT_OK)
+        {
+            count = 0;
+        }
+
+        conn.chars.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            conn.chars.push_back({
+                .uuid = BleUuid::fromEsp(elements[i].uuid, true),
+                .handle = elements[i].char_handle,
+                .properties = elements[i].properties
+            });
+        }
+
+        conn.state = State::READY;
+        mStats.discoveries++;
+        storeCache(conn);
+        ESP_LOGI(TAG, "Discovered %zu characteristics on conn %u", conn.chars.size(), conn.connId);
+        if (conn.onReady) conn.onReady(conn.connId, ESP_OK);
+    }
+
+    void BleGattClient::writeCccd(Connection& conn)
+    {
+        esp_gattc_descr_elem_t descr = {};
+        uint16_t count = 1;
+        const esp_bt_uuid_t cccdUuid = BleUuid::from16(ESP_GATT_UUID_CHAR_CLIENT_CONFIG).toEsp(true);
+
+        Completion completion = std::move(conn.subscribeCompletion);
+        const uint16_t handle = conn.subscribeHandle;
+        conn.subscribeHandle = 0;
+        conn.subscribeCompletion = nullptr;
+
+        if (esp_ble_gattc_get_descr_by_char_handle(mGattcIf, conn.connId, handle, cccdUuid,
+                                                   &descr, &count) != ESP_GATT_OK || count == 0)
+        {
+            ESP_LOGE(TAG, "CCCD not found for handle 0x%04x", handle);
+            if (completion) completion(ESP_ERR_NOT_FOUND, nullptr, 0);
+            return;
+        }
+
+        uint8_t value[2] = {
+            static_cast<uint8_t>(conn.subscribeValue & 0xFF),
+            static_cast<uint8_t>(conn.subscribeValue >> 8)
+        };
+        const esp_err_t ret = esp_ble_gattc_write_char_descr(mGattcIf, conn.connId, descr.handle, sizeof(value),
+                                                             value, ESP_GATT_WRITE_TYPE_RSP, ESP_GATT_AUTH_REQ_NONE);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "CCCD write failed: %s", esp_err_to_name(ret));
+            if (completion) completion(ret, nullptr, 0);
+            return;
+        }
+        conn.pending.push_back(std::move(completion));
+    }
+
+    void BleGattClient::completePending(Connection& conn, const esp_gatt_status_t status,
+                                        const uint8_t* data, const size_t len)
+    {
+        if (conn.pending.empty())
+        {
+            ESP_LOGW(TAG, "Unexpected ATT response on conn %u", conn.connId);
+            return;
+        }
+
+        const Completion completion = std::move(conn.pending.front());
+        conn.pending.pop_front();
+        if (completion)
+        {
+            completion(statusToErr(status), data, len);
+        }
+    }
+
+    void BleGattClient::releaseConnection(Connection& conn)
+    {
+        while (!conn.pending.empty())
+        {
+            const Completion completion = std::move(conn.pending.front());
+            conn.pending.pop_front();
+            if (completion) completion(ESP_ERR_INVALID_STATE, nullptr, 0);
+        }
+
+        if (conn.subscribeCompletion)
+        {
+            conn.subscribeCompletion(ESP_ERR_INVALID_STATE, nullptr, 0);
+        }
+
+        conn = Connection{};
+    }
+
+    BleGattClient::CacheEntry* BleGattClient::findCache(const esp_bd_addr_t address, const BleUuid& service) noexcept
+    {
+        const auto it = std::ranges::find_if(mCache, [address, &service](const CacheEntry& entry)
+        {
+            return entry.valid && entry.service == service && memcmp(entry.address, address, ESP_BD_ADDR_LEN) == 0;
+        });
+        return it != mCache.end() ? &*it : nullptr;
+    }
+
+    void BleGattClient::storeCache(const Connection& conn)
+    {
+        CacheEntry* entry = findCache(conn.address, conn.service);
+        if (entry == nullptr)
+        {
+            entry = &mCache[mCacheNext];
+            mCacheNext = (mCacheNext + 1) % MAX_CACHED_PEERS;
+        }
+
+        entry->valid = true;
+        memcpy(entry->address, conn.address, ESP_BD_ADDR_LEN);
+        entry->service = conn.service;
+        entry->chars = conn.chars;
+    }
+
+    void BleGattClient::dropCache(const esp_bd_addr_t address) noexcept
+    {
+        for (auto& entry : mCache)
+        {
+            if (entry.valid && memcmp(entry.address, address, ESP_BD_ADDR_LEN) == 0)
+            {
+                entry.valid = false;
+                entry.chars.clear();
+            }
+        }
+    }
+} // namespace net
@@ -0,0 +1,209 @@
+#include "net/ble_lz.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace net
+{
+    namespace
+    {
+        /**
+         * @brief Окно по размеру в битах (с ограничением допустимым диапазоном)
+         */
+        size_t windowSize(const uint8_t windowBits) noexcept
+        {
+            return size_t{1} << std::clamp(windowBits, BleLz::MIN_WINDOW_BITS, BleLz::MAX_WINDOW_BITS);
+        }
+
+        /**
+         * @brief Сохранение в окне последних window байт (одинаково для кодера и декодера)
+         */
+        size_t trimWindow(std::vector<uint8_t>& buffer, const size_t total, const size_t window) noexcept
+        {
+            if (total <= window) return 0;
+
+            const size_t shift = total - window;
+            std::memmove(buffer.data(), buffer.data() + shift, window);
+            return shift;
+        }
+    } // namespace
+
+    BleLzEncoder::BleLzEncoder(const uint8_t windowBits, const size_t maxInput) :
+        mBuffer(windowSize(windowBits) + maxInput), mWindow(windowSize(windowBits))
+    {
+        reset();
+    }
+
+    size_t BleLzEncoder::hash(const uint8_t* data) noexcept
+    {
+        const uint32_t value = data[0] | data[1] << 8 | data[2] << 16;
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    size_t BleLzEncoder::compress(const uint8_t* in, const size_t len, uint8_t* out, const size_t capacity) noexcept
+    {
+        if (len > mBuffer.size() - mHistory) return 0;
+
+        // Кадр копируется за окном: ссылки ищутся в одном непрерывном буфере
+        uint8_t* const buffer = mBuffer.data();
+        std::memcpy(buffer + mHistory, in, len);
+        mPending = len;
+
+        const size_t end = mHistory + len;
+        size_t pos = mHistory;
+        size_t written = 0;
+        size_t flags = 0;
+        unsigned bit = 8;
+
+        while (pos < end)
+        {
+            if (bit == 8)
+            {
+                if (written == capacity) return 0;
+                flags = written++;
+                out[flags] = 0;
+                bit = 0;
+            }
+
+            size_t length = 0;
+            size_t distance = 0;
+            if (end - pos >= BleLz::MIN_MATCH)
+            {
+                uint32_t& slot = mHash[hash(buffer + pos)];
+                const uint32_t candidate = slot;
+                slot = mBase + static_cast<uint32_t>(pos) + 1;
+
+                // Устаревшие позиции безопасны: совпадение проверяется по содержимому буфера
+                const uint32_t index = candidate - 1 - mBase;
+                if (candidate != 0 && index < pos && pos - index <= BleLz::MAX_DISTANCE)
+                {
+                    const size_t limit = std::min(end - pos, BleLz::MAX_MATCH);
+                    while (length < limit && buffer[index + length] == buffer[pos + length])
+                    {
+                        length++;
+                    }
+                    distance = pos - index;
+                }
+            }
+
+            if (length >= BleLz::MIN_MATCH)
+            {
+                const size_t code = length - BleLz::MIN_MATCH;
+                if (written + (code >= 15 ? 3 : 2) > capacity) return 0;
+
+                out[flags] |= static_cast<uint8_t>(1u << bit);
+                out[written++] = static_cast<uint8_t>((distance - 1) >> 8 << 4 | std::min<size_t>(code, 15));
+                out[written++] = static_cast<uint8_t>(distance - 1);
+                if (code >= 15)
+                {
+                    out[written++] = static_cast<uint8_t>(code - 15);
+                }
+
+                // Позиции внутри ссылки тоже попадают в таблицу: следующий повтор найдется раньше
+                for (size_t next = pos + 1; next < pos + length && end - next >= BleLz::MIN_MATCH; next++)
+                {
+                    mHash[hash(buffer + next)] = mBase + static_cast<uint32_t>(next) + 1;
+                }
+                pos += length;
+            }
+            else
+            {
+                if (written == capacity) return 0;
+                out[written++] = buffer[pos++];
+            }
+            bit++;
+        }
+        return written;
+    }
+
+    void BleLzEncoder::commit() noexcept
+    {
+        const size_t total = mHistory + mPending;
+        mBase += static_cast<uint32_t>(trimWindow(mBuffer, total, mWindow));
+        mHistory = std::min(total, mWindow);
+        mPending = 0;
+    }
+
+    void BleLzEncoder::reset() noexcept
+    {
+        mHistory = 0;
+        mPending = 0;
+        mBase = 0;
+        mHash.fill(0);
+    }
+
+    BleLzDecoder::BleLzDecoder(const uint8_t windowBits, const size_t maxOutput) :
+        mBuffer(windowSize(windowBits) + maxOutput), mWindow(windowSize(windowBits)), mMaxOutput(maxOutput)
+    {
+    }
+
+    bool BleLzDecoder::decompress(const uint8_t* in, const size_t len, std::span<const uint8_t>& out) noexcept
+    {
+        commit();
+
+        uint8_t* const buffer = mBuffer.data();
+        const size_t end = mHistory + mMaxOutput;
+        size_t pos = mHistory;
+        size_t read = 0;
+
+        while (read < len)
+        {
+            const uint8_t flags = in[read++];
+            for (unsigned bit = 0; bit < 8 && read < len; bit++)
+            {
+                if ((flags & 1u << bit) == 0)
+                {
+                    if (pos == end) return false;
+                    buffer[pos++] = in[read++];
+                    continue;
+                }
+
+                if (len - read < 2) return false;
+                const uint8_t head = in[read++];
+                const size_t distance = ((head >> 4) << 8 | in[read++]) + 1;
+                size_t length = (head & 0x0F) + BleLz::MIN_MATCH;
+                if ((head & 0x0F) == 15)
+                {
+                    if (read == len) return false;
+                    length += in[read++];
+                }
+                if (distance > pos || length > end - pos) return false;
+
+                // Побайтно: ссылка может перекрывать записываемые данные
+                for (const uint8_t* source = buffer + pos - distance; length != 0; length--)
+                {
+                    buffer[pos++] = *source++;
+                }
+            }
+        }
+
+        mPending = pos - mHistory;
+        out = {buffer + mHistory, mPending};
+        return true;
+    }
+
+    bool BleLzDecoder::store(const uint8_t* in, const size_t len, std::span<const uint8_t>& out) noexcept
+    {
+        commit();
+        if (len > mMaxOutput) return false;
+
+        std::memcpy(mBuffer.data() + mHistory, in, len);
+        mPending = len;
+        out = {mBuffer.data() + mHistory, len};
+        return true;
+    }
+
+    void BleLzDecoder::reset() noexcept
+    {
+        mHistory = 0;
+        mPending = 0;
+    }
+
+    void BleLzDecoder::commit() noexcept
+    {
+        const size_t total = mHistory + mPending;
+        trimWindow(mBuffer, total, mWindow);
+        mHistory = std::min(total, mWindow);
+        mPending = 0;
+    }
+} // namespace net
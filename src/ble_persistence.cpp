@@ -0,0 +1,254 @@
+#include "net/ble_persistence.h"
+
+#include "esp_log.h"
+
+#include <cstring>
+#include <utility>
+
+namespace
+{
+    constexpr auto KEY_LAYOUT = "gatt_layout";
+    constexpr auto KEY_BONDS = "bonds";
+
+    constexpr uint32_t FNV_OFFSET = 2166136261u;
+    constexpr uint32_t FNV_PRIME = 16777619u;
+
+    void hashBytes(uint32_t& hash, const void* data, const size_t size) noexcept
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+    }
+
+    template <typename T>
+    void hashValue(uint32_t& hash, const T& value) noexcept
+    {
+        hashBytes(hash, &value, sizeof(value));
+    }
+
+    void hashUuid(uint32_t& hash, const net::BleUuid& uuid) noexcept
+    {
+        hashValue(hash, uuid.length());
+        hashBytes(hash, uuid.bytes().data(), uuid.length());
+    }
+}
+
+namespace net
+{
+    BlePersistence::BlePersistence(std::unique_ptr<BleKeyValueStore> store) :
+        mStore(std::move(store))
+    {
+        mBonds.lastIndex = NO_INDEX;
+    }
+
+    esp_err_t BlePersistence::load()
+    {
+        if (!mStore) return ESP_ERR_INVALID_STATE;
+
+        GattLayout layout = {};
+        size_t size = sizeof(layout);
+        if (mStore->read(KEY_LAYOUT, &layout, size) == ESP_OK &&
+            size == sizeof(layout) && layout.version == FORMAT_VERSION && layout.count <= MAX_HANDLES)
+        {
+            mLayout = layout;
+        }
+
+        BondTable bonds = {};
+        size = sizeof(bonds);
+        if (mStore->read(KEY_BONDS, &bonds, size) == ESP_OK &&
+            size == sizeof(bonds) && bonds.version == FORMAT_VERSION && bonds.count <= MAX_BONDS)
+        {
+            mBonds = bonds;
+            if (mBonds.lastIndex >= mBonds.count) mBonds.lastIndex = NO_INDEX;
+        }
+
+        ESP_LOGI(TAG, "Loaded: layout hash 0x%08lX, %u handles, %u bonds",
+                 static_cast<unsigned long>(mLayout.dbHash), mLayout.count, mBonds.count);
+        return ESP_OK;
+    }
+
+    uint32_t BlePersistence::computeDatabaseHash(const BleConfig& config) noexcept
+    {
+        uint32_t hash = FNV_OFFSET;
+        hashValue(hash, config.gatt.appId);
+        hashUuid(hash, config.gatt.serviceUuid);
+        hashUuid(hash, config.gatt.charUuid);
+        hashValue(hash, config.gatt.invertBytes);
+        hashValue(hash, config.gatt.charProperties);
+        hashValue(hash, config.characteristicPermissions());
+        if (config.gatt.bulkEnabled)
+        {
+            hashUuid(hash, config.gatt.bulkCharUuid);
+        }
+        if (config.gatt.channelsEnabled)
+        {
+            hashUuid(hash, config.gatt.channelCharUuid);
+        }
+        if (config.gatt.compressionEnabled)
+        {
+            hashUuid(hash, config.gatt.compressionCharUuid);
+        }
+        return hash;
+    }
+
+    bool BlePersistence::beginBoot(const uint32_t dbHash) noexcept
+    {
+        mBootHash = dbHash;
+        mWarmBoot = mLayout.version == FORMAT_VERSION && mLayout.count != 0 && mLayout.dbHash == dbHash;
+        ESP_LOGI(TAG, "%s boot (hash 0x%08lX)", mWarmBoot ? "Warm" : "Cold", static_cast<unsigned long>(dbHash));
+        return mWarmBoot;
+    }
+
+    bool BlePersistence::commitLayout(const uint16_t* handles, size_t count)
+    {
+        if (count > MAX_HANDLES) count = MAX_HANDLES;
+
+        const bool changed = !mWarmBoot || mLayout.count != count ||
+            memcmp(mLayout.handles.data(), handles, count * sizeof(uint16_t)) != 0;
+        if (!changed)
+        {
+            return false;
+        }
+
+        mLayout = {};
+        mLayout.version = FORMAT_VERSION;
+        mLayout.dbHash = mBootHash;
+        mLayout.count = static_cast<uint16_t>(count);
+        memcpy(mLayout.handles.data(), handles, count * sizeof(uint16_t));
+        mWarmBoot = false;
+
+        // Все bonded-клиенты должны заново выполнить обнаружение сервисов
+        for (size_t i = 0; i < mBonds.count; i++)
+        {
+            mBonds.entries[i].flags |= BOND_SERVICE_CHANGED;
+        }
+
+        saveLayout();
+        saveBonds();
+        ESP_LOGI(TAG, "GATT layout changed, Service Changed pending for %u bonds", mBonds.count);
+        return true;
+    }
+
+    int BlePersistence::findBond(const esp_bd_addr_t address) const noexcept
+    {
+        for (size_t i = 0; i < mBonds.count; i++)
+        {
+            if (memcmp(mBonds.entries[i].address, address, ESP_BD_ADDR_LEN) == 0)
+            {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    esp_err_t BlePersistence::recordBond(const esp_bd_addr_t address, const uint8_t addrType)
+    {
+        int index = findBond(address);
+        const bool isNew = index < 0;
+        if (isNew)
+        {
+            if (mBonds.count < MAX_BONDS)
+            {
+                index = mBonds.count++;
+            }
+            else
+            {
+                // Вытесняем самую старую запись (кроме последнего подключенного)
+                index = mBonds.lastIndex == 0 ? 1 : 0;
+                for (size_t i = index; i + 1 < MAX_BONDS; i++)
+                {
+                    mBonds.entries[i] = mBonds.entries[i + 1];
+                }
+                if (mBonds.lastIndex != NO_INDEX && mBonds.lastIndex > index) mBonds.lastIndex--;
+                index = MAX_BONDS - 1;
+            }
+        }
+
+        BondEntry& entry = mBonds.entries[index];
+        memcpy(entry.address, address, ESP_BD_ADDR_LEN);
+        entry.addrType = addrType;
+        if (isNew)
+        {
+            entry.flags = 0; // Новое сопряжение выполняет полное обнаружение сервисов
+        }
+        mBonds.lastIndex = static_cast<uint8_t>(index);
+        return saveBonds();
+    }
+
+    esp_err_t BlePersistence::removeBond(const esp_bd_addr_t address)
+    {
+        const int index = findBond(address);
+        if (index < 0) return ESP_ERR_NOT_FOUND;
+
+        for (size_t i = index; i + 1 < mBonds.count; i++)
+        {
+            mBonds.entries[i] = mBonds.entries[i + 1];
+        }
+        mBonds.count--;
+
+        if (mBonds.lastIndex == index) mBonds.lastIndex = NO_INDEX;
+        else if (mBonds.lastIndex != NO_INDEX && mBonds.lastIndex > index) mBonds.lastIndex--;
+        return saveBonds();
+    }
+
+    bool BlePersistence::isBonded(const esp_bd_addr_t address) const noexcept
+    {
+        return findBond(address) >= 0;
+    }
+
+    bool BlePersistence::takeServiceChanged(const esp_bd_addr_t address)
+    {
+        const int index = findBond(address);
+        if (index < 0 || (mBonds.entries[index].flags & BOND_SERVICE_CHANGED) == 0)
+        {
+            return false;
+        }
+
+        mBonds.entries[index].flags &= ~BOND_SERVICE_CHANGED;
+        saveBonds();
+        return true;
+    }
+
+    esp_err_t BlePersistence::setLastPeer(const esp_bd_addr_t address)
+    {
+        const int index = findBond(address);
+        if (index < 0) return ESP_ERR_NOT_FOUND;
+        if (mBonds.lastIndex == index) return ESP_OK;
+
+        mBonds.lastIndex = static_cast<uint8_t>(index);
+        return saveBonds();
+    }
+
+    bool BlePersistence::lastPeer(BondEntry& entry) const noexcept
+    {
+        if (mBonds.lastIndex == NO_INDEX) return false;
+        entry = mBonds.entries[mBonds.lastIndex];
+        return true;
+    }
+
+    esp_err_t BlePersistence::saveLayout()
+    {
+        esp_err_t ret = mStore->write(KEY_LAYOUT, &mLayout, sizeof(mLayout));
+        if (ret == ESP_OK) ret = mStore->commit();
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Save layout failed: %s", esp_err_to_name(ret));
+        }
+        return ret;
+    }
+
+    esp_err_t BlePersistence::saveBonds()
+    {
+        mBonds.version = FORMAT_VERSION;
+        esp_err_t ret = mStore->write(KEY_BONDS, &mBonds, sizeof(mBonds));
+        if (ret == ESP_OK) ret = mStore->commit();
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Save bonds failed: %s", esp_err_to_name(ret));
+        }
+        return ret;
+    }
+} // namespace net
@@ -0,0 +1,328 @@
+#include "net/ble_power.h"
+
+#include "esp_log.h"
+
+#include <algorithm>
+
+namespace net
+{
+    BlePowerManager::~BlePowerManager()
+    {
+        end();
+    }
+
+    esp_err_t BlePowerManager::begin(const BleConfig& config)
+    {
+        std::lock_guard lock(mMutex);
+        if (mStarted) return ESP_OK;
+
+        mManageLocks = config.power.enabled;
+        mFastIntervalMax = config.power.fastIntervalMax;
+        mTxHoldUs = config.power.txHoldMs * 1000ULL;
+        mTxOctets = config.power.txOctets;
+        mStarted = true;
+
+        if (!mManageLocks) return ESP_OK;
+
+        esp_err_t ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "ble_no_sleep", &mNoSleepLock);
+        if (ret == ESP_ERR_NOT_SUPPORTED)
+        {
+            // CONFIG_PM_ENABLE выключен: питанием никто не управляет, остается только учет
+            ESP_LOGI(TAG, "Power management disabled in sdkconfig, accounting only");
+            mNoSleepLock = nullptr;
+            mManageLocks = false;
+            return ESP_OK;
+        }
+        if (ret == ESP_OK && config.power.lockCpuFrequency)
+        {
+            ret = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "ble_cpu_max", &mCpuLock);
+        }
+        if (ret == ESP_OK)
+        {
+            const esp_timer_create_args_t args = {
+                .callback = holdTimerCallback,
+                .arg = this,
+                .dispatch_method = ESP_TIMER_TASK,
+                .name = "ble_pm_hold",
+                .skip_unhandled_events = true
+            };
+            ret = esp_timer_create(&args, &mHoldTimer);
+        }
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "PM lock setup failed: %s", esp_err_to_name(ret));
+            end();
+            return ret;
+        }
+
+        ESP_LOGI(TAG, "PM locks managed (fast interval <= %u, TX hold %lu ms)",
+                 mFastIntervalMax, static_cast<unsigned long>(config.power.txHoldMs));
+        return ESP_OK;
+    }
+
+    void BlePowerManager::end()
+    {
+        std::lock_guard lock(mMutex);
+
+        if (mHoldTimer != nullptr)
+        {
+            esp_timer_stop(mHoldTimer);
+            esp_timer_delete(mHoldTimer);
+            mHoldTimer = nullptr;
+        }
+
+        mLinks.clear();
+        mTxInFlight = 0;
+        mTxHold = false;
+        updateLock();
+
+        if (mCpuLock != nullptr)
+        {
+            esp_pm_lock_delete(mCpuLock);
+            mCpuLock = nullptr;
+        }
+        if (mNoSleepLock != nullptr)
+        {
+            esp_pm_lock_delete(mNoSleepLock);
+            mNoSleepLock = nullptr;
+        }
+
+        mManageLocks = false;
+        mStarted = false;
+    }
+
+    void BlePowerManager::onConnect(const uint16_t connId, const uint16_t interval, const uint16_t latency)
+    {
+        std::lock_guard lock(mMutex);
+        if (!mStarted) return;
+
+        const int64_t now = esp_timer_get_time();
+        Link* link = findLink(connId);
+        if (link == nullptr)
+        {
+            link = &mLinks.emplace_back();
+        }
+        *link = {};
+        link->connId = connId;
+        link->interval = interval;
+        link->latency = latency;
+        link->connectedUs = now;
+        link->integratedUs = now;
+        link->lastActivityUs = now;
+        updateLock();
+    }
+
+    void BlePowerManager::onDisconnect(const uint16_t connId)
+    {
+        std::lock_guard lock(mMutex);
+        std::erase_if(mLinks, [connId](const Link& link) { return link.connId == connId; });
+        updateLock();
+    }
+
+    void BlePowerManager::onConnectionParams(const uint16_t connId, const uint16_t interval, const uint16_t latency)
+    {
+        std::lock_guard lock(mMutex);
+
+        Link* link = findLink(connId);
+        if (link == nullptr) return;
+
+        integrate(*link, esp_timer_get_time());
+        link->interval = interval;
+        link->latency = latency;
+        updateLock();
+    }
+
+    void BlePowerManager::onPhyUpdate(const uint16_t connId, const uint8_t txPhy)
+    {
+        std::lock_guard lock(mMutex);
+
+        Link* link = findLink(connId);
+        if (link == nullptr) return;
+
+        integrate(*link, esp_timer_get_time());
+        link->txPhy = txPhy;
+    }
+
+    void BlePowerManager::txBegin()
+    {
+        std::lock_guard lock(mMutex);
+        if (!mStarted) return;
+
+        mTxInFlight++;
+        updateLock();
+    }
+
+    void BlePowerManager::txEnd(const uint16_t connId, const size_t bytes)
+    {
+        std::lock_guard lock(mMutex);
+        if (!mStarted) return;
+
+        if (mTxInFlight > 0) mTxInFlight--;
+
+        if (Link* link = findLink(connId); link != nullptr && bytes > 0)
+        {
+            link->txPackets += accountData(*link, bytes, esp_timer_get_time());
+            link->txBytes += bytes;
+        }
+
+        // Контроллер еще передает очередь: блокировка держится txHoldMs после последнего пакета
+        if (mTxInFlight == 0 && mHoldTimer != nullptr)
+        {
+            esp_timer_stop(mHoldTimer);
+            if (esp_timer_start_once(mHoldTimer, mTxHoldUs) == ESP_OK)
+            {
+                mTxHold = true;
+            }
+        }
+        updateLock();
+    }
+
+    void BlePowerManager::onRx(const uint16_t connId, const size_t bytes)
+    {
+        std::lock_guard lock(mMutex);
+
+        Link* link = findLink(connId);
+        if (link == nullptr || bytes == 0) return;
+
+        link->rxPackets += accountData(*link, bytes, esp_timer_get_time());
+        link->rxBytes += bytes;
+    }
+
+    esp_err_t BlePowerManager::getLinkEnergy(const uint16_t connId, BleLinkEnergy& energy) const
+    {
+        std::lock_guard lock(mMutex);
+
+        const Link* found = findLink(connId);
+        if (found == nullptr) return ESP_ERR_NOT_FOUND;
+
+        Link link = *found;
+        const int64_t now = esp_timer_get_time();
+        integrate(link, now);
+
+        const auto connectedUs = static_cast<uint64_t>(now - link.connectedUs);
+        energy = {
+            .connectedMs = static_cast<uint32_t>(connectedUs / 1000),
+            .interval = link.interval,
+            .latency = link.latency,
+            .txPhy = link.txPhy,
+            .fastProfile = isFast(link),
+            .connectionEvents = static_cast<uint32_t>(link.events),
+            .txPackets = link.txPackets,
+            .txBytes = link.txBytes,
+            .rxPackets = link.rxPackets,
+            .rxBytes = link.rxBytes,
+            .radioOnUs = link.radioOnUs,
+            .idleUs = connectedUs > link.activeUs ? connectedUs - link.activeUs : 0,
+            .dutyPermille = static_cast<uint16_t>(
+                connectedUs > 0 ? std::min<uint64_t>(link.radioOnUs * 1000 / connectedUs, 1000) : 0)
+        };
+        return ESP_OK;
+    }
+
+    BlePowerManager::Statistics BlePowerManager::getStatistics() const
+    {
+        std::lock_guard lock(mMutex);
+
+        uint64_t heldUs = mLockHeldUs;
+        if (mLockHeld)
+        {
+            heldUs += static_cast<uint64_t>(esp_timer_get_time() - mLockSinceUs);
+        }
+        return {
+            .lockHeld = mLockHeld,
+            .lockAcquisitions = mLockAcquisitions,
+            .lockHeldUs = heldUs
+        };
+    }
+
+    BlePowerManager::Link* BlePowerManager::findLink(const uint16_t connId) noexcept
+    {
+        const auto it = std::ranges::find(mLinks, connId, &Link::connId);
+        return it != mLinks.end() ? &*it : nullptr;
+    }
+
+    const BlePowerManager::Link* BlePowerManager::findLink(const uint16_t connId) const noexcept
+    {
+        const auto it = std::ranges::find(mLinks, connId, &Link::connId);
+        return it != mLinks.end() ? &*it : nullptr;
+    }
+
+    void BlePowerManager::integrate(Link& link, const int64_t now) const noexcept
+    {
+        if (now <= link.integratedUs || link.interval == 0) return;
+
+        // В простое периферия пропускает до latency событий подряд
+        const double eventUs = link.interval * 1250.0 * (1 + link.latency);
+        const double events = static_cast<double>(now - link.integratedUs) / eventUs;
+        const uint32_t emptyUs = packetAirtimeUs(link.txPhy, 0);
+
+        link.events += events;
+        link.radioOnUs += static_cast<uint64_t>(events * (WAKEUP_US + emptyUs + T_IFS_US + emptyUs));
+        link.integratedUs = now;
+    }
+
+    uint32_t BlePowerManager::accountData(Link& link, const size_t bytes, const int64_t now) const noexcept
+    {
+        integrate(link, now);
+
+        const uint32_t octets = mTxOctets > 0 ? mTxOctets : 27;
+        const uint32_t total = static_cast<uint32_t>(bytes) + L2CAP_ATT_OVERHEAD;
+        const uint32_t packets = (total + octets - 1) / octets;
+        const uint32_t lastPayload = total - (packets - 1) * octets;
+
+        // Пакет данных + T_IFS + пустое подтверждение + T_IFS
+        const uint32_t exchangeUs = T_IFS_US + packetAirtimeUs(link.txPhy, 0) + T_IFS_US;
+        link.radioOnUs += (packets - 1) * (packetAirtimeUs(link.txPhy, octets) + exchangeUs) +
+            packetAirtimeUs(link.txPhy, lastPayload) + exchangeUs;
+
+        // Обмен в пределах одного интервала считается одним периодом активности
+        const int64_t intervalUs = link.interval * 1250LL;
+        const int64_t gap = now - link.lastActivityUs;
+        link.activeUs += static_cast<uint64_t>(gap > intervalUs ? intervalUs : gap);
+        link.lastActivityUs = now;
+        return packets;
+    }
+
+    bool BlePowerManager::isFast(const Link& link) const noexcept
+    {
+        return link.interval <= mFastIntervalMax;
+    }
+
+    size_t BlePowerManager::fastLinkCount() const noexcept
+    {
+        return std::ranges::count_if(mLinks, [this](const Link& link) { return isFast(link); });
+    }
+
+    void BlePowerManager::updateLock()
+    {
+        const bool wanted = mManageLocks && (mTxInFlight > 0 || mTxHold || fastLinkCount() > 0);
+        if (wanted == mLockHeld) return;
+
+        const int64_t now = esp_timer_get_time();
+        if (wanted)
+        {
+            if (mNoSleepLock != nullptr) esp_pm_lock_acquire(mNoSleepLock);
+            if (mCpuLock != nullptr) esp_pm_lock_acquire(mCpuLock);
+            mLockSinceUs = now;
+            mLockAcquisitions++;
+            ESP_LOGD(TAG, "PM locks acquired");
+        }
+        else
+        {
+            if (mCpuLock != nullptr) esp_pm_lock_release(mCpuLock);
+            if (mNoSleepLock != nullptr) esp_pm_lock_release(mNoSleepLock);
+            mLockHeldUs += static_cast<uint64_t>(now - mLockSinceUs);
+            ESP_LOGD(TAG, "PM locks released");
+        }
+        mLockHeld = wanted;
+    }
+
+    void BlePowerManager::holdTimerCallback(void* arg)
+    {
+        auto* self = static_cast<BlePowerManager*>(arg);
+
+        std::lock_guard lock(self->mMutex);
+        self->mTxHold = false;
+        self->updateLock();
+    }
+} // namespace net
@@ -0,0 +1,162 @@
+#include "net/ble_preset_registry.h"
+
+#include "esp_log.h"
+
+#include <algorithm>
+
+namespace net
+{
+    const std::array<BlePresetRegistry::BuiltIn, 6> BlePresetRegistry::BUILT_IN = {{
+        {"BLE5_DEFAULT", &presets::BLE5_DEFAULT},
+        {"BLE5_LOW_POWER", &presets::BLE5_LOW_POWER},
+        {"BLE5_ULTRA_PERF", &presets::BLE5_ULTRA_PERF},
+        {"BLE4_DEFAULT", &presets::BLE4_DEFAULT},
+        {"BLE4_LOW_POWER", &presets::BLE4_LOW_POWER},
+        {"BLE4_HIGH_PERF", &presets::BLE4_HIGH_PERF},
+    }};
+
+    esp_err_t BlePresetRegistry::add(const std::string_view name, const BleConfig& config)
+    {
+        if (name.empty() || name.size() > MAX_NAME_LENGTH)
+        {
+            ESP_LOGE(TAG, "Invalid preset name length %u", static_cast<unsigned>(name.size()));
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (findBuiltIn(name) != nullptr)
+        {
+            ESP_LOGE(TAG, "Preset name '%.*s' is reserved", static_cast<int>(name.size()), name.data());
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (!validate(name, config))
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        std::lock_guard lock(mMutex);
+
+        Custom* slot = findCustom(name);
+        if (slot == nullptr)
+        {
+            const auto it = std::ranges::find_if(mCustom, [](const Custom& custom) { return !custom.used; });
+            if (it == mCustom.end())
+            {
+                ESP_LOGE(TAG, "Preset registry full (%u)", static_cast<unsigned>(MAX_CUSTOM));
+                return ESP_ERR_NO_MEM;
+            }
+            slot = &*it;
+            std::ranges::copy(name, slot->name.begin());
+            slot->nameLength = name.size();
+            slot->used = true;
+        }
+        slot->config.copyFrom(config);
+
+        ESP_LOGI(TAG, "Preset '%.*s' registered", static_cast<int>(name.size()), name.data());
+        return ESP_OK;
+    }
+
+    esp_err_t BlePresetRegistry::remove(const std::string_view name)
+    {
+        if (findBuiltIn(name) != nullptr)
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        std::lock_guard lock(mMutex);
+
+        Custom* custom = findCustom(name);
+        if (custom == nullptr)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        custom->used = false;
+        custom->nameLength = 0;
+        return ESP_OK;
+    }
+
+    esp_err_t BlePresetRegistry::find(const std::string_view name, BleConfig& config) const
+    {
+        if (const BuiltIn* builtIn = findBuiltIn(name))
+        {
+            config.copyFrom(*builtIn->config);
+            return ESP_OK;
+        }
+
+        std::lock_guard lock(mMutex);
+
+        const Custom* custom = findCustom(name);
+        if (custom == nullptr)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        config.copyFrom(custom->config);
+        return ESP_OK;
+    }
+
+    void BlePresetRegistry::forEach(const Visitor& visitor) const
+    {
+        if (!visitor) return;
+
+        for (const auto& builtIn : BUILT_IN)
+        {
+            visitor(builtIn.name, *builtIn.config, true);
+        }
+
+        std::lock_guard lock(mMutex);
+        for (const auto& custom : mCustom)
+        {
+            if (custom.used)
+            {
+                visitor(custom.view(), custom.config, false);
+            }
+        }
+    }
+
+    size_t BlePresetRegistry::size() const
+    {
+        std::lock_guard lock(mMutex);
+        return BUILT_IN.size() + std::ranges::count_if(mCustom, [](const Custom& custom) { return custom.used; });
+    }
+
+    bool BlePresetRegistry::validate(const std::string_view name, const BleConfig& config)
+    {
+        std::array<BleConfig::ValidationIssue, MAX_REPORTED_ISSUES> issues = {};
+        const size_t count = config.validateAll(issues);
+        if (count == 0)
+        {
+            return true;
+        }
+
+        ESP_LOGE(TAG, "Preset '%.*s': %u invalid field(s)", static_cast<int>(name.size()), name.data(),
+                 static_cast<unsigned>(count));
+
+        char line[128];
+        for (size_t i = 0; i < std::min(count, issues.size()); ++i)
+        {
+            BleConfig::formatIssue(issues[i], line, sizeof(line));
+            ESP_LOGE(TAG, "  %s", line);
+        }
+        return false;
+    }
+
+    const BlePresetRegistry::BuiltIn* BlePresetRegistry::findBuiltIn(const std::string_view name) noexcept
+    {
+        const auto it = std::ranges::find(BUILT_IN, name, &BuiltIn::name);
+        return it != BUILT_IN.end() ? &*it : nullptr;
+    }
+
+    BlePresetRegistry::Custom* BlePresetRegistry::findCustom(const std::string_view name) noexcept
+    {
+        const auto it = std::ranges::find_if(mCustom, [name](const Custom& custom)
+        {
+            return custom.used && custom.view() == name;
+        });
+        return it != mCustom.end() ? &*it : nullptr;
+    }
+
+    const BlePresetRegistry::Custom* BlePresetRegistry::findCustom(const std::string_view name) const noexcept
+    {
+        return const_cast<BlePresetRegistry*>(this)->findCustom(name);
+    }
+} // namespace net
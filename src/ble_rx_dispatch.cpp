@@ -0,0 +1,172 @@
+#include "net/ble_rx_dispatch.h"
+#include "net/ble_task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace net
+{
+    BleRxDispatcher::~BleRxDispatcher()
+    {
+        end();
+    }
+
+    esp_err_t BleRxDispatcher::begin(const BleConfig& config, Sink sink)
+    {
+        if (mRunning) return ESP_OK;
+        if (!config.rx.deferred) return ESP_OK;
+
+        // Буфер переживает остановку: повторный запуск не выделяет память
+        if (!mRing || mRing->capacity() < config.rx.bufferSize)
+        {
+            mRing = std::make_unique<SpscByteRing>(config.rx.bufferSize);
+        }
+        mRing->reset();
+        mHasHeader = false;
+        mSink = std::move(sink);
+
+        mRunning = true;
+        TaskHandle_t task = nullptr;
+        if (BleTask::create(dispatchTask, "ble_rx", config.rx.taskStack, this,
+                            config.rx.taskPriority, config.rx.taskCore, task) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Create rx task failed");
+            mRunning = false;
+            return ESP_ERR_NO_MEM;
+        }
+        mTask = task;
+
+        ESP_LOGI(TAG, "Deferred delivery started (buffer %u)", static_cast<unsigned>(mRing->capacity()));
+        return ESP_OK;
+    }
+
+    void BleRxDispatcher::end()
+    {
+        if (!mRunning) return;
+
+        // Задача доставляет принятые записи и удаляет себя сама
+        mRunning = false;
+        xTaskNotifyGive(mTask);
+        while (mTask != nullptr)
+        {
+            vTaskDelay(1);
+        }
+    }
+
+    bool BleRxDispatcher::post(const uint16_t connId, const uint32_t generation, const uint8_t* data,
+                               const size_t len) noexcept
+    {
+        TaskHandle_t task = mTask.load();
+        if (task == nullptr || !mRunning || len > MAX_MTU) return false;
+
+        const size_t queued = mRing->size();
+        const size_t record = sizeof(Header) + len;
+        if (mRing->capacity() - queued < record)
+        {
+            mRejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // Заголовок и данные публикуются двумя записями: задача ждет данных, видя только заголовок
+        const Header header = {
+            .timeUs = static_cast<uint32_t>(esp_timer_get_time()),
+            .generation = generation,
+            .connId = connId,
+            .len = static_cast<uint16_t>(len)
+        };
+        mRing->write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+        mRing->write(data, len);
+
+        if (queued + record > mMaxQueued.load(std::memory_order_relaxed))
+        {
+            mMaxQueued.store(static_cast<uint32_t>(queued + record), std::memory_order_relaxed);
+        }
+        xTaskNotifyGive(task);
+        return true;
+    }
+
+    BleRxDispatcher::Statistics BleRxDispatcher::getStatistics() const noexcept
+    {
+        return {
+            .delivered = mDelivered.load(),
+            .rejected = mRejected.load(),
+            .maxQueuedBytes = mMaxQueued.load(),
+            .maxLatencyUs = mMaxLatencyUs.load(),
+            .totalLatencyUs = mTotalLatencyUs.load()
+        };
+    }
+
+    void BleRxDispatcher::resetStatistics() noexcept
+    {
+        mDelivered = 0;
+        mRejected = 0;
+        mMaxQueued = 0;
+        mMaxLatencyUs = 0;
+        mTotalLatencyUs = 0;
+    }
+
+    void BleRxDispatcher::read(uint8_t* out, const size_t len) noexcept
+    {
+        for (size_t done = 0; done < len;)
+        {
+            const std::span<const uint8_t> chunk = mRing->peek();
+            const size_t count = std::min(chunk.size(), len - done);
+            std::memcpy(out + done, chunk.data(), count);
+            mRing->consume(count);
+            done += count;
+        }
+    }
+
+    void BleRxDispatcher::drain()
+    {
+        while (true)
+        {
+            if (!mHasHeader)
+            {
+                if (mRing->size() < sizeof(Header)) return;
+                read(reinterpret_cast<uint8_t*>(&mHeader), sizeof(Header));
+                mHasHeader = true;
+            }
+            if (mRing->size() < mHeader.len) return;
+            mHasHeader = false;
+
+            const uint32_t latency = static_cast<uint32_t>(esp_timer_get_time()) - mHeader.timeUs;
+            mTotalLatencyUs.fetch_add(latency, std::memory_order_relaxed);
+            if (latency > mMaxLatencyUs.load(std::memory_order_relaxed))
+            {
+                mMaxLatencyUs.store(latency, std::memory_order_relaxed);
+            }
+
+            // Непрерывная запись передается прямо из буфера и освобождается после вызова
+            const std::span<const uint8_t> chunk = mRing->peek();
+            if (chunk.size() >= mHeader.len)
+            {
+                mSink(mHeader.connId, mHeader.generation, chunk.first(mHeader.len));
+                mRing->consume(mHeader.len);
+            }
+            else
+            {
+                read(mRecord.data(), mHeader.len);
+                mSink(mHeader.connId, mHeader.generation, {mRecord.data(), mHeader.len});
+            }
+            mDelivered.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void BleRxDispatcher::dispatchTask(void* arg)
+    {
+        auto* self = static_cast<BleRxDispatcher*>(arg);
+        while (self->mRunning)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            self->drain();
+        }
+        self->drain();
+
+        self->mTask = nullptr;
+        vTaskDelete(nullptr);
+    }
+} // namespace net
@@ -0,0 +1,428 @@
+#include "net/ble_scanner.h"
+
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+namespace net
+{
+    namespace
+    {
+        /// @brief Типы AD-структур, используемые фильтрами
+        constexpr uint8_t AD_UUID16_PART = 0x02;
+        constexpr uint8_t AD_UUID16_CMPL = 0x03;
+        constexpr uint8_t AD_UUID32_PART = 0x04;
+        constexpr uint8_t AD_UUID32_CMPL = 0x05;
+        constexpr uint8_t AD_UUID128_PART = 0x06;
+        constexpr uint8_t AD_UUID128_CMPL = 0x07;
+        constexpr uint8_t AD_NAME_SHORT = 0x08;
+        constexpr uint8_t AD_NAME_CMPL = 0x09;
+
+        /// @brief Максимальное количество проб в таблице дубликатов
+        constexpr size_t DEDUP_MAX_PROBES = 8;
+
+        /// @brief Мощность передачи не указана в отчете
+        constexpr uint8_t TX_POWER_UNKNOWN = 0x7F;
+
+        /**
+         * @brief Сравнение UUID из AD-структуры (little-endian) с фильтром
+         * @param uuid Фильтр (байты в текстовом порядке, big-endian)
+         * @param data Список UUID из рекламы
+         * @param len Длина списка
+         * @param uuidLen Длина одного UUID в рекламе
+         */
+        bool containsUuid(const BleUuid& uuid, const uint8_t* data, const size_t len, const size_t uuidLen) noexcept
+        {
+            if (uuid.length() != uuidLen) return false;
+
+            const auto& bytes = uuid.bytes();
+            for (size_t offset = 0; offset + uuidLen <= len; offset += uuidLen)
+            {
+                bool match = true;
+                for (size_t i = 0; i < uuidLen && match; ++i)
+                {
+                    match = data[offset + i] == bytes[uuidLen - 1 - i];
+                }
+                if (match) return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief FNV-1a хэш
+         */
+        uint32_t fnv1a(const uint8_t* data, const size_t len, uint32_t hash = 2166136261u) noexcept
+        {
+            for (size_t i = 0; i < len; ++i)
+            {
+                hash ^= data[i];
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+    } // namespace
+
+    void BleScanConfig::setNamePrefix(const std::string_view prefix) noexcept
+    {
+        namePrefix.fill('\0');
+        std::copy_n(prefix.begin(), std::min(prefix.size(), MAX_NAME_PREFIX), namePrefix.begin());
+    }
+
+    size_t BleScanConfig::namePrefixLength() const noexcept
+    {
+        return std::find(namePrefix.begin(), namePrefix.end(), '\0') - namePrefix.begin();
+    }
+
+    BleScanner::~BleScanner()
+    {
+        stop();
+    }
+
+    esp_err_t BleScanner::start(const BleScanConfig& config, ResultCallback callback)
+    {
+        // Задача прошлого сканирования может еще дорабатывать отчеты после stop() из callback
+        if (mScanning || mRunning || mTask != nullptr)
+        {
+            ESP_LOGW(TAG, "Scan already running");
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        if (!callback)
+        {
+            ESP_LOGE(TAG, "Scan callback is empty");
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (config.window > config.interval)
+        {
+            ESP_LOGE(TAG, "Scan window 0x%04x exceeds interval 0x%04x", config.window, config.interval);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        mConfig = config;
+        mCallback = std::move(callback);
+        mDedup.fill({});
+        resetStatistics();
+
+        // 1. Задача-потребитель (поднимается раньше, чем пойдут отчеты)
+        mRunning = true;
+        TaskHandle_t task = nullptr;
+        if (BleTask::create(consumerTask, "ble_scan", mConfig.taskStack, this,
+                            mConfig.taskPriority, mConfig.taskCore, task) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Create scan task failed");
+            mRunning = false;
+            return ESP_ERR_NO_MEM;
+        }
+        mTask = task;
+
+        // 2. Параметры сканирования; старт - по ESP_GAP_BLE_SET_EXT_SCAN_PARAMS_COMPLETE_EVT
+        const esp_ble_ext_scan_cfg_t phyCfg = {
+            .scan_type = mConfig.active ? BLE_SCAN_TYPE_ACTIVE : BLE_SCAN_TYPE_PASSIVE,
+            .scan_interval = mConfig.interval,
+            .scan_window = mConfig.window,
+        };
+
+        esp_ble_ext_scan_params_t params = {
+            .own_addr_type = BLE_ADDR_TYPE_PUBLIC,
+            .filter_policy = BLE_SCAN_FILTER_ALLOW_ALL,
+            // Дубликаты подавляются своей таблицей: контроллерный фильтр теряет
+            // обновления данных и изменения RSSI одного и того же устройства
+            .scan_duplicate = BLE_SCAN_DUPLICATE_DISABLE,
+            .cfg_mask = static_cast<esp_ble_ext_scan_cfg_mask_t>(
+                ESP_BLE_GAP_EXT_SCAN_CFG_UNCODE_MASK |
+                (mConfig.coded ? ESP_BLE_GAP_EXT_SCAN_CFG_CODE_MASK : 0)),
+            .uncoded_cfg = phyCfg,
+            .coded_cfg = phyCfg,
+        };
+
+        const esp_err_t ret = esp_ble_gap_set_ext_scan_params(&params);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Set ext scan params failed: %s", esp_err_to_name(ret));
+            stop();
+            return ret;
+        }
+
+        ESP_LOGI(TAG, "Scan configured: interval=0x%04x window=0x%04x %s%s",
+                 mConfig.interval, mConfig.window,
+                 mConfig.active ? "active" : "passive", mConfig.coded ? " +coded" : "");
+        return ESP_OK;
+    }
+
+    esp_err_t BleScanner::stop()
+    {
+        esp_err_t ret = ESP_OK;
+        if (mScanning)
+        {
+            ret = esp_ble_gap_stop_ext_scan();
+            if (ret != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Stop ext scan failed: %s", esp_err_to_name(ret));
+            }
+            mScanning = false;
+        }
+
+        // Задача дорабатывает накопленные отчеты и удаляет себя сама
+        const TaskHandle_t task = mTask.load();
+        if (mRunning.exchange(false) && task != nullptr)
+        {
+            xTaskNotifyGive(task);
+        }
+
+        // Из callback задача завершится после возврата из него: ожидание здесь - взаимоблокировка
+        if (task != nullptr && task != xTaskGetCurrentTaskHandle())
+        {
+            while (mTask != nullptr)
+            {
+                vTaskDelay(1);
+            }
+        }
+
+        return ret;
+    }
+
+    bool BleScanner::handleGapEvent(const esp_gap_ble_cb_event_t event, const esp_ble_gap_cb_param_t* param)
+    {
+        switch (event)
+        {
+        case ESP_GAP_BLE_SET_EXT_SCAN_PARAMS_COMPLETE_EVT:
+            if (param->set_ext_scan_params.status != ESP_BT_STATUS_SUCCESS)
+            {
+                ESP_LOGE(TAG, "Set ext scan params failed: %d", param->set_ext_scan_params.status);
+                return true;
+            }
+            if (mRunning)
+            {
+                // Длительность задается в единицах 10 мс
+                const esp_err_t ret = esp_ble_gap_start_ext_scan(
+                    static_cast<uint32_t>((mConfig.durationMs + 9) / 10), 0);
+                if (ret != ESP_OK)
+                {
+                    ESP_LOGE(TAG, "Start ext scan failed: %s", esp_err_to_name(ret));
+                }
+            }
+            return true;
+
+        case ESP_GAP_BLE_EXT_SCAN_START_COMPLETE_EVT:
+            mScanning = param->ext_scan_start.status == ESP_BT_STATUS_SUCCESS;
+            if (!mScanning)
+            {
+                ESP_LOGE(TAG, "Ext scan start failed: %d", param->ext_scan_start.status);
+            }
+            else
+            {
+                ESP_LOGI(TAG, "Scan started");
+            }
+            return true;
+
+        case ESP_GAP_BLE_EXT_SCAN_STOP_COMPLETE_EVT:
+            mScanning = false;
+            ESP_LOGI(TAG, "Scan stopped: received=%" PRIu32 " processed=%" PRIu32 " dropped=%" PRIu32,
+                     mReceived.load(), mProcessed.load(), mDropped.load());
+            return true;
+
+        case ESP_GAP_BLE_SCAN_TIMEOUT_EVT:
+            // Сканирование с durationMs завершилось само; задача-потребитель дорабатывает
+            // накопленные отчеты и завершается, ожидание stop() для повторного start() не нужно
+            mScanning = false;
+            if (TaskHandle_t task = mTask.load(); mRunning.exchange(false) && task != nullptr)
+            {
+                xTaskNotifyGive(task);
+            }
+            ESP_LOGI(TAG, "Scan timeout: received=%" PRIu32 " processed=%" PRIu32 " dropped=%" PRIu32,
+                     mReceived.load(), mProcessed.load(), mDropped.load());
+            return true;
+
+        case ESP_GAP_BLE_EXT_ADV_REPORT_EVT:
+            submitReport(param->ext_adv_report.params);
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    void BleScanner::submitReport(const esp_ble_gap_ext_adv_reprot_t& report) noexcept
+    {
+        mReceived.fetch_add(1, std::memory_order_relaxed);
+
+        if (!passesFilters(report))
+        {
+            mFiltered.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const int64_t nowUs = esp_timer_get_time();
+        if (isDuplicate(report, static_cast<uint32_t>(nowUs / 1000)))
+        {
+            mDuplicates.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Запись прямо в слот буфера, без промежуточной копии
+        BleScanReport* slot = mRing.reserve();
+        if (slot == nullptr)
+        {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const uint8_t len = std::min<uint8_t>(report.adv_data_len, BleScanReport::MAX_DATA_LEN);
+        slot->timestampUs = nowUs;
+        std::memcpy(slot->address, report.addr, sizeof(esp_bd_addr_t));
+        slot->addrType = report.addr_type;
+        slot->eventType = report.event_type;
+        slot->primaryPhy = report.primary_phy;
+        slot->secondaryPhy = report.secondly_phy;
+        slot->rssi = report.rssi;
+        slot->txPower = static_cast<int8_t>(report.tx_power == TX_POWER_UNKNOWN ? 127 : report.tx_power);
+        slot->dataLen = len;
+        std::memcpy(slot->data.data(), report.adv_data, len);
+        mRing.commit();
+
+        if (TaskHandle_t task = mTask.load(); task != nullptr)
+        {
+            xTaskNotifyGive(task);
+        }
+    }
+
+    BleScanner::Statistics BleScanner::getStatistics() const noexcept
+    {
+        return {
+            .received = mReceived.load(),
+            .filtered = mFiltered.load(),
+            .duplicates = mDuplicates.load(),
+            .dropped = mDropped.load(),
+            .processed = mProcessed.load(),
+        };
+    }
+
+    void BleScanner::resetStatistics() noexcept
+    {
+        mReceived = 0;
+        mFiltered = 0;
+        mDuplicates = 0;
+        mDropped = 0;
+        mProcessed = 0;
+    }
+
+    bool BleScanner::passesFilters(const esp_ble_gap_ext_adv_reprot_t& report) const noexcept
+    {
+        // 1. Самая дешевая проверка - RSSI
+        if (report.rssi < mConfig.minRssi) return false;
+
+        const bool needUuid = mConfig.serviceUuid.isValid();
+        const size_t prefixLen = mConfig.namePrefixLength();
+        if (!needUuid && prefixLen == 0) return true;
+
+        // 2. Один проход по AD-структурам для UUID и имени
+        bool uuidMatch = !needUuid;
+        bool nameMatch = prefixLen == 0;
+        const uint8_t* data = report.adv_data;
+        const size_t dataLen = std::min<size_t>(report.adv_data_len, BleScanReport::MAX_DATA_LEN);
+
+        for (size_t pos = 0; pos + 1 < dataLen && !(uuidMatch && nameMatch);)
+        {
+            const uint8_t fieldLen = data[pos];
+            if (fieldLen == 0 || pos + 1 + fieldLen > dataLen) break;
+
+            const uint8_t type = data[pos + 1];
+            const uint8_t* value = data + pos + 2;
+            const size_t valueLen = fieldLen - 1;
+
+            switch (type)
+            {
+            case AD_UUID16_PART:
+            case AD_UUID16_CMPL:
+                uuidMatch = uuidMatch || containsUuid(mConfig.serviceUuid, value, valueLen, ESP_UUID_LEN_16);
+                break;
+            case AD_UUID32_PART:
+            case AD_UUID32_CMPL:
+                uuidMatch = uuidMatch || containsUuid(mConfig.serviceUuid, value, valueLen, ESP_UUID_LEN_32);
+                break;
+            case AD_UUID128_PART:
+            case AD_UUID128_CMPL:
+                uuidMatch = uuidMatch || containsUuid(mConfig.serviceUuid, value, valueLen, ESP_UUID_LEN_128);
+                break;
+            case AD_NAME_SHORT:
+            case AD_NAME_CMPL:
+                nameMatch = nameMatch ||
+                    (valueLen >= prefixLen && std::memcmp(value, mConfig.namePrefix.data(), prefixLen) == 0);
+                break;
+            default:
+                break;
+            }
+
+            pos += 1 + fieldLen;
+        }
+
+        return uuidMatch && nameMatch;
+    }
+
+    bool BleScanner::isDuplicate(const esp_ble_gap_ext_adv_reprot_t& report, const uint32_t nowMs) noexcept
+    {
+        if (mConfig.dedupWindowMs == 0) return false;
+
+        uint32_t key = fnv1a(report.addr, sizeof(esp_bd_addr_t));
+        key = fnv1a(report.adv_data, std::min<size_t>(report.adv_data_len, BleScanReport::MAX_DATA_LEN), key);
+        key = key == 0 ? 1 : key; // 0 зарезервирован под пустую запись
+
+        // Открытая адресация с ограниченным числом проб: при заполнении
+        // вытесняется самая старая запись из цепочки
+        size_t oldest = key & (DEDUP_TABLE_SIZE - 1);
+        for (size_t probe = 0; probe < DEDUP_MAX_PROBES; ++probe)
+        {
+            const size_t index = (key + probe) & (DEDUP_TABLE_SIZE - 1);
+            DedupEntry& entry = mDedup[index];
+
+            if (entry.key == key)
+            {
+                const bool duplicate = nowMs - entry.lastSeen < mConfig.dedupWindowMs;
+                entry.lastSeen = nowMs;
+                return duplicate;
+            }
+
+            if (entry.key == 0 || nowMs - entry.lastSeen >= mConfig.dedupWindowMs)
+            {
+                entry = {key, nowMs};
+                return false;
+            }
+
+            if (entry.lastSeen - mDedup[oldest].lastSeen > UINT32_MAX / 2)
+            {
+                oldest = index;
+            }
+        }
+
+        mDedup[oldest] = {key, nowMs};
+        return false;
+    }
+
+    void BleScanner::consumerTask(void* arg)
+    {
+        auto* self = static_cast<BleScanner*>(arg);
+
+        while (true)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+            // Обработка на месте, слот освобождается после callback
+            while (const BleScanReport* report = self->mRing.front())
+            {
+                self->mCallback(*report);
+                self->mRing.release();
+                self->mProcessed.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (!self->mRunning) break;
+        }
+
+        self->mTask = nullptr;
+        vTaskDelete(nullptr);
+    }
+} // namespace net
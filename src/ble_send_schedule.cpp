@@ -0,0 +1,596 @@
+#include "net/ble_send_schedule.h"
+#include "net/ble_task.h"
+
+#include "esp_gap_ble_api.h"
+#include "esp_log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace net
+{
+    namespace
+    {
+        /// @brief Ожидание передачи пакета контроллеру задачей BTC, мкс
+        constexpr int64_t HANDOFF_TIMEOUT_US = 2000;
+
+        /// @brief Наблюдений подряд без возврата кредита до повторного определения фазы
+        constexpr uint8_t MAX_MISSES = 4;
+
+        void updateMax(std::atomic<uint32_t>& max, const int64_t value)
+        {
+            const auto clamped = static_cast<uint32_t>(std::clamp<int64_t>(value, 0, UINT32_MAX));
+            if (clamped > max.load(std::memory_order_relaxed))
+            {
+                max.store(clamped, std::memory_order_relaxed);
+            }
+        }
+    } // namespace
+
+    BleSendScheduler::BleSendScheduler(Sender sender) :
+        mSender(std::move(sender))
+    {
+    }
+
+    BleSendScheduler::~BleSendScheduler()
+    {
+        end();
+        if (mTimer != nullptr)
+        {
+            esp_timer_delete(mTimer);
+        }
+    }
+
+    esp_err_t BleSendScheduler::begin(const BleConfig& config)
+    {
+        if (mRunning) return ESP_OK;
+        if (!config.schedule.enabled) return ESP_OK;
+
+        if (mTimer == nullptr)
+        {
+            const esp_timer_create_args_t args = {
+                .callback = timerCallback,
+                .arg = this,
+                .dispatch_method = ESP_TIMER_TASK,
+                .name = "ble_sched",
+                .skip_unhandled_events = false
+            };
+            if (esp_timer_create(&args, &mTimer) != ESP_OK)
+            {
+                ESP_LOGE(TAG, "Create timer failed");
+                return ESP_ERR_NO_MEM;
+            }
+        }
+
+        {
+            // Очередь переживает остановку: повторный запуск не выделяет память
+            std::lock_guard lock(mMutex);
+            if (mEntries.size() != config.schedule.queueLength)
+            {
+                mEntries.assign(config.schedule.queueLength, Entry{});
+            }
+            for (Entry& entry : mEntries)
+            {
+                entry.state = EntryState::FREE;
+            }
+            mBatch.reserve(mEntries.size());
+            mLinks.clear();
+            mLeadUs = config.schedule.leadUs;
+            mBatchMode = config.schedule.batch;
+            mObserveEvery = std::max<uint8_t>(config.schedule.observeEvery, 1);
+        }
+
+        mRunning = true;
+        TaskHandle_t task = nullptr;
+        if (BleTask::create(scheduleTask, "ble_sched", config.schedule.taskStack, this,
+                            config.schedule.taskPriority, config.schedule.taskCore, task) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Create schedule task failed");
+            mRunning = false;
+            return ESP_ERR_NO_MEM;
+        }
+        mTask = task;
+
+        ESP_LOGI(TAG, "Scheduled sends started (queue %u, lead %u us%s)", static_cast<unsigned>(mEntries.size()),
+                 static_cast<unsigned>(mLeadUs), mBatchMode ? ", batch" : "");
+        return ESP_OK;
+    }
+
+    void BleSendScheduler::end()
+    {
+        if (!mRunning) return;
+
+        // Задача завершает текущий выпуск и удаляет себя сама
+        mRunning = false;
+        xTaskNotifyGive(mTask);
+        while (mTask != nullptr)
+        {
+            vTaskDelay(1);
+        }
+        esp_timer_stop(mTimer);
+
+        std::lock_guard lock(mMutex);
+        for (Entry& entry : mEntries)
+        {
+            entry.state = EntryState::FREE;
+        }
+        mLinks.clear();
+    }
+
+    BleSendScheduler::DrainResult BleSendScheduler::drain(const int64_t deadlineUs)
+    {
+        if (!mRunning) return {};
+
+        const uint32_t sentBefore = mSent.load();
+        const uint32_t failedBefore = mFailed.load();
+        mFlushing = true;
+        wake();
+        while (pending() != 0 && esp_timer_get_time() < deadlineUs)
+        {
+            vTaskDelay(1);
+        }
+        mFlushing = false;
+
+        const DrainResult result = {
+            .flushed = mSent.load() - sentBefore,
+            .dropped = static_cast<uint32_t>(pending()) + (mFailed.load() - failedBefore)
+        };
+        ESP_LOGI(TAG, "Queue drained: %u sent, %u dropped", static_cast<unsigned>(result.flushed),
+                 static_cast<unsigned>(result.dropped));
+        return result;
+    }
+
+    esp_err_t BleSendScheduler::schedule(const uint16_t connId, const uint8_t* data, const size_t len,
+                                         const int64_t dueUs)
+    {
+        if (!mRunning) return ESP_ERR_INVALID_STATE;
+        if (len == 0 || len > MAX_MTU) return ESP_ERR_INVALID_SIZE;
+
+        {
+            std::lock_guard lock(mMutex);
+            if (findLink(connId) == nullptr) return ESP_ERR_NOT_FOUND;
+
+            const auto it = std::ranges::find_if(mEntries, [](const Entry& entry)
+            {
+                return entry.state == EntryState::FREE;
+            });
+            if (it == mEntries.end())
+            {
+                mRejected.fetch_add(1, std::memory_order_relaxed);
+                return ESP_ERR_NO_MEM;
+            }
+
+            it->state = EntryState::QUEUED;
+            it->connId = connId;
+            it->len = static_cast<uint16_t>(len);
+            it->sequence = mSequence++;
+            it->dueUs = dueUs > 0 ? dueUs : esp_timer_get_time();
+            std::memcpy(it->data.data(), data, len);
+        }
+
+        mQueued.fetch_add(1, std::memory_order_relaxed);
+        wake();
+        return ESP_OK;
+    }
+
+    esp_err_t BleSendScheduler::nextEvent(const uint16_t connId, int64_t& timeUs) const
+    {
+        std::lock_guard lock(mMutex);
+        const auto it = std::ranges::find_if(mLinks, [connId](const Link& link) { return link.connId == connId; });
+        if (it == mLinks.end()) return ESP_ERR_NOT_FOUND;
+        if (!it->locked) return ESP_ERR_INVALID_STATE;
+
+        timeUs = slotAtOrAfter(*it, esp_timer_get_time());
+        return ESP_OK;
+    }
+
+    void BleSendScheduler::handleConnect(const uint16_t connId, const uint16_t interval)
+    {
+        if (!mRunning) return;
+
+        std::lock_guard lock(mMutex);
+        Link* link = findLink(connId);
+        if (link == nullptr)
+        {
+            link = &mLinks.emplace_back();
+        }
+        *link = {
+            .connId = connId,
+            .intervalUs = interval * INTERVAL_UNIT_US,
+            .phaseUs = 0,
+            .lastSlotUs = 0,
+            .locked = false,
+            .skipped = 0,
+            .misses = 0
+        };
+    }
+
+    void BleSendScheduler::handleConnectionParams(const uint16_t connId, const uint16_t interval)
+    {
+        if (!mRunning) return;
+
+        {
+            // Новые параметры начинают действовать с мгновения, неизвестного хосту
+            std::lock_guard lock(mMutex);
+            Link* link = findLink(connId);
+            if (link == nullptr) return;
+            link->intervalUs = interval * INTERVAL_UNIT_US;
+            link->locked = false;
+            link->misses = 0;
+        }
+        wake();
+    }
+
+    void BleSendScheduler::handleDisconnect(const uint16_t connId)
+    {
+        if (!mRunning) return;
+
+        std::lock_guard lock(mMutex);
+        std::erase_if(mLinks, [connId](const Link& link) { return link.connId == connId; });
+        for (Entry& entry : mEntries)
+        {
+            if (entry.state == EntryState::QUEUED && entry.connId == connId)
+            {
+                entry.state = EntryState::FREE;
+            }
+        }
+    }
+
+    BleSendScheduler::Statistics BleSendScheduler::getStatistics() const noexcept
+    {
+        return {
+            .queued = mQueued.load(),
+            .sent = mSent.load(),
+            .rejected = mRejected.load(),
+            .failed = mFailed.load(),
+            .late = mLate.load(),
+            .events = mEvents.load(),
+            .observed = mObserved.load(),
+            .unobserved = mUnobserved.load(),
+            .relocks = mRelocks.load(),
+            .maxJitterUs = mMaxJitterUs.load(),
+            .totalJitterUs = mTotalJitterUs.load(),
+            .maxLatencyUs = mMaxLatencyUs.load(),
+            .totalLatencyUs = mTotalLatencyUs.load()
+        };
+    }
+
+    void BleSendScheduler::resetStatistics() noexcept
+    {
+        mQueued = 0;
+        mSent = 0;
+        mRejected = 0;
+        mFailed = 0;
+        mLate = 0;
+        mEvents = 0;
+        mObserved = 0;
+        mUnobserved = 0;
+        mRelocks = 0;
+        mMaxJitterUs = 0;
+        mTotalJitterUs = 0;
+        mMaxLatencyUs = 0;
+        mTotalLatencyUs = 0;
+    }
+
+    size_t BleSendScheduler::pending() const
+    {
+        std::lock_guard lock(mMutex);
+        return static_cast<size_t>(std::ranges::count_if(mEntries, [](const Entry& entry)
+        {
+            return entry.state != EntryState::FREE;
+        }));
+    }
+
+    int64_t BleSendScheduler::slotAtOrAfter(const Link& link, const int64_t timeUs) noexcept
+    {
+        const int64_t delta = timeUs - link.phaseUs;
+        int64_t events = delta / link.intervalUs;
+        if (delta > 0 && delta % link.intervalUs != 0)
+        {
+            events++;
+        }
+        return link.phaseUs + events * link.intervalUs;
+    }
+
+    BleSendScheduler::Link* BleSendScheduler::findLink(const uint16_t connId) noexcept
+    {
+        const auto it = std::ranges::find_if(mLinks, [connId](const Link& link) { return link.connId == connId; });
+        return it != mLinks.end() ? &*it : nullptr;
+    }
+
+    bool BleSendScheduler::plan(const int64_t nowUs, Plan& result) noexcept
+    {
+        bool found = false;
+        for (const Entry& entry : mEntries)
+        {
+            if (entry.state != EntryState::QUEUED) continue;
+            const Link* link = findLink(entry.connId);
+            if (link == nullptr) continue;
+
+            Plan candidate = {.connId = entry.connId, .slotUs = 0, .releaseUs = 0};
+            if (link->locked && !mFlushing)
+            {
+                // Событие, до которого стек успевает передать пакет, не раньше запрошенного
+                // и не то же, в котором соединение уже получило выпуск
+                const int64_t earliest = std::max({entry.dueUs, nowUs + mLeadUs,
+                                                   link->lastSlotUs + link->intervalUs / 2});
+                candidate.slotUs = slotAtOrAfter(*link, earliest);
+                candidate.releaseUs = candidate.slotUs - mLeadUs;
+            }
+            else
+            {
+                // Фаза неизвестна: уведомление уходит сразу и по нему определяется фаза.
+                // При сбросе очереди запрошенное время не ждется
+                candidate.releaseUs = mFlushing ? nowUs : std::max(entry.dueUs, nowUs);
+                candidate.slotUs = candidate.releaseUs + mLeadUs;
+            }
+
+            if (!found || candidate.releaseUs < result.releaseUs)
+            {
+                result = candidate;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    bool BleSendScheduler::waitUntil(const int64_t timeUs)
+    {
+        // Таймер будит задачу заранее, последний отрезок - активное ожидание
+        if (const int64_t sleepUs = timeUs - SPIN_US - esp_timer_get_time(); sleepUs > 0)
+        {
+            esp_timer_start_once(mTimer, static_cast<uint64_t>(sleepUs));
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            esp_timer_stop(mTimer);
+            if (!mRunning || esp_timer_get_time() < timeUs - SPIN_US) return false;
+        }
+
+        // Не дольше SPIN_US: таймер разбудил не раньше timeUs - SPIN_US
+        while (esp_timer_get_time() < timeUs)
+        {
+        }
+        return mRunning;
+    }
+
+    bool BleSendScheduler::yieldSlice(int64_t& sliceEndUs, const int64_t nowUs)
+    {
+        if (nowUs < sliceEndUs) return false;
+
+        // Раннее пробуждение (новое уведомление) только укорачивает сон
+        esp_timer_start_once(mTimer, static_cast<uint64_t>(SPIN_US));
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        esp_timer_stop(mTimer);
+        sliceEndUs = esp_timer_get_time() + SPIN_US;
+        return true;
+    }
+
+    void BleSendScheduler::release(const Plan& plan)
+    {
+        bool locked = false;
+        bool observe = false;
+        int64_t intervalUs = 0;
+        int64_t requestUs = 0;
+
+        mBatch.clear();
+        {
+            std::lock_guard lock(mMutex);
+            Link* link = findLink(plan.connId);
+            if (link == nullptr) return;
+
+            // В событие уходят уведомления соединения, запрошенные не позже него;
+            // при сбросе очереди - все уведомления соединения
+            const int64_t dueLimit = mFlushing ? INT64_MAX : link->locked ? plan.slotUs : plan.releaseUs;
+            for (Entry& entry : mEntries)
+            {
+                if (entry.state == EntryState::QUEUED && entry.connId == plan.connId && entry.dueUs <= dueLimit)
+                {
+                    mBatch.push_back(&entry);
+                }
+            }
+            if (mBatch.empty()) return;
+
+            std::ranges::sort(mBatch, {}, &Entry::sequence);
+            if (!mBatchMode && !mFlushing)
+            {
+                mBatch.resize(1);
+            }
+            for (Entry* entry : mBatch)
+            {
+                entry->state = EntryState::SENDING;
+            }
+
+            locked = link->locked;
+            intervalUs = link->intervalUs;
+            link->lastSlotUs = plan.slotUs;
+            if (!mFlushing && (!locked || ++link->skipped >= mObserveEvery))
+            {
+                link->skipped = 0;
+                observe = true;
+            }
+            requestUs = std::ranges::min(mBatch, {}, &Entry::dueUs)->dueUs;
+        }
+
+        const uint16_t credits = observe ? esp_ble_get_cur_sendable_packets_num(plan.connId) : 0;
+        uint32_t sent = 0;
+        for (const Entry* entry : mBatch)
+        {
+            if (mSender(plan.connId, entry->data.data(), entry->len) == ESP_OK)
+            {
+                sent++;
+            }
+            else
+            {
+                mFailed.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (plan.slotUs - entry->dueUs > intervalUs)
+            {
+                mLate.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        mSent.fetch_add(sent, std::memory_order_relaxed);
+        mEvents.fetch_add(1, std::memory_order_relaxed);
+
+        {
+            std::lock_guard lock(mMutex);
+            for (Entry* entry : mBatch)
+            {
+                entry->state = EntryState::FREE;
+            }
+        }
+
+        if (!observe || sent == 0 || credits == 0) return;
+        updatePhase(plan, observeCompletion(plan, credits, locked, intervalUs), requestUs);
+    }
+
+    int64_t BleSendScheduler::observeCompletion(const Plan& plan, const uint16_t credits, const bool locked,
+                                                const int64_t intervalUs)
+    {
+        // Кредит уменьшается, когда задача BTC передает пакет контроллеру
+        uint16_t lowest = credits;
+        const int64_t handoffUs = esp_timer_get_time() + HANDOFF_TIMEOUT_US;
+        int64_t sliceEndUs = esp_timer_get_time() + SPIN_US;
+        while ((lowest = std::min(lowest, esp_ble_get_cur_sendable_packets_num(plan.connId))) >= credits)
+        {
+            const int64_t nowUs = esp_timer_get_time();
+            if (!mRunning || nowUs >= handoffUs) return 0;
+            yieldSlice(sliceEndUs, nowUs);
+        }
+
+        if (!locked)
+        {
+            return std::max<int64_t>(spinForCredit(plan.connId, lowest, esp_timer_get_time() + 2 * intervalUs), 0);
+        }
+
+        // Подтверждение приходит в событии отправки или в следующем (клиент подтверждает
+        // пакет своим следующим пакетом): ожидание - только в окнах вокруг этих событий
+        for (int64_t event = 0; event < 2; event++)
+        {
+            const int64_t centerUs = plan.slotUs + event * intervalUs;
+            while (mRunning && !waitUntil(centerUs - intervalUs / 4))
+            {
+            }
+            const int64_t completionUs = spinForCredit(plan.connId, lowest, centerUs + intervalUs / 4);
+            if (completionUs != 0) return std::max<int64_t>(completionUs, 0);
+        }
+        return 0;
+    }
+
+    int64_t BleSendScheduler::spinForCredit(const uint16_t connId, uint16_t& lowest, const int64_t untilUs)
+    {
+        int64_t sliceEndUs = esp_timer_get_time() + SPIN_US;
+        int64_t checkedUs = 0;
+        bool slept = false;
+        for (bool first = true; mRunning; first = false)
+        {
+            const uint16_t credits = esp_ble_get_cur_sendable_packets_num(connId);
+            const int64_t nowUs = esp_timer_get_time();
+
+            // Кредит, вернувшийся во время сна, датируется серединой сна
+            if (credits > lowest) return first ? -1 : slept ? (checkedUs + nowUs) / 2 : nowUs;
+            lowest = credits;
+            if (nowUs >= untilUs) break;
+
+            checkedUs = nowUs;
+            slept = yieldSlice(sliceEndUs, nowUs);
+        }
+        return 0;
+    }
+
+    void BleSendScheduler::updatePhase(const Plan& plan, const int64_t completionUs, const int64_t requestUs)
+    {
+        std::lock_guard lock(mMutex);
+        Link* link = findLink(plan.connId);
+        if (link == nullptr) return;
+
+        if (completionUs == 0)
+        {
+            mUnobserved.fetch_add(1, std::memory_order_relaxed);
+            if (link->locked && ++link->misses >= MAX_MISSES)
+            {
+                link->locked = false;
+                mRelocks.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+        link->misses = 0;
+
+        if (!link->locked)
+        {
+            link->phaseUs = completionUs;
+            link->locked = true;
+            ESP_LOGD(TAG, "Conn %u: phase locked, interval %lld us", plan.connId,
+                     static_cast<long long>(link->intervalUs));
+            return;
+        }
+
+        // Отклонение от ближайшего расчетного события
+        const int64_t interval = link->intervalUs;
+        int64_t error = (completionUs - plan.slotUs) % interval;
+        if (error > interval / 2)
+        {
+            error -= interval;
+        }
+        else if (error < -interval / 2)
+        {
+            error += interval;
+        }
+        const int64_t jitter = error < 0 ? -error : error;
+
+        // Малое отклонение сглаживается, большое - фаза сменилась (пропуск событий, уход)
+        if (jitter * 4 >= interval)
+        {
+            link->phaseUs = completionUs;
+            mRelocks.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            link->phaseUs = plan.slotUs + error / 4;
+        }
+
+        mObserved.fetch_add(1, std::memory_order_relaxed);
+        mTotalJitterUs.fetch_add(static_cast<uint64_t>(jitter), std::memory_order_relaxed);
+        updateMax(mMaxJitterUs, jitter);
+        const int64_t latency = std::max<int64_t>(completionUs - requestUs, 0);
+        mTotalLatencyUs.fetch_add(static_cast<uint64_t>(latency), std::memory_order_relaxed);
+        updateMax(mMaxLatencyUs, latency);
+    }
+
+    void BleSendScheduler::scheduleTask(void* arg)
+    {
+        auto* self = static_cast<BleSendScheduler*>(arg);
+        while (self->mRunning)
+        {
+            Plan plan = {};
+            bool ready;
+            {
+                std::lock_guard lock(self->mMutex);
+                ready = self->plan(esp_timer_get_time(), plan);
+            }
+
+            // Новое уведомление, смена параметров или остановка будят задачу для пересчета
+            if (!ready)
+            {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                continue;
+            }
+            if (!self->waitUntil(plan.releaseUs)) continue;
+            self->release(plan);
+        }
+
+        self->mTask = nullptr;
+        vTaskDelete(nullptr);
+    }
+
+    void BleSendScheduler::wake() const noexcept
+    {
+        if (const TaskHandle_t task = mTask.load(); task != nullptr)
+        {
+            xTaskNotifyGive(task);
+        }
+    }
+
+    void BleSendScheduler::timerCallback(void* arg)
+    {
+        static_cast<BleSendScheduler*>(arg)->wake();
+    }
+} // namespace net
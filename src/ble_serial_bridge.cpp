@@ -0,0 +1,244 @@
+#include "net/ble_serial_bridge.h"
+#include "net/ble_task.h"
+
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace net
+{
+    BleSerialBridge::BleSerialBridge(DataSender sender) :
+        mSender(std::move(sender))
+    {
+    }
+
+    BleSerialBridge::~BleSerialBridge()
+    {
+        stop();
+    }
+
+    esp_err_t BleSerialBridge::start(BleSerialPort& port, const BleSerialBridgeConfig& config)
+    {
+        if (mRunning) return ESP_ERR_INVALID_STATE;
+
+        if (const esp_err_t ret = port.open(); ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Port open failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+
+        mPort = &port;
+        mConfig = config;
+
+        // Буфер переживает остановку: BTC может дописывать в него после stop()
+        if (!mDownlink || mDownlink->capacity() < config.downlinkBufferSize)
+        {
+            mDownlink = std::make_unique<SpscByteRing>(config.downlinkBufferSize);
+        }
+        mDownlink->reset();
+
+        mRunning = true;
+        TaskHandle_t uplink = nullptr;
+        TaskHandle_t downlink = nullptr;
+        if (BleTask::create(uplinkTask, "ble_bridge_up", config.taskStack, this, config.taskPriority,
+                            config.taskCore, uplink) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Create uplink task failed");
+            mRunning = false;
+            port.close();
+            return ESP_ERR_NO_MEM;
+        }
+        mUplinkTask = uplink;
+
+        if (BleTask::create(downlinkTask, "ble_bridge_down", config.taskStack, this, config.taskPriority,
+                            config.taskCore, downlink) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Create downlink task failed");
+            stop();
+            return ESP_ERR_NO_MEM;
+        }
+        mDownlinkTask = downlink;
+
+        ESP_LOGI(TAG, "Bridge started (coalesce %lu ms, downlink buffer %u)",
+                 static_cast<unsigned long>(config.coalesceMs), static_cast<unsigned>(mDownlink->capacity()));
+        return ESP_OK;
+    }
+
+    void BleSerialBridge::stop()
+    {
+        if (!mRunning && mUplinkTask == nullptr && mDownlinkTask == nullptr) return;
+
+        // Задачи замечают остановку не позже idleWaitMs и удаляют себя сами
+        mRunning = false;
+        for (auto* task : {&mUplinkTask, &mDownlinkTask})
+        {
+            if (const auto handle = static_cast<TaskHandle_t>(task->load()); handle != nullptr)
+            {
+                xTaskNotifyGive(handle);
+            }
+        }
+        while (mUplinkTask != nullptr || mDownlinkTask != nullptr)
+        {
+            vTaskDelay(1);
+        }
+
+        if (mPort != nullptr)
+        {
+            mPort->close();
+            mPort = nullptr;
+        }
+        ESP_LOGI(TAG, "Bridge stopped");
+    }
+
+    void BleSerialBridge::handleConnect(const uint16_t connId) noexcept
+    {
+        int32_t expected = NO_PEER;
+        if (mPeer.compare_exchange_strong(expected, connId))
+        {
+            ESP_LOGI(TAG, "Bridge bound to conn %u", connId);
+            if (const auto task = static_cast<TaskHandle_t>(mUplinkTask.load()); task != nullptr)
+            {
+                xTaskNotifyGive(task);
+            }
+        }
+    }
+
+    void BleSerialBridge::handleDisconnect(const uint16_t connId) noexcept
+    {
+        int32_t expected = connId;
+        if (mPeer.compare_exchange_strong(expected, NO_PEER))
+        {
+            ESP_LOGI(TAG, "Bridge unbound from conn %u", connId);
+        }
+    }
+
+    void BleSerialBridge::setLinkMtu(const uint16_t mtu) noexcept
+    {
+        const size_t payload = mtu > 3 ? mtu - 3u : 20u;
+        mPayload = static_cast<uint16_t>(std::min(payload, MAX_PAYLOAD));
+    }
+
+    bool BleSerialBridge::handleWrite(const uint16_t connId, const uint8_t* data, const size_t len,
+                                      const bool needRsp) noexcept
+    {
+        if (!mRunning || !mDownlink || connId != mPeer.load()) return true;
+
+        // Запись не принимается частично: запись с ответом клиент повторит, Write Command
+        // отбрасывается целиком - обрезанная посередине команда порту бесполезна
+        if (mDownlink->capacity() - mDownlink->size() < len)
+        {
+            if (needRsp)
+            {
+                mDownlinkRejected.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            mDownlinkDropped.fetch_add(len, std::memory_order_relaxed);
+            mDownlinkDroppedWrites.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        mDownlink->write(data, len);
+        if (const auto task = static_cast<TaskHandle_t>(mDownlinkTask.load()); task != nullptr && len > 0)
+        {
+            xTaskNotifyGive(task);
+        }
+        return true;
+    }
+
+    BleSerialBridge::Statistics BleSerialBridge::getStatistics() const noexcept
+    {
+        return {
+            .uplinkBytes = mUplinkBytes.load(),
+            .uplinkNotifications = mUplinkNotifications.load(),
+            .uplinkStalls = mUplinkStalls.load(),
+            .uplinkDropped = mUplinkDropped.load(),
+            .downlinkBytes = mDownlinkBytes.load(),
+            .downlinkDropped = mDownlinkDropped.load(),
+            .downlinkDroppedWrites = mDownlinkDroppedWrites.load(),
+            .downlinkRejected = mDownlinkRejected.load(),
+        };
+    }
+
+    void BleSerialBridge::uplinkTask(void* arg)
+    {
+        auto* self = static_cast<BleSerialBridge*>(arg);
+        auto& buffer = self->mUplink;
+        size_t filled = 0;
+
+        while (self->mRunning)
+        {
+            const int32_t peer = self->mPeer.load();
+            if (peer == NO_PEER)
+            {
+                // Без соединения порт не читается: данные ждут в буфере UART под управлением потока
+                self->mUplinkDropped.fetch_add(filled, std::memory_order_relaxed);
+                filled = 0;
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(self->mConfig.idleWaitMs));
+                continue;
+            }
+
+            const size_t payload = self->mPayload.load();
+            if (filled == 0)
+            {
+                filled = self->mPort->read(buffer.data(), 1, self->mConfig.idleWaitMs);
+                if (filled == 0) continue;
+            }
+            if (filled < payload)
+            {
+                filled += self->mPort->read(buffer.data() + filled, payload - filled, self->mConfig.coalesceMs);
+            }
+
+            // MTU мог уменьшиться после чтения: остаток уходит следующим уведомлением
+            const size_t len = std::min(filled, payload);
+            const esp_err_t ret = self->mSender(static_cast<uint16_t>(peer), buffer.data(), len);
+            if (ret == ESP_ERR_TIMEOUT)
+            {
+                // Нет кредитов: тот же буфер уйдет повторно, порт пока не читается
+                self->mUplinkStalls.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            if (ret == ESP_OK)
+            {
+                self->mUplinkBytes.fetch_add(len, std::memory_order_relaxed);
+                self->mUplinkNotifications.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                self->mUplinkDropped.fetch_add(len, std::memory_order_relaxed);
+            }
+            std::memmove(buffer.data(), buffer.data() + len, filled - len);
+            filled -= len;
+        }
+
+        self->mUplinkTask = nullptr;
+        vTaskDelete(nullptr);
+    }
+
+    void BleSerialBridge::downlinkTask(void* arg)
+    {
+        auto* self = static_cast<BleSerialBridge*>(arg);
+
+        while (self->mRunning)
+        {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(self->mConfig.idleWaitMs));
+
+            // Запись в порт прямо из кольцевого буфера
+            for (auto data = self->mDownlink->peek(); !data.empty() && self->mRunning;
+                 data = self->mDownlink->peek())
+            {
+                const size_t written = self->mPort->write(data.data(), data.size(), self->mConfig.idleWaitMs);
+                self->mDownlink->consume(written);
+                self->mDownlinkBytes.fetch_add(written, std::memory_order_relaxed);
+                if (written == 0) break;
+            }
+        }
+
+        self->mDownlinkTask = nullptr;
+        vTaskDelete(nullptr);
+    }
+} // namespace net
@@ -0,0 +1,152 @@
+#include "net/ble_serial_port.h"
+
+#include "esp_log.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+
+namespace net
+{
+#ifdef ESP_PLATFORM
+    UartSerialPort::~UartSerialPort()
+    {
+        close();
+    }
+
+    esp_err_t UartSerialPort::open()
+    {
+        if (mOpen) return ESP_OK;
+
+        const bool rts = mConfig.rtsPin != UART_PIN_NO_CHANGE;
+        const bool cts = mConfig.ctsPin != UART_PIN_NO_CHANGE;
+        const uart_config_t uartConfig = {
+            .baud_rate = mConfig.baudRate,
+            .data_bits = UART_DATA_8_BITS,
+            .parity = UART_PARITY_DISABLE,
+            .stop_bits = UART_STOP_BITS_1,
+            .flow_ctrl = rts && cts ? UART_HW_FLOWCTRL_CTS_RTS
+                : rts ? UART_HW_FLOWCTRL_RTS
+                : cts ? UART_HW_FLOWCTRL_CTS
+                : UART_HW_FLOWCTRL_DISABLE,
+            .rx_flow_ctrl_thresh = mConfig.rxFlowThreshold,
+            .source_clk = UART_SCLK_DEFAULT,
+        };
+
+        esp_err_t ret = uart_param_config(mConfig.port, &uartConfig);
+        if (ret == ESP_OK)
+        {
+            ret = uart_set_pin(mConfig.port, mConfig.txPin, mConfig.rxPin, mConfig.rtsPin, mConfig.ctsPin);
+        }
+        if (ret == ESP_OK)
+        {
+            // Без буфера передачи: write() пишет в FIFO сам и ограничивает ожидание
+            ret = uart_driver_install(mConfig.port, mConfig.rxBufferSize, 0, 0, nullptr, 0);
+        }
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "UART%d setup failed: %s", mConfig.port, esp_err_to_name(ret));
+            return ret;
+        }
+
+        mOpen = true;
+        ESP_LOGI(TAG, "UART%d open: %d baud, flow control %s", mConfig.port, mConfig.baudRate,
+                 rts && cts ? "RTS/CTS" : rts ? "RTS" : cts ? "CTS" : "off");
+        return ESP_OK;
+    }
+
+    void UartSerialPort::close()
+    {
+        if (!mOpen) return;
+
+        uart_driver_delete(mConfig.port);
+        mOpen = false;
+    }
+
+    size_t UartSerialPort::read(uint8_t* data, const size_t len, const uint32_t timeoutMs)
+    {
+        if (!mOpen) return 0;
+
+        const int count = uart_read_bytes(mConfig.port, data, len, pdMS_TO_TICKS(timeoutMs));
+        return count > 0 ? static_cast<size_t>(count) : 0;
+    }
+
+    size_t UartSerialPort::write(const uint8_t* data, const size_t len, const uint32_t timeoutMs)
+    {
+        if (!mOpen) return 0;
+
+        // uart_write_bytes() ждет места в FIFO без ограничения (при снятом CTS - бесконечно):
+        // FIFO дозаполняется порциями, между ними - ожидание передачи с остатком таймаута
+        const TickType_t timeout = pdMS_TO_TICKS(timeoutMs);
+        const TickType_t start = xTaskGetTickCount();
+        size_t total = 0;
+        while (total < len)
+        {
+            const int count = uart_tx_chars(mConfig.port, reinterpret_cast<const char*>(data + total), len - total);
+            if (count < 0) break;
+            total += static_cast<size_t>(count);
+            if (total == len) break;
+
+            const TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= timeout || uart_wait_tx_done(mConfig.port, timeout - elapsed) != ESP_OK) break;
+        }
+        return total;
+    }
+#endif // ESP_PLATFORM
+
+    esp_err_t FdSerialPort::open()
+    {
+        return mReadFd >= 0 && mWriteFd >= 0 ? ESP_OK : ESP_ERR_INVALID_ARG;
+    }
+
+    size_t FdSerialPort::read(uint8_t* data, const size_t len, const uint32_t timeoutMs)
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+
+        size_t total = 0;
+        while (total < len)
+        {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+            pollfd fd = {.fd = mReadFd, .events = POLLIN, .revents = 0};
+            const int ready = poll(&fd, 1, left.count() > 0 ? static_cast<int>(left.count()) : 0);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready <= 0) break;
+
+            const ssize_t count = ::read(mReadFd, data + total, len - total);
+            if (count < 0 && errno == EINTR) continue;
+            if (count <= 0) break; // Конец потока или ошибка
+            total += static_cast<size_t>(count);
+        }
+        return total;
+    }
+
+    size_t FdSerialPort::write(const uint8_t* data, const size_t len, const uint32_t timeoutMs)
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+
+        size_t total = 0;
+        while (total < len)
+        {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+            pollfd fd = {.fd = mWriteFd, .events = POLLOUT, .revents = 0};
+            const int ready = poll(&fd, 1, left.count() > 0 ? static_cast<int>(left.count()) : 0);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready <= 0) break;
+
+            const ssize_t count = ::write(mWriteFd, data + total, len - total);
+            if (count < 0 && errno == EINTR) continue;
+            if (count <= 0) break;
+            total += static_cast<size_t>(count);
+        }
+        return total;
+    }
+} // namespace net
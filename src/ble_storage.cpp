@@ -0,0 +1,116 @@
+#include "net/ble_storage.h"
+
+#include "esp_log.h"
+
+#include <cstdio>
+#include <utility>
+
+namespace net
+{
+#ifdef ESP_PLATFORM
+    NvsKeyValueStore::NvsKeyValueStore(const char* nameSpace) :
+        mNameSpace(nameSpace)
+    {
+    }
+
+    NvsKeyValueStore::~NvsKeyValueStore()
+    {
+        if (mIsOpen)
+        {
+            nvs_close(mHandle);
+        }
+    }
+
+    esp_err_t NvsKeyValueStore::open()
+    {
+        if (mIsOpen) return ESP_OK;
+
+        const esp_err_t ret = nvs_open(mNameSpace, NVS_READWRITE, &mHandle);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "NVS open '%s' failed: %s", mNameSpace, esp_err_to_name(ret));
+            return ret;
+        }
+
+        mIsOpen = true;
+        return ESP_OK;
+    }
+
+    esp_err_t NvsKeyValueStore::read(const char* key, void* data, size_t& size)
+    {
+        if (const esp_err_t ret = open(); ret != ESP_OK) return ret;
+
+        const esp_err_t ret = nvs_get_blob(mHandle, key, data, &size);
+        return ret == ESP_ERR_NVS_NOT_FOUND ? ESP_ERR_NOT_FOUND : ret;
+    }
+
+    esp_err_t NvsKeyValueStore::write(const char* key, const void* data, const size_t size)
+    {
+        if (const esp_err_t ret = open(); ret != ESP_OK) return ret;
+        return nvs_set_blob(mHandle, key, data, size);
+    }
+
+    esp_err_t NvsKeyValueStore::erase(const char* key)
+    {
+        if (const esp_err_t ret = open(); ret != ESP_OK) return ret;
+
+        const esp_err_t ret = nvs_erase_key(mHandle, key);
+        return ret == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : ret;
+    }
+
+    esp_err_t NvsKeyValueStore::commit()
+    {
+        if (const esp_err_t ret = open(); ret != ESP_OK) return ret;
+        return nvs_commit(mHandle);
+    }
+#endif
+
+    FileKeyValueStore::FileKeyValueStore(std::string directory) :
+        mDirectory(std::move(directory))
+    {
+    }
+
+    std::string FileKeyValueStore::pathFor(const char* key) const
+    {
+        return mDirectory + "/" + key + ".bin";
+    }
+
+    esp_err_t FileKeyValueStore::read(const char* key, void* data, size_t& size)
+    {
+        FILE* file = fopen(pathFor(key).c_str(), "rb");
+        if (file == nullptr)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        size = fread(data, 1, size, file);
+        const bool failed = ferror(file) != 0;
+        fclose(file);
+        return failed ? ESP_FAIL : ESP_OK;
+    }
+
+    esp_err_t FileKeyValueStore::write(const char* key, const void* data, const size_t size)
+    {
+        FILE* file = fopen(pathFor(key).c_str(), "wb");
+        if (file == nullptr)
+        {
+            ESP_LOGE(TAG, "Open '%s' for write failed", key);
+            return ESP_FAIL;
+        }
+
+        const size_t written = fwrite(data, 1, size, file);
+        fclose(file);
+        return written == size ? ESP_OK : ESP_FAIL;
+    }
+
+    esp_err_t FileKeyValueStore::erase(const char* key)
+    {
+        remove(pathFor(key).c_str());
+        return ESP_OK;
+    }
+
+    esp_err_t FileKeyValueStore::commit()
+    {
+        return ESP_OK;
+    }
+} // namespace net
@@ -0,0 +1,55 @@
+#include "net/ble_task.h"
+
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+namespace net
+{
+    BaseType_t BleTask::stackCore() noexcept
+    {
+#ifdef CONFIG_BT_BLUEDROID_PINNED_TO_CORE
+        return CONFIG_BT_BLUEDROID_PINNED_TO_CORE;
+#else
+        return 0;
+#endif
+    }
+
+    BaseType_t BleTask::resolveCore(const int8_t core) noexcept
+    {
+#if defined(CONFIG_FREERTOS_UNICORE) || portNUM_PROCESSORS == 1
+        (void)core;
+        return tskNO_AFFINITY;
+#else
+        if (core == CORE_AUTO) return stackCore() == 0 ? 1 : 0;
+        if (core == CORE_ANY) return tskNO_AFFINITY;
+        if (core < 0 || core >= portNUM_PROCESSORS)
+        {
+            ESP_LOGW(TAG, "No core %d, task is not pinned", core);
+            return tskNO_AFFINITY;
+        }
+        return core;
+#endif
+    }
+
+    esp_err_t BleTask::create(const TaskFunction_t function, const char* name, const uint32_t stack, void* arg,
+                              const UBaseType_t priority, const int8_t core, TaskHandle_t& handle) noexcept
+    {
+        const BaseType_t coreId = resolveCore(core);
+        if (xTaskCreatePinnedToCore(function, name, stack, arg, priority, &handle, coreId) != pdPASS)
+        {
+            handle = nullptr;
+            return ESP_ERR_NO_MEM;
+        }
+
+        if (coreId == tskNO_AFFINITY)
+        {
+            ESP_LOGD(TAG, "Task %s: priority %u, any core", name, static_cast<unsigned>(priority));
+        }
+        else
+        {
+            ESP_LOGD(TAG, "Task %s: priority %u, core %d", name, static_cast<unsigned>(priority),
+                     static_cast<int>(coreId));
+        }
+        return ESP_OK;
+    }
+} // namespace net
@@ -0,0 +1,85 @@
+#include "net/ble_trace.h"
+
+#include "esp_timer.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+namespace net
+{
+    void BleTrace::record(const BleTraceKind kind, const uint8_t code, const uint16_t connId,
+                          const uint32_t arg) noexcept
+    {
+        if (!mEnabled.load(std::memory_order_relaxed)) return;
+
+        const uint32_t index = mHead.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = mSlots[index & (CAPACITY - 1)];
+
+        // Читатель не примет слот, пока номер не опубликован заново
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.entry = {
+            .timeUs = static_cast<uint32_t>(esp_timer_get_time()),
+            .connId = connId,
+            .kind = static_cast<uint8_t>(kind),
+            .code = code,
+            .arg = arg
+        };
+        slot.seq.store(index + 1, std::memory_order_release);
+    }
+
+    bool BleTrace::read(const uint32_t index, BleTraceEntry& entry) const noexcept
+    {
+        const Slot& slot = mSlots[index & (CAPACITY - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != index + 1) return false;
+
+        entry = slot.entry;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == index + 1;
+    }
+
+    size_t BleTrace::snapshot(const std::span<BleTraceEntry> out) const noexcept
+    {
+        const uint32_t head = mHead.load(std::memory_order_acquire);
+        const uint32_t available = head < CAPACITY ? head : CAPACITY;
+        const uint32_t count = available < out.size() ? available : static_cast<uint32_t>(out.size());
+
+        size_t copied = 0;
+        for (uint32_t index = head - count; index != head; index++)
+        {
+            if (read(index, out[copied]))
+            {
+                copied++;
+            }
+        }
+        return copied;
+    }
+
+    void BleTrace::dump() const
+    {
+        const uint32_t head = mHead.load(std::memory_order_acquire);
+        const uint32_t count = head < CAPACITY ? head : CAPACITY;
+
+        // printf, а не ESP_LOG: строки разбирает конвертер, префикс лога ему мешает
+        printf("BLETRACE BEGIN %u %" PRIu32 " %" PRId64 "\n", FORMAT_VERSION, count, esp_timer_get_time());
+        for (uint32_t index = head - count; index != head; index++)
+        {
+            BleTraceEntry entry;
+            if (!read(index, entry)) continue;
+
+            printf("BLETRACE %08" PRIx32 " %08" PRIx32 " %02x %02x %04x %08" PRIx32 "\n",
+                   index, entry.timeUs, entry.kind, entry.code, entry.connId, entry.arg);
+        }
+        printf("BLETRACE END\n");
+        fflush(stdout);
+    }
+
+    void BleTrace::clear() noexcept
+    {
+        for (Slot& slot : mSlots)
+        {
+            slot.seq.store(0, std::memory_order_relaxed);
+        }
+        mHead.store(0, std::memory_order_release);
+    }
+} // namespace net
@@ -0,0 +1,66 @@
+#include "net/ble_tx_scheduler.h"
+
+#include "esp_gap_ble_api.h"
+#include "esp_log.h"
+
+#include "freertos/task.h"
+
+namespace net
+{
+    esp_err_t BleTxScheduler::acquire(const uint16_t connId, const TickType_t timeout) noexcept
+    {
+        if (esp_ble_get_cur_sendable_packets_num(connId) > 0)
+        {
+            return ESP_OK;
+        }
+
+        mCreditWaits.fetch_add(1, std::memory_order_relaxed);
+
+        // Кредиты возвращаются по Number Of Completed Packets, событие не публикуется
+        // наружу, поэтому ожидание - опрос с шагом в один тик
+        const TickType_t start = xTaskGetTickCount();
+        while (esp_ble_get_cur_sendable_packets_num(connId) == 0)
+        {
+            if (xTaskGetTickCount() - start >= timeout)
+            {
+                mCreditTimeouts.fetch_add(1, std::memory_order_relaxed);
+                ESP_LOGD(TAG, "No TX credits for conn %u", connId);
+                return ESP_ERR_TIMEOUT;
+            }
+            vTaskDelay(1);
+        }
+        return ESP_OK;
+    }
+
+    void BleTxScheduler::complete(const size_t bytes, const esp_err_t result) noexcept
+    {
+        if (result != ESP_OK)
+        {
+            mErrors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        mPackets.fetch_add(1, std::memory_order_relaxed);
+        mBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    BleTxScheduler::Statistics BleTxScheduler::getStatistics() const noexcept
+    {
+        return {
+            .packets = mPackets.load(),
+            .bytes = mBytes.load(),
+            .creditWaits = mCreditWaits.load(),
+            .creditTimeouts = mCreditTimeouts.load(),
+            .errors = mErrors.load(),
+        };
+    }
+
+    void BleTxScheduler::resetStatistics() noexcept
+    {
+        mPackets = 0;
+        mBytes = 0;
+        mCreditWaits = 0;
+        mCreditTimeouts = 0;
+        mErrors = 0;
+    }
+} // namespace net
@@ -0,0 +1,128 @@
+#include "net/ble_value_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace net
+{
+    esp_err_t BleValueCache::update(const uint8_t* data, const size_t len) noexcept
+    {
+        if (len > MAX_VALUE || (data == nullptr && len != 0)) return ESP_ERR_INVALID_SIZE;
+        if (mWriting.test_and_set(std::memory_order_acquire)) return ESP_ERR_INVALID_STATE;
+
+        // Запись идет в неактивный слот: читатели опубликованного значения не мешают
+        const uint32_t next = mVersion.load(std::memory_order_relaxed) + 1;
+        Slot& slot = mSlots[next & 1];
+
+        slot.version.store(WRITING, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        if (len != 0)
+        {
+            std::memcpy(slot.data.data(), data, len);
+        }
+        slot.len = static_cast<uint16_t>(len);
+        slot.version.store(next, std::memory_order_release);
+        mVersion.store(next, std::memory_order_release);
+
+        mWriting.clear(std::memory_order_release);
+        return ESP_OK;
+    }
+
+    esp_err_t BleValueCache::read(const std::span<uint8_t> out, size_t& len, uint32_t& version) const noexcept
+    {
+        for (size_t attempt = 0; attempt < MAX_READ_RETRIES; attempt++)
+        {
+            const uint32_t current = mVersion.load(std::memory_order_acquire);
+            const Slot& slot = mSlots[current & 1];
+            if (slot.version.load(std::memory_order_acquire) != current) continue;
+
+            const size_t size = slot.len;
+            if (size > out.size()) return ESP_ERR_INVALID_SIZE;
+            std::memcpy(out.data(), slot.data.data(), size);
+
+            // Слот перезаписан во время копирования: производитель обогнал на два значения
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.version.load(std::memory_order_relaxed) != current) continue;
+
+            len = size;
+            version = current;
+            return ESP_OK;
+        }
+        return ESP_ERR_TIMEOUT;
+    }
+
+    esp_gatt_status_t BleValueCache::serveRead(const uint16_t connId, const uint16_t offset, const bool isLong,
+                                               const uint16_t mtu, esp_gatt_rsp_t& rsp) noexcept
+    {
+        uint8_t* const value = rsp.attr_value.value;
+        const size_t chunk = mtu > 1 ? mtu - 1u : 0u;
+        Reader* reader = findReader(connId);
+
+        size_t len = 0;
+        const uint8_t* source = value;
+        if (isLong && reader != nullptr)
+        {
+            // Продолжение длинного чтения: фрагменты из снимка первого запроса
+            len = reader->len;
+            source = reader->data.data();
+        }
+        else
+        {
+            uint32_t version = 0;
+            if (read({value, ESP_GATT_MAX_ATTR_LEN}, len, version) != ESP_OK) return ESP_GATT_BUSY;
+
+            if (len > chunk)
+            {
+                // Значение не помещается в один ответ: снимок для последующих Read Blob.
+                // Без свободного слота фрагменты читаются из текущего значения
+                if (reader == nullptr)
+                {
+                    reader = findReader(NO_CONN);
+                }
+                if (reader != nullptr)
+                {
+                    reader->connId = connId;
+                    reader->len = static_cast<uint16_t>(len);
+                    std::memcpy(reader->data.data(), value, len);
+                }
+            }
+            else if (reader != nullptr)
+            {
+                reader->connId = NO_CONN;
+            }
+        }
+
+        if (offset > len) return ESP_GATT_INVALID_OFFSET;
+
+        const size_t size = std::min(len - offset, chunk);
+        std::memmove(value, source + offset, size);
+        rsp.attr_value.offset = offset;
+        rsp.attr_value.len = static_cast<uint16_t>(size);
+        return ESP_GATT_OK;
+    }
+
+    void BleValueCache::releaseReader(const uint16_t connId) noexcept
+    {
+        if (Reader* reader = findReader(connId); reader != nullptr)
+        {
+            reader->connId = NO_CONN;
+        }
+    }
+
+    void BleValueCache::releaseReaders() noexcept
+    {
+        for (Reader& reader : mReaders)
+        {
+            reader.connId = NO_CONN;
+        }
+    }
+
+    BleValueCache::Reader* BleValueCache::findReader(const uint16_t connId) noexcept
+    {
+        const auto it = std::ranges::find_if(mReaders, [connId](const Reader& reader)
+        {
+            return reader.connId == connId;
+        });
+        return it != mReaders.end() ? &*it : nullptr;
+    }
+} // namespace net
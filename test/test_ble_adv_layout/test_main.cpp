@@ -0,0 +1,177 @@
+/**
+ * @file test_main.cpp
+ * @brief Тесты раскладки рекламы BleAdvLayout: формы UUID, размещение и сокращение имени
+ */
+
+#include "net/ble_adv_layout.h"
+
+#include <unity.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+using net::BleAdvLayout;
+using net::BleUuid;
+using namespace net::uuid_literals;
+
+namespace
+{
+    constexpr uint8_t FLAGS = 0x06;
+    constexpr BleUuid NUS = "6E400001-B5A3-F393-E0A9-E50E24DCCA9E"_uuid;
+
+    BleAdvLayout::Input legacyInput(const std::string_view name, const BleUuid& uuid)
+    {
+        return {
+            .flags = FLAGS,
+            .name = name,
+            .serviceUuid = uuid,
+            .invertBytes = true,
+            .advCapacity = BleAdvLayout::LEGACY_DATA_MAX,
+            .scanRspCapacity = BleAdvLayout::LEGACY_DATA_MAX
+        };
+    }
+
+    /**
+     * @brief Значение AD структуры заданного типа (пустой span - структуры нет)
+     */
+    std::span<const uint8_t> findAd(const BleAdvLayout::Payload& payload, const uint8_t type)
+    {
+        for (size_t pos = 0; pos + 1 < payload.size; pos += payload.data[pos] + 1)
+        {
+            if (payload.data[pos + 1] == type) return {&payload.data[pos + 2], payload.data[pos] - 1u};
+        }
+        return {};
+    }
+} // namespace
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_short_name_fits_advertising()
+{
+    const BleAdvLayout::Plan plan = BleAdvLayout::plan(legacyInput("Node", BleUuid::from16(0x180F)));
+
+    const uint8_t expected[] = {2, BleAdvLayout::AD_FLAGS, FLAGS,
+                                3, BleAdvLayout::AD_UUID16_COMPLETE, 0x0F, 0x18,
+                                5, BleAdvLayout::AD_NAME_COMPLETE, 'N', 'o', 'd', 'e'};
+    TEST_ASSERT_EQUAL(sizeof(expected), plan.adv.size);
+    TEST_ASSERT_EQUAL_MEMORY(expected, plan.adv.data.data(), sizeof(expected));
+    TEST_ASSERT_EQUAL(0, plan.scanRsp.size);
+    TEST_ASSERT_TRUE(plan.uuid == BleAdvLayout::Placement::ADV);
+    TEST_ASSERT_TRUE(plan.name == BleAdvLayout::Placement::ADV);
+    TEST_ASSERT_TRUE(plan.shortName == BleAdvLayout::Placement::NONE);
+}
+
+static void test_base_uuid_compacted()
+{
+    std::array<uint8_t, ESP_UUID_LEN_128> out = {};
+    TEST_ASSERT_EQUAL(ESP_UUID_LEN_16,
+                      BleAdvLayout::compactUuid("0000180F-0000-1000-8000-00805F9B34FB"_uuid, true, out));
+    TEST_ASSERT_EQUAL_HEX8(0x0F, out[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x18, out[1]);
+
+    TEST_ASSERT_EQUAL(ESP_UUID_LEN_32,
+                      BleAdvLayout::compactUuid("1234ABCD-0000-1000-8000-00805F9B34FB"_uuid, true, out));
+    const uint8_t uuid32[] = {0xCD, 0xAB, 0x34, 0x12};
+    TEST_ASSERT_EQUAL_MEMORY(uuid32, out.data(), sizeof(uuid32));
+
+    // Собственный 128-бит UUID передается целиком, порядок байт - как при регистрации сервиса
+    TEST_ASSERT_EQUAL(ESP_UUID_LEN_128, BleAdvLayout::compactUuid(NUS, true, out));
+    TEST_ASSERT_EQUAL_HEX8(0x9E, out[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x6E, out[15]);
+    TEST_ASSERT_EQUAL(ESP_UUID_LEN_128, BleAdvLayout::compactUuid(NUS, false, out));
+    TEST_ASSERT_EQUAL_HEX8(0x6E, out[0]);
+
+    TEST_ASSERT_EQUAL(0, BleAdvLayout::compactUuid(BleUuid(), true, out));
+}
+
+static void test_long_name_moves_to_scan_response()
+{
+    // Флаги и 128-бит UUID занимают 21 байт: полное имя уходит в scan response,
+    // в рекламном пакете остается его начало
+    constexpr std::string_view name = "Greenhouse sensor 42";
+    const BleAdvLayout::Plan plan = BleAdvLayout::plan(legacyInput(name, NUS));
+
+    TEST_ASSERT_TRUE(plan.uuid == BleAdvLayout::Placement::ADV);
+    TEST_ASSERT_EQUAL(ESP_UUID_LEN_128, plan.uuidLength);
+    TEST_ASSERT_TRUE(plan.name == BleAdvLayout::Placement::SCAN_RSP);
+    TEST_ASSERT_TRUE(plan.shortName == BleAdvLayout::Placement::ADV);
+    TEST_ASSERT_EQUAL(8, plan.shortNameLength);
+    TEST_ASSERT_EQUAL(BleAdvLayout::LEGACY_DATA_MAX, plan.adv.size);
+
+    const std::span<const uint8_t> complete = findAd(plan.scanRsp, BleAdvLayout::AD_NAME_COMPLETE);
+    TEST_ASSERT_EQUAL(name.size(), complete.size());
+    TEST_ASSERT_EQUAL_MEMORY(name.data(), complete.data(), name.size());
+    const std::span<const uint8_t> shortName = findAd(plan.adv, BleAdvLayout::AD_NAME_SHORT);
+    TEST_ASSERT_EQUAL(8, shortName.size());
+    TEST_ASSERT_EQUAL_MEMORY(name.data(), shortName.data(), 8);
+    TEST_ASSERT_EQUAL(0, findAd(plan.scanRsp, BleAdvLayout::AD_FLAGS).size());
+}
+
+static void test_oversized_name_shortened_on_utf8_boundary()
+{
+    // 15 двухбайтовых символов (30 байт) не помещаются ни в один пакет: в scan response
+    // остается 29 байт, сокращение не разрезает последний символ
+    std::string name;
+    for (int i = 0; i < 15; i++) name += "\xD0\x94";
+    const BleAdvLayout::Plan plan = BleAdvLayout::plan(legacyInput(name, NUS));
+
+    TEST_ASSERT_TRUE(plan.name == BleAdvLayout::Placement::NONE);
+    TEST_ASSERT_TRUE(plan.shortName == BleAdvLayout::Placement::SCAN_RSP);
+    TEST_ASSERT_EQUAL(28, plan.shortNameLength);
+    TEST_ASSERT_EQUAL_MEMORY(name.data(), findAd(plan.scanRsp, BleAdvLayout::AD_NAME_SHORT).data(), 28);
+
+    TEST_ASSERT_EQUAL(0, BleAdvLayout::utf8Prefix("\xE2\x82\xAC", 2));
+    TEST_ASSERT_EQUAL(1, BleAdvLayout::utf8Prefix("A\xE2\x82\xAC", 3));
+    TEST_ASSERT_EQUAL(4, BleAdvLayout::utf8Prefix("A\xE2\x82\xAC", 10));
+}
+
+static void test_non_scannable_drops_what_does_not_fit()
+{
+    // Без scan response 128-бит UUID и имя делят 28 байт рекламного пакета
+    BleAdvLayout::Input input = legacyInput("Greenhouse sensor 42", NUS);
+    input.scanRspCapacity = 0;
+    const BleAdvLayout::Plan plan = BleAdvLayout::plan(input);
+    TEST_ASSERT_EQUAL(0, plan.scanRsp.size);
+    TEST_ASSERT_TRUE(plan.uuid == BleAdvLayout::Placement::ADV);
+    TEST_ASSERT_TRUE(plan.shortName == BleAdvLayout::Placement::ADV);
+    TEST_ASSERT_EQUAL(8, plan.shortNameLength);
+
+    // UUID, не помещающийся никуда, пропускается
+    input.advCapacity = 12;
+    const BleAdvLayout::Plan tight = BleAdvLayout::plan(input);
+    TEST_ASSERT_TRUE(tight.uuid == BleAdvLayout::Placement::NONE);
+    TEST_ASSERT_EQUAL(0, tight.uuidLength);
+    TEST_ASSERT_LESS_OR_EQUAL(12, tight.adv.size);
+}
+
+static void test_extended_capacity_keeps_everything_in_advertising()
+{
+    BleAdvLayout::Input input = legacyInput("Greenhouse sensor 42", NUS);
+    input.advCapacity = 255;
+    input.scanRspCapacity = 0;
+    const BleAdvLayout::Plan plan = BleAdvLayout::plan(input);
+
+    TEST_ASSERT_TRUE(plan.uuid == BleAdvLayout::Placement::ADV);
+    TEST_ASSERT_TRUE(plan.name == BleAdvLayout::Placement::ADV);
+    TEST_ASSERT_TRUE(plan.shortName == BleAdvLayout::Placement::NONE);
+    TEST_ASSERT_EQUAL(3 + 18 + 22, plan.adv.size);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_short_name_fits_advertising);
+    RUN_TEST(test_base_uuid_compacted);
+    RUN_TEST(test_long_name_moves_to_scan_response);
+    RUN_TEST(test_oversized_name_shortened_on_utf8_boundary);
+    RUN_TEST(test_non_scannable_drops_what_does_not_fit);
+    RUN_TEST(test_extended_capacity_keeps_everything_in_advertising);
+    return UNITY_END();
+}
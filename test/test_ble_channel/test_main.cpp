@@ -0,0 +1,256 @@
+/**
+ * @file test_main.cpp
+ * @brief Тесты транспорта каналов: сегментация SDU, кредиты, callback'и без мьютекса
+ * @details Два транспорта соединены напрямую: фрейм одного сразу передается в handleFrame()
+ *          другого. Фреймы дополнительно записываются для проверки сегментации.
+ */
+
+#include "net/ble_channel.h"
+
+#include <unity.h>
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using net::BleChannelTransport;
+
+namespace
+{
+    constexpr uint16_t CONN_ID = 1;
+    constexpr uint16_t PSM = 0x0080;
+
+    /**
+     * @brief Callback, сохраняющий принятые SDU
+     */
+    class SduCollector : public esp32_c3::objects::Callback
+    {
+    public:
+        explicit SduCollector(std::vector<std::vector<uint8_t>>& sdus) :
+            mSdus(sdus)
+        {
+        }
+
+        void invoke(void* data) override
+        {
+            const auto* packet = static_cast<Packet*>(data);
+            mSdus.emplace_back(packet->buffer.begin(), packet->buffer.begin() + packet->size);
+            if (onSdu) onSdu(*packet);
+        }
+
+        std::function<void(const Packet&)> onSdu;
+
+    private:
+        std::vector<std::vector<uint8_t>>& mSdus;
+    };
+
+    /**
+     * @brief Пара транспортов, соединенных напрямую
+     */
+    struct Link
+    {
+        std::unique_ptr<BleChannelTransport> device;
+        std::unique_ptr<BleChannelTransport> client;
+        std::vector<std::vector<uint8_t>> deviceFrames; ///< Фреймы устройства клиенту
+        std::vector<std::vector<uint8_t>> deviceSdus;   ///< SDU, принятые устройством
+        std::vector<std::vector<uint8_t>> clientSdus;   ///< SDU, принятые клиентом
+        SduCollector* deviceCallback = nullptr;
+        SduCollector* clientCallback = nullptr;
+        bool dropCredits = false; ///< Клиент не возвращает кредиты устройству
+
+        explicit Link(const uint16_t linkMtu, const uint16_t credits = 8)
+        {
+            device = std::make_unique<BleChannelTransport>(
+                [this](const uint16_t connId, const uint8_t* data, const size_t len, bool)
+                {
+                    deviceFrames.emplace_back(data, data + len);
+                    client->handleFrame(connId, data, len);
+                    return ESP_OK;
+                });
+            client = std::make_unique<BleChannelTransport>(
+                [this](const uint16_t connId, const uint8_t* data, const size_t len, bool)
+                {
+                    if (dropCredits && data[0] == BleChannelTransport::FRAME_CREDIT) return ESP_OK;
+                    device->handleFrame(connId, data, len);
+                    return ESP_OK;
+                });
+            device->setLinkMtu(linkMtu);
+            client->setLinkMtu(linkMtu);
+
+            auto deviceCb = std::make_unique<SduCollector>(deviceSdus);
+            auto clientCb = std::make_unique<SduCollector>(clientSdus);
+            deviceCallback = deviceCb.get();
+            clientCallback = clientCb.get();
+            const BleChannelTransport::PsmConfig config = {.sduMtu = MAX_MTU, .initialCredits = credits};
+            device->registerPsm(PSM, config, std::move(deviceCb));
+            client->registerPsm(PSM, config, std::move(clientCb));
+        }
+    };
+
+    std::vector<uint8_t> pattern(const size_t len)
+    {
+        std::vector<uint8_t> data(len);
+        for (size_t i = 0; i < len; i++) data[i] = static_cast<uint8_t>(i * 7 + 3);
+        return data;
+    }
+} // namespace
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_connect_reports_both_sides()
+{
+    Link link(247);
+    int deviceOpen = 0;
+    int clientOpen = 0;
+    link.device->setChannelEventHandler([&](uint16_t, uint16_t psm, const bool connected)
+    {
+        if (psm == PSM) deviceOpen += connected ? 1 : -1;
+    });
+    link.client->setChannelEventHandler([&](uint16_t, uint16_t psm, const bool connected)
+    {
+        if (psm == PSM) clientOpen += connected ? 1 : -1;
+    });
+
+    TEST_ASSERT_EQUAL(ESP_OK, link.client->connectChannel(CONN_ID, PSM));
+    TEST_ASSERT_EQUAL(1, deviceOpen);
+    TEST_ASSERT_EQUAL(1, clientOpen);
+
+    BleChannelTransport::ChannelStatistics stats;
+    TEST_ASSERT_EQUAL(ESP_OK, link.device->getStatistics(CONN_ID, PSM, stats));
+    TEST_ASSERT_EQUAL_UINT16(8, stats.localCredits);
+
+    TEST_ASSERT_EQUAL(ESP_OK, link.device->closeChannel(CONN_ID, PSM));
+    TEST_ASSERT_EQUAL(0, deviceOpen);
+    TEST_ASSERT_EQUAL(0, clientOpen);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, link.client->getStatistics(CONN_ID, PSM, stats));
+}
+
+static void test_connect_to_unregistered_psm_fails()
+{
+    Link link(247);
+    link.device->unregisterPsm(PSM);
+    TEST_ASSERT_EQUAL(ESP_OK, link.client->connectChannel(CONN_ID, PSM));
+
+    BleChannelTransport::ChannelStatistics stats;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, link.client->getStatistics(CONN_ID, PSM, stats));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, link.client->connectChannel(CONN_ID, 0x0081));
+}
+
+static void test_segmentation_round_trip()
+{
+    for (const uint16_t linkMtu : {23, 64, 247, 512})
+    {
+        Link link(linkMtu);
+        TEST_ASSERT_EQUAL(ESP_OK, link.client->connectChannel(CONN_ID, PSM));
+
+        // Первый фрейм несет длину SDU: [тип][PSM][длина][сегмент], остальные - [тип][PSM][сегмент]
+        const size_t maxFrame = linkMtu - BleChannelTransport::ATT_HEADER;
+        const size_t firstSegment = maxFrame - BleChannelTransport::FRAME_HEADER - 2;
+        const size_t nextSegment = maxFrame - BleChannelTransport::FRAME_HEADER;
+
+        uint32_t sent = 0;
+        for (const size_t len : {size_t{1}, firstSegment, firstSegment + 1, firstSegment + nextSegment,
+                                 size_t{MAX_MTU}})
+        {
+            if (len > MAX_MTU) continue;
+
+            const std::vector<uint8_t> sdu = pattern(len);
+            link.deviceFrames.clear();
+            link.clientSdus.clear();
+            TEST_ASSERT_EQUAL(ESP_OK, link.device->sendSdu(CONN_ID, PSM, sdu.data(), len, pdMS_TO_TICKS(10)));
+
+            TEST_ASSERT_EQUAL(1, link.clientSdus.size());
+            TEST_ASSERT_EQUAL(len, link.clientSdus[0].size());
+            TEST_ASSERT_EQUAL_MEMORY(sdu.data(), link.clientSdus[0].data(), len);
+
+            const size_t expectedFrames = len <= firstSegment ?
+                1 : 1 + (len - firstSegment + nextSegment - 1) / nextSegment;
+            TEST_ASSERT_EQUAL(expectedFrames, link.deviceFrames.size());
+            for (const auto& frame : link.deviceFrames)
+            {
+                TEST_ASSERT_EQUAL(BleChannelTransport::FRAME_DATA, frame[0]);
+                TEST_ASSERT_LESS_OR_EQUAL(maxFrame, frame.size());
+            }
+            TEST_ASSERT_EQUAL(len & 0xFF, link.deviceFrames[0][3]);
+            TEST_ASSERT_EQUAL(len >> 8, link.deviceFrames[0][4]);
+            sent++;
+        }
+
+        BleChannelTransport::ChannelStatistics stats;
+        TEST_ASSERT_EQUAL(ESP_OK, link.device->getStatistics(CONN_ID, PSM, stats));
+        TEST_ASSERT_EQUAL_UINT32(sent, stats.txSdus);
+        TEST_ASSERT_EQUAL_UINT32(0, stats.creditStalls);
+    }
+}
+
+static void test_sdu_larger_than_remote_mtu_rejected()
+{
+    Link link(247);
+    TEST_ASSERT_EQUAL(ESP_OK, link.client->connectChannel(CONN_ID, PSM));
+    const std::vector<uint8_t> sdu = pattern(MAX_MTU + 1);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, link.device->sendSdu(CONN_ID, PSM, sdu.data(), sdu.size(), 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, link.device->sendSdu(CONN_ID, 0x0081, sdu.data(), 10, 1));
+}
+
+static void test_credit_exhaustion_times_out()
+{
+    Link link(23, 4);
+    link.dropCredits = true;
+    TEST_ASSERT_EQUAL(ESP_OK, link.client->connectChannel(CONN_ID, PSM));
+    link.deviceFrames.clear();
+
+    // 4 кредита: SDU из 10 фреймов упирается в ожидание возврата
+    const std::vector<uint8_t> sdu = pattern(150);
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, link.device->sendSdu(CONN_ID, PSM, sdu.data(), sdu.size(), pdMS_TO_TICKS(20)));
+    TEST_ASSERT_EQUAL(4, link.deviceFrames.size());
+
+    BleChannelTransport::ChannelStatistics stats;
+    TEST_ASSERT_EQUAL(ESP_OK, link.device->getStatistics(CONN_ID, PSM, stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.creditStalls);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.localCredits);
+}
+
+static void test_callbacks_may_reenter_transport()
+{
+    Link link(247);
+    TEST_ASSERT_EQUAL(ESP_OK, link.client->connectChannel(CONN_ID, PSM));
+
+    // Эхо из callback SDU: отправка в обратную сторону из обработчика приема
+    link.clientCallback->onSdu = [&link](const Packet& packet)
+    {
+        link.client->sendSdu(packet.id, PSM, packet.buffer.data(), packet.size, pdMS_TO_TICKS(10));
+    };
+    // Закрытие канала из обработчика приема
+    link.deviceCallback->onSdu = [&link](const Packet& packet)
+    {
+        link.device->closeChannel(packet.id, PSM);
+    };
+
+    const std::vector<uint8_t> sdu = pattern(300);
+    TEST_ASSERT_EQUAL(ESP_OK, link.device->sendSdu(CONN_ID, PSM, sdu.data(), sdu.size(), pdMS_TO_TICKS(10)));
+    TEST_ASSERT_EQUAL(1, link.deviceSdus.size());
+    TEST_ASSERT_EQUAL_MEMORY(sdu.data(), link.deviceSdus[0].data(), sdu.size());
+
+    BleChannelTransport::ChannelStatistics stats;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, link.device->getStatistics(CONN_ID, PSM, stats));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, link.client->getStatistics(CONN_ID, PSM, stats));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_connect_reports_both_sides);
+    RUN_TEST(test_connect_to_unregistered_psm_fails);
+    RUN_TEST(test_segmentation_round_trip);
+    RUN_TEST(test_sdu_larger_than_remote_mtu_rejected);
+    RUN_TEST(test_credit_exhaustion_times_out);
+    RUN_TEST(test_callbacks_may_reenter_transport);
+    return UNITY_END();
+}
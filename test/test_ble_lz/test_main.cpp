@@ -0,0 +1,212 @@
+/**
+ * @file test_main.cpp
+ * @brief Тесты кодека LZSS: кадры с общим окном, несжимаемые данные, поврежденный ввод
+ * @details Кодер и декодер ведут окно независимо: каждый кадр проходит compress() и commit()
+ *          у отправителя и decompress() или store() у получателя, как в BleCompression.
+ */
+
+#include "net/ble_lz.h"
+
+#include <unity.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using net::BleLz;
+using net::BleLzDecoder;
+using net::BleLzEncoder;
+
+namespace
+{
+    constexpr size_t MAX_FRAME = 512;
+
+    /**
+     * @brief Кадр телеметрии: постоянный заголовок, счетчик и медленно меняющиеся значения
+     */
+    std::vector<uint8_t> telemetry(const uint32_t index, const size_t len)
+    {
+        std::vector<uint8_t> data(len);
+        for (size_t i = 0; i < len; i++) data[i] = static_cast<uint8_t>("sensor;temp=21.5;hum=40;"[i % 24]);
+        std::memcpy(data.data(), &index, std::min(sizeof(index), len));
+        return data;
+    }
+
+    std::vector<uint8_t> random(const size_t len, const uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::vector<uint8_t> data(len);
+        for (auto& byte : data) byte = static_cast<uint8_t>(rng());
+        return data;
+    }
+
+    /**
+     * @brief Пара кодер-декодер с одинаковым окном
+     */
+    struct Codec
+    {
+        BleLzEncoder encoder;
+        BleLzDecoder decoder;
+        std::vector<uint8_t> packed;
+
+        explicit Codec(const uint8_t windowBits) :
+            encoder(windowBits, MAX_FRAME), decoder(windowBits, MAX_FRAME)
+        {
+        }
+
+        /**
+         * @brief Кадр через кодер и декодер; при несжимаемых данных - передача как есть
+         * @return size_t Размер переданного кадра
+         */
+        size_t roundTrip(const std::vector<uint8_t>& frame, std::vector<uint8_t>& received)
+        {
+            packed.assign(BleLz::maxCompressedSize(frame.size()), 0);
+            const size_t len = encoder.compress(frame.data(), frame.size(), packed.data(), frame.size());
+            encoder.commit();
+
+            std::span<const uint8_t> out;
+            const bool ok = len != 0
+                ? decoder.decompress(packed.data(), len, out)
+                : decoder.store(frame.data(), frame.size(), out);
+            received.assign(out.begin(), out.end());
+            return ok ? (len != 0 ? len : frame.size()) : 0;
+        }
+    };
+} // namespace
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_frames_share_window()
+{
+    for (uint8_t windowBits = BleLz::MIN_WINDOW_BITS; windowBits <= BleLz::MAX_WINDOW_BITS; windowBits++)
+    {
+        Codec codec(windowBits);
+        size_t plain = 0;
+        size_t sent = 0;
+        std::vector<uint8_t> received;
+        for (uint32_t i = 0; i < 50; i++)
+        {
+            const std::vector<uint8_t> frame = telemetry(i, 20 + i % 7 * 30);
+            const size_t len = codec.roundTrip(frame, received);
+            TEST_ASSERT_TRUE(len != 0);
+            TEST_ASSERT_EQUAL(frame.size(), received.size());
+            TEST_ASSERT_EQUAL_MEMORY(frame.data(), received.data(), frame.size());
+            plain += frame.size();
+            sent += len;
+        }
+        // Повторяющаяся телеметрия сжимается за счет окна прошлых кадров
+        TEST_ASSERT_TRUE(sent * 3 < plain);
+    }
+}
+
+static void test_incompressible_frames_stored()
+{
+    Codec codec(BleLz::MAX_WINDOW_BITS);
+    std::vector<uint8_t> received;
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        // Случайный кадр не помещается в исходный размер и уходит как есть, окно остается общим
+        const std::vector<uint8_t> frame = i % 2 == 0 ? random(300, i) : telemetry(i, 300);
+        TEST_ASSERT_TRUE(codec.roundTrip(frame, received) != 0);
+        TEST_ASSERT_EQUAL_MEMORY(frame.data(), received.data(), frame.size());
+    }
+
+    // В худшем случае данные помещаются в maxCompressedSize()
+    BleLzEncoder encoder(BleLz::MAX_WINDOW_BITS, MAX_FRAME);
+    const std::vector<uint8_t> frame = random(MAX_FRAME, 99);
+    std::vector<uint8_t> packed(BleLz::maxCompressedSize(frame.size()));
+    TEST_ASSERT_EQUAL(packed.size(), encoder.compress(frame.data(), frame.size(), packed.data(), packed.size()));
+    TEST_ASSERT_EQUAL(0, encoder.compress(frame.data(), MAX_FRAME + 1, packed.data(), packed.size()));
+}
+
+static void test_uncommitted_frame_replaced()
+{
+    BleLzEncoder encoder(10, MAX_FRAME);
+    BleLzDecoder decoder(10, MAX_FRAME);
+    std::vector<uint8_t> packed(BleLz::maxCompressedSize(MAX_FRAME));
+    std::span<const uint8_t> out;
+
+    const std::vector<uint8_t> first = telemetry(1, 100);
+    size_t len = encoder.compress(first.data(), first.size(), packed.data(), packed.size());
+    encoder.commit();
+    TEST_ASSERT_TRUE(decoder.decompress(packed.data(), len, out));
+
+    // Кадр не отправлен (нет кредитов): следующий compress() его заменяет, окно не расходится
+    const std::vector<uint8_t> dropped = random(200, 7);
+    TEST_ASSERT_TRUE(encoder.compress(dropped.data(), dropped.size(), packed.data(), packed.size()) != 0);
+
+    const std::vector<uint8_t> second = telemetry(2, 100);
+    len = encoder.compress(second.data(), second.size(), packed.data(), packed.size());
+    encoder.commit();
+    TEST_ASSERT_TRUE(decoder.decompress(packed.data(), len, out));
+    TEST_ASSERT_EQUAL(second.size(), out.size());
+    TEST_ASSERT_EQUAL_MEMORY(second.data(), out.data(), second.size());
+}
+
+static void test_long_and_overlapping_matches()
+{
+    Codec codec(BleLz::MAX_WINDOW_BITS);
+    std::vector<uint8_t> received;
+
+    // Серия одного байта: ссылка с дистанцией 1 перекрывает записываемые данные
+    const std::vector<uint8_t> run(MAX_FRAME, 0x55);
+    const size_t len = codec.roundTrip(run, received);
+    TEST_ASSERT_TRUE(len != 0 && len < 16);
+    TEST_ASSERT_EQUAL_MEMORY(run.data(), received.data(), run.size());
+
+    // Ссылки длиннее 18 байт несут байт добавки, длиннее MAX_MATCH - делятся
+    for (const size_t tail : {size_t{17}, size_t{18}, size_t{19}, BleLz::MAX_MATCH, BleLz::MAX_MATCH + 1})
+    {
+        std::vector<uint8_t> frame = random(64, static_cast<uint32_t>(tail));
+        frame.resize(64 + tail);
+        for (size_t i = 64; i < frame.size(); i++) frame[i] = frame[i - 64];
+        TEST_ASSERT_TRUE(codec.roundTrip(frame, received) != 0);
+        TEST_ASSERT_EQUAL(frame.size(), received.size());
+        TEST_ASSERT_EQUAL_MEMORY(frame.data(), received.data(), frame.size());
+    }
+}
+
+static void test_corrupted_input_rejected()
+{
+    BleLzDecoder decoder(8, 16);
+    std::span<const uint8_t> out;
+
+    // Ссылка до начала окна
+    const uint8_t beforeWindow[] = {0x01, 0x00, 0x00};
+    TEST_ASSERT_FALSE(decoder.decompress(beforeWindow, sizeof(beforeWindow), out));
+
+    // Ссылка без второго байта и без байта добавки
+    const uint8_t truncated[] = {0x02, 'a', 0x00};
+    TEST_ASSERT_FALSE(decoder.decompress(truncated, sizeof(truncated), out));
+    const uint8_t noExtra[] = {0x02, 'a', 0x0F, 0x00};
+    TEST_ASSERT_FALSE(decoder.decompress(noExtra, sizeof(noExtra), out));
+
+    // Результат длиннее maxOutput
+    const uint8_t overflow[] = {0x02, 'a', 0x0F, 0x00, 0x00};
+    TEST_ASSERT_FALSE(decoder.decompress(overflow, sizeof(overflow), out));
+    const uint8_t big[17] = {};
+    TEST_ASSERT_FALSE(decoder.store(big, sizeof(big), out));
+
+    // После ошибок декодер принимает корректный кадр
+    const uint8_t valid[] = {0x04, 'a', 'b', 0x01, 0x01};
+    TEST_ASSERT_TRUE(decoder.decompress(valid, sizeof(valid), out));
+    TEST_ASSERT_EQUAL(6, out.size());
+    TEST_ASSERT_EQUAL_MEMORY("ababab", out.data(), 6);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_frames_share_window);
+    RUN_TEST(test_incompressible_frames_stored);
+    RUN_TEST(test_uncommitted_frame_replaced);
+    RUN_TEST(test_long_and_overlapping_matches);
+    RUN_TEST(test_corrupted_input_rejected);
+    return UNITY_END();
+}
@@ -0,0 +1,278 @@
+/**
+ * @file test_main.cpp
+ * @brief Тесты моста BleSerialBridge с FdSerialPort на pty и pipe
+ * @details Задачи моста работают потоками заглушки FreeRTOS, уведомления собирает
+ *          отправитель теста. Сторона "устройства" порта - второй конец pty или pipe.
+ */
+
+#include "net/ble_serial_bridge.h"
+
+#include <unity.h>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using net::BleSerialBridge;
+using net::BleSerialBridgeConfig;
+using net::FdSerialPort;
+
+namespace
+{
+    constexpr uint16_t CONN_ID = 3;
+
+    /**
+     * @brief Уведомления, отправленные мостом
+     */
+    struct Uplink
+    {
+        std::mutex mutex;
+        std::vector<uint8_t> bytes;
+        std::vector<size_t> notifications;
+        int timeouts = 0; ///< Сколько первых отправок вернуть с ESP_ERR_TIMEOUT
+
+        BleSerialBridge::DataSender sender()
+        {
+            return [this](const uint16_t connId, const uint8_t* data, const size_t len)
+            {
+                std::lock_guard lock(mutex);
+                if (connId != CONN_ID) return ESP_ERR_INVALID_ARG;
+                if (timeouts > 0)
+                {
+                    timeouts--;
+                    return ESP_ERR_TIMEOUT;
+                }
+                bytes.insert(bytes.end(), data, data + len);
+                notifications.push_back(len);
+                return ESP_OK;
+            };
+        }
+
+        size_t size()
+        {
+            std::lock_guard lock(mutex);
+            return bytes.size();
+        }
+    };
+
+    bool waitFor(const std::function<bool()>& condition, const int timeoutMs = 2000)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (!condition())
+        {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::vector<uint8_t> pattern(const size_t len)
+    {
+        std::vector<uint8_t> data(len);
+        for (size_t i = 0; i < len; i++) data[i] = static_cast<uint8_t>(i * 13 + 1);
+        return data;
+    }
+
+    void writeAll(const int fd, const std::vector<uint8_t>& data)
+    {
+        size_t total = 0;
+        while (total < data.size())
+        {
+            const ssize_t count = ::write(fd, data.data() + total, data.size() - total);
+            TEST_ASSERT_TRUE(count > 0);
+            total += static_cast<size_t>(count);
+        }
+    }
+
+    std::vector<uint8_t> readExactly(const int fd, const size_t len)
+    {
+        std::vector<uint8_t> data(len);
+        FdSerialPort port(fd);
+        const size_t count = port.read(data.data(), len, 2000);
+        data.resize(count);
+        return data;
+    }
+
+    BleSerialBridgeConfig testConfig()
+    {
+        BleSerialBridgeConfig config;
+        config.coalesceMs = 20;
+        config.idleWaitMs = 20;
+        return config;
+    }
+} // namespace
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_pty_round_trip()
+{
+    // pty в сыром режиме: байты проходят без обработки строк и эха
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    TEST_ASSERT_TRUE(master >= 0);
+    TEST_ASSERT_EQUAL(0, grantpt(master));
+    TEST_ASSERT_EQUAL(0, unlockpt(master));
+    const int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    TEST_ASSERT_TRUE(slave >= 0);
+    termios tio = {};
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    Uplink uplink;
+    FdSerialPort port(slave);
+    BleSerialBridge bridge(uplink.sender());
+    bridge.setLinkMtu(247);
+    TEST_ASSERT_EQUAL(ESP_OK, bridge.start(port, testConfig()));
+    bridge.handleConnect(CONN_ID);
+
+    // Порт -> клиент: уведомления не длиннее MTU - 3, данные по порядку
+    const std::vector<uint8_t> up = pattern(1500);
+    writeAll(master, up);
+    TEST_ASSERT_TRUE(waitFor([&] { return uplink.size() >= up.size(); }));
+    {
+        std::lock_guard lock(uplink.mutex);
+        TEST_ASSERT_EQUAL(up.size(), uplink.bytes.size());
+        TEST_ASSERT_EQUAL_MEMORY(up.data(), uplink.bytes.data(), up.size());
+        for (const size_t len : uplink.notifications) TEST_ASSERT_LESS_OR_EQUAL(244, len);
+    }
+
+    // Клиент -> порт
+    const std::vector<uint8_t> down = pattern(700);
+    TEST_ASSERT_TRUE(bridge.handleWrite(CONN_ID, down.data(), 200, true));
+    TEST_ASSERT_TRUE(bridge.handleWrite(CONN_ID, down.data() + 200, 500, false));
+    const std::vector<uint8_t> received = readExactly(master, down.size());
+    TEST_ASSERT_EQUAL(down.size(), received.size());
+    TEST_ASSERT_EQUAL_MEMORY(down.data(), received.data(), down.size());
+
+    bridge.stop();
+    const BleSerialBridge::Statistics stats = bridge.getStatistics();
+    TEST_ASSERT_EQUAL_UINT64(up.size(), stats.uplinkBytes);
+    TEST_ASSERT_EQUAL_UINT64(down.size(), stats.downlinkBytes);
+    close(slave);
+    close(master);
+}
+
+static void test_uplink_retries_without_credits()
+{
+    int toPort[2];
+    int fromPort[2];
+    TEST_ASSERT_EQUAL(0, pipe(toPort));
+    TEST_ASSERT_EQUAL(0, pipe(fromPort));
+
+    Uplink uplink;
+    uplink.timeouts = 5;
+    FdSerialPort port(toPort[0], fromPort[1]);
+    BleSerialBridge bridge(uplink.sender());
+    bridge.setLinkMtu(23);
+    TEST_ASSERT_EQUAL(ESP_OK, bridge.start(port, testConfig()));
+    bridge.handleConnect(CONN_ID);
+
+    // Без кредитов тот же буфер уходит повторно: ничего не теряется и не переставляется
+    const std::vector<uint8_t> up = pattern(100);
+    writeAll(toPort[1], up);
+    TEST_ASSERT_TRUE(waitFor([&] { return uplink.size() >= up.size(); }));
+    bridge.stop();
+
+    std::lock_guard lock(uplink.mutex);
+    TEST_ASSERT_EQUAL_MEMORY(up.data(), uplink.bytes.data(), up.size());
+    for (const size_t len : uplink.notifications) TEST_ASSERT_LESS_OR_EQUAL(20, len);
+    const BleSerialBridge::Statistics stats = bridge.getStatistics();
+    TEST_ASSERT_EQUAL_UINT32(5, stats.uplinkStalls);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.uplinkDropped);
+
+    for (const int fd : {toPort[0], toPort[1], fromPort[0], fromPort[1]}) close(fd);
+}
+
+static void test_downlink_overflow_drops_whole_writes()
+{
+    int toPort[2];
+    int fromPort[2];
+    TEST_ASSERT_EQUAL(0, pipe(toPort));
+    TEST_ASSERT_EQUAL(0, pipe(fromPort));
+
+    // Pipe к "устройству" заполнен: порт не принимает, буфер моста не опустошается
+    fcntl(fromPort[1], F_SETFL, fcntl(fromPort[1], F_GETFL) | O_NONBLOCK);
+    const std::vector<uint8_t> filler(4096, 0xEE);
+    size_t pending = 0;
+    for (ssize_t count; (count = ::write(fromPort[1], filler.data(), filler.size())) > 0;)
+    {
+        pending += static_cast<size_t>(count);
+    }
+
+    Uplink uplink;
+    FdSerialPort port(toPort[0], fromPort[1]);
+    BleSerialBridge bridge(uplink.sender());
+    BleSerialBridgeConfig config = testConfig();
+    config.downlinkBufferSize = 64;
+    TEST_ASSERT_EQUAL(ESP_OK, bridge.start(port, config));
+    bridge.handleConnect(CONN_ID);
+
+    const std::vector<uint8_t> data = pattern(40);
+    TEST_ASSERT_TRUE(bridge.handleWrite(CONN_ID, data.data(), data.size(), false));
+    TEST_ASSERT_TRUE(bridge.handleWrite(CONN_ID, data.data(), data.size(), false));  // не помещается
+    TEST_ASSERT_FALSE(bridge.handleWrite(CONN_ID, data.data(), data.size(), true)); // отклонена
+
+    BleSerialBridge::Statistics stats = bridge.getStatistics();
+    TEST_ASSERT_EQUAL_UINT64(data.size(), stats.downlinkDropped);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.downlinkDroppedWrites);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.downlinkRejected);
+
+    // "Устройство" читает: принятая запись доходит целиком, отброшенная - нет
+    std::vector<uint8_t> drained = readExactly(fromPort[0], pending + data.size());
+    TEST_ASSERT_EQUAL(pending + data.size(), drained.size());
+    TEST_ASSERT_EQUAL_MEMORY(data.data(), drained.data() + pending, data.size());
+    bridge.stop();
+
+    stats = bridge.getStatistics();
+    TEST_ASSERT_EQUAL_UINT64(data.size(), stats.downlinkBytes);
+    for (const int fd : {toPort[0], toPort[1], fromPort[0], fromPort[1]}) close(fd);
+}
+
+static void test_other_connection_ignored()
+{
+    int toPort[2];
+    int fromPort[2];
+    TEST_ASSERT_EQUAL(0, pipe(toPort));
+    TEST_ASSERT_EQUAL(0, pipe(fromPort));
+
+    Uplink uplink;
+    FdSerialPort port(toPort[0], fromPort[1]);
+    BleSerialBridge bridge(uplink.sender());
+    TEST_ASSERT_EQUAL(ESP_OK, bridge.start(port, testConfig()));
+    bridge.handleConnect(CONN_ID);
+    bridge.handleConnect(CONN_ID + 1); // мост обслуживает первое соединение
+
+    const std::vector<uint8_t> data = pattern(10);
+    TEST_ASSERT_TRUE(bridge.handleWrite(CONN_ID + 1, data.data(), data.size(), true));
+    bridge.handleDisconnect(CONN_ID + 1);
+    TEST_ASSERT_TRUE(bridge.handleWrite(CONN_ID, data.data(), data.size(), true));
+    TEST_ASSERT_EQUAL(data.size(), readExactly(fromPort[0], data.size()).size());
+    bridge.stop();
+
+    const BleSerialBridge::Statistics stats = bridge.getStatistics();
+    TEST_ASSERT_EQUAL_UINT64(data.size(), stats.downlinkBytes);
+    for (const int fd : {toPort[0], toPort[1], fromPort[0], fromPort[1]}) close(fd);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_pty_round_trip);
+    RUN_TEST(test_uplink_retries_without_credits);
+    RUN_TEST(test_downlink_overflow_drops_whole_writes);
+    RUN_TEST(test_other_connection_ignored);
+    return UNITY_END();
+}
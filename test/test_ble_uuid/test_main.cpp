@@ -0,0 +1,109 @@
+/**
+ * @file test_main.cpp
+ * @brief Тесты разбора и преобразования BleUuid
+ */
+
+#include "net/ble_uuid.h"
+
+#include <unity.h>
+
+#include <cstring>
+
+using net::BleUuid;
+using net::UuidError;
+using namespace net::uuid_literals;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_parse_16_and_32()
+{
+    BleUuid uuid;
+    TEST_ASSERT_EQUAL(UuidError::NONE, BleUuid::parse("180f", uuid));
+    TEST_ASSERT_EQUAL(ESP_UUID_LEN_16, uuid.length());
+    TEST_ASSERT_EQUAL_UINT16(0x180F, uuid.value16());
+
+    TEST_ASSERT_EQUAL(UuidError::NONE, BleUuid::parse("12345678", uuid));
+    TEST_ASSERT_EQUAL(ESP_UUID_LEN_32, uuid.length());
+    TEST_ASSERT_EQUAL_UINT32(0x12345678, uuid.value32());
+}
+
+static void test_parse_128_with_and_without_dashes()
+{
+    BleUuid dashed;
+    BleUuid plain;
+    TEST_ASSERT_EQUAL(UuidError::NONE, BleUuid::parse("6E400001-B5A3-F393-E0A9-E50E24DCCA9E", dashed));
+    TEST_ASSERT_EQUAL(UuidError::NONE, BleUuid::parse("6e400001b5a3f393e0a9e50e24dcca9e", plain));
+    TEST_ASSERT_EQUAL(ESP_UUID_LEN_128, dashed.length());
+    TEST_ASSERT_TRUE(dashed == plain);
+    TEST_ASSERT_EQUAL_HEX8(0x6E, dashed.bytes()[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x9E, dashed.bytes()[15]);
+}
+
+static void test_parse_errors()
+{
+    BleUuid uuid = BleUuid::from16(0xABCD);
+    TEST_ASSERT_EQUAL(UuidError::EMPTY, BleUuid::parse("", uuid));
+    TEST_ASSERT_EQUAL(UuidError::INVALID_LENGTH, BleUuid::parse("123", uuid));
+    TEST_ASSERT_EQUAL(UuidError::INVALID_LENGTH, BleUuid::parse("123456", uuid));
+    TEST_ASSERT_EQUAL(UuidError::INVALID_LENGTH, BleUuid::parse("6e400001b5a3f393e0a9e50e24dcca9e00", uuid));
+    TEST_ASSERT_EQUAL(UuidError::INVALID_CHAR, BleUuid::parse("18g0", uuid));
+    TEST_ASSERT_EQUAL(UuidError::INVALID_DASH, BleUuid::parse("18-0f", uuid));
+    TEST_ASSERT_EQUAL(UuidError::INVALID_DASH, BleUuid::parse("6E400001B-5A3-F393-E0A9-E50E24DCCA9E", uuid));
+
+    // При ошибке результат не изменяется
+    TEST_ASSERT_EQUAL_UINT16(0xABCD, uuid.value16());
+}
+
+static void test_constexpr_literal()
+{
+    constexpr BleUuid uuid = "6E400001-B5A3-F393-E0A9-E50E24DCCA9E"_uuid;
+    static_assert(uuid.length() == ESP_UUID_LEN_128);
+    static_assert(uuid.bytes()[0] == 0x6E && uuid.bytes()[15] == 0x9E);
+    static_assert("2902"_uuid == BleUuid::from16(0x2902));
+    TEST_ASSERT_TRUE(uuid.isValid());
+}
+
+static void test_to_string_round_trip()
+{
+    const BleUuid uuid = BleUuid::fromString("6e400001-b5a3-f393-e0a9-e50e24dcca9e");
+    TEST_ASSERT_EQUAL_STRING("6E400001-B5A3-F393-E0A9-E50E24DCCA9E", uuid.toString().data());
+    TEST_ASSERT_TRUE(BleUuid::fromString(uuid.toString().data()) == uuid);
+    TEST_ASSERT_EQUAL_STRING("180F", BleUuid::from16(0x180F).toString().data());
+}
+
+static void test_esp_round_trip()
+{
+    const BleUuid uuid128 = BleUuid::fromString("6E400001-B5A3-F393-E0A9-E50E24DCCA9E");
+    const esp_bt_uuid_t inverted = uuid128.toEsp(true);
+    TEST_ASSERT_EQUAL(ESP_UUID_LEN_128, inverted.len);
+    TEST_ASSERT_EQUAL_HEX8(0x9E, inverted.uuid.uuid128[0]);
+    TEST_ASSERT_TRUE(BleUuid::fromEsp(inverted, true) == uuid128);
+    TEST_ASSERT_TRUE(BleUuid::fromEsp(uuid128.toEsp(false), false) == uuid128);
+
+    const BleUuid uuid32 = BleUuid::fromString("12345678");
+    const esp_bt_uuid_t esp32 = uuid32.toEsp(true);
+    TEST_ASSERT_EQUAL_UINT32(0x12345678, esp32.uuid.uuid32);
+    TEST_ASSERT_TRUE(BleUuid::fromEsp(esp32, true) == uuid32);
+
+    esp_bt_uuid_t invalid = {};
+    invalid.len = 3;
+    TEST_ASSERT_FALSE(BleUuid::fromEsp(invalid, true).isValid());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_16_and_32);
+    RUN_TEST(test_parse_128_with_and_without_dashes);
+    RUN_TEST(test_parse_errors);
+    RUN_TEST(test_constexpr_literal);
+    RUN_TEST(test_to_string_round_trip);
+    RUN_TEST(test_esp_round_trip);
+    return UNITY_END();
+}
@@ -0,0 +1,387 @@
+/**
+ * @file ble_adv_layout_fuzz.cpp
+ * @brief Проверка раскладки рекламы BleAdvLayout на случайных именах и UUID
+ * @details Перебирает случайные имена (ASCII и многобайтовые символы UTF-8, от пустого
+ *          до длиннее любого пакета), UUID всех форм (16, 32, 128 бит, 128 бит на базе
+ *          Base UUID), флаги и емкости пакетов (legacy, несканируемая, расширенная,
+ *          произвольные) и проверяет каждую раскладку:
+ *          - пакеты не длиннее емкости, AD структуры разбираются и не повторяются;
+ *          - флаги только в рекламном пакете;
+ *          - UUID передан один раз, в самой короткой форме, и раскрывается в исходный;
+ *            пропущен, только если не помещался ни в один пакет;
+ *          - полное имя совпадает с исходным; сокращенное - непустой префикс, не
+ *            разрезающий символ UTF-8; полное имя сокращено, только если не помещалось.
+ *          Печатает распределение решений и первые ошибки; код возврата 1 при ошибках.
+ *
+ *          Сборка и запуск (заголовки ESP-IDF заменяются заглушками tools/host):
+ *          @code
+ *          g++ -std=c++20 -O2 -Iinclude -Iinclude/net -Itools/host \
+ *              tools/ble_adv_layout_fuzz.cpp src/ble_adv_layout.cpp -o ble_adv_layout_fuzz
+ *          ./ble_adv_layout_fuzz --iterations 1000000
+ *          @endcode
+ *
+ *          Параметры:
+ *          - --iterations N  количество раскладок (по умолчанию 200000)
+ *          - --seed N        начальное значение генератора (по умолчанию 1)
+ */
+
+#include "net/ble_adv_layout.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace
+{
+    using net::BleAdvLayout;
+    using net::BleUuid;
+
+    constexpr size_t MAX_REPORTED = 10;
+
+    /// @brief Символы имен: ASCII, 2-, 3- и 4-байтовые UTF-8
+    constexpr std::array<std::string_view, 6> SYMBOLS = {
+        "A", "z", "7", "\xD0\x94", "\xE2\x82\xAC", "\xF0\x9F\x98\x80"
+    };
+
+    constexpr std::array<uint8_t, 12> BASE_TAIL = {
+        0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB
+    };
+
+    /**
+     * @brief Емкости пакетов
+     */
+    struct Capacity
+    {
+        uint8_t adv;     ///< Рекламный пакет
+        uint8_t scanRsp; ///< Scan response
+    };
+
+    constexpr std::array<Capacity, 4> TYPICAL = {{
+        {BleAdvLayout::LEGACY_DATA_MAX, BleAdvLayout::LEGACY_DATA_MAX},
+        {BleAdvLayout::LEGACY_DATA_MAX, 0},
+        {BleAdvLayout::EXT_DATA_MAX, 0},
+        {0, BleAdvLayout::EXT_DATA_MAX},
+    }};
+
+    /**
+     * @brief AD структура в пакете
+     */
+    struct Field
+    {
+        bool present;           ///< Найдена
+        std::string_view value; ///< Значение
+    };
+
+    /**
+     * @brief Разобранный пакет
+     */
+    struct Parsed
+    {
+        bool valid = true;                  ///< Структура корректна, типы не повторяются
+        std::array<Field, 256> fields = {}; ///< Значения по типу AD
+    };
+
+    struct Counters
+    {
+        uint64_t nameInAdv = 0;
+        uint64_t nameInScanRsp = 0;
+        uint64_t shortInAdv = 0;
+        uint64_t shortened = 0;
+        uint64_t uuidInScanRsp = 0;
+        uint64_t uuidCompacted = 0;
+        uint64_t failures = 0;
+    };
+
+    Counters sCounters;
+
+    Parsed parse(const BleAdvLayout::Payload& payload)
+    {
+        Parsed parsed;
+        for (size_t i = 0; i < payload.size;)
+        {
+            const size_t len = payload.data[i];
+            if (len < 1 || i + 1 + len > payload.size || parsed.fields[payload.data[i + 1]].present)
+            {
+                parsed.valid = false;
+                return parsed;
+            }
+            parsed.fields[payload.data[i + 1]] = {
+                true, {reinterpret_cast<const char*>(&payload.data[i + 2]), len - 1}
+            };
+            i += 1 + len;
+        }
+        return parsed;
+    }
+
+    /**
+     * @brief UUID в 128-бит форме (16 и 32 бит раскрываются через Base UUID)
+     */
+    std::array<uint8_t, 16> expand(const BleUuid& uuid)
+    {
+        std::array<uint8_t, 16> full = {};
+        const auto& bytes = uuid.bytes();
+        if (uuid.length() == 16) return bytes;
+
+        const size_t offset = uuid.length() == 2 ? 2 : 0;
+        for (size_t i = 0; i < uuid.length(); i++)
+        {
+            full[offset + i] = bytes[i];
+        }
+        std::copy(BASE_TAIL.begin(), BASE_TAIL.end(), full.begin() + 4);
+        return full;
+    }
+
+    /**
+     * @brief UUID из значения AD структуры
+     */
+    std::array<uint8_t, 16> decode(const std::string_view value, const bool invertBytes)
+    {
+        std::array<uint8_t, 16> full = {};
+        const auto* data = reinterpret_cast<const uint8_t*>(value.data());
+        if (value.size() == 16)
+        {
+            for (size_t i = 0; i < 16; i++)
+            {
+                full[i] = invertBytes ? data[15 - i] : data[i];
+            }
+            return full;
+        }
+
+        const size_t offset = value.size() == 2 ? 2 : 0;
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            full[offset + i] = data[value.size() - 1 - i];
+        }
+        std::copy(BASE_TAIL.begin(), BASE_TAIL.end(), full.begin() + 4);
+        return full;
+    }
+
+    BleUuid randomUuid(std::mt19937& rng)
+    {
+        std::array<uint8_t, 16> bytes = {};
+        for (auto& byte : bytes)
+        {
+            byte = static_cast<uint8_t>(rng());
+        }
+
+        size_t digits = 32;
+        switch (rng() % 6)
+        {
+        case 0: return {};
+        case 1: digits = 4; break;
+        case 2: digits = 8; break;
+        case 3: break;
+        case 4: // Base UUID, 16 бит
+            bytes[0] = 0;
+            bytes[1] = 0;
+            [[fallthrough]];
+        default: // Base UUID, 32 бит
+            std::copy(BASE_TAIL.begin(), BASE_TAIL.end(), bytes.begin() + 4);
+            break;
+        }
+
+        char text[33] = {};
+        for (size_t i = 0; i < digits; i++)
+        {
+            text[i] = "0123456789ABCDEF"[(bytes[i / 2] >> (i % 2 == 0 ? 4 : 0)) & 0x0F];
+        }
+        BleUuid uuid;
+        BleUuid::parse({text, digits}, uuid);
+        return uuid;
+    }
+
+    std::string randomName(std::mt19937& rng)
+    {
+        // Чаще - длины вокруг границ пакетов
+        const size_t target = rng() % 4 == 0 ? rng() % 260 : rng() % 40;
+        const bool ascii = rng() % 2 == 0;
+        std::string name;
+        while (name.size() < target)
+        {
+            name += SYMBOLS[ascii ? rng() % 3 : rng() % SYMBOLS.size()];
+        }
+        return name;
+    }
+
+    void fail(const char* what, const BleAdvLayout::Input& input)
+    {
+        if (sCounters.failures++ < MAX_REPORTED)
+        {
+            std::printf("FAIL %s: name %zu bytes, UUID %u bytes, flags 0x%02X, capacity %u/%u\n", what,
+                        input.name.size(), input.serviceUuid.length(), input.flags, input.advCapacity,
+                        input.scanRspCapacity);
+        }
+    }
+
+    /**
+     * @brief Свободное место пакета без AD структур имени
+     */
+    size_t freeForName(const BleAdvLayout::Payload& payload, const Parsed& parsed, const uint8_t capacity)
+    {
+        size_t used = payload.size;
+        for (const uint8_t type : {BleAdvLayout::AD_NAME_COMPLETE, BleAdvLayout::AD_NAME_SHORT})
+        {
+            if (parsed.fields[type].present)
+            {
+                used -= 2 + parsed.fields[type].value.size();
+            }
+        }
+        const size_t limit = std::min(capacity, BleAdvLayout::EXT_DATA_MAX);
+        return limit > used + 2 ? limit - used - 2 : 0;
+    }
+
+    void check(const BleAdvLayout::Input& input)
+    {
+        const BleAdvLayout::Plan plan = BleAdvLayout::plan(input);
+        if (plan.adv.size > input.advCapacity || plan.scanRsp.size > input.scanRspCapacity)
+        {
+            fail("payload exceeds capacity", input);
+            return;
+        }
+
+        const Parsed adv = parse(plan.adv);
+        const Parsed scanRsp = parse(plan.scanRsp);
+        if (!adv.valid || !scanRsp.valid)
+        {
+            fail("malformed or repeated AD structure", input);
+            return;
+        }
+        if (scanRsp.fields[BleAdvLayout::AD_FLAGS].present)
+        {
+            fail("flags in scan response", input);
+        }
+
+        // UUID
+        std::array<uint8_t, 16> compact = {};
+        const uint8_t compactLen = BleAdvLayout::compactUuid(input.serviceUuid, input.invertBytes, compact);
+        const uint8_t uuidType = compactLen == 2 ? BleAdvLayout::AD_UUID16_COMPLETE
+                                     : compactLen == 4 ? BleAdvLayout::AD_UUID32_COMPLETE
+                                     : BleAdvLayout::AD_UUID128_COMPLETE;
+        const Field& inAdv = adv.fields[uuidType];
+        const Field& inRsp = scanRsp.fields[uuidType];
+        if (inAdv.present && inRsp.present)
+        {
+            fail("UUID in both packets", input);
+        }
+        else if (inAdv.present || inRsp.present)
+        {
+            const Field& field = inAdv.present ? inAdv : inRsp;
+            if (!input.serviceUuid.isValid() || decode(field.value, input.invertBytes) != expand(input.serviceUuid))
+            {
+                fail("UUID does not decode to the configured one", input);
+            }
+            if (input.serviceUuid.length() == 16 && compactLen < 16)
+            {
+                sCounters.uuidCompacted++;
+            }
+            if (inRsp.present)
+            {
+                sCounters.uuidInScanRsp++;
+            }
+        }
+        else if (compactLen != 0)
+        {
+            const size_t flags = adv.fields[BleAdvLayout::AD_FLAGS].present ? 3 : 0;
+            if (2u + compactLen + flags <= input.advCapacity || 2u + compactLen <= input.scanRspCapacity)
+            {
+                fail("UUID dropped although it fits", input);
+            }
+        }
+
+        // Имя
+        const std::string_view name = input.name;
+        const Field* complete = adv.fields[BleAdvLayout::AD_NAME_COMPLETE].present
+                                    ? &adv.fields[BleAdvLayout::AD_NAME_COMPLETE]
+                                    : scanRsp.fields[BleAdvLayout::AD_NAME_COMPLETE].present
+                                    ? &scanRsp.fields[BleAdvLayout::AD_NAME_COMPLETE]
+                                    : nullptr;
+        if (complete != nullptr && complete->value != name)
+        {
+            fail("complete name differs", input);
+        }
+        for (const Parsed* packet : {&adv, &scanRsp})
+        {
+            const Field& field = packet->fields[BleAdvLayout::AD_NAME_SHORT];
+            if (!field.present) continue;
+            if (field.value.empty() || field.value.size() >= name.size() || !name.starts_with(field.value) ||
+                (static_cast<uint8_t>(name[field.value.size()]) & 0xC0) == 0x80)
+            {
+                fail("shortened name is not a whole-character prefix", input);
+            }
+            sCounters.shortened++;
+        }
+
+        if (name.empty()) return;
+        const size_t advFree = freeForName(plan.adv, adv, input.advCapacity);
+        const size_t rspFree = freeForName(plan.scanRsp, scanRsp, input.scanRspCapacity);
+        if (complete == nullptr && (name.size() <= advFree || name.size() <= rspFree))
+        {
+            fail("name shortened although it fits", input);
+        }
+        if (complete == nullptr && !adv.fields[BleAdvLayout::AD_NAME_SHORT].present &&
+            !scanRsp.fields[BleAdvLayout::AD_NAME_SHORT].present &&
+            BleAdvLayout::utf8Prefix(name, std::max(advFree, rspFree)) != 0)
+        {
+            fail("name dropped although a prefix fits", input);
+        }
+
+        sCounters.nameInAdv += plan.name == BleAdvLayout::Placement::ADV;
+        sCounters.nameInScanRsp += plan.name == BleAdvLayout::Placement::SCAN_RSP;
+        sCounters.shortInAdv += plan.name == BleAdvLayout::Placement::SCAN_RSP &&
+            plan.shortName == BleAdvLayout::Placement::ADV;
+    }
+} // namespace
+
+int main(const int argc, char** argv)
+{
+    uint64_t iterations = 200000;
+    uint32_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--iterations")
+        {
+            iterations = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (arg == "--seed")
+        {
+            seed = static_cast<uint32_t>(std::strtoul(argv[i + 1], nullptr, 10));
+        }
+    }
+
+    std::mt19937 rng(seed);
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        const std::string name = randomName(rng);
+        Capacity capacity = TYPICAL[rng() % TYPICAL.size()];
+        if (rng() % 4 == 0)
+        {
+            capacity = {static_cast<uint8_t>(rng() % 256), static_cast<uint8_t>(rng() % 256)};
+        }
+
+        const BleAdvLayout::Input input = {
+            .flags = static_cast<uint8_t>(rng() % 3 == 0 ? 0 : rng() % 2 == 0 ? 0x06 : rng()),
+            .name = name,
+            .serviceUuid = randomUuid(rng),
+            .invertBytes = rng() % 2 == 0,
+            .advCapacity = std::min(capacity.adv, BleAdvLayout::EXT_DATA_MAX),
+            .scanRspCapacity = std::min(capacity.scanRsp, BleAdvLayout::EXT_DATA_MAX)
+        };
+        check(input);
+    }
+
+    std::printf("Layouts: %llu\n", static_cast<unsigned long long>(iterations));
+    std::printf("  complete name in adv:       %llu\n", static_cast<unsigned long long>(sCounters.nameInAdv));
+    std::printf("  complete name in scan rsp:  %llu (short copy in adv: %llu)\n",
+                static_cast<unsigned long long>(sCounters.nameInScanRsp),
+                static_cast<unsigned long long>(sCounters.shortInAdv));
+    std::printf("  shortened names:            %llu\n", static_cast<unsigned long long>(sCounters.shortened));
+    std::printf("  UUID in scan rsp:           %llu\n", static_cast<unsigned long long>(sCounters.uuidInScanRsp));
+    std::printf("  128-bit UUID compacted:     %llu\n", static_cast<unsigned long long>(sCounters.uuidCompacted));
+    std::printf("Failures: %llu\n", static_cast<unsigned long long>(sCounters.failures));
+    return sCounters.failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,402 @@
+/**
+ * @file ble_affinity_bench.cpp
+ * @brief Влияние размещения обработки по ядрам на пропускную способность и джиттер приема
+ * @details Приложение ESP-IDF (запускается на устройстве, радио не используется).
+ *          Задача "btc" с приоритетом и ядром задачи BTC эмулирует прием записей
+ *          характеристики данных: на каждую запись тратит STACK_WORK_US (разбор стеком)
+ *          и передает ее приложению тем же путем, что BLE::handleWriteEvent: под мьютексом
+ *          BLE находит соединение и ставит запись в BleRxDispatcher (rx.deferred) или
+ *          освобождает мьютекс и вызывает BLE::deliverData. Доставка, как в BLE, ищет
+ *          соединение и копирует callback с контекстом под мьютексом, а вызывает без него.
+ *          Callback соединения тратит APP_WORK_US (разбор пакета приложением), задача
+ *          приложения каждые APP_SEND_PERIOD_US держит мьютекс APP_SEND_US (sendData).
+ *
+ *          Два замера на каждый вариант размещения:
+ *          - пропускная способность: записи поступают без пауз, при заполненном буфере
+ *            "клиент" повторяет запись через тик; печатается обработано записей в секунду;
+ *          - джиттер: каждые INTERVAL_US (событие соединения) приходит BURST записей;
+ *            печатается задержка стека (насколько позже идеального стек освобождается
+ *            после каждой записи, p50/p99/max) и задержка доставки приложению.
+ *
+ *          На двухъядерных целях (ESP32, ESP32-S3) вариант "auto" переносит обработку
+ *          на ядро, свободное от стека: пропускная способность ограничена большим из
+ *          STACK_WORK_US и APP_WORK_US, а не их суммой, задержка стека не зависит от
+ *          приложения. На ESP32-C3 все варианты deferred равнозначны: обработка идет
+ *          ниже приоритета BTC, поэтому задержка стека тоже падает, а пропускная
+ *          способность остается ограничена одним ядром.
+ *
+ *          Сборка: файл кладется в main/ проекта ESP-IDF, библиотека - в components/:
+ *          @code
+ *          idf.py set-target esp32s3 && idf.py build flash monitor
+ *          @endcode
+ */
+
+#include "net/ble_config.h"
+#include "net/ble_rx_dispatch.h"
+#include "net/ble_task.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace
+{
+    constexpr auto TAG = "AFFINITY_BENCH";
+
+    constexpr size_t PAYLOAD = 244;                                ///< Длина записи (MTU 247)
+    constexpr int64_t STACK_WORK_US = 150;                         ///< Обработка записи стеком
+    constexpr int64_t APP_WORK_US = 400;                           ///< Обработка записи приложением
+    constexpr int64_t APP_SEND_US = 100;                           ///< Отправка приложения под мьютексом BLE
+    constexpr uint32_t APP_SEND_PERIOD_US = 2000;                  ///< Период отправок приложения
+    constexpr uint16_t CONN_ID = 0;                                ///< Соединение записей
+    constexpr uint32_t BURST = 6;                                  ///< Записей за событие соединения
+    constexpr uint64_t INTERVAL_US = 7500;                         ///< Интервал соединения, мкс
+    constexpr uint32_t BURSTS = 400;                               ///< Событий соединения в замере джиттера
+    constexpr int64_t SATURATION_US = 3000000;                     ///< Длительность замера пропускной способности
+    constexpr UBaseType_t BTC_PRIORITY = configMAX_PRIORITIES - 6; ///< Приоритет задачи BTC в ESP-IDF
+
+    /**
+     * @brief Вариант размещения обработки
+     */
+    struct Variant
+    {
+        const char* name; ///< Название
+        bool deferred;    ///< Доставка задачей ble_rx (иначе - в задаче BTC)
+        int8_t core;      ///< Ядро задачи ble_rx (см. BleTask)
+    };
+
+    /**
+     * @brief Выборка задержек (один писатель)
+     */
+    struct Samples
+    {
+        std::vector<uint32_t> values; ///< Задержки, мкс
+
+        void add(const int64_t value)
+        {
+            if (values.size() < values.capacity())
+            {
+                values.push_back(static_cast<uint32_t>(std::max<int64_t>(value, 0)));
+            }
+        }
+
+        uint32_t percentile(const unsigned percent)
+        {
+            if (values.empty()) return 0;
+            std::ranges::sort(values);
+            return values[(values.size() - 1) * percent / 100];
+        }
+    };
+
+    /**
+     * @brief Соединение (поля DeviceConnection, участвующие в доставке)
+     */
+    struct Connection
+    {
+        uint16_t connId;                                                        ///< Идентификатор соединения
+        uint32_t generation;                                                    ///< Номер подключения
+        std::function<void(uint16_t, std::span<const uint8_t>, void*)> handler; ///< Callback данных
+        void* context;                                                          ///< Контекст приложения
+    };
+
+    /**
+     * @brief Состояние замера
+     */
+    struct Bench
+    {
+        std::recursive_mutex mutex;          ///< Мьютекс BLE
+        std::vector<Connection> connections; ///< Активные соединения
+        net::BleRxDispatcher dispatcher;     ///< Доставка вариантов deferred
+        Variant variant = {};                ///< Текущий вариант
+        bool paced = false;                  ///< Замер джиттера (иначе - пропускной способности)
+        Samples stackDelay;                  ///< Задержка освобождения стека
+        Samples delivery;                    ///< Задержка доставки приложению
+        std::atomic<uint32_t> accepted = 0;  ///< Принято записей
+        std::atomic<uint32_t> lost = 0;      ///< Не принято записей (буфер заполнен)
+        std::atomic<uint32_t> processed = 0; ///< Обработано приложением
+        uint32_t processedInWindow = 0;      ///< Обработано до конца потока записей
+        std::atomic<int64_t> eventUs = 0;    ///< Начало текущего события соединения
+        TaskHandle_t btcTask = nullptr;      ///< Задача эмуляции BTC
+        TaskHandle_t mainTask = nullptr;     ///< Задача замера
+        std::atomic<bool> sending = false;   ///< Задача отправок приложения работает
+    };
+
+    Bench sBench;
+
+    void busyWait(const int64_t us)
+    {
+        const int64_t start = esp_timer_get_time();
+        while (esp_timer_get_time() - start < us)
+        {
+        }
+    }
+
+    /**
+     * @brief Обработчик приложения: время передачи стеком - в первых 8 байтах записи
+     */
+    void appHandler(uint16_t, const std::span<const uint8_t> data, void*)
+    {
+        int64_t handledUs = 0;
+        std::memcpy(&handledUs, data.data(), sizeof(handledUs));
+        sBench.delivery.add(esp_timer_get_time() - handledUs);
+        busyWait(APP_WORK_US);
+        sBench.processed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Доставка записи (как BLE::deliverData)
+     */
+    void deliver(const uint16_t connId, const uint32_t generation, const std::span<const uint8_t> data)
+    {
+        std::function<void(uint16_t, std::span<const uint8_t>, void*)> handler;
+        void* context = nullptr;
+        {
+            std::lock_guard lock(sBench.mutex);
+            const auto conn = std::ranges::find_if(sBench.connections,
+                                                   [connId](const auto& item) { return item.connId == connId; });
+            if (conn == sBench.connections.end() || conn->generation != generation) return;
+            handler = conn->handler;
+            context = conn->context;
+        }
+        handler(connId, data, context);
+    }
+
+    /**
+     * @brief Запись, принятая стеком (как BLE::handleWriteEvent и BLE::dispatchData)
+     */
+    bool handleWrite(uint8_t* payload)
+    {
+        busyWait(STACK_WORK_US);
+        const int64_t now = esp_timer_get_time();
+        std::memcpy(payload, &now, sizeof(now));
+
+        std::unique_lock lock(sBench.mutex);
+        const auto conn = std::ranges::find_if(sBench.connections,
+                                               [](const auto& item) { return item.connId == CONN_ID; });
+        const uint32_t generation = conn->generation;
+        if (sBench.variant.deferred)
+        {
+            return sBench.dispatcher.post(CONN_ID, generation, payload, PAYLOAD);
+        }
+
+        lock.unlock();
+        deliver(CONN_ID, generation, {payload, PAYLOAD});
+        return true;
+    }
+
+    /**
+     * @brief Отправки приложения: мьютекс BLE на время передачи уведомления стеку
+     */
+    void appSendTask(void*)
+    {
+        while (sBench.sending)
+        {
+            {
+                std::lock_guard lock(sBench.mutex);
+                busyWait(APP_SEND_US);
+            }
+            vTaskDelay(std::max<TickType_t>(pdMS_TO_TICKS(APP_SEND_PERIOD_US / 1000), 1));
+        }
+        xTaskNotifyGive(sBench.mainTask);
+        vTaskDelete(nullptr);
+    }
+
+    void btcTask(void*)
+    {
+        uint8_t payload[PAYLOAD] = {};
+        if (sBench.paced)
+        {
+            for (uint32_t burst = 0; burst < BURSTS; burst++)
+            {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                const int64_t eventUs = sBench.eventUs.load();
+                for (uint32_t i = 0; i < BURST; i++)
+                {
+                    const bool accepted = handleWrite(payload);
+                    (accepted ? sBench.accepted : sBench.lost).fetch_add(1, std::memory_order_relaxed);
+                    sBench.stackDelay.add(esp_timer_get_time() - eventUs - (i + 1) * STACK_WORK_US);
+                }
+            }
+        }
+        else
+        {
+            const int64_t end = esp_timer_get_time() + SATURATION_US;
+            while (esp_timer_get_time() < end)
+            {
+                if (handleWrite(payload))
+                {
+                    sBench.accepted.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    // Клиент повторит запись в следующем событии соединения
+                    sBench.lost.fetch_add(1, std::memory_order_relaxed);
+                    vTaskDelay(1);
+                }
+            }
+            sBench.processedInWindow = sBench.processed.load();
+        }
+
+        xTaskNotifyGive(sBench.mainTask);
+        vTaskDelete(nullptr);
+    }
+
+    void connectionEvent(void*)
+    {
+        sBench.eventUs = esp_timer_get_time();
+        xTaskNotifyGive(sBench.btcTask);
+    }
+
+    /**
+     * @brief Один замер варианта
+     */
+    void run(const Variant& variant, const bool paced)
+    {
+        sBench.variant = variant;
+        sBench.paced = paced;
+        sBench.stackDelay.values.clear();
+        sBench.delivery.values.clear();
+        sBench.accepted = 0;
+        sBench.lost = 0;
+        sBench.processed = 0;
+        sBench.processedInWindow = 0;
+        sBench.eventUs = 0;
+
+        net::BleConfig config;
+        config.rx.deferred = variant.deferred;
+        config.rx.taskCore = variant.core;
+        if (sBench.dispatcher.begin(config, deliver) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Dispatcher start failed");
+            return;
+        }
+
+        // Каждый замер - новое подключение, как после переподключения клиента
+        {
+            std::lock_guard lock(sBench.mutex);
+            const uint32_t generation = sBench.connections.empty() ? 1 : sBench.connections[0].generation + 1;
+            sBench.connections = {{CONN_ID, generation, appHandler, nullptr}};
+        }
+
+        TaskHandle_t sender = nullptr;
+        sBench.sending = true;
+        if (net::BleTask::create(appSendTask, "app_send", 3072, nullptr, tskIDLE_PRIORITY + 5,
+                                 net::BleTask::CORE_ANY, sender) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Create app task failed");
+            sBench.sending = false;
+            sBench.dispatcher.end();
+            return;
+        }
+
+        TaskHandle_t task = nullptr;
+        if (net::BleTask::create(btcTask, "btc_emu", 4096, nullptr, BTC_PRIORITY,
+                                 static_cast<int8_t>(net::BleTask::stackCore()), task) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Create BTC task failed");
+            sBench.sending = false;
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            sBench.dispatcher.end();
+            return;
+        }
+        sBench.btcTask = task;
+
+        esp_timer_handle_t timer = nullptr;
+        if (paced)
+        {
+            const esp_timer_create_args_t args = {
+                .callback = connectionEvent,
+                .arg = nullptr,
+                .dispatch_method = ESP_TIMER_TASK,
+                .name = "conn_event",
+                .skip_unhandled_events = true
+            };
+            esp_timer_create(&args, &timer);
+            esp_timer_start_periodic(timer, INTERVAL_US);
+        }
+
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (timer != nullptr)
+        {
+            esp_timer_stop(timer);
+            esp_timer_delete(timer);
+        }
+
+        sBench.dispatcher.end();
+        sBench.sending = false;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        const BaseType_t core = net::BleTask::resolveCore(variant.core);
+        char where[8];
+        if (!variant.deferred)
+        {
+            std::snprintf(where, sizeof(where), "btc");
+        }
+        else if (core == tskNO_AFFINITY)
+        {
+            std::snprintf(where, sizeof(where), "any");
+        }
+        else
+        {
+            std::snprintf(where, sizeof(where), "%d", static_cast<int>(core));
+        }
+
+        if (!paced)
+        {
+            ESP_LOGI(TAG, "%-12s core %-4s throughput %6lu writes/s, retries %lu", variant.name, where,
+                     static_cast<unsigned long>(sBench.processedInWindow * 1000000ull / SATURATION_US),
+                     static_cast<unsigned long>(sBench.lost.load()));
+            return;
+        }
+
+        Samples& stack = sBench.stackDelay;
+        Samples& delivery = sBench.delivery;
+        ESP_LOGI(TAG, "%-12s core %-4s stack delay %5lu/%5lu/%5lu us, delivery %5lu/%5lu/%5lu us, lost %lu",
+                 variant.name, where,
+                 static_cast<unsigned long>(stack.percentile(50)), static_cast<unsigned long>(stack.percentile(99)),
+                 static_cast<unsigned long>(stack.percentile(100)),
+                 static_cast<unsigned long>(delivery.percentile(50)),
+                 static_cast<unsigned long>(delivery.percentile(99)),
+                 static_cast<unsigned long>(delivery.percentile(100)), static_cast<unsigned long>(sBench.lost.load()));
+    }
+} // namespace
+
+extern "C" void app_main()
+{
+    sBench.mainTask = xTaskGetCurrentTaskHandle();
+    sBench.stackDelay.values.reserve(BURSTS * BURST);
+    sBench.delivery.values.reserve(BURSTS * BURST);
+
+    const int8_t stackCore = static_cast<int8_t>(net::BleTask::stackCore());
+    const Variant variants[] = {
+        {"inline", false, net::BleTask::CORE_AUTO},
+        {"same core", true, stackCore},
+        {"auto", true, net::BleTask::CORE_AUTO},
+        {"any", true, net::BleTask::CORE_ANY},
+    };
+
+    ESP_LOGI(TAG, "Cores: %d, stack core %d, stack work %lu us, app work %lu us, %u x %u B per %lu us",
+             portNUM_PROCESSORS, stackCore, static_cast<unsigned long>(STACK_WORK_US),
+             static_cast<unsigned long>(APP_WORK_US), static_cast<unsigned>(BURST), static_cast<unsigned>(PAYLOAD),
+             static_cast<unsigned long>(INTERVAL_US));
+    for (const Variant& variant : variants)
+    {
+        run(variant, false);
+    }
+    for (const Variant& variant : variants)
+    {
+        run(variant, true);
+    }
+}
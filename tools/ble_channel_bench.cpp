@@ -0,0 +1,416 @@
+/**
+ * @file ble_channel_bench.cpp
+ * @brief Сравнение пропускной способности каналов BleChannelTransport и уведомлений GATT
+ * @details Два транспорта (устройство и клиент) соединены моделью канального уровня:
+ *          время идет событиями соединения с интервалом --interval-ms, в каждом событии
+ *          в каждую сторону передается не больше --packets пакетов LL с полезной
+ *          нагрузкой --dle байт. Фрейм (ATT PDU + заголовок L2CAP) занимает целое число
+ *          пакетов LL; буфер контроллера вмещает --buffers фреймов, отправитель ждет
+ *          свободного места, как BLE::sendToDevice() ждет кредиты контроллера.
+ *          Клиент в событии передает первым, поэтому кредиты, возвращенные на фреймы
+ *          события k, приходят устройству в событии k + 1.
+ *
+ *          Сравниваются:
+ *          - notify: поток, нарезанный по ATT MTU - 3, без управления потоком получателя;
+ *          - channel: SDU размера --sdu через каналы с окном кредитов получателя
+ *            (перебираются окна 2, 4, 8, 16 или одно окно --credits).
+ *
+ *          Время модельное, поэтому результат не зависит от скорости хоста. Печатается
+ *          полезная пропускная способность, доля полезных байт в пакетах LL, количество
+ *          событий и ожиданий кредитов получателя.
+ *
+ *          Сборка и запуск (ESP-IDF, FreeRTOS и esp32-c3-common заменяются заглушками tools/host):
+ *          @code
+ *          g++ -std=c++20 -O2 -Iinclude -Iinclude/net -Itools/host \
+ *              tools/ble_channel_bench.cpp src/ble_channel.cpp -pthread -o ble_channel_bench
+ *          ./ble_channel_bench --interval-ms 15 --packets 4 --mtu 247 --sdu 512
+ *          @endcode
+ *
+ *          Параметры:
+ *          - --interval-ms N  интервал соединения, мс (по умолчанию 7.5)
+ *          - --packets N      пакетов LL в событии в каждую сторону (по умолчанию 6)
+ *          - --dle N          полезная нагрузка пакета LL, байт (27..251, по умолчанию 251)
+ *          - --mtu N          ATT MTU (по умолчанию 247)
+ *          - --sdu N          размер SDU канала (по умолчанию 512)
+ *          - --credits N      окно кредитов получателя (по умолчанию перебор)
+ *          - --buffers N      буферов контроллера, фреймов (по умолчанию 12)
+ *          - --total-kb N     объем передачи, КБ (по умолчанию 256)
+ */
+
+#include "net/ble_channel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using net::BleChannelTransport;
+
+namespace
+{
+    constexpr uint16_t CONN_ID = 1;
+    constexpr uint16_t PSM = 0x0080;
+
+    /// @brief Заголовок L2CAP на ATT PDU
+    constexpr size_t L2CAP_HEADER = 4;
+
+    /**
+     * @brief Параметры запуска
+     */
+    struct Options
+    {
+        double intervalMs = 7.5;
+        uint32_t packets = 6;
+        uint32_t dle = 251;
+        uint32_t mtu = 247;
+        uint32_t sdu = 512;
+        uint32_t credits = 0;
+        uint32_t buffers = 12;
+        uint32_t totalKb = 256;
+    };
+
+    /**
+     * @brief Результат прогона
+     */
+    struct Result
+    {
+        uint64_t payloadBytes = 0; ///< Доставлено байт приложения
+        uint64_t llBytes = 0;      ///< Передано байт полезной нагрузки LL (обе стороны)
+        uint64_t events = 0;       ///< Событий соединения
+        uint32_t stalls = 0;       ///< Ожиданий кредитов получателя
+    };
+
+    /**
+     * @brief Модель канального уровня между устройством и клиентом
+     */
+    class SimLink
+    {
+    public:
+        using Deliver = std::function<void(const uint8_t* data, size_t len)>;
+        using Blocked = std::function<bool()>;
+
+        explicit SimLink(const Options& options) :
+            mOptions(options)
+        {
+        }
+
+        /**
+         * @brief Фрейм устройства клиенту (blocking - ждать места в буфере контроллера)
+         */
+        esp_err_t sendForward(const uint8_t* data, const size_t len, const bool blocking)
+        {
+            if (mDirect)
+            {
+                mToClient(data, len);
+                return ESP_OK;
+            }
+
+            std::unique_lock lock(mMutex);
+            if (blocking)
+            {
+                mSpaceCv.wait(lock, [this] { return mForward.size() < mOptions.buffers; });
+            }
+            mForward.emplace_back(data, data + len);
+            mForwardPackets += llPackets(len);
+            return ESP_OK;
+        }
+
+        /**
+         * @brief Фрейм клиента устройству
+         */
+        esp_err_t sendReverse(const uint8_t* data, const size_t len)
+        {
+            if (mDirect)
+            {
+                mToDevice(data, len);
+                return ESP_OK;
+            }
+
+            std::lock_guard lock(mMutex);
+            mReverse.emplace_back(data, data + len);
+            return ESP_OK;
+        }
+
+        void setDirect(const bool direct) { mDirect = direct; }
+        void setReceivers(Deliver toClient, Deliver toDevice)
+        {
+            mToClient = std::move(toClient);
+            mToDevice = std::move(toDevice);
+        }
+        void setBlocked(Blocked blocked) { mBlocked = std::move(blocked); }
+        void producerDone() { mProducerDone = true; }
+
+        /**
+         * @brief Цикл событий соединения до завершения отправителя и опустошения буферов
+         */
+        void run(Result& result)
+        {
+            while (true)
+            {
+                // 1. Событие начинается, когда отправитель заполнил его, остался без кредитов
+                // получателя или закончил: время модели не зависит от скорости хоста
+                bool done = false;
+                while (true)
+                {
+                    const bool blocked = mBlocked && mBlocked();
+                    std::unique_lock lock(mMutex);
+                    const bool empty = mForward.empty() && mReverse.empty();
+                    if (mProducerDone && empty)
+                    {
+                        done = true;
+                        break;
+                    }
+                    if (mForwardPackets >= mOptions.packets || mProducerDone || blocked) break;
+                    lock.unlock();
+                    std::this_thread::sleep_for(std::chrono::microseconds(20));
+                }
+                if (done) break;
+
+                result.events++;
+
+                // 2. Клиент передает первым: кредиты, накопленные к началу события
+                transfer(mReverse, nullptr, mToDevice, result);
+
+                // 3. Устройство: фреймы целиком, пока хватает пакетов события
+                transfer(mForward, &mForwardPackets, mToClient, result);
+            }
+        }
+
+    private:
+        [[nodiscard]] uint32_t llPackets(const size_t frameLen) const
+        {
+            const size_t pdu = frameLen + BleChannelTransport::ATT_HEADER + L2CAP_HEADER;
+            return static_cast<uint32_t>((pdu + mOptions.dle - 1) / mOptions.dle);
+        }
+
+        void transfer(std::deque<std::vector<uint8_t>>& queue, uint32_t* queuedPackets, const Deliver& deliver,
+                      Result& result)
+        {
+            std::vector<std::vector<uint8_t>> batch;
+            {
+                std::lock_guard lock(mMutex);
+                uint32_t budget = mOptions.packets;
+                while (!queue.empty() && llPackets(queue.front().size()) <= budget)
+                {
+                    const uint32_t packets = llPackets(queue.front().size());
+                    budget -= packets;
+                    if (queuedPackets != nullptr) *queuedPackets -= packets;
+                    result.llBytes += queue.front().size() + BleChannelTransport::ATT_HEADER + L2CAP_HEADER;
+                    batch.push_back(std::move(queue.front()));
+                    queue.pop_front();
+                }
+            }
+            mSpaceCv.notify_all();
+
+            // Доставка без мьютекса модели: получатель отвечает через send*()
+            for (const auto& frame : batch)
+            {
+                deliver(frame.data(), frame.size());
+            }
+        }
+
+        const Options& mOptions;
+        std::mutex mMutex;
+        std::condition_variable mSpaceCv;
+        std::deque<std::vector<uint8_t>> mForward;
+        std::deque<std::vector<uint8_t>> mReverse;
+        uint32_t mForwardPackets = 0;
+        std::atomic<bool> mDirect = true;
+        std::atomic<bool> mProducerDone = false;
+        Deliver mToClient;
+        Deliver mToDevice;
+        Blocked mBlocked;
+    };
+
+    /**
+     * @brief Счетчик принятых байт
+     */
+    class ByteCounter : public esp32_c3::objects::Callback
+    {
+    public:
+        explicit ByteCounter(std::atomic<uint64_t>& bytes) :
+            mBytes(bytes)
+        {
+        }
+
+        void invoke(void* data) override
+        {
+            mBytes += static_cast<Packet*>(data)->size;
+        }
+
+    private:
+        std::atomic<uint64_t>& mBytes;
+    };
+
+    Result runNotify(const Options& options)
+    {
+        SimLink link(options);
+        Result result;
+        std::atomic<uint64_t> received = 0;
+        link.setReceivers([&](const uint8_t*, const size_t len) { received += len; },
+                          [](const uint8_t*, size_t) {});
+        link.setDirect(false);
+
+        const uint64_t total = static_cast<uint64_t>(options.totalKb) * 1024;
+        std::thread producer([&]
+        {
+            std::vector<uint8_t> chunk(options.mtu - BleChannelTransport::ATT_HEADER, 0x5A);
+            for (uint64_t sent = 0; sent < total;)
+            {
+                const size_t len = static_cast<size_t>(std::min<uint64_t>(chunk.size(), total - sent));
+                link.sendForward(chunk.data(), len, true);
+                sent += len;
+            }
+            link.producerDone();
+        });
+
+        link.run(result);
+        producer.join();
+        result.payloadBytes = received;
+        return result;
+    }
+
+    Result runChannel(const Options& options, const uint16_t credits)
+    {
+        SimLink link(options);
+        Result result;
+        std::atomic<uint64_t> received = 0;
+
+        BleChannelTransport device([&](uint16_t, const uint8_t* data, const size_t len, const bool blocking)
+        {
+            return link.sendForward(data, len, blocking);
+        });
+        BleChannelTransport client([&](uint16_t, const uint8_t* data, const size_t len, bool)
+        {
+            return link.sendReverse(data, len);
+        });
+        link.setReceivers([&](const uint8_t* data, const size_t len) { client.handleFrame(CONN_ID, data, len); },
+                          [&](const uint8_t* data, const size_t len) { device.handleFrame(CONN_ID, data, len); });
+
+        device.setLinkMtu(static_cast<uint16_t>(options.mtu));
+        client.setLinkMtu(static_cast<uint16_t>(options.mtu));
+        const uint16_t sduMtu = static_cast<uint16_t>(std::min<uint32_t>(options.sdu, MAX_MTU));
+        device.registerPsm(PSM, {.sduMtu = sduMtu, .initialCredits = credits},
+                           std::make_unique<ByteCounter>(received));
+        client.registerPsm(PSM, {.sduMtu = sduMtu, .initialCredits = credits},
+                           std::make_unique<ByteCounter>(received));
+
+        // Открытие канала вне модели времени
+        client.connectChannel(CONN_ID, PSM);
+        link.setDirect(false);
+        link.setBlocked([&device]
+        {
+            // Без кредитов получателя отправитель ждет возврата, событие не заполнится
+            BleChannelTransport::ChannelStatistics stats = {};
+            return device.getStatistics(CONN_ID, PSM, stats) != ESP_OK || stats.localCredits == 0;
+        });
+
+        const uint64_t total = static_cast<uint64_t>(options.totalKb) * 1024;
+        std::thread producer([&]
+        {
+            std::vector<uint8_t> sdu(sduMtu, 0xA5);
+            for (uint64_t sent = 0; sent < total;)
+            {
+                const size_t len = static_cast<size_t>(std::min<uint64_t>(sdu.size(), total - sent));
+                if (device.sendSdu(CONN_ID, PSM, sdu.data(), len, portMAX_DELAY) != ESP_OK) break;
+                sent += len;
+            }
+            link.producerDone();
+        });
+
+        link.run(result);
+        producer.join();
+
+        BleChannelTransport::ChannelStatistics stats = {};
+        device.getStatistics(CONN_ID, PSM, stats);
+        result.stalls = stats.creditStalls;
+        result.payloadBytes = received;
+        return result;
+    }
+
+    void print(const char* mode, const uint32_t credits, const Result& result, const Options& options)
+    {
+        const double seconds = static_cast<double>(result.events) * options.intervalMs / 1000.0;
+        const double kbps = seconds > 0 ? static_cast<double>(result.payloadBytes) * 8 / 1000.0 / seconds : 0;
+        const double efficiency = result.llBytes != 0 ?
+            100.0 * static_cast<double>(result.payloadBytes) / static_cast<double>(result.llBytes) : 0;
+        if (credits == 0)
+        {
+            std::printf("%-8s %7s %10.1f %9.1f%% %9llu %7u\n", mode, "-", kbps, efficiency,
+                        static_cast<unsigned long long>(result.events), result.stalls);
+        }
+        else
+        {
+            std::printf("%-8s %7u %10.1f %9.1f%% %9llu %7u\n", mode, credits, kbps, efficiency,
+                        static_cast<unsigned long long>(result.events), result.stalls);
+        }
+    }
+
+    bool parseOptions(const int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view arg = argv[i];
+            if (i + 1 >= argc)
+            {
+                std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+                return false;
+            }
+            const char* value = argv[++i];
+
+            if (arg == "--interval-ms") options.intervalMs = std::strtod(value, nullptr);
+            else if (arg == "--packets") options.packets = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (arg == "--dle") options.dle = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (arg == "--mtu") options.mtu = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (arg == "--sdu") options.sdu = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (arg == "--credits") options.credits = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (arg == "--buffers") options.buffers = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (arg == "--total-kb") options.totalKb = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else
+            {
+                std::fprintf(stderr, "Unknown option: %s\n", argv[i - 1]);
+                return false;
+            }
+        }
+
+        options.dle = std::clamp<uint32_t>(options.dle, 27, 251);
+        options.mtu = std::clamp<uint32_t>(options.mtu, BleChannelTransport::MIN_SDU_MTU, MAX_MTU);
+        options.sdu = std::clamp<uint32_t>(options.sdu, BleChannelTransport::MIN_SDU_MTU, MAX_MTU);
+        options.packets = std::max<uint32_t>(options.packets, 1);
+        // Самый длинный фрейм должен помещаться в одно событие, буфер - вмещать событие
+        const uint32_t framePackets = (options.mtu + L2CAP_HEADER + options.dle - 1) / options.dle;
+        options.packets = std::max(options.packets, framePackets);
+        options.buffers = std::max(options.buffers, options.packets);
+        return true;
+    }
+} // namespace
+
+int main(const int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 2;
+
+    std::printf("interval=%.2fms packets=%u dle=%u mtu=%u sdu=%u buffers=%u total=%uKB\n\n",
+                options.intervalMs, options.packets, options.dle, options.mtu, options.sdu, options.buffers,
+                options.totalKb);
+    std::printf("%-8s %7s %10s %10s %9s %7s\n", "mode", "credits", "kbps", "payload", "events", "stalls");
+
+    print("notify", 0, runNotify(options), options);
+
+    const std::vector<uint32_t> windows = options.credits != 0 ?
+        std::vector<uint32_t>{options.credits} : std::vector<uint32_t>{2, 4, 8, 16};
+    for (const uint32_t credits : windows)
+    {
+        print("channel", credits, runChannel(options, static_cast<uint16_t>(credits)), options);
+    }
+    return 0;
+}
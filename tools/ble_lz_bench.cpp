@@ -0,0 +1,323 @@
+/**
+ * @file ble_lz_bench.cpp
+ * @brief Степень сжатия и затраты CPU кодека BleLz на хосте
+ * @details Прогоняет типичные полезные нагрузки (JSON-телеметрия, бинарные структуры
+ *          датчиков, строки лога, случайные данные) кадрами заданного размера через
+ *          BleLzEncoder/BleLzDecoder с общим окном, как BleCompression на соединении:
+ *          кадр, который не сжался, уходит как есть (заголовок + данные). Печатает
+ *          отношение байт в эфире к исходным (с учетом байта заголовка), время сжатия
+ *          и распаковки на байт и проверяет совпадение распакованных данных.
+ *          Время на хосте не равно времени на ESP32-C3 (160 МГц, RV32IMC), но
+ *          соотношение между вариантами сохраняется; для оценки на устройстве время
+ *          умножается примерно на 15-25.
+ *
+ *          Сборка и запуск:
+ *          @code
+ *          g++ -std=c++20 -O2 -Iinclude tools/ble_lz_bench.cpp src/ble_lz.cpp -o ble_lz_bench
+ *          ./ble_lz_bench --frame 244 --bytes 1000000
+ *          @endcode
+ *
+ *          Параметры:
+ *          - --frame N   размер кадра (полезная нагрузка уведомления), по умолчанию 20, 100 и 244
+ *          - --bytes N   объем данных на каждую нагрузку (по умолчанию 500000)
+ *          - --window N  размер окна, бит (по умолчанию 8, 10 и 12)
+ */
+
+#include "net/ble_lz.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    /// @brief Байт заголовка кадра (см. BleCompression)
+    constexpr size_t HEADER_SIZE = 1;
+
+    /**
+     * @brief Нагрузка для замера
+     */
+    struct Workload
+    {
+        const char* name;          ///< Название
+        std::vector<uint8_t> data; ///< Поток данных
+    };
+
+    /**
+     * @brief JSON-телеметрия: одинаковые ключи, медленно меняющиеся значения
+     */
+    std::vector<uint8_t> makeJson(const size_t bytes, std::mt19937& rng)
+    {
+        std::vector<uint8_t> out;
+        std::normal_distribution<double> noise(0.0, 0.05);
+        double temperature = 23.4;
+        double humidity = 41.0;
+        uint32_t sequence = 0;
+        char line[160];
+        while (out.size() < bytes)
+        {
+            temperature += noise(rng);
+            humidity += noise(rng);
+            const int len = std::snprintf(line, sizeof(line),
+                                          "{\"seq\":%u,\"t\":%.2f,\"h\":%.1f,\"bat\":%u,\"state\":\"ok\"}\n",
+                                          sequence, temperature, humidity, 3700 - sequence / 1000);
+            sequence++;
+            out.insert(out.end(), line, line + len);
+        }
+        out.resize(bytes);
+        return out;
+    }
+
+    /**
+     * @brief Бинарные отсчеты датчиков: структура 16 байт, малые изменения между отсчетами
+     */
+    std::vector<uint8_t> makeBinary(const size_t bytes, std::mt19937& rng)
+    {
+        struct Sample
+        {
+            uint32_t timestampMs;
+            int16_t accel[3];
+            uint16_t pressure;
+            uint8_t flags;
+            uint8_t reserved[3];
+        };
+        static_assert(sizeof(Sample) == 16);
+
+        std::vector<uint8_t> out;
+        std::uniform_int_distribution<int> jitter(-2, 2);
+        Sample sample = {0, {12, -3, 1010}, 10132, 0x01, {}};
+        while (out.size() < bytes)
+        {
+            sample.timestampMs += 10;
+            for (auto& axis : sample.accel)
+            {
+                axis = static_cast<int16_t>(axis + jitter(rng));
+            }
+            if (jitter(rng) == 2)
+            {
+                sample.pressure = static_cast<uint16_t>(sample.pressure + jitter(rng));
+            }
+            const auto* raw = reinterpret_cast<const uint8_t*>(&sample);
+            out.insert(out.end(), raw, raw + sizeof(sample));
+        }
+        out.resize(bytes);
+        return out;
+    }
+
+    /**
+     * @brief Строки лога с повторяющимися шаблонами
+     */
+    std::vector<uint8_t> makeLog(const size_t bytes, std::mt19937& rng)
+    {
+        static constexpr const char* MESSAGES[] = {
+            "I (%u) SENSOR: sample ready, queue depth %u\n",
+            "W (%u) BLE: notify congested, retry %u\n",
+            "I (%u) POWER: battery %u mV\n",
+            "D (%u) CTRL: setpoint reached after %u ms\n",
+        };
+        std::vector<uint8_t> out;
+        std::uniform_int_distribution<unsigned> pick(0, std::size(MESSAGES) - 1);
+        std::uniform_int_distribution<unsigned> value(0, 4000);
+        uint32_t timeMs = 0;
+        char line[160];
+        while (out.size() < bytes)
+        {
+            timeMs += value(rng) % 50;
+            const int len = std::snprintf(line, sizeof(line), MESSAGES[pick(rng)], timeMs, value(rng));
+            out.insert(out.end(), line, line + len);
+        }
+        out.resize(bytes);
+        return out;
+    }
+
+    /**
+     * @brief Случайные данные (худший случай: сжатие не помогает)
+     */
+    std::vector<uint8_t> makeRandom(const size_t bytes, std::mt19937& rng)
+    {
+        std::vector<uint8_t> out(bytes);
+        std::uniform_int_distribution<int> byte(0, 255);
+        for (auto& value : out)
+        {
+            value = static_cast<uint8_t>(byte(rng));
+        }
+        return out;
+    }
+
+    /**
+     * @brief Результат замера
+     */
+    struct Result
+    {
+        double ratio;          ///< Байт в эфире / исходных
+        double compressNs;     ///< Сжатие, нс на исходный байт
+        double decompressNs;   ///< Распаковка, нс на исходный байт
+        double rawFrames;      ///< Доля кадров, ушедших без сжатия
+        bool verified;         ///< Распакованные данные совпали
+    };
+
+    Result run(const std::vector<uint8_t>& data, const size_t frame, const uint8_t windowBits)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        net::BleLzEncoder encoder(windowBits, frame);
+        net::BleLzDecoder decoder(windowBits, frame);
+
+        /**
+         * @brief Кадр в эфире
+         */
+        struct Frame
+        {
+            size_t offset;   ///< Смещение в wire
+            size_t size;     ///< Длина без заголовка
+            bool compressed; ///< Сжатый кадр
+        };
+
+        // Буферы выделяются заранее: в замер попадает только работа кодека
+        std::vector<uint8_t> wire(net::BleLz::maxCompressedSize(data.size()) + frame);
+        std::vector<Frame> frames;
+        frames.reserve(data.size() / frame + 1);
+
+        // Сжатие: как BleCompression::encode - кадр не короче исходного уходит без сжатия
+        size_t wireBytes = 0;
+        size_t rawFrames = 0;
+        const auto compressStart = Clock::now();
+        for (size_t offset = 0; offset < data.size(); offset += frame)
+        {
+            const size_t len = std::min(frame, data.size() - offset);
+            const size_t size = encoder.compress(data.data() + offset, len, wire.data() + wireBytes, len - 1);
+            encoder.commit();
+            if (size == 0)
+            {
+                std::memcpy(wire.data() + wireBytes, data.data() + offset, len);
+                frames.push_back({wireBytes, len, false});
+                rawFrames++;
+            }
+            else
+            {
+                frames.push_back({wireBytes, size, true});
+            }
+            wireBytes += frames.back().size;
+        }
+        const auto compressTime = Clock::now() - compressStart;
+
+        bool verified = true;
+        size_t offset = 0;
+        const auto decompressStart = Clock::now();
+        for (const Frame& item : frames)
+        {
+            std::span<const uint8_t> plain;
+            const bool ok = item.compressed
+                ? decoder.decompress(wire.data() + item.offset, item.size, plain)
+                : decoder.store(wire.data() + item.offset, item.size, plain);
+            if (!ok || std::memcmp(plain.data(), data.data() + offset, plain.size()) != 0)
+            {
+                verified = false;
+                break;
+            }
+            offset += plain.size();
+        }
+        const auto decompressTime = Clock::now() - decompressStart;
+        verified = verified && offset == data.size();
+
+        const auto nsPerByte = [&](const Clock::duration duration)
+        {
+            return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) /
+                static_cast<double>(data.size());
+        };
+        return {
+            static_cast<double>(wireBytes + frames.size() * HEADER_SIZE) / static_cast<double>(data.size()),
+            nsPerByte(compressTime),
+            nsPerByte(decompressTime),
+            static_cast<double>(rawFrames) / static_cast<double>(frames.size()),
+            verified
+        };
+    }
+
+    size_t parseSize(const char* value, const char* option)
+    {
+        char* end = nullptr;
+        const unsigned long result = std::strtoul(value, &end, 10);
+        if (end == value || *end != '\0' || result == 0)
+        {
+            std::fprintf(stderr, "Invalid value for %s: %s\n", option, value);
+            std::exit(1);
+        }
+        return result;
+    }
+} // namespace
+
+int main(const int argc, char** argv)
+{
+    std::vector<size_t> frames = {20, 100, 244};
+    std::vector<uint8_t> windows = {8, 10, 12};
+    size_t bytes = 500000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return 1;
+        }
+        if (arg == "--frame")
+        {
+            frames = {parseSize(argv[++i], "--frame")};
+        }
+        else if (arg == "--bytes")
+        {
+            bytes = parseSize(argv[++i], "--bytes");
+        }
+        else if (arg == "--window")
+        {
+            const size_t bits = parseSize(argv[++i], "--window");
+            if (bits < net::BleLz::MIN_WINDOW_BITS || bits > net::BleLz::MAX_WINDOW_BITS)
+            {
+                std::fprintf(stderr, "Window must be %u..%u bits\n", net::BleLz::MIN_WINDOW_BITS,
+                             net::BleLz::MAX_WINDOW_BITS);
+                return 1;
+            }
+            windows = {static_cast<uint8_t>(bits)};
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(42);
+    const Workload workloads[] = {
+        {"json", makeJson(bytes, rng)},
+        {"binary", makeBinary(bytes, rng)},
+        {"log", makeLog(bytes, rng)},
+        {"random", makeRandom(bytes, rng)},
+    };
+
+    std::printf("%-8s %6s %7s %8s %9s %12s %14s\n",
+                "payload", "frame", "window", "ratio", "raw, %", "comp ns/B", "decomp ns/B");
+    bool ok = true;
+    for (const Workload& workload : workloads)
+    {
+        for (const size_t frame : frames)
+        {
+            for (const uint8_t window : windows)
+            {
+                const Result result = run(workload.data, frame, window);
+                std::printf("%-8s %6zu %7u %8.3f %9.1f %12.2f %14.2f%s\n",
+                            workload.name, frame, 1u << window, result.ratio, result.rawFrames * 100.0,
+                            result.compressNs, result.decompressNs, result.verified ? "" : "  MISMATCH");
+                ok = ok && result.verified;
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,409 @@
+/**
+ * @file ble_preset_tuner.cpp
+ * @brief Подбор пресета BleConfig на хосте
+ * @details Перебирает интервал рекламы, интервал соединения, PHY и длину пакета (DLE)
+ *          на модели радиоканала и печатает таблицы пропускной способности, задержки
+ *          и оценки энергопотребления (доля времени работы радио). Модель учитывает
+ *          время передачи пакетов на каждом PHY, T_IFS, пустые подтверждения,
+ *          заголовки L2CAP/ATT и накладные расходы на пробуждение; она предназначена
+ *          для сравнения вариантов между собой, а не для точного прогноза.
+ *
+ *          Встроенные пресеты берутся из констант net::presets (ble_config.h), поэтому
+ *          таблица отмечает их по тем же значениям, с которыми собирается прошивка.
+ *
+ *          Сборка и запуск (ESP-IDF и FreeRTOS заменяются заглушками tools/host):
+ *          @code
+ *          g++ -std=c++20 -O2 -Iinclude -Iinclude/net -Itools/host tools/ble_preset_tuner.cpp -o ble_preset_tuner
+ *          ./ble_preset_tuner --min-kbps 200 --max-latency-ms 30
+ *          @endcode
+ *
+ *          Параметры:
+ *          - --min-kbps N        минимальная пропускная способность для рекомендации
+ *          - --max-latency-ms N  максимальная средняя задержка для рекомендации
+ *          - --mtu N             ATT MTU (по умолчанию 247)
+ *          - --latency N         slave latency (по умолчанию 0)
+ *          - --max-packets N     ограничение пакетов за событие соединения (0 - без ограничения)
+ *          - --encrypted         учитывать MIC (4 байта) в каждом пакете данных
+ *          - --adv-data N        размер рекламных данных, байт (по умолчанию 31)
+ */
+
+#include "net/ble_config.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    /// @brief Межкадровый интервал T_IFS, мкс
+    constexpr double T_IFS_US = 150.0;
+
+    /// @brief Накладные расходы на пробуждение и подготовку радио в каждом событии, мкс
+    constexpr double WAKEUP_US = 400.0;
+
+    /// @brief Запас в конце события соединения, мкс
+    constexpr double EVENT_MARGIN_US = 500.0;
+
+    /// @brief Заголовки L2CAP (4) и ATT (3) на ATT PDU
+    constexpr double L2CAP_ATT_OVERHEAD = 7.0;
+
+    /**
+     * @brief Физический уровень
+     */
+    enum class Phy : uint8_t
+    {
+        PHY_1M,
+        PHY_2M,
+        CODED_S8
+    };
+
+    const char* phyName(const Phy phy)
+    {
+        switch (phy)
+        {
+        case Phy::PHY_1M: return "1M";
+        case Phy::PHY_2M: return "2M";
+        case Phy::CODED_S8: return "Coded";
+        }
+        return "?";
+    }
+
+    /// @brief Имя маски предпочтений PHY для BleConfig::connection
+    const char* phyMaskName(const Phy phy)
+    {
+        switch (phy)
+        {
+        case Phy::PHY_1M: return "ESP_BLE_GAP_PHY_1M_PREF_MASK";
+        case Phy::PHY_2M: return "ESP_BLE_GAP_PHY_2M_PREF_MASK";
+        case Phy::CODED_S8: return "ESP_BLE_GAP_PHY_CODED_PREF_MASK";
+        }
+        return "0";
+    }
+
+    /**
+     * @brief Время передачи пакета канального уровня
+     * @param phy Физический уровень
+     * @param payload Длина полезной нагрузки PDU (включая MIC), байт
+     * @return double Время в эфире, мкс
+     */
+    double packetAirtimeUs(const Phy phy, const double payload)
+    {
+        switch (phy)
+        {
+        case Phy::PHY_1M:
+            // преамбула 1 + AA 4 + заголовок 2 + данные + CRC 3, 1 мкс на бит
+            return (10.0 + payload) * 8.0;
+        case Phy::PHY_2M:
+            // преамбула 2 + AA 4 + заголовок 2 + данные + CRC 3, 0.5 мкс на бит
+            return (11.0 + payload) * 4.0;
+        case Phy::CODED_S8:
+            // преамбула 80 + AA 256 + CI 16 + TERM1 24 + (заголовок, данные, CRC) * 64 + TERM2 24
+            return 400.0 + (5.0 + payload) * 64.0;
+        }
+        return 0.0;
+    }
+
+    /**
+     * @brief Параметры варианта соединения
+     */
+    struct ConnCase
+    {
+        Phy phy;            ///< PHY соединения
+        uint16_t dle;       ///< Максимальная длина PDU данных (27 или 251)
+        uint16_t interval;  ///< Интервал соединения, единицы 1.25 мс
+        const char* preset; ///< Встроенный пресет с такими параметрами (или nullptr)
+    };
+
+    /**
+     * @brief Результат моделирования соединения
+     */
+    struct ConnResult
+    {
+        ConnCase params;       ///< Параметры
+        double kbps;           ///< Полезная пропускная способность, кбит/с
+        double avgLatencyMs;   ///< Средняя задержка доставки, мс
+        double worstLatencyMs; ///< Худшая задержка доставки, мс
+        double idleDutyPct;    ///< Доля работы радио без данных, %
+        double usPerKb;        ///< Время работы радио на 1 КБ данных, мкс
+        int packetsPerEvent;   ///< Пакетов данных за событие
+    };
+
+    /**
+     * @brief Опции командной строки
+     */
+    struct Options
+    {
+        double minKbps = 0.0;      ///< Требуемая пропускная способность
+        double maxLatencyMs = 1e9; ///< Допустимая средняя задержка
+        uint16_t mtu = 247;        ///< ATT MTU
+        uint16_t latency = 0;      ///< Slave latency
+        int maxPackets = 0;        ///< Ограничение пакетов за событие
+        bool encrypted = false;    ///< Учитывать MIC
+        uint16_t advData = 31;     ///< Размер рекламных данных
+    };
+
+    ConnResult simulateConnection(const ConnCase& params, const Options& options)
+    {
+        const double mic = options.encrypted ? 4.0 : 0.0;
+        const double intervalUs = params.interval * 1250.0;
+
+        const double dataUs = packetAirtimeUs(params.phy, params.dle + mic);
+        const double emptyUs = packetAirtimeUs(params.phy, 0.0);
+        const double exchangeUs = dataUs + T_IFS_US + emptyUs + T_IFS_US;
+
+        // Пакет, не помещающийся в событие, контроллер не передаст (connMaxTxTime)
+        int packets = std::max(static_cast<int>((intervalUs - EVENT_MARGIN_US) / exchangeUs), 0);
+        if (options.maxPackets > 0)
+        {
+            packets = std::min(packets, options.maxPackets);
+        }
+
+        // Доля полезных данных в байтах L2CAP: ATT payload / (ATT payload + заголовки)
+        const double attPayload = options.mtu - 3.0;
+        const double efficiency = attPayload / (attPayload + L2CAP_ATT_OVERHEAD);
+        const double bytesPerEvent = packets * params.dle * efficiency;
+
+        ConnResult result = {};
+        result.params = params;
+        result.packetsPerEvent = packets;
+        result.kbps = bytesPerEvent * 8.0 / (intervalUs / 1000.0);
+
+        // Данные ждут ближайшего события: в среднем половина интервала
+        result.avgLatencyMs = intervalUs / 2000.0 + dataUs / 1000.0;
+        result.worstLatencyMs = intervalUs * (1.0 + options.latency) / 1000.0 + dataUs / 1000.0;
+
+        const double idleEventUs = WAKEUP_US + emptyUs + T_IFS_US + emptyUs;
+        result.idleDutyPct = idleEventUs / (intervalUs * (1.0 + options.latency)) * 100.0;
+
+        const double activeUs = WAKEUP_US + packets * exchangeUs;
+        result.usPerKb = packets > 0 ? activeUs / (bytesPerEvent / 1024.0) : 0.0;
+        return result;
+    }
+
+    void printConnectionTable(const std::vector<ConnResult>& results)
+    {
+        printf("\nConnection sweep (interval, PHY, DLE)\n");
+        printf("%-8s %-6s %-5s %-7s %-10s %-9s %-11s %-10s %-11s %s\n",
+               "CI(ms)", "PHY", "DLE", "pkt/ev", "kbps", "avg(ms)", "worst(ms)", "idle(%)", "radio us/KB",
+               "preset");
+        for (const auto& r : results)
+        {
+            if (r.packetsPerEvent == 0)
+            {
+                printf("%-8.2f %-6s %-5u PDU does not fit into the connection event\n",
+                       r.params.interval * 1.25, phyName(r.params.phy), r.params.dle);
+                continue;
+            }
+            printf("%-8.2f %-6s %-5u %-7d %-10.1f %-9.2f %-11.2f %-10.3f %-11.0f %s\n",
+                   r.params.interval * 1.25, phyName(r.params.phy), r.params.dle, r.packetsPerEvent,
+                   r.kbps, r.avgLatencyMs, r.worstLatencyMs, r.idleDutyPct, r.usPerKb,
+                   r.params.preset ? r.params.preset : "");
+        }
+    }
+
+    void printAdvertisingTable(const Options& options)
+    {
+        // Интервалы рекламы, единицы 0.625 мс
+        constexpr uint16_t INTERVALS[] = {0x20, 0x30, 0x40, 0x80, 0xA0, 0x200, 0x400, 0x640};
+
+        // Legacy ADV_IND на 1M: AdvA 6 + данные
+        const double legacyUs = packetAirtimeUs(Phy::PHY_1M, 6.0 + options.advData);
+        // Extended: ADV_EXT_IND на 1M (~13 байт) + AUX_ADV_IND на 2M (~15 байт заголовка + данные)
+        const double extUs = 3.0 * packetAirtimeUs(Phy::PHY_1M, 13.0) +
+            packetAirtimeUs(Phy::PHY_2M, 15.0 + options.advData);
+
+        printf("\nAdvertising sweep (%u bytes of AD data, 3 channels)\n", options.advData);
+        printf("%-10s %-16s %-16s %-14s %s\n", "ADV(ms)", "discovery(ms)", "worst(ms)", "legacy duty(%)",
+               "ext duty(%)");
+        for (const uint16_t interval : INTERVALS)
+        {
+            const double intervalMs = interval * 0.625;
+            // advDelay 0..10 мс добавляется к каждому событию
+            const double meanMs = intervalMs / 2.0 + 5.0;
+            const double worstMs = intervalMs + 10.0;
+            const double eventMs = intervalMs + 5.0;
+            const double legacyDuty = (WAKEUP_US + 3.0 * legacyUs) / (eventMs * 1000.0) * 100.0;
+            const double extDuty = (WAKEUP_US + extUs) / (eventMs * 1000.0) * 100.0;
+            printf("%-10.2f %-16.2f %-16.2f %-14.3f %.3f\n", intervalMs, meanMs, worstMs, legacyDuty, extDuty);
+        }
+    }
+
+    void printRecommendation(const std::vector<ConnResult>& results, const Options& options)
+    {
+        const ConnResult* best = nullptr;
+        for (const auto& r : results)
+        {
+            if (r.packetsPerEvent == 0 || r.kbps < options.minKbps || r.avgLatencyMs > options.maxLatencyMs)
+            {
+                continue;
+            }
+            // Минимальная доля работы радио в простое, при равенстве - больше пропускная способность
+            if (best == nullptr || r.idleDutyPct < best->idleDutyPct ||
+                (r.idleDutyPct == best->idleDutyPct && r.kbps > best->kbps))
+            {
+                best = &r;
+            }
+        }
+
+        if (best == nullptr)
+        {
+            printf("\nNo combination meets --min-kbps %.1f and --max-latency-ms %.1f\n",
+                   options.minKbps, options.maxLatencyMs);
+            return;
+        }
+
+        const auto& p = best->params;
+        // Таймаут супервизии: не меньше 6 пропущенных событий с учетом latency, не меньше 1 с
+        const unsigned minTimeout = static_cast<unsigned>((1u + options.latency) * p.interval * 6u / 8u + 1u);
+        const unsigned timeout = std::min(std::max(minTimeout, 100u), 0x0C80u);
+
+        printf("\nRecommended: CI %.2f ms, PHY %s, DLE %u -> %.1f kbps, avg latency %.2f ms, idle duty %.3f%%\n",
+               p.interval * 1.25, phyName(p.phy), p.dle, best->kbps, best->avgLatencyMs, best->idleDutyPct);
+        printf("\nconstexpr auto TUNED_CONFIG = net::BleConfig::compose(net::BleConfig::Preset::%s,\n",
+               p.phy == Phy::PHY_1M && p.dle == 27 ? "BLE4_DEFAULT" : "BLE5_DEFAULT");
+        printf("    [](net::BleConfig& config) {\n");
+        printf("        config.connection.txPhy = %s;\n", phyMaskName(p.phy));
+        printf("        config.connection.rxPhy = %s;\n", phyMaskName(p.phy));
+        printf("        config.connection.minInterval = 0x%02X;\n", p.interval);
+        printf("        config.connection.maxInterval = 0x%02X;\n", p.interval);
+        printf("        config.connection.latency = %u;\n", options.latency);
+        printf("        config.connection.supervisionTimeout = %u;\n", timeout);
+        printf("    });\n");
+        printf("static_assert(TUNED_CONFIG.isValid());\n");
+    }
+
+    bool parseOptions(const int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--encrypted")
+            {
+                options.encrypted = true;
+            }
+            else if (arg == "--min-kbps" && hasValue)
+            {
+                options.minKbps = atof(argv[++i]);
+            }
+            else if (arg == "--max-latency-ms" && hasValue)
+            {
+                options.maxLatencyMs = atof(argv[++i]);
+            }
+            else if (arg == "--mtu" && hasValue)
+            {
+                options.mtu = static_cast<uint16_t>(std::clamp(atoi(argv[++i]), 23, 517));
+            }
+            else if (arg == "--latency" && hasValue)
+            {
+                options.latency = static_cast<uint16_t>(std::clamp(atoi(argv[++i]), 0, 499));
+            }
+            else if (arg == "--max-packets" && hasValue)
+            {
+                options.maxPackets = std::max(atoi(argv[++i]), 0);
+            }
+            else if (arg == "--adv-data" && hasValue)
+            {
+                options.advData = static_cast<uint16_t>(std::clamp(atoi(argv[++i]), 0, 251));
+            }
+            else
+            {
+                fprintf(stderr, "Unknown option: %s\n", argv[i]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Вариант соединения встроенного пресета
+     * @details PHY - предпочтительный из connection.txPhy (без BLE 5 фич контроллера - 1M),
+     *          DLE - power.txOctets, интервал - connection.minInterval.
+     */
+    constexpr ConnCase presetCase(const char* name, const net::BleConfig& config)
+    {
+        Phy phy = Phy::CODED_S8;
+        if (!config.controller.ble_50_feat_supp || config.connection.txPhy == ESP_BLE_GAP_PHY_1M_PREF_MASK)
+        {
+            phy = Phy::PHY_1M;
+        }
+        else if ((config.connection.txPhy & ESP_BLE_GAP_PHY_2M_PREF_MASK) != 0)
+        {
+            phy = Phy::PHY_2M;
+        }
+        else if ((config.connection.txPhy & ESP_BLE_GAP_PHY_1M_PREF_MASK) != 0)
+        {
+            phy = Phy::PHY_1M;
+        }
+        return {phy, config.power.txOctets, config.connection.minInterval, name};
+    }
+
+    /// @brief Встроенные пресеты BleConfig
+    constexpr ConnCase PRESETS[] = {
+        presetCase("BLE5_ULTRA_PERF", net::presets::BLE5_ULTRA_PERF),
+        presetCase("BLE5_DEFAULT", net::presets::BLE5_DEFAULT),
+        presetCase("BLE5_LOW_POWER", net::presets::BLE5_LOW_POWER),
+        presetCase("BLE4_HIGH_PERF", net::presets::BLE4_HIGH_PERF),
+        presetCase("BLE4_DEFAULT", net::presets::BLE4_DEFAULT),
+        presetCase("BLE4_LOW_POWER", net::presets::BLE4_LOW_POWER),
+    };
+
+    /**
+     * @brief Встроенный пресет, совпадающий с вариантом соединения
+     */
+    const char* builtInPreset(const Phy phy, const uint16_t dle, const uint16_t interval)
+    {
+        for (const ConnCase& preset : PRESETS)
+        {
+            if (preset.phy == phy && preset.dle == dle && preset.interval == interval) return preset.preset;
+        }
+        return nullptr;
+    }
+} // namespace
+
+int main(const int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return EXIT_FAILURE;
+    }
+
+    // Интервалы соединения, единицы 1.25 мс: 7.5, 15, 30, 50, 100, 200 мс и интервалы пресетов
+    std::vector<uint16_t> intervals = {0x06, 0x0C, 0x18, 0x28, 0x50, 0xA0};
+    std::vector<uint16_t> dles = {27, 251};
+    for (const ConnCase& preset : PRESETS)
+    {
+        intervals.push_back(preset.interval);
+        dles.push_back(preset.dle);
+    }
+    for (auto* values : {&intervals, &dles})
+    {
+        std::ranges::sort(*values);
+        values->erase(std::ranges::unique(*values).begin(), values->end());
+    }
+    constexpr Phy PHYS[] = {Phy::PHY_1M, Phy::PHY_2M, Phy::CODED_S8};
+
+    std::vector<ConnResult> results;
+    for (const Phy phy : PHYS)
+    {
+        for (const uint16_t dle : dles)
+        {
+            for (const uint16_t interval : intervals)
+            {
+                results.push_back(simulateConnection({phy, dle, interval, builtInPreset(phy, dle, interval)},
+                                                     options));
+            }
+        }
+    }
+
+    printf("BLE preset tuner: MTU %u, latency %u, %s\n", options.mtu, options.latency,
+           options.encrypted ? "encrypted" : "unencrypted");
+    printAdvertisingTable(options);
+    printConnectionTable(results);
+    printRecommendation(results, options);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,256 @@
+/**
+ * @file ble_scan_bench.cpp
+ * @brief Пропускная способность BleScanner на генераторе рекламных отчетов
+ * @details Генератор подает отчеты ESP_GAP_BLE_EXT_ADV_REPORT_EVT в BleScanner::handleGapEvent()
+ *          так же, как обработчик GAP в задаче BTC: набор устройств (адрес, имя, UUID сервиса,
+ *          RSSI) рекламирует по кругу, часть устройств меняет данные, часть слабее порога RSSI
+ *          или без нужного UUID. Callback тратит --work-us на отчет (разбор приложением).
+ *
+ *          Печатает:
+ *          - стоимость отчета в контексте производителя (фильтры, дубликаты, копирование), нс;
+ *          - пропускную способность (отчетов в секунду на входе и переданных в callback);
+ *          - распределение отчетов по счетчикам сканера (отфильтровано, дубликаты, потеряно);
+ *          - задержку доставки в callback (p50/p99/max).
+ *
+ *          Сборка и запуск (ESP-IDF и FreeRTOS заменяются заглушками tools/host):
+ *          @code
+ *          g++ -std=c++20 -O2 -Iinclude -Iinclude/net -Itools/host \
+ *              tools/ble_scan_bench.cpp src/ble_scanner.cpp src/ble_task.cpp -pthread -o ble_scan_bench
+ *          ./ble_scan_bench --reports 500000 --devices 200 --work-us 20
+ *          @endcode
+ *
+ *          Параметры:
+ *          - --reports N   количество отчетов (по умолчанию 200000)
+ *          - --devices N   количество устройств (по умолчанию 64)
+ *          - --rate N      отчетов в секунду (0 - без пауз, по умолчанию)
+ *          - --work-us N   работа callback на отчет, мкс (по умолчанию 0)
+ *          - --dedup-ms N  окно подавления дубликатов, мс (по умолчанию 1000)
+ *          - --filter      фильтр по UUID сервиса и RSSI (-80 дБм)
+ */
+
+#include "net/ble_scanner.h"
+
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace net;
+
+namespace
+{
+    /// @brief UUID сервиса, по которому фильтруют "свои" устройства
+    constexpr uint16_t SERVICE_UUID = 0xFEAA;
+
+    /**
+     * @brief Параметры запуска
+     */
+    struct Options
+    {
+        uint32_t reports = 200000;
+        uint32_t devices = 64;
+        uint32_t rate = 0;
+        uint32_t workUs = 0;
+        uint32_t dedupMs = 1000;
+        bool filter = false;
+    };
+
+    /**
+     * @brief Рекламирующее устройство генератора
+     */
+    struct Device
+    {
+        esp_bd_addr_t address;
+        int8_t rssi;
+        bool ownService; ///< Рекламирует SERVICE_UUID
+        bool changing;   ///< Меняет данные в каждом пакете (счетчик датчика)
+        uint8_t counter;
+    };
+
+    bool parseOptions(const int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view arg = argv[i];
+            const auto next = [&](uint32_t& value)
+            {
+                if (i + 1 >= argc) return false;
+                value = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+                return true;
+            };
+
+            if (arg == "--reports" && next(options.reports)) continue;
+            if (arg == "--devices" && next(options.devices)) continue;
+            if (arg == "--rate" && next(options.rate)) continue;
+            if (arg == "--work-us" && next(options.workUs)) continue;
+            if (arg == "--dedup-ms" && next(options.dedupMs)) continue;
+            if (arg == "--filter")
+            {
+                options.filter = true;
+                continue;
+            }
+            std::fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return false;
+        }
+        options.devices = std::max<uint32_t>(options.devices, 1);
+        return true;
+    }
+
+    /**
+     * @brief Рекламные данные устройства: флаги, UUID (свой или чужой), имя, данные сервиса
+     */
+    void fillReport(Device& device, const uint32_t index, esp_ble_gap_ext_adv_reprot_t& report)
+    {
+        std::memset(&report, 0, sizeof(report));
+        report.event_type = 0x0013; // connectable, scannable, legacy
+        report.addr_type = BLE_ADDR_TYPE_RANDOM;
+        std::memcpy(report.addr, device.address, sizeof(esp_bd_addr_t));
+        report.primary_phy = ESP_BLE_GAP_PRI_PHY_1M;
+        report.secondly_phy = ESP_BLE_GAP_PHY_1M;
+        report.tx_power = 0x7F;
+        report.rssi = device.rssi;
+
+        uint8_t* data = report.adv_data;
+        size_t len = 0;
+        const auto put = [&](const uint8_t type, const uint8_t* value, const size_t valueLen)
+        {
+            data[len++] = static_cast<uint8_t>(valueLen + 1);
+            data[len++] = type;
+            std::memcpy(data + len, value, valueLen);
+            len += valueLen;
+        };
+
+        const uint8_t flags = 0x06;
+        put(0x01, &flags, 1);
+
+        const uint16_t uuid = device.ownService ? SERVICE_UUID : static_cast<uint16_t>(0x1800 + index % 16);
+        const uint8_t uuidLe[2] = {static_cast<uint8_t>(uuid), static_cast<uint8_t>(uuid >> 8)};
+        put(0x03, uuidLe, sizeof(uuidLe));
+
+        char name[16];
+        const int nameLen = std::snprintf(name, sizeof(name), "sensor-%03u", static_cast<unsigned>(index % 1000));
+        put(0x09, reinterpret_cast<const uint8_t*>(name), static_cast<size_t>(nameLen));
+
+        if (device.changing) device.counter++;
+        const uint8_t serviceData[4] = {uuidLe[0], uuidLe[1], device.counter, static_cast<uint8_t>(index)};
+        put(0x16, serviceData, sizeof(serviceData));
+
+        report.adv_data_len = static_cast<uint8_t>(len);
+    }
+
+    uint32_t percentile(std::vector<uint32_t>& values, const double p)
+    {
+        if (values.empty()) return 0;
+        const size_t index = std::min(values.size() - 1, static_cast<size_t>(p * static_cast<double>(values.size())));
+        std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+        return values[index];
+    }
+} // namespace
+
+int main(const int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 2;
+
+    // 1. Устройства: четверть "свои", треть меняет данные, часть на краю зоны приема
+    std::mt19937 rng(1);
+    std::vector<Device> devices(options.devices);
+    for (uint32_t i = 0; i < options.devices; i++)
+    {
+        Device& device = devices[i];
+        for (auto& byte : device.address) byte = static_cast<uint8_t>(rng());
+        device.address[0] |= 0xC0; // static random
+        device.rssi = static_cast<int8_t>(-40 - static_cast<int>(rng() % 60));
+        device.ownService = i % 4 == 0;
+        device.changing = i % 3 == 0;
+        device.counter = 0;
+    }
+
+    // 2. Сканер с callback, имитирующим разбор отчета приложением
+    BleScanConfig config;
+    config.dedupWindowMs = options.dedupMs;
+    if (options.filter)
+    {
+        config.minRssi = -80;
+        config.serviceUuid = BleUuid::from16(SERVICE_UUID);
+    }
+
+    std::mutex latencyMutex;
+    std::vector<uint32_t> latencies;
+    latencies.reserve(options.reports);
+
+    BleScanner scanner;
+    const esp_err_t ret = scanner.start(config, [&](const BleScanReport& report)
+    {
+        const int64_t start = esp_timer_get_time();
+        while (esp_timer_get_time() - start < options.workUs)
+        {
+        }
+        std::lock_guard lock(latencyMutex);
+        latencies.push_back(static_cast<uint32_t>(start - report.timestampUs));
+    });
+    if (ret != ESP_OK)
+    {
+        std::fprintf(stderr, "Scanner start failed: %s\n", esp_err_to_name(ret));
+        return 1;
+    }
+
+    // 3. Генератор в контексте "BTC": отчеты через обработчик GAP
+    esp_ble_gap_cb_param_t param;
+    int64_t producerNs = 0;
+    const auto begin = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < options.reports; i++)
+    {
+        fillReport(devices[i % options.devices], i % options.devices, param.ext_adv_report.params);
+
+        const auto before = std::chrono::steady_clock::now();
+        scanner.handleGapEvent(ESP_GAP_BLE_EXT_ADV_REPORT_EVT, &param);
+        producerNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - before).count();
+
+        if (options.rate != 0)
+        {
+            std::this_thread::sleep_until(begin + std::chrono::microseconds(
+                static_cast<int64_t>(i + 1) * 1000000 / options.rate));
+        }
+    }
+    const auto produced = std::chrono::steady_clock::now();
+
+    // 4. Дождаться, пока потребитель разберет буфер
+    BleScanner::Statistics stats = scanner.getStatistics();
+    while (stats.processed + stats.filtered + stats.duplicates + stats.dropped < stats.received)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        stats = scanner.getStatistics();
+    }
+    const auto consumed = std::chrono::steady_clock::now();
+    scanner.stop();
+
+    const double produceSec = std::chrono::duration<double>(produced - begin).count();
+    const double totalSec = std::chrono::duration<double>(consumed - begin).count();
+
+    std::printf("reports=%" PRIu32 " devices=%" PRIu32 " rate=%" PRIu32 "/s work=%" PRIu32 "us dedup=%" PRIu32
+                "ms filter=%s\n",
+                options.reports, options.devices, options.rate, options.workUs, options.dedupMs,
+                options.filter ? "on" : "off");
+    std::printf("producer:   %.0f ns/report, %.0f reports/s offered\n",
+                static_cast<double>(producerNs) / std::max<uint32_t>(stats.received, 1),
+                stats.received / produceSec);
+    std::printf("consumer:   %.0f reports/s delivered\n", stats.processed / totalSec);
+    std::printf("counters:   received=%" PRIu32 " filtered=%" PRIu32 " duplicates=%" PRIu32 " dropped=%" PRIu32
+                " processed=%" PRIu32 "\n",
+                stats.received, stats.filtered, stats.duplicates, stats.dropped, stats.processed);
+    std::printf("latency us: p50=%" PRIu32 " p99=%" PRIu32 " max=%" PRIu32 "\n",
+                percentile(latencies, 0.50), percentile(latencies, 0.99), percentile(latencies, 1.0));
+    return 0;
+}
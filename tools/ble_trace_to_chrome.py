@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""
+Преобразование дампа BleTrace (BLE::getTrace().dump()) в формат Chrome trace / Perfetto.
+
+Вход - журнал консоли с блоком строк "BLETRACE BEGIN ... BLETRACE END" (остальные строки
+пропускаются). Выход - JSON для chrome://tracing или https://ui.perfetto.dev:
+  - события GAP/GATTS/GATTC - отметки на отдельных дорожках;
+  - отправки - интервалы на дорожке соединения;
+  - callback'и приложения - интервалы на дорожке callback'ов.
+
+Имена событий GATTS/GATTC встроены. Номера событий GAP зависят от версии ESP-IDF и
+включенных функций (BLE 4.2/5.0), поэтому имена берутся из esp_gap_ble_api.h через
+--gap-enum; без него события подписываются номером.
+
+    idf.py monitor | tee ble.log
+    python3 tools/ble_trace_to_chrome.py ble.log -o ble_trace.json \\
+        --gap-enum $IDF_PATH/components/bt/host/bluedroid/api/include/api/esp_gap_ble_api.h
+"""
+
+import argparse
+import json
+import re
+import sys
+
+NO_CONN = 0xFFFF
+
+KIND_GAP, KIND_GATTS, KIND_GATTC, KIND_SEND_BEGIN, KIND_SEND_END, KIND_CALLBACK_BEGIN, KIND_CALLBACK_END = range(7)
+
+SEND_NAMES = ["notify", "channel frame"]
+CALLBACK_NAMES = ["data callback", "bulk handler", "pairing handler", "startup callback", "connection observer"]
+
+GATTS_EVENTS = {
+    0: "REG", 1: "READ", 2: "WRITE", 3: "EXEC_WRITE", 4: "MTU", 5: "CONF", 6: "UNREG", 7: "CREATE",
+    8: "ADD_INCL_SRVC", 9: "ADD_CHAR", 10: "ADD_CHAR_DESCR", 11: "DELETE", 12: "START", 13: "STOP",
+    14: "CONNECT", 15: "DISCONNECT", 16: "OPEN", 17: "CANCEL_OPEN", 18: "CLOSE", 19: "LISTEN",
+    20: "CONGEST", 21: "RESPONSE", 22: "CREAT_ATTR_TAB", 23: "SET_ATTR_VAL", 24: "SEND_SERVICE_CHANGE",
+}
+
+GATTC_EVENTS = {
+    0: "REG", 1: "UNREG", 2: "OPEN", 3: "READ_CHAR", 4: "WRITE_CHAR", 5: "CLOSE", 6: "SEARCH_CMPL",
+    7: "SEARCH_RES", 8: "READ_DESCR", 9: "WRITE_DESCR", 10: "NOTIFY", 11: "PREP_WRITE", 12: "EXEC",
+    13: "ACL", 14: "CANCEL_OPEN", 15: "SRVC_CHG", 17: "ENC_CMPL_CB", 18: "CFG_MTU", 24: "CONGEST",
+    38: "REG_FOR_NOTIFY", 39: "UNREG_FOR_NOTIFY", 40: "CONNECT", 41: "DISCONNECT", 42: "READ_MULTIPLE",
+    43: "QUEUE_FULL", 44: "SET_ASSOC", 45: "GET_ADDR_LIST", 46: "DIS_SRVC_CMPL", 47: "READ_MULTI_VAR",
+}
+
+# Значение arg в записях событий (см. BLE::traceGattsEvent и соседние)
+GATTS_ARGS = {1: "handle", 2: "len", 3: "flag", 4: "mtu", 5: "status", 14: "interval", 15: "reason",
+              20: "congested", 21: "status"}
+GATTC_ARGS = {2: "status", 3: "status", 4: "status", 5: "reason", 10: "len", 18: "mtu", 24: "congested",
+              41: "reason"}
+
+# Дорожки (tid)
+TID_GAP, TID_GATTS, TID_GATTC, TID_CALLBACKS, TID_SEND_BASE = 1, 2, 3, 4, 16
+
+LINE_RE = re.compile(r"BLETRACE ([0-9a-f]{8}) ([0-9a-f]{8}) ([0-9a-f]{2}) ([0-9a-f]{2}) ([0-9a-f]{4}) ([0-9a-f]{8})")
+BEGIN_RE = re.compile(r"BLETRACE BEGIN (\d+) (\d+) (-?\d+)")
+
+
+def parse_gap_enum(path):
+    """Имена esp_gap_ble_cb_event_t: перечисление по порядку, все блоки #if считаются включенными."""
+    with open(path, encoding="utf-8", errors="replace") as f:
+        text = f.read()
+    match = re.search(r"typedef\s+enum\s*\{(.*?)\}\s*esp_gap_ble_cb_event_t", text, re.S)
+    if not match:
+        sys.exit(f"{path}: esp_gap_ble_cb_event_t not found")
+
+    names = {}
+    value = -1
+    body = re.sub(r"/\*.*?\*/|//[^\n]*", "", match.group(1), flags=re.S)
+    for line in body.splitlines():
+        line = line.strip()
+        if not line or line.startswith("#"):
+            continue
+        for item in filter(None, (part.strip() for part in line.split(","))):
+            name, _, explicit = item.partition("=")
+            name = name.strip()
+            if not name.startswith("ESP_GAP_BLE_"):
+                continue
+            explicit = explicit.strip()
+            value = int(explicit, 0) if explicit and explicit[0].isdigit() else value + 1
+            names[value] = name[len("ESP_GAP_BLE_"):].removesuffix("_EVT")
+    return names
+
+
+def read_dump(stream):
+    """Последний полный блок дампа: (время дампа, [(seq, timeLow, kind, code, conn, arg)])"""
+    block, entries, dump_now = None, [], None
+    for line in stream:
+        if (m := BEGIN_RE.search(line)) is not None:
+            if int(m.group(1)) != 1:
+                sys.exit(f"unsupported trace format version {m.group(1)}")
+            block, dump_now = [], int(m.group(3))
+        elif block is not None and "BLETRACE END" in line:
+            entries = block
+            block = None
+        elif block is not None and (m := LINE_RE.search(line)) is not None:
+            block.append(tuple(int(group, 16) for group in m.groups()))
+    if not entries:
+        sys.exit("no complete BLETRACE block found")
+    return dump_now, entries
+
+
+def absolute_times(dump_now, entries):
+    """Разворот 32-битного времени: записи идут по порядку, последняя - не позже dump_now."""
+    unwrapped, offset, previous = [], 0, None
+    for entry in entries:
+        low = entry[1]
+        if previous is not None and low < previous and previous - low > 1 << 31:
+            offset += 1 << 32
+        unwrapped.append(low + offset)
+        previous = low
+    last = unwrapped[-1]
+    last_abs = dump_now - ((dump_now - last) & 0xFFFFFFFF)
+    return [t - last + last_abs for t in unwrapped]
+
+
+def convert(dump_now, entries, gap_names):
+    events = []
+    open_spans = {}
+
+    def instant(tid, name, ts, conn, args):
+        if conn != NO_CONN:
+            args["conn"] = conn
+        events.append({"name": name, "ph": "i", "s": "t", "ts": ts, "pid": 1, "tid": tid, "args": args})
+
+    for entry, ts in zip(entries, absolute_times(dump_now, entries)):
+        seq, _, kind, code, conn, arg = entry
+        if kind == KIND_GAP:
+            args = {"arg": f"0x{arg:08x}"} if arg else {}
+            instant(TID_GAP, "GAP " + gap_names.get(code, str(code)), ts, conn, args)
+        elif kind == KIND_GATTS:
+            args = {GATTS_ARGS[code]: arg} if code in GATTS_ARGS else {}
+            instant(TID_GATTS, "GATTS " + GATTS_EVENTS.get(code, str(code)), ts, conn, args)
+        elif kind == KIND_GATTC:
+            args = {GATTC_ARGS[code]: arg} if code in GATTC_ARGS else {}
+            instant(TID_GATTC, "GATTC " + GATTC_EVENTS.get(code, str(code)), ts, conn, args)
+        elif kind in (KIND_SEND_BEGIN, KIND_CALLBACK_BEGIN):
+            open_spans.setdefault((kind, code, conn), []).append((ts, arg, seq))
+        elif kind in (KIND_SEND_END, KIND_CALLBACK_END):
+            begin_kind = KIND_SEND_BEGIN if kind == KIND_SEND_END else KIND_CALLBACK_BEGIN
+            # Начало могло быть вытеснено из буфера: такой интервал пропускается
+            pending = open_spans.get((begin_kind, code, conn))
+            if not pending:
+                continue
+            start, begin_arg, _ = pending.pop(0)
+            if kind == KIND_SEND_END:
+                name = SEND_NAMES[code] if code < len(SEND_NAMES) else f"send {code}"
+                tid = TID_SEND_BASE + (conn if conn != NO_CONN else 0xFF)
+                args = {"len": begin_arg, "result": arg - (1 << 32) if arg & 0x80000000 else arg}
+            else:
+                name = CALLBACK_NAMES[code] if code < len(CALLBACK_NAMES) else f"callback {code}"
+                tid = TID_CALLBACKS
+                args = {"arg": begin_arg}
+            if conn != NO_CONN:
+                args["conn"] = conn
+            events.append({"name": name, "ph": "X", "ts": start, "dur": max(ts - start, 1),
+                           "pid": 1, "tid": tid, "args": args})
+
+    threads = {TID_GAP: "GAP", TID_GATTS: "GATTS", TID_GATTC: "GATTC", TID_CALLBACKS: "callbacks"}
+    for event in events:
+        if event["tid"] >= TID_SEND_BASE:
+            conn = event["tid"] - TID_SEND_BASE
+            threads[event["tid"]] = "send" if conn == 0xFF else f"send conn {conn}"
+    metadata = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "BLE"}}]
+    metadata += [{"name": "thread_name", "ph": "M", "pid": 1, "tid": tid, "args": {"name": name}}
+                 for tid, name in sorted(threads.items())]
+    return {"traceEvents": metadata + events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert BleTrace dump to Chrome trace / Perfetto JSON")
+    parser.add_argument("input", nargs="?", help="console log with BLETRACE block (default: stdin)")
+    parser.add_argument("-o", "--output", help="output JSON (default: stdout)")
+    parser.add_argument("--gap-enum", help="esp_gap_ble_api.h of the ESP-IDF used for the firmware")
+    args = parser.parse_args()
+
+    gap_names = parse_gap_enum(args.gap_enum) if args.gap_enum else {}
+    if args.input:
+        with open(args.input, encoding="utf-8", errors="replace") as stream:
+            dump_now, entries = read_dump(stream)
+    else:
+        dump_now, entries = read_dump(sys.stdin)
+
+    trace = convert(dump_now, entries, gap_names)
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+    print(f"{len(entries)} records, {len(trace['traceEvents'])} trace events", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,27 @@
+/**
+ * @file callback.h
+ * @brief Заглушка Callback из esp32-c3-common для сборки на хосте
+ * @details На хосте invoke() синхронно вызывает переопределенный обработчик.
+ */
+
+#ifndef HOST_ESP32_C3_OBJECTS_CALLBACK_H
+#define HOST_ESP32_C3_OBJECTS_CALLBACK_H
+
+namespace esp32_c3::objects
+{
+    /**
+     * @brief Callback данных (аргумент - Packet*)
+     */
+    class Callback
+    {
+    public:
+        virtual ~Callback() = default;
+
+        /**
+         * @brief Обработка данных
+         */
+        virtual void invoke(void* data) = 0;
+    };
+} // namespace esp32_c3::objects
+
+#endif // HOST_ESP32_C3_OBJECTS_CALLBACK_H
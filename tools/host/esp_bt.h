@@ -0,0 +1,63 @@
+/**
+ * @file esp_bt.h
+ * @brief Заглушка esp_bt.h ESP-IDF для сборки конфигурации на хосте
+ * @details Только поля esp_bt_controller_config_t, которые задают пресеты BleConfig;
+ *          значения перечислений совпадают с ESP-IDF.
+ */
+
+#ifndef HOST_ESP_BT_H
+#define HOST_ESP_BT_H
+
+#include "esp_err.h"
+
+#include <cstdint>
+
+typedef enum
+{
+    ESP_BT_MODE_IDLE = 0x00,
+    ESP_BT_MODE_BLE = 0x01,
+    ESP_BT_MODE_CLASSIC_BT = 0x02,
+    ESP_BT_MODE_BTDM = 0x03
+} esp_bt_mode_t;
+
+typedef enum
+{
+    ESP_PWR_LVL_N24 = 0,
+    ESP_PWR_LVL_N21 = 1,
+    ESP_PWR_LVL_N18 = 2,
+    ESP_PWR_LVL_N15 = 3,
+    ESP_PWR_LVL_N12 = 4,
+    ESP_PWR_LVL_N9 = 5,
+    ESP_PWR_LVL_N6 = 6,
+    ESP_PWR_LVL_N3 = 7,
+    ESP_PWR_LVL_N0 = 8,
+    ESP_PWR_LVL_P3 = 9,
+    ESP_PWR_LVL_P6 = 10,
+    ESP_PWR_LVL_P9 = 11,
+    ESP_PWR_LVL_P12 = 12,
+    ESP_PWR_LVL_P15 = 13,
+    ESP_PWR_LVL_P18 = 14,
+    ESP_PWR_LVL_P21 = 15,
+    ESP_PWR_LVL_INVALID = 0xFF
+} esp_power_level_t;
+
+#define ESP_BT_SLEEP_MODE_NONE 0
+#define ESP_BT_SLEEP_MODE_1 1
+
+typedef struct
+{
+    uint32_t magic;
+    uint8_t bluetooth_mode;
+    uint8_t ble_max_act;
+    uint8_t sleep_mode;
+    uint8_t txpwr_dft;
+    bool ble_50_feat_supp;
+} esp_bt_controller_config_t;
+
+#define BT_CONTROLLER_INIT_CONFIG_DEFAULT()                                                         \
+    {                                                                                               \
+        .magic = 0x5A5AA5A5, .bluetooth_mode = ESP_BT_MODE_BLE, .ble_max_act = 6,                   \
+        .sleep_mode = ESP_BT_SLEEP_MODE_NONE, .txpwr_dft = ESP_PWR_LVL_P9, .ble_50_feat_supp = true \
+    }
+
+#endif // HOST_ESP_BT_H
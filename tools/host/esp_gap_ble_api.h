@@ -0,0 +1,216 @@
+/**
+ * @file esp_gap_ble_api.h
+ * @brief Заглушка GAP API ESP-IDF (Bluedroid) для сборки сканера и конфигурации на хосте
+ * @details Расширенное сканирование, параметры рекламы и безопасности из BleConfig: типы
+ *          и битовые маски совпадают с ESP-IDF, значения событий - нет. Вызовы API ничего
+ *          не делают: отчеты подает генератор через BleScanner::submitReport() или
+ *          handleGapEvent().
+ */
+
+#ifndef HOST_ESP_GAP_BLE_API_H
+#define HOST_ESP_GAP_BLE_API_H
+
+#include "esp_bt_defs.h"
+#include "esp_err.h"
+
+#include <cstdint>
+
+typedef enum
+{
+    BLE_SCAN_TYPE_PASSIVE = 0x0,
+    BLE_SCAN_TYPE_ACTIVE = 0x1
+} esp_ble_scan_type_t;
+
+typedef enum
+{
+    BLE_SCAN_FILTER_ALLOW_ALL = 0x0,
+    BLE_SCAN_FILTER_ALLOW_ONLY_WLST = 0x1
+} esp_ble_scan_filter_t;
+
+typedef enum
+{
+    BLE_SCAN_DUPLICATE_DISABLE = 0x0,
+    BLE_SCAN_DUPLICATE_ENABLE = 0x1
+} esp_ble_scan_duplicate_t;
+
+typedef uint8_t esp_ble_ext_scan_cfg_mask_t;
+typedef uint8_t esp_ble_gap_pri_phy_t;
+typedef uint8_t esp_ble_gap_phy_t;
+typedef uint16_t esp_ble_gap_adv_type_t;
+typedef uint8_t esp_ble_gap_ext_adv_data_status_t;
+
+#define ESP_BLE_GAP_EXT_SCAN_CFG_UNCODE_MASK 0x01
+#define ESP_BLE_GAP_EXT_SCAN_CFG_CODE_MASK 0x02
+
+#define ESP_BLE_GAP_PRI_PHY_1M 0x01
+#define ESP_BLE_GAP_PRI_PHY_CODED 0x03
+#define ESP_BLE_GAP_PHY_1M 0x01
+#define ESP_BLE_GAP_PHY_2M 0x02
+#define ESP_BLE_GAP_PHY_CODED 0x03
+
+typedef uint8_t esp_ble_gap_phy_mask_t;
+
+#define ESP_BLE_GAP_PHY_1M_PREF_MASK (1 << 0)
+#define ESP_BLE_GAP_PHY_2M_PREF_MASK (1 << 1)
+#define ESP_BLE_GAP_PHY_CODED_PREF_MASK (1 << 2)
+
+typedef uint16_t esp_ble_ext_adv_type_mask_t;
+
+#define ESP_BLE_GAP_SET_EXT_ADV_PROP_CONNECTABLE (1 << 0)
+#define ESP_BLE_GAP_SET_EXT_ADV_PROP_SCANNABLE (1 << 1)
+#define ESP_BLE_GAP_SET_EXT_ADV_PROP_DIRECTED (1 << 2)
+#define ESP_BLE_GAP_SET_EXT_ADV_PROP_LEGACY (1 << 4)
+
+#define ESP_BLE_ADV_FLAG_LIMIT_DISC (0x01 << 0)
+#define ESP_BLE_ADV_FLAG_GEN_DISC (0x01 << 1)
+#define ESP_BLE_ADV_FLAG_BREDR_NOT_SPT (0x01 << 2)
+
+typedef uint8_t esp_ble_auth_req_t;
+
+#define ESP_LE_AUTH_NO_BOND 0x00
+#define ESP_LE_AUTH_BOND 0x01
+#define ESP_LE_AUTH_REQ_MITM (1 << 2)
+#define ESP_LE_AUTH_REQ_SC_ONLY (1 << 3)
+
+typedef uint8_t esp_ble_io_cap_t;
+
+#define ESP_IO_CAP_OUT 0
+#define ESP_IO_CAP_IO 1
+#define ESP_IO_CAP_IN 2
+#define ESP_IO_CAP_NONE 3
+#define ESP_IO_CAP_KBDISP 4
+
+#define ESP_BLE_ENC_KEY_MASK (1 << 0)
+#define ESP_BLE_ID_KEY_MASK (1 << 1)
+#define ESP_BLE_CSR_KEY_MASK (1 << 2)
+#define ESP_BLE_LINK_KEY_MASK (1 << 3)
+
+typedef enum
+{
+    ADV_TYPE_IND = 0x00,
+    ADV_TYPE_DIRECT_IND_HIGH = 0x01,
+    ADV_TYPE_SCAN_IND = 0x02,
+    ADV_TYPE_NONCONN_IND = 0x03,
+    ADV_TYPE_DIRECT_IND_LOW = 0x04
+} esp_ble_adv_type_t;
+
+typedef enum
+{
+    ADV_CHNL_37 = 0x01,
+    ADV_CHNL_38 = 0x02,
+    ADV_CHNL_39 = 0x04,
+    ADV_CHNL_ALL = 0x07
+} esp_ble_adv_channel_t;
+
+typedef enum
+{
+    ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY = 0x00,
+    ADV_FILTER_ALLOW_SCAN_WLST_CON_ANY,
+    ADV_FILTER_ALLOW_SCAN_ANY_CON_WLST,
+    ADV_FILTER_ALLOW_SCAN_WLST_CON_WLST
+} esp_ble_adv_filter_t;
+
+typedef struct
+{
+    uint16_t adv_int_min;
+    uint16_t adv_int_max;
+    esp_ble_adv_type_t adv_type;
+    esp_ble_addr_type_t own_addr_type;
+    esp_bd_addr_t peer_addr;
+    esp_ble_addr_type_t peer_addr_type;
+    esp_ble_adv_channel_t channel_map;
+    esp_ble_adv_filter_t adv_filter_policy;
+} esp_ble_adv_params_t;
+
+typedef struct
+{
+    esp_ble_ext_adv_type_mask_t type;
+    uint32_t interval_min;
+    uint32_t interval_max;
+    esp_ble_adv_channel_t channel_map;
+    esp_ble_addr_type_t own_addr_type;
+    esp_ble_addr_type_t peer_addr_type;
+    esp_bd_addr_t peer_addr;
+    esp_ble_adv_filter_t filter_policy;
+    int8_t tx_power;
+    esp_ble_gap_pri_phy_t primary_phy;
+    uint8_t max_skip;
+    esp_ble_gap_phy_t secondary_phy;
+    uint8_t sid;
+    bool scan_req_notif;
+} esp_ble_gap_ext_adv_params_t;
+
+typedef struct
+{
+    esp_ble_scan_type_t scan_type;
+    uint16_t scan_interval;
+    uint16_t scan_window;
+} esp_ble_ext_scan_cfg_t;
+
+typedef struct
+{
+    esp_ble_addr_type_t own_addr_type;
+    esp_ble_scan_filter_t filter_policy;
+    esp_ble_scan_duplicate_t scan_duplicate;
+    esp_ble_ext_scan_cfg_mask_t cfg_mask;
+    esp_ble_ext_scan_cfg_t uncoded_cfg;
+    esp_ble_ext_scan_cfg_t coded_cfg;
+} esp_ble_ext_scan_params_t;
+
+typedef struct
+{
+    esp_ble_gap_adv_type_t event_type;
+    uint8_t addr_type;
+    esp_bd_addr_t addr;
+    esp_ble_gap_pri_phy_t primary_phy;
+    esp_ble_gap_phy_t secondly_phy;
+    uint8_t sid;
+    uint8_t tx_power;
+    int8_t rssi;
+    uint16_t per_adv_interval;
+    uint8_t dir_addr_type;
+    esp_bd_addr_t dir_addr;
+    esp_ble_gap_ext_adv_data_status_t data_status;
+    uint8_t adv_data_len;
+    uint8_t adv_data[251];
+} esp_ble_gap_ext_adv_reprot_t;
+
+typedef enum
+{
+    ESP_GAP_BLE_SET_EXT_SCAN_PARAMS_COMPLETE_EVT,
+    ESP_GAP_BLE_EXT_SCAN_START_COMPLETE_EVT,
+    ESP_GAP_BLE_EXT_SCAN_STOP_COMPLETE_EVT,
+    ESP_GAP_BLE_EXT_ADV_REPORT_EVT,
+    ESP_GAP_BLE_SCAN_TIMEOUT_EVT,
+    ESP_GAP_BLE_EVT_MAX
+} esp_gap_ble_cb_event_t;
+
+typedef union
+{
+    struct
+    {
+        esp_bt_status_t status;
+    } set_ext_scan_params, ext_scan_start, ext_scan_stop;
+
+    struct
+    {
+        esp_ble_gap_ext_adv_reprot_t params;
+    } ext_adv_report;
+} esp_ble_gap_cb_param_t;
+
+inline esp_err_t esp_ble_gap_set_ext_scan_params(const esp_ble_ext_scan_params_t*)
+{
+    return ESP_OK;
+}
+
+inline esp_err_t esp_ble_gap_start_ext_scan(uint32_t, uint16_t)
+{
+    return ESP_OK;
+}
+
+inline esp_err_t esp_ble_gap_stop_ext_scan()
+{
+    return ESP_OK;
+}
+
+#endif // HOST_ESP_GAP_BLE_API_H
@@ -0,0 +1,33 @@
+/**
+ * @file esp_gatts_api.h
+ * @brief Заглушка GATT определений ESP-IDF для сборки конфигурации на хосте
+ * @details Только свойства и права характеристик; значения совпадают с ESP-IDF.
+ */
+
+#ifndef HOST_ESP_GATTS_API_H
+#define HOST_ESP_GATTS_API_H
+
+#include "esp_bt_defs.h"
+#include "esp_err.h"
+
+#include <cstdint>
+
+typedef uint8_t esp_gatt_char_prop_t;
+
+#define ESP_GATT_CHAR_PROP_BIT_BROADCAST (1 << 0)
+#define ESP_GATT_CHAR_PROP_BIT_READ (1 << 1)
+#define ESP_GATT_CHAR_PROP_BIT_WRITE_NR (1 << 2)
+#define ESP_GATT_CHAR_PROP_BIT_WRITE (1 << 3)
+#define ESP_GATT_CHAR_PROP_BIT_NOTIFY (1 << 4)
+#define ESP_GATT_CHAR_PROP_BIT_INDICATE (1 << 5)
+
+typedef uint16_t esp_gatt_perm_t;
+
+#define ESP_GATT_PERM_READ (1 << 0)
+#define ESP_GATT_PERM_READ_ENCRYPTED (1 << 1)
+#define ESP_GATT_PERM_READ_ENC_MITM (1 << 2)
+#define ESP_GATT_PERM_WRITE (1 << 4)
+#define ESP_GATT_PERM_WRITE_ENCRYPTED (1 << 5)
+#define ESP_GATT_PERM_WRITE_ENC_MITM (1 << 6)
+
+#endif // HOST_ESP_GATTS_API_H
@@ -0,0 +1,19 @@
+/**
+ * @file esp_log.h
+ * @brief Заглушка журнала ESP-IDF для сборки на хосте
+ * @details Ошибки и предупреждения печатаются в stderr, остальные уровни отключены,
+ *          чтобы не искажать замеры.
+ */
+
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#include <cstdio>
+
+#define ESP_LOGE(tag, format, ...) std::fprintf(stderr, "E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) std::fprintf(stderr, "W %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ((void)(tag))
+#define ESP_LOGD(tag, format, ...) ((void)(tag))
+#define ESP_LOGV(tag, format, ...) ((void)(tag))
+
+#endif // HOST_ESP_LOG_H
@@ -0,0 +1,20 @@
+/**
+ * @file esp_timer.h
+ * @brief Заглушка esp_timer для сборки на хосте
+ * @details Только монотонное время; отсчет, как и на устройстве, от запуска программы.
+ */
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include "host_clock.h"
+
+#include <chrono>
+#include <cstdint>
+
+inline int64_t esp_timer_get_time()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(host::sinceStart()).count();
+}
+
+#endif // HOST_ESP_TIMER_H
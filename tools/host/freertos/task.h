@@ -0,0 +1,120 @@
+/**
+ * @file task.h
+ * @brief Заглушка задач FreeRTOS для сборки на хосте
+ * @details Задача - поток std::thread; приоритет и ядро игнорируются. Поддерживаются
+ *          уведомления (xTaskNotifyGive/ulTaskNotifyTake) и задержки. Задачи библиотеки
+ *          удаляют себя последним оператором (vTaskDelete(nullptr)), поэтому vTaskDelete
+ *          не прерывает поток: поток завершается возвратом из функции задачи.
+ *          Управляющий блок задачи не освобождается: уведомление после завершения
+ *          задачи остается безопасным, как и на устройстве до очистки idle-задачей.
+ */
+
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+#include "host_clock.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct tskTaskControlBlock
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint32_t notifyValue = 0;
+};
+
+typedef tskTaskControlBlock* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+namespace host
+{
+    /// @brief Управляющий блок текущего потока (создается при первом обращении)
+    inline TaskHandle_t& currentTask()
+    {
+        thread_local TaskHandle_t task = nullptr;
+        if (task == nullptr) task = new tskTaskControlBlock;
+        return task;
+    }
+} // namespace host
+
+inline BaseType_t xTaskCreatePinnedToCore(const TaskFunction_t function, const char*, uint32_t, void* arg,
+                                          UBaseType_t, TaskHandle_t* handle, BaseType_t)
+{
+    auto* task = new tskTaskControlBlock;
+    if (handle != nullptr) *handle = task;
+    std::thread([task, function, arg]
+    {
+        host::currentTask() = task;
+        function(arg);
+    }).detach();
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(const TaskFunction_t function, const char* name, const uint32_t stack, void* arg,
+                              const UBaseType_t priority, TaskHandle_t* handle)
+{
+    return xTaskCreatePinnedToCore(function, name, stack, arg, priority, handle, tskNO_AFFINITY);
+}
+
+inline void vTaskDelete(TaskHandle_t)
+{
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return host::currentTask();
+}
+
+inline TickType_t xTaskGetTickCount()
+{
+    return static_cast<TickType_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(host::sinceStart()).count());
+}
+
+inline void vTaskDelay(const TickType_t ticks)
+{
+    if (ticks == 0)
+    {
+        std::this_thread::yield();
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline BaseType_t xTaskNotifyGive(const TaskHandle_t task)
+{
+    {
+        std::lock_guard lock(task->mutex);
+        task->notifyValue++;
+    }
+    task->cv.notify_one();
+    return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(const BaseType_t clearOnExit, const TickType_t ticks)
+{
+    TaskHandle_t task = host::currentTask();
+    std::unique_lock lock(task->mutex);
+    const auto ready = [task] { return task->notifyValue != 0; };
+    if (ticks == portMAX_DELAY)
+    {
+        task->cv.wait(lock, ready);
+    }
+    else
+    {
+        task->cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+    }
+
+    const uint32_t value = task->notifyValue;
+    if (value != 0)
+    {
+        task->notifyValue = clearOnExit ? 0 : value - 1;
+    }
+    return value;
+}
+
+#endif // HOST_FREERTOS_TASK_H
@@ -0,0 +1,21 @@
+/**
+ * @file host_clock.h
+ * @brief Общие часы заглушек esp_timer и FreeRTOS на хосте
+ */
+
+#ifndef HOST_CLOCK_H
+#define HOST_CLOCK_H
+
+#include <chrono>
+
+namespace host
+{
+    /// @brief Время с первого обращения (запуска программы)
+    inline std::chrono::steady_clock::duration sinceStart()
+    {
+        static const auto start = std::chrono::steady_clock::now();
+        return std::chrono::steady_clock::now() - start;
+    }
+} // namespace host
+
+#endif // HOST_CLOCK_H
@@ -0,0 +1,40 @@
+/**
+ * @file packet.h
+ * @brief Заглушка Packet из esp32-c3-common для сборки на хосте
+ * @details Только поля и методы, используемые библиотекой.
+ */
+
+#ifndef HOST_PACKETS_PACKET_H
+#define HOST_PACKETS_PACKET_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/// @brief Максимальный размер полезной нагрузки пакета
+constexpr uint16_t MAX_MTU = 512;
+
+/**
+ * @brief Пакет данных с идентификатором источника
+ */
+struct Packet
+{
+    uint16_t id = 0;                       ///< Идентификатор (соединение)
+    std::array<uint8_t, MAX_MTU> buffer{}; ///< Данные
+    size_t size = 0;                       ///< Длина данных
+
+    /**
+     * @brief Копирование данных в пакет
+     * @return bool false, если данные не помещаются
+     */
+    bool setPayload(const uint8_t* data, const size_t len)
+    {
+        if (len > buffer.size()) return false;
+        std::memcpy(buffer.data(), data, len);
+        size = len;
+        return true;
+    }
+};
+
+#endif // HOST_PACKETS_PACKET_H
@@ -0,0 +1,11 @@
+/**
+ * @file sdkconfig.h
+ * @brief Заглушка sdkconfig.h для сборки на хосте (одноядерная цель, стек BLE не закреплен)
+ */
+
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+#define CONFIG_FREERTOS_UNICORE 1
+
+#endif // HOST_SDKCONFIG_H